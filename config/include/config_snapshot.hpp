@@ -0,0 +1,85 @@
+#pragma once
+
+#include "core/dedup_modes.hpp"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Immutable copy of the configuration values read on every file
+ *
+ * PocoConfigAdapter builds one whenever the configuration changes and hands it out through
+ * snapshot(). Lookups allocate nothing: extensions resolve through a perfect hash table built
+ * from the configured file types, video parameters are resolved per mode up front.
+ */
+class ConfigSnapshot
+{
+public:
+    struct ExtensionInfo
+    {
+        bool supported = false;         // enabled in any category
+        bool needs_transcoding = false; // PocoConfigManager::needsTranscoding
+        const char *media_type = "";    // "image", "video", "audio" or "" when not enabled in those
+        const char *category = "";      // same, whether or not the extension is enabled; "" if not configured
+    };
+
+    struct VideoParams
+    {
+        int skip_duration_seconds = 1;
+        int frames_per_skip = 2;
+        int skip_count = 8;
+    };
+
+    ConfigSnapshot(DedupMode dedup_mode,
+                   const std::map<std::string, bool> &supported_file_types,
+                   const std::map<std::string, bool> &transcoding_file_types,
+                   std::vector<std::string> image_extensions,
+                   std::vector<std::string> video_extensions,
+                   std::vector<std::string> audio_extensions,
+                   const std::map<std::string, std::string> &media_types_by_extension,
+                   const std::array<VideoParams, 3> &video_params);
+
+    DedupMode dedupMode() const { return dedup_mode_; }
+    const VideoParams &videoParams(DedupMode mode) const { return video_params_[static_cast<size_t>(mode)]; }
+
+    const std::vector<std::string> &enabledFileTypes() const { return enabled_file_types_; }
+    const std::vector<std::string> &imageExtensions() const { return image_extensions_; }
+    const std::vector<std::string> &videoExtensions() const { return video_extensions_; }
+    const std::vector<std::string> &audioExtensions() const { return audio_extensions_; }
+
+    // Category of every configured extension, enabled or not
+    const std::map<std::string, std::string> &mediaTypesByExtension() const { return media_types_by_extension_; }
+
+    // Extension without the dot, any case
+    const ExtensionInfo &extension(std::string_view ext) const;
+
+    // Same, for the extension of a file path (text after the last '.')
+    const ExtensionInfo &extensionOfPath(std::string_view path) const;
+
+private:
+    struct Entry
+    {
+        std::string key; // lowercase extension
+        ExtensionInfo info;
+    };
+
+    static uint32_t hash(std::string_view key, uint32_t seed);
+    void buildTable(const std::map<std::string, ExtensionInfo> &entries);
+
+    DedupMode dedup_mode_;
+    std::array<VideoParams, 3> video_params_;
+    std::vector<std::string> enabled_file_types_;
+    std::vector<std::string> image_extensions_;
+    std::vector<std::string> video_extensions_;
+    std::vector<std::string> audio_extensions_;
+    std::map<std::string, std::string> media_types_by_extension_;
+
+    std::vector<Entry> entries_;
+    std::vector<uint16_t> table_; // power-of-two size, hash -> entry index + 1 (0 = free); collision free for seed_
+    uint32_t seed_ = 0;
+    size_t longest_key_ = 0;
+    ExtensionInfo none_;
+};
@@ -3,6 +3,7 @@
 #include "poco_config_manager.hpp"
 #include "core/dedup_modes.hpp"
 #include "config_observer.hpp"
+#include "config_snapshot.hpp"
 #include <nlohmann/json.hpp>
 #include <memory>
 #include <mutex>
@@ -34,6 +35,9 @@ public:
     // Destructor
     ~PocoConfigAdapter();
 
+    // Per-file configuration lookups; rebuilt on every published change. Readers take no lock.
+    std::shared_ptr<const ConfigSnapshot> snapshot() const;
+
     // Configuration getters - delegate to PocoConfigManager
     nlohmann::json getAll() const;
     DedupMode getDedupMode() const;
@@ -42,16 +46,29 @@ public:
     std::string getServerHost() const;
     std::string getAuthSecret() const;
     int getScanIntervalSeconds() const;
+    int getFullWalkIntervalScans() const;
+    bool getWatchEnabled() const;
+    int getWatchDebounceMs() const;
     int getProcessingIntervalSeconds() const;
 
     // Thread configuration getters
     int getMaxProcessingThreads() const;
     int getMaxScanThreads() const;
+    int getMaxScanRootsPerMount() const;
+
+    // Network mount I/O limits
+    int getMountMaxConcurrentIo() const;
+    int getMountBandwidthMBPerSecond() const;
+    int getMountLatencyThresholdMs() const;
+    int getMountAcquireTimeoutSeconds() const;
+    int getMountBreakerTimeoutSeconds() const;
 
     int getDatabaseThreads() const;
 
     // Processing configuration getters
     int getProcessingBatchSize() const;
+    int getProcessingClaimLeaseSeconds() const;
+    int getProcessingMemoryBudgetMB() const;
 
     // File type configuration getters
     std::map<std::string, bool> getSupportedFileTypes() const;
@@ -66,8 +83,16 @@ public:
     std::vector<std::string> getEnabledVideoExtensions() const;
     std::vector<std::string> getEnabledAudioExtensions() const;
 
+    // Category of every configured extension, enabled or not
+    std::map<std::string, std::string> getMediaTypesByExtension() const;
+
     // Cache configuration getters
     uint32_t getDecoderCacheSizeMB() const;
+    int getTranscodeMaxEdgePx() const;
+    bool getWriteRawTranscodes() const;
+    int getRawHandoffMB() const;
+    std::string getThumbnailStoreDir() const;
+    int getThumbnailStoreMaxMB() const;
 
     // Cache configuration methods
     std::string getCacheConfig() const;
@@ -178,6 +203,7 @@ private:
 
     // Internal methods
     void publishEvent(const ConfigUpdateEvent &event);
+    void rebuildSnapshot();
     void initializeDefaultConfig();
     std::string generateUpdateId() const;
     void persistChanges(const std::string &changed_key = "");
@@ -185,6 +211,12 @@ private:
     // Reference to the underlying Poco configuration manager
     PocoConfigManager &poco_cfg_;
 
+    // Current snapshot (std::atomic_load/atomic_store); the version lets readers keep a
+    // thread-local copy and skip the shared_ptr load until it changes
+    std::shared_ptr<const ConfigSnapshot> snapshot_;
+    std::atomic<uint64_t> snapshot_version_{0};
+    std::mutex snapshot_mutex_;
+
     // Observers
     mutable std::mutex observers_mutex_;
     std::vector<ConfigObserver *> observers_;
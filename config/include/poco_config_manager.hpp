@@ -40,16 +40,29 @@ public:
     // Interval configuration getters
     int getScanIntervalSeconds() const;
     int getProcessingIntervalSeconds() const;
+    int getFullWalkIntervalScans() const;
+    bool getWatchEnabled() const;
+    int getWatchDebounceMs() const;
 
     // Thread configuration getters
     int getMaxProcessingThreads() const;
     int getMaxScanThreads() const;
+    int getMaxScanRootsPerMount() const;
+
+    // Network mount I/O limits
+    int getMountMaxConcurrentIo() const;
+    int getMountBandwidthMBPerSecond() const;
+    int getMountLatencyThresholdMs() const;
+    int getMountAcquireTimeoutSeconds() const;
+    int getMountBreakerTimeoutSeconds() const;
 
     int getDatabaseThreads() const;
     int getMaxDecoderThreads() const;
 
     // Processing configuration getters
     int getProcessingBatchSize() const;
+    int getProcessingClaimLeaseSeconds() const;
+    int getProcessingMemoryBudgetMB() const;
     bool getPreProcessQualityStack() const;
 
     // Database configuration getters
@@ -61,6 +74,11 @@ public:
 
     // Cache configuration getters
     uint32_t getDecoderCacheSizeMB() const;
+    int getTranscodeMaxEdgePx() const;
+    bool getWriteRawTranscodes() const;
+    int getRawHandoffMB() const;
+    std::string getThumbnailStoreDir() const;
+    int getThumbnailStoreMaxMB() const;
 
     // File type configuration getters
     std::map<std::string, bool> getSupportedFileTypes() const;
@@ -69,6 +87,7 @@ public:
     std::vector<std::string> getEnabledImageExtensions() const;
     std::vector<std::string> getEnabledVideoExtensions() const;
     std::vector<std::string> getEnabledAudioExtensions() const;
+    std::map<std::string, std::string> getMediaTypesByExtension() const;
     bool needsTranscoding(const std::string &file_extension) const;
 
     // Video processing configuration getters
@@ -0,0 +1,158 @@
+#include "config_snapshot.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    // Seeds tried per table size before the table is doubled
+    constexpr uint32_t SEEDS_PER_SIZE = 64;
+
+    char lower(char c)
+    {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+}
+
+ConfigSnapshot::ConfigSnapshot(DedupMode dedup_mode,
+                               const std::map<std::string, bool> &supported_file_types,
+                               const std::map<std::string, bool> &transcoding_file_types,
+                               std::vector<std::string> image_extensions,
+                               std::vector<std::string> video_extensions,
+                               std::vector<std::string> audio_extensions,
+                               const std::map<std::string, std::string> &media_types_by_extension,
+                               const std::array<VideoParams, 3> &video_params)
+    : dedup_mode_(dedup_mode),
+      video_params_(video_params),
+      image_extensions_(std::move(image_extensions)),
+      video_extensions_(std::move(video_extensions)),
+      audio_extensions_(std::move(audio_extensions)),
+      media_types_by_extension_(media_types_by_extension)
+{
+    std::map<std::string, ExtensionInfo> entries;
+    auto key = [](std::string ext)
+    {
+        std::transform(ext.begin(), ext.end(), ext.begin(), lower);
+        return ext;
+    };
+
+    for (const auto &[ext, enabled] : supported_file_types)
+    {
+        if (enabled)
+        {
+            enabled_file_types_.push_back(ext);
+            entries[key(ext)].supported = true;
+        }
+    }
+    for (const auto &[ext, enabled] : transcoding_file_types)
+    {
+        if (enabled)
+            entries[key(ext)].needs_transcoding = true;
+    }
+
+    // First category wins, matching the image/video/audio order of MediaProcessor::getMediaType
+    auto assign = [&](const std::vector<std::string> &exts, const char *media_type)
+    {
+        for (const auto &ext : exts)
+        {
+            auto &info = entries[key(ext)];
+            if (!*info.media_type)
+                info.media_type = media_type;
+        }
+    };
+    assign(image_extensions_, "image");
+    assign(video_extensions_, "video");
+    assign(audio_extensions_, "audio");
+
+    // Scan-time classification covers disabled types too, so enabling one later needs no rewrite
+    for (const auto &[ext, media_type] : media_types_by_extension_)
+    {
+        auto &info = entries[key(ext)];
+        if (media_type == "image")
+            info.category = "image";
+        else if (media_type == "video")
+            info.category = "video";
+        else if (media_type == "audio")
+            info.category = "audio";
+    }
+
+    buildTable(entries);
+}
+
+uint32_t ConfigSnapshot::hash(std::string_view key, uint32_t seed)
+{
+    // FNV-1a over the lowercased key with a final mix; the seed picks a collision-free variant
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : key)
+    {
+        h ^= static_cast<unsigned char>(lower(c));
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+void ConfigSnapshot::buildTable(const std::map<std::string, ExtensionInfo> &entries)
+{
+    entries_.clear();
+    for (const auto &[ext, info] : entries)
+    {
+        entries_.push_back({ext, info});
+        longest_key_ = std::max(longest_key_, ext.size());
+    }
+
+    size_t size = 8;
+    while (size < entries_.size() * 2)
+        size *= 2;
+
+    while (true)
+    {
+        for (uint32_t seed = 0; seed < SEEDS_PER_SIZE; ++seed)
+        {
+            std::vector<uint16_t> table(size, 0);
+            bool collision = false;
+            for (size_t i = 0; i < entries_.size() && !collision; ++i)
+            {
+                auto &slot = table[hash(entries_[i].key, seed) & (size - 1)];
+                collision = slot != 0;
+                slot = static_cast<uint16_t>(i + 1);
+            }
+            if (!collision)
+            {
+                table_ = std::move(table);
+                seed_ = seed;
+                return;
+            }
+        }
+        size *= 2;
+    }
+}
+
+const ConfigSnapshot::ExtensionInfo &ConfigSnapshot::extension(std::string_view ext) const
+{
+    if (ext.empty() || ext.size() > longest_key_)
+        return none_;
+
+    uint16_t slot = table_[hash(ext, seed_) & (table_.size() - 1)];
+    if (slot == 0)
+        return none_;
+
+    const Entry &entry = entries_[slot - 1];
+    if (entry.key.size() != ext.size())
+        return none_;
+    for (size_t i = 0; i < ext.size(); ++i)
+    {
+        if (lower(ext[i]) != entry.key[i])
+            return none_;
+    }
+    return entry.info;
+}
+
+const ConfigSnapshot::ExtensionInfo &ConfigSnapshot::extensionOfPath(std::string_view path) const
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string_view::npos)
+        return none_;
+    return extension(path.substr(dot + 1));
+}
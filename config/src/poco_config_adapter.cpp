@@ -58,6 +58,8 @@ PocoConfigAdapter::PocoConfigAdapter()
             Logger::info("Created new config.json with default values");
         }
     }
+
+    rebuildSnapshot();
 }
 
 // Configuration getters - delegate to PocoConfigManager
@@ -71,10 +73,49 @@ PocoConfigAdapter::~PocoConfigAdapter()
     stopWatching();
 }
 
-// Configuration getters - delegate to PocoConfigManager
+std::shared_ptr<const ConfigSnapshot> PocoConfigAdapter::snapshot() const
+{
+    // Only the first call after a change pays for the (locked) shared_ptr load
+    thread_local uint64_t cached_version = 0;
+    thread_local std::shared_ptr<const ConfigSnapshot> cached;
+    uint64_t version = snapshot_version_.load(std::memory_order_acquire);
+    if (version != cached_version || !cached)
+    {
+        cached = std::atomic_load(&snapshot_);
+        cached_version = version;
+    }
+    return cached;
+}
+
+void PocoConfigAdapter::rebuildSnapshot()
+{
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    std::array<ConfigSnapshot::VideoParams, 3> video_params;
+    for (DedupMode mode : {DedupMode::FAST, DedupMode::BALANCED, DedupMode::QUALITY})
+    {
+        auto &params = video_params[static_cast<size_t>(mode)];
+        params.skip_duration_seconds = poco_cfg_.getVideoSkipDurationSeconds(mode);
+        params.frames_per_skip = poco_cfg_.getVideoFramesPerSkip(mode);
+        params.skip_count = poco_cfg_.getVideoSkipCount(mode);
+    }
+
+    auto snapshot = std::make_shared<const ConfigSnapshot>(
+        poco_cfg_.getDedupMode(),
+        poco_cfg_.getSupportedFileTypes(),
+        poco_cfg_.getTranscodingFileTypes(),
+        poco_cfg_.getEnabledImageExtensions(),
+        poco_cfg_.getEnabledVideoExtensions(),
+        poco_cfg_.getEnabledAudioExtensions(),
+        poco_cfg_.getMediaTypesByExtension(),
+        video_params);
+    std::atomic_store(&snapshot_, std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
+    snapshot_version_.fetch_add(1, std::memory_order_release);
+}
+
+// Configuration getters - delegate to PocoConfigManager (per-file ones are served from the snapshot)
 DedupMode PocoConfigAdapter::getDedupMode() const
 {
-    return poco_cfg_.getDedupMode();
+    return snapshot()->dedupMode();
 }
 
 std::string PocoConfigAdapter::getLogLevel() const
@@ -102,6 +143,21 @@ int PocoConfigAdapter::getScanIntervalSeconds() const
     return poco_cfg_.getScanIntervalSeconds();
 }
 
+int PocoConfigAdapter::getFullWalkIntervalScans() const
+{
+    return poco_cfg_.getFullWalkIntervalScans();
+}
+
+bool PocoConfigAdapter::getWatchEnabled() const
+{
+    return poco_cfg_.getWatchEnabled();
+}
+
+int PocoConfigAdapter::getWatchDebounceMs() const
+{
+    return poco_cfg_.getWatchDebounceMs();
+}
+
 int PocoConfigAdapter::getProcessingIntervalSeconds() const
 {
     return poco_cfg_.getProcessingIntervalSeconds();
@@ -118,6 +174,36 @@ int PocoConfigAdapter::getMaxScanThreads() const
     return poco_cfg_.getMaxScanThreads();
 }
 
+int PocoConfigAdapter::getMaxScanRootsPerMount() const
+{
+    return poco_cfg_.getMaxScanRootsPerMount();
+}
+
+int PocoConfigAdapter::getMountMaxConcurrentIo() const
+{
+    return poco_cfg_.getMountMaxConcurrentIo();
+}
+
+int PocoConfigAdapter::getMountBandwidthMBPerSecond() const
+{
+    return poco_cfg_.getMountBandwidthMBPerSecond();
+}
+
+int PocoConfigAdapter::getMountLatencyThresholdMs() const
+{
+    return poco_cfg_.getMountLatencyThresholdMs();
+}
+
+int PocoConfigAdapter::getMountAcquireTimeoutSeconds() const
+{
+    return poco_cfg_.getMountAcquireTimeoutSeconds();
+}
+
+int PocoConfigAdapter::getMountBreakerTimeoutSeconds() const
+{
+    return poco_cfg_.getMountBreakerTimeoutSeconds();
+}
+
 int PocoConfigAdapter::getDatabaseThreads() const
 {
     return poco_cfg_.getDatabaseThreads();
@@ -129,6 +215,16 @@ int PocoConfigAdapter::getProcessingBatchSize() const
     return poco_cfg_.getProcessingBatchSize();
 }
 
+int PocoConfigAdapter::getProcessingClaimLeaseSeconds() const
+{
+    return poco_cfg_.getProcessingClaimLeaseSeconds();
+}
+
+int PocoConfigAdapter::getProcessingMemoryBudgetMB() const
+{
+    return poco_cfg_.getProcessingMemoryBudgetMB();
+}
+
 // File type configuration getters
 std::map<std::string, bool> PocoConfigAdapter::getSupportedFileTypes() const
 {
@@ -143,28 +239,33 @@ std::map<std::string, bool> PocoConfigAdapter::getTranscodingFileTypes() const
 // File type utility methods
 std::vector<std::string> PocoConfigAdapter::getEnabledFileTypes() const
 {
-    return poco_cfg_.getEnabledFileTypes();
+    return snapshot()->enabledFileTypes();
 }
 
 bool PocoConfigAdapter::needsTranscoding(const std::string &file_extension) const
 {
-    return poco_cfg_.needsTranscoding(file_extension);
+    return snapshot()->extension(file_extension).needs_transcoding;
 }
 
 // Category-specific enabled extensions
 std::vector<std::string> PocoConfigAdapter::getEnabledImageExtensions() const
 {
-    return poco_cfg_.getEnabledImageExtensions();
+    return snapshot()->imageExtensions();
 }
 
 std::vector<std::string> PocoConfigAdapter::getEnabledVideoExtensions() const
 {
-    return poco_cfg_.getEnabledVideoExtensions();
+    return snapshot()->videoExtensions();
 }
 
 std::vector<std::string> PocoConfigAdapter::getEnabledAudioExtensions() const
 {
-    return poco_cfg_.getEnabledAudioExtensions();
+    return snapshot()->audioExtensions();
+}
+
+std::map<std::string, std::string> PocoConfigAdapter::getMediaTypesByExtension() const
+{
+    return snapshot()->mediaTypesByExtension();
 }
 
 // Cache configuration getters
@@ -173,6 +274,31 @@ uint32_t PocoConfigAdapter::getDecoderCacheSizeMB() const
     return poco_cfg_.getDecoderCacheSizeMB();
 }
 
+int PocoConfigAdapter::getTranscodeMaxEdgePx() const
+{
+    return poco_cfg_.getTranscodeMaxEdgePx();
+}
+
+bool PocoConfigAdapter::getWriteRawTranscodes() const
+{
+    return poco_cfg_.getWriteRawTranscodes();
+}
+
+int PocoConfigAdapter::getRawHandoffMB() const
+{
+    return poco_cfg_.getRawHandoffMB();
+}
+
+std::string PocoConfigAdapter::getThumbnailStoreDir() const
+{
+    return poco_cfg_.getThumbnailStoreDir();
+}
+
+int PocoConfigAdapter::getThumbnailStoreMaxMB() const
+{
+    return poco_cfg_.getThumbnailStoreMaxMB();
+}
+
 // Decoder configuration getters
 int PocoConfigAdapter::getMaxDecoderThreads() const
 {
@@ -214,17 +340,17 @@ bool PocoConfigAdapter::getPreProcessQualityStack() const
 // Video processing configuration accessors
 int PocoConfigAdapter::getVideoSkipDurationSeconds(DedupMode mode) const
 {
-    return poco_cfg_.getVideoSkipDurationSeconds(mode);
+    return snapshot()->videoParams(mode).skip_duration_seconds;
 }
 
 int PocoConfigAdapter::getVideoFramesPerSkip(DedupMode mode) const
 {
-    return poco_cfg_.getVideoFramesPerSkip(mode);
+    return snapshot()->videoParams(mode).frames_per_skip;
 }
 
 int PocoConfigAdapter::getVideoSkipCount(DedupMode mode) const
 {
-    return poco_cfg_.getVideoSkipCount(mode);
+    return snapshot()->videoParams(mode).skip_count;
 }
 
 // Configuration setters with event publishing
@@ -787,6 +913,7 @@ bool PocoConfigAdapter::loadConfig(const std::string &file_path)
         if (poco_cfg_.load(file_path))
         {
             Logger::info("Loaded configuration from " + file_path);
+            rebuildSnapshot();
             // Migrate to JSON
             if (poco_cfg_.save("config.json"))
             {
@@ -810,6 +937,7 @@ bool PocoConfigAdapter::loadConfig(const std::string &file_path)
         if (poco_cfg_.load(path))
         {
             Logger::info("Loaded configuration from " + path);
+            rebuildSnapshot();
             return true;
         }
     }
@@ -937,6 +1065,7 @@ std::string PocoConfigAdapter::getThreadingConfig() const
         nlohmann::json config = {
             {"max_processing_threads", poco_cfg_.getMaxProcessingThreads()},
             {"max_scan_threads", poco_cfg_.getMaxScanThreads()},
+            {"max_scan_roots_per_mount", poco_cfg_.getMaxScanRootsPerMount()},
             {"database_threads", poco_cfg_.getDatabaseThreads()}};
         return config.dump();
     }
@@ -1004,6 +1133,9 @@ std::string PocoConfigAdapter::getScanningConfig() const
     {
         nlohmann::json config = {
             {"scan_interval_seconds", poco_cfg_.getScanIntervalSeconds()},
+            {"full_walk_interval_scans", poco_cfg_.getFullWalkIntervalScans()},
+            {"watch_enabled", poco_cfg_.getWatchEnabled()},
+            {"watch_debounce_ms", poco_cfg_.getWatchDebounceMs()},
             {"max_scan_threads", poco_cfg_.getMaxScanThreads()}};
         return config.dump();
     }
@@ -1032,6 +1164,9 @@ std::string PocoConfigAdapter::getLoggingConfig() const
 // Internal methods
 void PocoConfigAdapter::publishEvent(const ConfigUpdateEvent &event)
 {
+    // Observers read the new values through the snapshot
+    rebuildSnapshot();
+
     std::lock_guard<std::mutex> lock(observers_mutex_);
 
     // Log to stdout for immediate visibility
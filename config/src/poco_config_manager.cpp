@@ -136,6 +136,21 @@ int PocoConfigManager::getScanIntervalSeconds() const
     return getInt("scan_interval_seconds", 3600);
 }
 
+int PocoConfigManager::getFullWalkIntervalScans() const
+{
+    return getInt("scanning.full_walk_interval_scans", 24);
+}
+
+bool PocoConfigManager::getWatchEnabled() const
+{
+    return getBool("scanning.watch_enabled", false);
+}
+
+int PocoConfigManager::getWatchDebounceMs() const
+{
+    return getInt("scanning.watch_debounce_ms", 2000);
+}
+
 int PocoConfigManager::getProcessingIntervalSeconds() const
 {
     return getInt("processing_interval_seconds", 1800);
@@ -152,6 +167,37 @@ int PocoConfigManager::getMaxScanThreads() const
     return getInt("threading.max_scan_threads", 4);
 }
 
+int PocoConfigManager::getMaxScanRootsPerMount() const
+{
+    return getInt("threading.max_scan_roots_per_mount", 1);
+}
+
+// Network mount I/O limits (see MountThrottle)
+int PocoConfigManager::getMountMaxConcurrentIo() const
+{
+    return getInt("network_mounts.max_concurrent_io", 4);
+}
+
+int PocoConfigManager::getMountBandwidthMBPerSecond() const
+{
+    return getInt("network_mounts.bandwidth_mb_per_second", 0);
+}
+
+int PocoConfigManager::getMountLatencyThresholdMs() const
+{
+    return getInt("network_mounts.latency_threshold_ms", 5000);
+}
+
+int PocoConfigManager::getMountAcquireTimeoutSeconds() const
+{
+    return getInt("network_mounts.acquire_timeout_seconds", 30);
+}
+
+int PocoConfigManager::getMountBreakerTimeoutSeconds() const
+{
+    return getInt("network_mounts.breaker_timeout_seconds", 60);
+}
+
 int PocoConfigManager::getDatabaseThreads() const
 {
     return getInt("threading.database_threads", 2);
@@ -168,6 +214,16 @@ int PocoConfigManager::getProcessingBatchSize() const
     return getInt("processing.batch_size", 100);
 }
 
+int PocoConfigManager::getProcessingClaimLeaseSeconds() const
+{
+    return getInt("processing.claim_lease_seconds", 900);
+}
+
+int PocoConfigManager::getProcessingMemoryBudgetMB() const
+{
+    return getInt("processing.memory_budget_mb", 0);
+}
+
 bool PocoConfigManager::getPreProcessQualityStack() const
 {
     return getBool("pre_process_quality_stack", false);
@@ -205,6 +261,36 @@ uint32_t PocoConfigManager::getDecoderCacheSizeMB() const
     return getUInt32("cache.decoder_cache_size_mb", 1024);
 }
 
+// Longest edge of RAW transcode output in pixels, 0 = full resolution
+int PocoConfigManager::getTranscodeMaxEdgePx() const
+{
+    return getInt("cache.transcode_max_edge_px", 1024);
+}
+
+// Whether decoded RAW proxies are also written to the cache directory
+bool PocoConfigManager::getWriteRawTranscodes() const
+{
+    return getBool("cache.write_raw_transcodes", true);
+}
+
+// Memory for decoded RAW proxies waiting to be fingerprinted
+int PocoConfigManager::getRawHandoffMB() const
+{
+    return getInt("cache.raw_handoff_mb", 256);
+}
+
+// Directory of the packed canonical thumbnail store, empty = disabled
+std::string PocoConfigManager::getThumbnailStoreDir() const
+{
+    return getString("cache.thumbnail_store_dir", "");
+}
+
+// Disk the thumbnail store may use before it compacts and drops its oldest records, 0 = unlimited
+int PocoConfigManager::getThumbnailStoreMaxMB() const
+{
+    return getInt("cache.thumbnail_store_max_mb", 4096);
+}
+
 // File type configuration getters
 std::map<std::string, bool> PocoConfigManager::getSupportedFileTypes() const
 {
@@ -287,6 +373,26 @@ std::vector<std::string> PocoConfigManager::getEnabledAudioExtensions() const
     return getEnabledExtensionsForCategory("audio");
 }
 
+// "image", "video" or "audio" for every extension listed in those categories, enabled or not
+std::map<std::string, std::string> PocoConfigManager::getMediaTypesByExtension() const
+{
+    std::map<std::string, std::string> media_types;
+    const std::pair<const char *, const char *> categories[] = {{"images", "image"}, {"video", "video"}, {"audio", "audio"}};
+    for (const auto &[category, media_type] : categories)
+    {
+        auto category_config = getNestedConfig(std::string("categories.") + category);
+        if (!category_config.is_object())
+            continue;
+        for (auto it = category_config.begin(); it != category_config.end(); ++it)
+        {
+            // First category wins, as for the enabled lists
+            if (it.value().is_boolean())
+                media_types.emplace(it.key(), media_type);
+        }
+    }
+    return media_types;
+}
+
 bool PocoConfigManager::needsTranscoding(const std::string &file_extension) const
 {
     std::string ext = file_extension;
@@ -365,6 +471,13 @@ bool PocoConfigManager::validateProcessingConfig() const
         return false;
     }
 
+    int lease_seconds = getProcessingClaimLeaseSeconds();
+    if (lease_seconds <= 0)
+    {
+        Logger::error("Invalid processing claim lease: " + std::to_string(lease_seconds));
+        return false;
+    }
+
     return true;
 }
 
@@ -378,6 +491,24 @@ bool PocoConfigManager::validateCacheConfig() const
         return false;
     }
 
+    if (getTranscodeMaxEdgePx() < 0)
+    {
+        Logger::error("Invalid transcode max edge: " + std::to_string(getTranscodeMaxEdgePx()));
+        return false;
+    }
+
+    if (getRawHandoffMB() < 0)
+    {
+        Logger::error("Invalid RAW handoff size: " + std::to_string(getRawHandoffMB()));
+        return false;
+    }
+
+    if (getThumbnailStoreMaxMB() < 0)
+    {
+        Logger::error("Invalid thumbnail store size: " + std::to_string(getThumbnailStoreMaxMB()));
+        return false;
+    }
+
     return true;
 }
 
@@ -389,6 +520,8 @@ nlohmann::json PocoConfigManager::getProcessingConfig() const
     processing_config["max_scan_threads"] = getMaxScanThreads();
     processing_config["max_decoder_threads"] = getMaxDecoderThreads();
     processing_config["batch_size"] = getProcessingBatchSize();
+    processing_config["claim_lease_seconds"] = getProcessingClaimLeaseSeconds();
+    processing_config["memory_budget_mb"] = getProcessingMemoryBudgetMB();
     processing_config["dedup_mode"] = getString("dedup_mode");
     processing_config["pre_process_quality_stack"] = getPreProcessQualityStack();
     return processing_config;
@@ -398,6 +531,11 @@ nlohmann::json PocoConfigManager::getCacheConfig() const
 {
     nlohmann::json cache_config;
     cache_config["decoder_cache_size_mb"] = getDecoderCacheSizeMB();
+    cache_config["transcode_max_edge_px"] = getTranscodeMaxEdgePx();
+    cache_config["write_raw_transcodes"] = getWriteRawTranscodes();
+    cache_config["raw_handoff_mb"] = getRawHandoffMB();
+    cache_config["thumbnail_store_dir"] = getThumbnailStoreDir();
+    cache_config["thumbnail_store_max_mb"] = getThumbnailStoreMaxMB();
 
     // Add cache cleanup settings
     cache_config["cache_cleanup"] = {
@@ -422,12 +560,23 @@ void PocoConfigManager::initializeDefaultConfig()
     cfg_->setInt("server_port", 8080);
     cfg_->setString("server_host", "localhost");
     cfg_->setInt("scan_interval_seconds", 3600);
+    cfg_->setInt("scanning.full_walk_interval_scans", 24);
+    cfg_->setBool("scanning.watch_enabled", false);
+    cfg_->setInt("scanning.watch_debounce_ms", 2000);
     cfg_->setInt("processing_interval_seconds", 1800);
     cfg_->setBool("pre_process_quality_stack", false);
 
     // Threading defaults
     cfg_->setInt("threading.max_processing_threads", 8);
     cfg_->setInt("threading.max_scan_threads", 4);
+    cfg_->setInt("threading.max_scan_roots_per_mount", 1);
+
+    // Network mount I/O defaults
+    cfg_->setInt("network_mounts.max_concurrent_io", 4);
+    cfg_->setInt("network_mounts.bandwidth_mb_per_second", 0);
+    cfg_->setInt("network_mounts.latency_threshold_ms", 5000);
+    cfg_->setInt("network_mounts.acquire_timeout_seconds", 30);
+    cfg_->setInt("network_mounts.breaker_timeout_seconds", 60);
 
     cfg_->setInt("threading.database_threads", 2);
     cfg_->setInt("threading.max_decoder_threads", 4);
@@ -441,9 +590,16 @@ void PocoConfigManager::initializeDefaultConfig()
 
     // Cache defaults
     cfg_->setUInt("cache.decoder_cache_size_mb", 1024);
+    cfg_->setInt("cache.transcode_max_edge_px", 1024);
+    cfg_->setBool("cache.write_raw_transcodes", true);
+    cfg_->setInt("cache.raw_handoff_mb", 256);
+    cfg_->setString("cache.thumbnail_store_dir", "");
+    cfg_->setInt("cache.thumbnail_store_max_mb", 4096);
 
     // Processing defaults
     cfg_->setInt("processing.batch_size", 100);
+    cfg_->setInt("processing.claim_lease_seconds", 900);
+    cfg_->setInt("processing.memory_budget_mb", 0);
 
     // Cache cleanup defaults
     cfg_->setInt("cache_cleanup.fully_processed_age_days", 7);
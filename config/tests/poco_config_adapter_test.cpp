@@ -215,6 +215,33 @@ TEST_F(PocoConfigAdapterTest, TranscodingNeeds)
     EXPECT_FALSE(config.needsTranscoding("png"));
 }
 
+// Test per-file lookups through the configuration snapshot
+TEST_F(PocoConfigAdapterTest, SnapshotLookups)
+{
+    auto &config = PocoConfigAdapter::getInstance();
+    auto snapshot = config.snapshot();
+    ASSERT_NE(snapshot, nullptr);
+
+    EXPECT_STREQ(snapshot->extensionOfPath("/photos/a.JPG").media_type, "image");
+    EXPECT_TRUE(snapshot->extensionOfPath("/photos/a.JPG").supported);
+    EXPECT_STREQ(snapshot->extensionOfPath("/videos/b.mov").media_type, "video");
+    EXPECT_TRUE(snapshot->extensionOfPath("/music/c.mp3").needs_transcoding);
+    EXPECT_FALSE(snapshot->extensionOfPath("/videos/d.avi").supported);
+    EXPECT_FALSE(snapshot->extensionOfPath("/docs/readme").supported);
+    EXPECT_STREQ(snapshot->extensionOfPath("/docs/e.txt").media_type, "");
+
+    // Disabled types keep their category for scan-time classification
+    EXPECT_STREQ(snapshot->extensionOfPath("/videos/d.avi").media_type, "");
+    EXPECT_STREQ(snapshot->extensionOfPath("/videos/d.avi").category, "video");
+    EXPECT_STREQ(snapshot->extensionOfPath("/docs/e.txt").category, "");
+    EXPECT_EQ(config.getMediaTypesByExtension()["avi"], "video");
+
+    // Setters publish a new snapshot; one taken earlier keeps its values
+    config.setDedupMode(DedupMode::QUALITY);
+    EXPECT_EQ(config.snapshot()->dedupMode(), DedupMode::QUALITY);
+    EXPECT_EQ(snapshot->dedupMode(), DedupMode::FAST);
+}
+
 // Test configuration setters
 TEST_F(PocoConfigAdapterTest, ConfigurationSetters)
 {
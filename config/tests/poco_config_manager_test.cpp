@@ -199,6 +199,7 @@ TEST_F(PocoConfigManagerTest, ProcessingConfigurationGetters)
     EXPECT_TRUE(config.load(test_config_path_));
 
     EXPECT_EQ(config.getProcessingBatchSize(), 50);
+    EXPECT_EQ(config.getProcessingMemoryBudgetMB(), 0);
 }
 
 // Test file type configuration getters
@@ -306,6 +307,11 @@ TEST_F(PocoConfigManagerTest, ConfigurationSections)
 
     auto cache_config = config.getCacheConfig();
     EXPECT_EQ(cache_config["decoder_cache_size_mb"], 512);
+    EXPECT_EQ(cache_config["transcode_max_edge_px"], 1024);
+    EXPECT_EQ(cache_config["write_raw_transcodes"], true);
+    EXPECT_EQ(cache_config["raw_handoff_mb"], 256);
+    EXPECT_EQ(cache_config["thumbnail_store_dir"], "");
+    EXPECT_EQ(cache_config["thumbnail_store_max_mb"], 4096);
     EXPECT_EQ(cache_config["cache_cleanup"]["fully_processed_age_days"], 5);
     EXPECT_EQ(cache_config["cache_cleanup"]["cleanup_threshold_percent"], 75);
 }
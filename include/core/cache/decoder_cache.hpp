@@ -1,17 +1,77 @@
 #ifndef DECODER_CACHE_HPP
 #define DECODER_CACHE_HPP
 
+#include "config_observer.hpp"
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cv
+{
+    class Mat;
+}
 
 /**
- * @brief DecoderCache class for managing decoder cache configuration
+ * @brief Byte-budgeted LRU cache of small canonical decodes
+ *
+ * Holds the reduced pixels the fingerprinting algorithms start from (the 9x8 and 32x32 grayscale
+ * images behind dHash/pHash, the 224x224 colour image behind the CNN embedding, and the same per
+ * sampled video frame), so a retry, a dedup mode switch or a video sampling change can fingerprint
+ * a file again without reading and decoding the source media.
  *
- * This class provides access to decoder cache configuration settings.
- * Currently supports reading the cache size in megabytes.
+ * Entries are keyed by path plus the file's mtime and size, so a modified file never hits; stale
+ * entries simply age out. The cache is split into shards with their own lock and LRU list, each
+ * holding an equal share of decoder_cache_size_mb. Budget changes apply live; 0 disables caching.
  */
-class DecoderCache
+class DecoderCache : public ConfigObserver
 {
 public:
+    /**
+     * @brief Canonical representation stored for a file (or for one sampled video skip)
+     */
+    enum class Variant : uint8_t
+    {
+        GRAY_9X8,      // dHash input
+        GRAY_32X32,    // pHash input
+        COLOR_224,     // CNN input, before the BGR->RGB conversion
+        FRAME_DIGESTS, // video: one row of hex SHA-256 per valid frame of a skip (FAST/BALANCED)
+        FRAMES_224     // video: the 224x224 frames of a skip stacked vertically (QUALITY)
+    };
+
+    /**
+     * @brief Identity of a cached decode
+     */
+    struct Key
+    {
+        std::string path;
+        int64_t mtime_ns = 0;
+        uint64_t file_size = 0;
+        Variant variant = Variant::GRAY_9X8;
+        int64_t frame_pts = -1;  // video: seek target of the skip, -1 for images
+        int32_t frame_count = 0; // video: frames_per_skip the skip was sampled with
+
+        /**
+         * @brief Key for a file as it is on disk now
+         * @return Key with an empty path when the file cannot be stat'ed (never cached)
+         */
+        static Key forFile(const std::string &path, Variant variant);
+
+        Key withVariant(Variant other) const;
+        Key forSkip(Variant other, int64_t pts, int32_t frames) const;
+
+        bool operator==(const Key &other) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
     /**
      * @brief Get the singleton instance of DecoderCache
      * @return Reference to the DecoderCache instance
@@ -24,12 +84,62 @@ public:
      */
     uint32_t getCacheSizeMB() const;
 
+    /**
+     * @brief Change the budget; shards over their new share evict immediately
+     */
+    void setCacheSizeMB(uint32_t size_mb);
+
+    /**
+     * @brief Whether puts are kept at all (budget above zero)
+     */
+    bool enabled() const { return budget_bytes_.load() > 0; }
+
+    /**
+     * @brief Look up a decode and mark it most recently used
+     * @return The cached pixels, or null on a miss
+     */
+    std::shared_ptr<const cv::Mat> get(const Key &key);
+
+    /**
+     * @brief Store a decode, evicting least recently used entries of its shard as needed
+     *
+     * Ignored for keys without a path and for entries larger than a shard's share of the budget.
+     */
+    void put(const Key &key, std::shared_ptr<const cv::Mat> image);
+
+    /**
+     * @brief Drop every entry
+     */
+    void clear();
+
+    size_t bytesUsed() const;
+    size_t entryCount() const;
+
+    void onConfigUpdate(const ConfigUpdateEvent &event) override;
+
     /**
      * @brief Destructor
      */
     ~DecoderCache() = default;
 
 private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<const cv::Mat> image;
+        size_t bytes;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // most recently used at the front
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t bytes = 0;
+    };
+
     /**
      * @brief Private constructor for singleton pattern
      */
@@ -45,10 +155,19 @@ private:
      */
     DecoderCache &operator=(const DecoderCache &) = delete;
 
+    Shard &shardFor(const Key &key);
+    size_t shardBudget() const { return budget_bytes_.load() / SHARD_COUNT; }
+
+    // Caller holds shard.mutex
+    static void evictTo(Shard &shard, size_t budget);
+
     /**
      * @brief Cache size in megabytes
      */
-    uint32_t cache_size_mb_;
+    std::atomic<uint32_t> cache_size_mb_;
+    std::atomic<size_t> budget_bytes_;
+
+    std::array<Shard, SHARD_COUNT> shards_;
 };
 
-#endif // DECODER_CACHE_HPP
\ No newline at end of file
+#endif // DECODER_CACHE_HPP
@@ -0,0 +1,131 @@
+#ifndef THUMBNAIL_STORE_HPP
+#define THUMBNAIL_STORE_HPP
+
+#include "core/cache/decoder_cache.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Persistent store of canonical decodes in packed segment files
+ *
+ * Backs DecoderCache on local disk with the same keys and variants: the 9x8/32x32 grayscale and
+ * 224x224 colour image per picture, and per sampled video skip the frame digests and 224x224
+ * frames. A dedup mode switch, a retry after restart or a new hash algorithm run over forEach()
+ * then reads local segments instead of the network share and the decoders.
+ *
+ * Records are appended to segment_NNNNNN.thm files of up to items_per_segment records each and
+ * read back through read-only mmaps, mapped ahead of the file so appends rarely force a remap.
+ * The index is rebuilt at open() by walking the segments; the newest record of a
+ * path/variant/skip wins and a torn record at the end of the last segment (crash mid-append) is
+ * cut off. Each record carries a CRC-32 that is checked when it is read; a record that fails it
+ * is dropped and reads as a miss.
+ *
+ * With a byte cap, a store that outgrows it first compacts sealed segments that hold mostly
+ * superseded or dropped records (their current records move to the end), then drops the oldest
+ * segments with their records.
+ */
+class ThumbnailStore
+{
+public:
+    static constexpr size_t DEFAULT_ITEMS_PER_SEGMENT = 4096;
+
+    explicit ThumbnailStore(size_t items_per_segment = DEFAULT_ITEMS_PER_SEGMENT);
+    ~ThumbnailStore();
+
+    ThumbnailStore(const ThumbnailStore &) = delete;
+    ThumbnailStore &operator=(const ThumbnailStore &) = delete;
+
+    /**
+     * @brief Store used by media processing, opened from cache.thumbnail_store_dir at startup
+     */
+    static ThumbnailStore &getInstance();
+
+    /**
+     * @brief Open (creating if needed) the store in dir and index its segments
+     * @param max_bytes Disk the segments may use, 0 = unlimited
+     * @return false if the directory or a segment cannot be opened; the store stays closed
+     */
+    bool open(const std::string &dir, uint64_t max_bytes = 0);
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief Record stored for key's path, variant and skip, if it matches key's mtime and size
+     * and passes its CRC
+     */
+    std::shared_ptr<const cv::Mat> get(const DecoderCache::Key &key);
+
+    /**
+     * @brief Append a record (ignored while closed or for keys without a path)
+     */
+    bool put(const DecoderCache::Key &key, const cv::Mat &image);
+
+    /**
+     * @brief Visit the current record of every entry, segment by segment in file order
+     *
+     * The Mat points into the segment mapping and is only valid during the call. visit runs
+     * without the store's lock, so it may call get() and put().
+     */
+    void forEach(const std::function<void(const DecoderCache::Key &, const cv::Mat &)> &visit);
+
+    size_t entryCount() const;
+    size_t segmentCount() const;
+    uint64_t diskBytes() const;
+
+private:
+    // Read-only mmap of a segment, unmapped when the last reader lets go of it
+    struct Mapping;
+
+    struct Segment
+    {
+        std::string path;
+        uint32_t number = 0; // from the file name
+        int fd = -1;
+        std::shared_ptr<const Mapping> map;
+        size_t size = 0;       // bytes of complete records
+        size_t records = 0;
+        size_t live_bytes = 0; // of records the index still points at
+    };
+
+    struct Location
+    {
+        uint32_t segment; // number, not position: compaction removes segments
+        uint64_t offset;  // of the record header
+        uint64_t length;
+        int64_t mtime_ns;
+        uint64_t file_size;
+    };
+
+    // Key with the file version cleared: one slot per path/variant/skip
+    static DecoderCache::Key slotOf(const DecoderCache::Key &key);
+
+    // Drop the index entry of a record that failed its CRC, unless it was replaced meanwhile
+    void dropCorrupt(const DecoderCache::Key &key, uint32_t segment, uint64_t offset);
+
+    // Caller holds mutex_
+    void closeLocked();
+    bool openSegment(const std::string &path, uint32_t number, bool &stale);
+    void indexSegment(size_t position);
+    bool ensureMapped(Segment &segment, size_t end);
+    bool startSegment();
+    size_t positionOf(uint32_t number) const;
+    bool append(const uint8_t *record, size_t length, const DecoderCache::Key &key);
+    void enforceCap();
+    bool relocate(size_t position);
+    void dropSegment(size_t position);
+
+    const size_t items_per_segment_;
+    mutable std::mutex mutex_;
+    std::string dir_;
+    uint64_t max_bytes_ = 0;
+    uint64_t total_bytes_ = 0;      // of all segments
+    std::vector<Segment> segments_; // by number; last one is appended to
+    std::unordered_map<DecoderCache::Key, Location, DecoderCache::KeyHash> index_;
+};
+
+#endif // THUMBNAIL_STORE_HPP
@@ -0,0 +1,98 @@
+#ifndef FRAME_BUFFER_POOL_HPP
+#define FRAME_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+struct AVBufferPool;
+struct AVCodecContext;
+struct AVFrame;
+
+/**
+ * @brief Shared AVBufferPools for decoded video frames and conversion scratch frames
+ *
+ * A 4K stream decodes into ~12 MB frames and its RGB conversion target takes another ~24 MB.
+ * Left to FFmpeg's default allocator and av_frame_get_buffer, every file maps and unmaps those
+ * buffers afresh. Decoder contexts attached here take their frames from AVBufferPools keyed by
+ * pixel format and padded geometry, shared by every context and file, and the RGB scratch frames
+ * come from the same pools, so large buffers are recycled instead of faulted in again.
+ *
+ * A pool holds no more buffers than were in use at once for its geometry. Once more than
+ * MAX_POOLS geometries exist, the least recently used pool is released; its buffers return to
+ * the heap as the frames still holding them are freed.
+ */
+class FrameBufferPool
+{
+public:
+    static constexpr size_t MAX_POOLS = 16;
+
+    /**
+     * @brief Get the singleton instance of FrameBufferPool
+     * @return Reference to the FrameBufferPool instance
+     */
+    static FrameBufferPool &getInstance();
+
+    /**
+     * @brief Route a decoder's frame allocations through the pools; call before avcodec_open2
+     *
+     * Hardware frames and decoders without direct rendering support keep FFmpeg's allocator.
+     */
+    void attach(AVCodecContext *ctx);
+
+    /**
+     * @brief Pooled replacement for av_frame_get_buffer (frame format, width and height set)
+     * @return 0 on success, a negative AVERROR otherwise
+     */
+    int getBuffer(AVFrame *frame);
+
+    size_t poolCount() const;
+
+    /**
+     * @brief Destructor
+     */
+    ~FrameBufferPool();
+
+private:
+    // Pixel format, padded width, padded height
+    using PoolKey = std::tuple<int, int, int>;
+
+    struct Pool
+    {
+        AVBufferPool *pool;
+        uint64_t last_used;
+    };
+
+    /**
+     * @brief Private constructor for singleton pattern
+     */
+    FrameBufferPool() = default;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    FrameBufferPool(const FrameBufferPool &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    FrameBufferPool &operator=(const FrameBufferPool &) = delete;
+
+    // AVCodecContext::get_buffer2 callback; may be called from frame-threading workers
+    static int decoderGetBuffer(AVCodecContext *ctx, AVFrame *frame, int flags);
+
+    // Give frame one pooled buffer holding all planes of a width x height image, every line size
+    // a multiple of stride_align
+    int allocate(AVFrame *frame, int width, int height, int stride_align);
+
+    // Caller holds mutex_
+    void evictLeastRecentlyUsed();
+
+    mutable std::mutex mutex_;
+    std::map<PoolKey, Pool> pools_;
+    uint64_t use_counter_ = 0;
+};
+
+#endif // FRAME_BUFFER_POOL_HPP
@@ -84,7 +84,7 @@ public:
     private:
         std::atomic<bool> is_open_{false};
         std::atomic<int> failure_count_{0};
-        std::chrono::steady_clock::time_point last_failure_time_;
+        std::atomic<std::chrono::steady_clock::rep> last_failure_time_{0};
         const int failure_threshold_;
         const std::chrono::seconds timeout_;
         std::string operation_name_;
@@ -96,46 +96,78 @@ public:
         template <typename Func, typename... Args>
         auto call(Func func, Args &&...args) -> decltype(func(std::forward<Args>(args)...))
         {
-            if (is_open_.load())
+            if (!allowRequest())
             {
-                if (std::chrono::steady_clock::now() - last_failure_time_ > timeout_)
-                {
-                    is_open_.store(false);
-                    failure_count_.store(0);
-                    Logger::info("Circuit breaker closed for operation '" + operation_name_ +
-                                 "', retrying external library calls");
-                }
-                else
-                {
-                    throw std::runtime_error("Circuit breaker is open for operation '" + operation_name_ +
-                                             "' - external library calls are blocked");
-                }
+                throw std::runtime_error("Circuit breaker is open for operation '" + operation_name_ +
+                                         "' - external library calls are blocked");
             }
 
             try
             {
                 auto result = func(std::forward<Args>(args)...);
-                failure_count_.store(0);
+                recordSuccess();
                 return result;
             }
             catch (...)
             {
-                failure_count_.fetch_add(1);
-                if (failure_count_.load() >= failure_threshold_)
-                {
-                    is_open_.store(true);
-                    last_failure_time_ = std::chrono::steady_clock::now();
-                    Logger::error("Circuit breaker opened for operation '" + operation_name_ +
-                                  "' due to repeated failures");
-                }
+                recordFailure();
                 throw;
             }
         }
 
+        // Non-throwing form for callers that report outcomes apart from the call itself.
+        // Returns false while open; once the timeout has passed the breaker closes again.
+        bool allowRequest()
+        {
+            if (!is_open_.load())
+                return true;
+
+            auto opened_at = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_failure_time_.load()));
+            if (std::chrono::steady_clock::now() - opened_at <= timeout_)
+                return false;
+
+            bool expected = true;
+            if (is_open_.compare_exchange_strong(expected, false))
+            {
+                failure_count_.store(0);
+                Logger::info("Circuit breaker closed for operation '" + operation_name_ +
+                             "', retrying external library calls");
+            }
+            return true;
+        }
+
+        void recordSuccess()
+        {
+            failure_count_.store(0);
+        }
+
+        void recordFailure()
+        {
+            if (failure_count_.fetch_add(1) + 1 < failure_threshold_)
+                return;
+
+            last_failure_time_.store(std::chrono::steady_clock::now().time_since_epoch().count());
+            bool expected = false;
+            if (is_open_.compare_exchange_strong(expected, true))
+            {
+                Logger::error("Circuit breaker opened for operation '" + operation_name_ +
+                              "' due to repeated failures");
+            }
+        }
+
         bool isOpen() const
         {
             return is_open_.load();
         }
+
+        // Whether allowRequest() would return false right now, without closing an expired breaker
+        bool rejectsRequests() const
+        {
+            if (!is_open_.load())
+                return false;
+            auto opened_at = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_failure_time_.load()));
+            return std::chrono::steady_clock::now() - opened_at <= timeout_;
+        }
         int getFailureCount() const
         {
             return failure_count_.load();
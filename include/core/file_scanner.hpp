@@ -5,8 +5,17 @@
 #include "core/file_utils.hpp"
 #include "logging/logger.hpp"
 #include <string>
+#include <vector>
 #include <functional>
 
+// Totals of a FileScanner::scanRoots run
+struct MultiRootScanResult
+{
+    size_t files_stored = 0;
+    size_t successful_scans = 0;
+    size_t failed_scans = 0;
+};
+
 class FileScanner
 {
 public:
@@ -16,6 +25,28 @@ public:
     // Scan a directory and store only supported files in the database
     size_t scanDirectory(const std::string &dir_path, bool recursive = false);
 
+    // Recursive scan that skips subtrees whose directory mtime is unchanged since the last
+    // scan of this root. full_walk lists every directory (the periodic safety net for files
+    // edited in place); both modes refresh the stored directory manifest. Walked files are
+    // diffed in memory against the root's stored stats and written in batched transactions;
+    // stored files missing from a listed directory are deleted. A full walk stamps every file it
+    // finds with a new scan generation and sweeps the unstamped rest of the root instead.
+    size_t scanDirectoryIncremental(const std::string &dir_path, bool full_walk);
+
+    // Scan several roots concurrently (one FileScanner each), at most max_threads roots at once
+    // and at most per_mount_limit roots on the same device or network server, so roots sharing
+    // a disk or NAS are not walked against each other. All walks list directories through one
+    // budget of max_threads, so the threads of a finished root go to those still walking.
+    // Progress is logged as each root completes. Stops picking up roots once shutdown is requested.
+    static MultiRootScanResult scanRoots(const std::string &db_path, const std::vector<std::string> &roots,
+                                         bool full_walk, size_t max_threads, size_t per_mount_limit);
+
+    // Directory walker threads for recursive scans (0 = max_scan_threads from config)
+    void setWalkerThreads(size_t threads) { walker_threads_ = threads; }
+
+    // Listings budget shared with concurrent scanners (nullptr = walker threads only)
+    void setThreadBudget(ScanThreadBudget *budget) { thread_budget_ = budget; }
+
     // Scan a single file and store it if supported
     bool scanFile(const std::string &file_path);
 
@@ -32,7 +63,15 @@ private:
     size_t files_scanned_;
     size_t files_stored_;
     size_t files_skipped_;
+    size_t walker_threads_ = 0;
+    ScanThreadBudget *thread_budget_ = nullptr;
 
     // Handle individual file during scanning
-    void handleFile(const std::string &file_path);
+    void handleFile(const FileMetadata &metadata);
+
+    // Hand a stored RAW file to the transcoder right away instead of waiting for the processing pass
+    void queueRawFile(const std::string &file_path);
+
+    // Hand RAW files that a diff inserted or changed to the transcoder
+    void queueRawFiles(const ScanDiff &diff);
 };
\ No newline at end of file
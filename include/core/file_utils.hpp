@@ -7,9 +7,15 @@
 #include <memory>
 #include <optional>
 #include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
+struct stat;
+
 // Forward declarations
 template <typename T>
 class SimpleObservable;
@@ -57,8 +63,8 @@ struct FileMetadata
     std::time_t modification_time; // Last modification time
     std::time_t creation_time;     // Creation time
     uint64_t file_size;            // File size in bytes
-    uint32_t inode;                // Inode number (for hard link detection)
-    uint32_t device_id;            // Device ID (for mount point changes)
+    uint64_t inode;                // Inode number (for hard link detection)
+    uint64_t device_id;            // Device ID (for mount point changes)
 
     // Comparison operators for change detection
     bool operator==(const FileMetadata &other) const;
@@ -68,6 +74,58 @@ struct FileMetadata
     std::string toString() const;
 };
 
+/**
+ * @brief Per-directory state kept between scans so unchanged subtrees can be skipped
+ *
+ * A directory's mtime only moves when entries are added, removed or renamed in it, so an
+ * unchanged mtime means its file list (and its set of subdirectories) is the same as last time.
+ * In-place edits of existing files do not touch it, which is why full walks still run periodically.
+ */
+struct DirectoryManifestEntry
+{
+    std::string dir_path;
+    std::string parent_path;
+    int64_t mtime_ns;   // Directory mtime in nanoseconds
+    bool listed = true; // False when this walk reused the entry instead of reading the directory
+};
+
+using DirectoryManifest = std::unordered_map<std::string, DirectoryManifestEntry>;
+
+/**
+ * @brief Directory listings allowed at once across several concurrent walks
+ *
+ * Walks that share a budget may each run as many threads as the whole budget, but only that
+ * many of their listings run at a time. A walk that finishes early thereby hands its share to
+ * the walks still running instead of leaving it idle.
+ */
+class ScanThreadBudget
+{
+public:
+    explicit ScanThreadBudget(size_t slots) : free_(slots > 0 ? slots : 1) {}
+
+    void acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]
+                 { return free_ > 0; });
+        --free_;
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++free_;
+        }
+        cv_.notify_one();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t free_;
+};
+
 /**
  * @brief File utilities for efficient file operations
  */
@@ -81,6 +139,23 @@ public:
      */
     static std::optional<FileMetadata> getFileMetadata(const std::string &file_path);
 
+    /**
+     * @brief Build FileMetadata from an existing stat result (real inode and device id)
+     * @param file_path Path the stat result belongs to
+     * @param st Result of stat/fstatat for that path
+     */
+    static FileMetadata metadataFromStat(const std::string &file_path, const struct stat &st);
+
+    /**
+     * @brief Whether metadata recorded by an older Linux build describes the file as it is now
+     *
+     * Those builds stored inode and device as 0 and the mtime as std::filesystem::file_time_type
+     * ticks. The file is unchanged if its size matches and that mtime, converted to Unix time,
+     * matches to the second; its metadata can then be refreshed in place instead of reprocessing it.
+     */
+    static bool isLegacyMetadataOf(int64_t legacy_mtime, uint64_t legacy_size, uint64_t legacy_inode,
+                                   uint64_t legacy_device_id, const FileMetadata &current);
+
     /**
      * @brief Check if file has changed based on metadata comparison
      * @param file_path Path to the file
@@ -107,9 +182,21 @@ public:
      * Lists all files in a directory as a simple observable stream
      * @param dir_path Directory path to scan
      * @param recursive Whether to scan recursively
+     * @param max_threads Directory-listing threads for recursive scans
      * @return SimpleObservable that emits file paths
      */
-    static SimpleObservable<std::string> listFilesAsObservable(const std::string &dir_path, bool recursive = false);
+    static SimpleObservable<std::string> listFilesAsObservable(const std::string &dir_path, bool recursive = false, size_t max_threads = 1);
+
+    /**
+     * Lists all files in a directory together with their stat metadata
+     * Recursive listings stat each file once during the walk (fstatat on the open
+     * directory fd on Linux), so callers can hand the metadata straight to storage.
+     * @param dir_path Directory path to scan
+     * @param recursive Whether to scan recursively
+     * @param max_threads Directory-listing threads for recursive scans
+     * @return SimpleObservable that emits FileMetadata (file_path is always set)
+     */
+    static SimpleObservable<FileMetadata> listFilesWithMetadataAsObservable(const std::string &dir_path, bool recursive = false, size_t max_threads = 1);
 
     /**
      * Scans a directory recursively and calls the provided function for each file
@@ -118,6 +205,41 @@ public:
      */
     static void scanDirectoryRecursively(const std::string &dir_path, std::function<void(const std::string &)> onNext);
 
+    /**
+     * Scans a directory recursively with up to max_threads walker threads
+     * On Linux subdirectories are listed in parallel on a work-stealing pool; onNext is
+     * still called serially on the calling thread, in no particular order.
+     * @param dir_path Directory path to scan
+     * @param onNext Function to call for each file found
+     * @param max_threads Maximum number of directory-listing threads
+     */
+    static void scanDirectoryRecursively(const std::string &dir_path, std::function<void(const std::string &)> onNext, size_t max_threads);
+
+    /**
+     * Scans a directory recursively and calls onNext with each file's metadata
+     * @param dir_path Directory path to scan
+     * @param onNext Function to call for each file found
+     * @param max_threads Maximum number of directory-listing threads
+     */
+    static void scanDirectoryWithMetadata(const std::string &dir_path, std::function<void(const FileMetadata &)> onNext, size_t max_threads);
+
+    /**
+     * Scans a directory recursively, recording a directory manifest for the next scan
+     * @param dir_path Directory path to scan
+     * @param onNext Function to call for each file found in a directory that was listed
+     * @param max_threads Maximum number of directory-listing threads
+     * @param previous_manifest Manifest from the last scan; directories whose mtime matches are
+     *        not listed and their files are not emitted. nullptr forces a full walk.
+     * @param manifest_out Receives the manifest for this walk (empty where unsupported)
+     * @param budget Listings budget shared with concurrent walks (nullptr = only max_threads limits)
+     */
+    static void scanDirectoryIncremental(const std::string &dir_path,
+                                         std::function<void(const FileMetadata &)> onNext,
+                                         size_t max_threads,
+                                         const DirectoryManifest *previous_manifest,
+                                         std::vector<DirectoryManifestEntry> &manifest_out,
+                                         ScanThreadBudget *budget = nullptr);
+
     /**
      * Validates if a path is a valid directory
      * @param path Path to validate
@@ -132,6 +254,32 @@ public:
      */
     static std::string computeFileHash(const std::string &file_path);
 
+    /**
+     * Computes the SHA256 hash of bytes already in memory; equal to computeFileHash of a file
+     * holding them
+     * @param data Start of the bytes
+     * @param size Number of bytes
+     * @return SHA256 hash as hexadecimal string
+     */
+    static std::string computeBufferHash(const unsigned char *data, size_t size);
+
+    /**
+     * Computes the SHA256 hash of bytes produced in pieces; equal to computeFileHash of a file
+     * holding them
+     * @param produce Called once with a sink for the bytes; returns false if they could not all be read
+     * @return SHA256 hash as hexadecimal string, empty if produce failed
+     */
+    static std::string computeStreamHash(const std::function<bool(const std::function<void(const unsigned char *, size_t)> &)> &produce);
+
+    /**
+     * Cheap content key: the file size and a SHA256 over a few blocks spread across the file.
+     * Equal files always get equal keys; unequal keys mean different content, equal keys only
+     * make identical content likely (confirm with computeFileHash)
+     * @param file_path Path to the file
+     * @return "<size>-<hex digest>", or an empty string if the file cannot be read
+     */
+    static std::string computeSampledFileHash(const std::string &file_path);
+
 private:
-    static SimpleObservable<std::string> listFilesInternal(const std::string &dir_path, bool recursive);
+    static SimpleObservable<std::string> listFilesInternal(const std::string &dir_path, bool recursive, size_t max_threads = 1);
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+class FileScanner;
+
+/**
+ * @brief Live change feed for local scan roots (inotify on Linux)
+ *
+ * Every directory under a watched root gets an inotify watch. Create, close-after-write,
+ * delete and move events are collected per path and debounced: once a path has been quiet
+ * for the debounce window it is re-checked on disk and either stored through FileScanner
+ * or removed from scanned_files. New directories are watched as they appear and scanned
+ * once, since files can land in them before their watch exists.
+ *
+ * When the kernel queue overflows (IN_Q_OVERFLOW) individual events are lost, so every
+ * watched root gets an incremental (directory-manifest) rescan instead.
+ *
+ * Network mounts are never watched: inotify only sees changes made through this host.
+ * On other platforms start() returns false and the interval scans stay in charge.
+ */
+class FileWatcher
+{
+public:
+    static FileWatcher &getInstance();
+
+    // Start watching the given roots; returns false if watching is not supported
+    bool start(const std::string &db_path, const std::vector<std::string> &roots, int debounce_ms);
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Watch an additional root (e.g. a scan path added at runtime); no-op when not running
+    void addRoot(const std::string &root);
+
+    // True when root is a local root whose watches are in place, so interval scans may skip it
+    bool isWatching(const std::string &root) const;
+
+private:
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    void watchLoop();
+    void attachPendingRoots();
+    bool addWatchTree(const std::string &dir_path);
+    void removeWatchTree(const std::string &dir_path);
+    void readEvents();
+    void markPending(const std::string &path);
+    void flushDue();
+    void rescanAfterOverflow();
+
+    std::atomic<bool> running_{false};
+    std::thread watch_thread_;
+    std::unique_ptr<FileScanner> scanner_;
+    std::chrono::milliseconds debounce_{2000};
+    std::atomic<bool> watch_limit_hit_{false}; // some directory went unwatched (ENOSPC)
+
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1; // eventfd used by stop()/addRoot() to interrupt poll()
+
+    // Roots handed over by start()/addRoot(); attached on the watch thread
+    mutable std::mutex roots_mutex_;
+    std::vector<std::string> pending_roots_;
+    std::set<std::string> watched_roots_;
+
+    // Watch thread only
+    std::unordered_map<int, std::string> wd_to_dir_;
+    std::map<std::string, int> dir_to_wd_; // ordered so a subtree is one key range
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending_; // path -> flush deadline
+    bool overflowed_ = false;
+    std::chrono::steady_clock::time_point overflow_deadline_;
+};
@@ -8,6 +8,11 @@
 #include "logging/logger.hpp"
 #include "core/processing_result.hpp"
 
+namespace cv
+{
+    class Mat;
+}
+
 /**
  * @brief Processing algorithm information
  */
@@ -39,6 +44,15 @@ public:
      */
     static ProcessingResult processFile(const std::string &file_path, DedupMode mode);
 
+    /**
+     * @brief Fingerprint an image that is already decoded, without reading the file
+     * @param image 8-bit BGR pixels, e.g. a RAW proxy handed over by TranscodingManager
+     * @param mode Quality mode for processing
+     * @param file_path Path the pixels belong to, for logging
+     * @return ProcessingResult containing the binary artifact
+     */
+    static ProcessingResult processDecodedImage(const cv::Mat &image, DedupMode mode, const std::string &file_path);
+
     /**
      * @brief Get processing algorithm information for a media type and mode
      * @param media_type Media type ("image", "video", "audio")
@@ -60,6 +74,20 @@ public:
      */
     static std::vector<std::string> getSupportedExtensions();
 
+    /**
+     * @brief Determine the media category of a file from its extension
+     * @param file_path Path to the file to classify
+     * @return "image", "video" or "audio", or an empty string if the extension is not enabled
+     */
+    static std::string getMediaType(const std::string &file_path);
+
+    /**
+     * @brief Media category of a file's extension whether or not its type is enabled
+     * @param file_path Path to the file to classify
+     * @return "image", "video" or "audio", or an empty string if the extension is not configured
+     */
+    static std::string getMediaCategory(const std::string &file_path);
+
     // Audio support
     static bool isAudioFile(const std::string &file_path);
 
@@ -82,6 +110,7 @@ private:
      * @return ProcessingResult with dHash artifact
      */
     static ProcessingResult processImageFast(const std::string &file_path);
+    static ProcessingResult processImageFast(const cv::Mat &image, const std::string &file_path);
 
     /**
      * @brief Process image file using BALANCED mode (libvips + OpenCV pHash)
@@ -89,6 +118,7 @@ private:
      * @return ProcessingResult with pHash artifact
      */
     static ProcessingResult processImageBalanced(const std::string &file_path);
+    static ProcessingResult processImageBalanced(const cv::Mat &image, const std::string &file_path);
 
     /**
      * @brief Process image file using QUALITY mode (CNN embeddings)
@@ -96,6 +126,7 @@ private:
      * @return ProcessingResult with CNN embedding artifact
      */
     static ProcessingResult processImageQuality(const std::string &file_path);
+    static ProcessingResult processImageQuality(const cv::Mat &image, const std::string &file_path);
 
     /**
      * @brief Process video file using FAST mode
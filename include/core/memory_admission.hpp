@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Memory-budget admission for decoding work
+ *
+ * Before a worker decodes a file it estimates the decode's peak memory from the file header
+ * (dimensions, channels and bit depth; for video also the frames the decoder keeps alive) and
+ * asks for that much of processing.memory_budget_mb. Jobs start while the admitted total fits
+ * the budget. A job that does not fit waits instead of failing, and smaller jobs that arrive
+ * after it still start while they fit. Once the oldest waiting job has waited the bypass limit
+ * (DEFAULT_MAX_BYPASS unless set), later arrivals queue behind it so it cannot starve. A job larger than the
+ * whole budget runs when nothing else is admitted.
+ *
+ * The budget starts at half of physical memory; the server sets processing.memory_budget_mb
+ * through setBudgetMB(), live, so tools that only estimate do not need the configuration stack.
+ */
+class MemoryAdmission
+{
+private:
+    struct Waiter;
+
+public:
+    class Grant
+    {
+    public:
+        Grant() = default;
+        Grant(Grant &&other) noexcept;
+        Grant &operator=(Grant &&other) noexcept;
+        Grant(const Grant &) = delete;
+        Grant &operator=(const Grant &) = delete;
+        ~Grant();
+
+        uint64_t bytes() const { return bytes_; }
+
+        // Return the bytes to the budget before the grant goes out of scope
+        void release();
+
+    private:
+        friend class MemoryAdmission;
+        explicit Grant(uint64_t bytes) : bytes_(bytes) {}
+
+        uint64_t bytes_ = 0;
+    };
+
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_BYPASS{30000};
+
+    static MemoryAdmission &getInstance();
+
+    // Wait until bytes fit the budget and charge them until the grant is released; what names
+    // the job in the log. Zero bytes are granted at once.
+    Grant admit(uint64_t bytes, const std::string &what);
+
+    // Peak memory of decoding an image: the decoder's own buffer plus the 8-bit BGR image and
+    // full-size temporaries of the canonical reduction
+    static uint64_t imagePeakBytes(int width, int height, int channels, int bits_per_sample);
+
+    // Peak memory of decoding a video stream: the frames held for reference and in the decoder
+    // threads plus the RGB conversion frames
+    static uint64_t videoPeakBytes(int width, int height, int bits_per_sample, int decoder_threads);
+
+    // Peak memory of a LibRaw decode: the raw sensor data plus the 16-bit 4-channel working image
+    // and the 8-bit copies made from it (width x height after any half-size reduction)
+    static uint64_t rawPeakBytes(int raw_width, int raw_height, int width, int height);
+
+    // imagePeakBytes() from the header of a JPEG, PNG, TIFF, WebP, BMP or OpenEXR file; other
+    // formats are estimated from the file size. 0 if the file cannot be read.
+    static uint64_t estimateImagePeakBytes(const std::string &path);
+
+    // Buffering a RAW file plus rawPeakBytes(), before anything else of it is read: dimensions from
+    // the header of TIFF-based RAWs, else a 16-bit mosaic the size of the file. max_edge_px > 0
+    // assumes the half-size decode used when half the sensor still covers it. 0 if the file is missing.
+    static uint64_t estimateRawPeakBytes(const std::string &path, int max_edge_px);
+
+    uint64_t budgetBytes() const { return budget_bytes_.load(); }
+    uint64_t admittedBytes() const;
+    size_t waitingCount() const;
+
+    // Change the budget (0 = half of physical memory); waiting jobs re-check at once
+    void setBudgetMB(uint32_t budget_mb);
+
+    // How long a waiting job lets later arrivals pass it; waiting jobs re-check at once
+    void setMaxBypass(std::chrono::milliseconds max_bypass);
+
+private:
+    MemoryAdmission();
+    ~MemoryAdmission() = default;
+    MemoryAdmission(const MemoryAdmission &) = delete;
+    MemoryAdmission &operator=(const MemoryAdmission &) = delete;
+
+    void release(uint64_t bytes);
+
+    // Caller holds mutex_
+    bool canAdmit(const Waiter &waiter, std::chrono::steady_clock::time_point now) const;
+
+    std::atomic<uint64_t> budget_bytes_{0};
+    std::atomic<int64_t> max_bypass_ms_{DEFAULT_MAX_BYPASS.count()};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t admitted_bytes_ = 0;
+    std::list<const Waiter *> waiters_; // arrival order
+};
@@ -3,6 +3,7 @@
 #include <mutex>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
@@ -102,6 +103,44 @@ private:
     }
 };
 
+namespace cv
+{
+    class MatAllocator;
+}
+
+/**
+ * @brief cv::Mat allocator that recycles buffers through thread-local size-class free lists
+ *
+ * Fingerprinting allocates the same handful of temporaries (decoded colour, gray, resized, float,
+ * DCT, split channels) for every file. Installed as OpenCV's default allocator, this serves those
+ * from per-thread free lists of power-of-two blocks (256 B to 64 MB) on threads that opted in with
+ * enableForCurrentThread(), so workers stop contending on malloc arena locks and the heap does not
+ * fragment over long runs. A block freed on its own thread goes straight back to that thread's
+ * list; one freed on any other thread is handed back to the thread that allocated it, which picks
+ * it up on its next miss. Each thread keeps at most 64 MB of free blocks (and as much again
+ * waiting to be picked up). Other threads, larger buffers and user-provided data use OpenCV's
+ * standard allocator. Long-lived copies (DecoderCache, ThumbnailStore) are made with the standard
+ * allocator, so they neither hold pooled blocks nor are charged for a whole size class.
+ */
+class PooledMatAllocator
+{
+public:
+    // Make the pooled allocator OpenCV's default; call once at startup before workers start
+    static void install();
+
+    // Serve this thread's Mat allocations from its pool (no effect until install())
+    static void enableForCurrentThread();
+
+    static cv::MatAllocator *allocator();
+
+    struct Stats
+    {
+        uint64_t reused = 0;    // allocations served from a free list
+        uint64_t allocated = 0; // allocations that went to the heap
+    };
+    static Stats stats();
+};
+
 // Specialized memory pool for common types
 class CommonMemoryPools
 {
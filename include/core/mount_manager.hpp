@@ -5,6 +5,10 @@
 #include <optional>
 #include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string_view>
 
 struct MountInfo
 {
@@ -21,6 +25,34 @@ struct RelativePath
     std::string relative_path;
 };
 
+// Immutable view of the mount table. Network mounts are indexed in a path-component trie, so
+// a lookup costs one step per component of the path and needs no locks; share a snapshot
+// across threads and take a new one from MountManager to see mount changes.
+class MountTable
+{
+public:
+    explicit MountTable(std::vector<MountInfo> mounts);
+
+    const std::vector<MountInfo> &mounts() const { return mounts_; }
+
+    // Network mount with the longest mount point that is a component prefix of path
+    const MountInfo *findNetworkMount(std::string_view path) const;
+
+    bool isNetworkPath(const std::string &path) const;
+    std::optional<RelativePath> toRelativePath(const std::string &absolute_path) const;
+    std::optional<std::string> toAbsolutePath(const RelativePath &relative_path) const;
+
+private:
+    struct Node
+    {
+        std::map<std::string, size_t, std::less<>> children; // component -> node index
+        int mount = -1; // index into mounts_ of the network mount at this node
+    };
+
+    std::vector<MountInfo> mounts_;
+    std::vector<Node> nodes_; // nodes_[0] is "/"
+};
+
 class MountManager
 {
 public:
@@ -28,8 +60,14 @@ public:
 
     // Mount detection
     std::vector<MountInfo> detectMounts();
+
+    // Re-detect mounts if the mount table changed since the last snapshot
     void refreshMounts();
 
+    // Current mount table, rebuilt first if it changed. Scans take one snapshot and use it for
+    // every file instead of going through the per-call lookups below.
+    std::shared_ptr<const MountTable> snapshot();
+
     // Path conversion
     std::optional<RelativePath> toRelativePath(const std::string &absolute_path);
     std::optional<std::string> toAbsolutePath(const RelativePath &relative_path);
@@ -43,18 +81,22 @@ public:
     bool validateRelativePath(const RelativePath &relative_path);
 
 private:
-    MountManager() = default;
-    ~MountManager() = default;
+    MountManager();
+    ~MountManager();
     MountManager(const MountManager &) = delete;
     MountManager &operator=(const MountManager &) = delete;
 
-    void updateMountMap();
+    bool mountsChanged();
 
-    std::vector<MountInfo> mounts_cache_;
-    std::map<std::string, MountInfo> mount_map_;
+    std::shared_ptr<const MountTable> table_; // accessed with std::atomic_load/atomic_store
+    std::mutex refresh_mutex_;
 
-    // Caching fields for Option 1
-    std::chrono::steady_clock::time_point last_mount_detection_;
-    static constexpr std::chrono::seconds MOUNT_CACHE_DURATION{30}; // Cache for 30 seconds
-    bool mounts_detected_ = false;
-};
\ No newline at end of file
+    // /proc/self/mountinfo reports POLLPRI when the mount table changes (Linux); it is polled at
+    // most once per MOUNT_POLL_INTERVAL. Elsewhere the table is re-detected once it is older than
+    // MOUNT_CACHE_DURATION.
+    int mountinfo_fd_ = -1;
+    std::atomic<std::chrono::steady_clock::rep> last_mount_poll_{0};
+    std::atomic<std::chrono::steady_clock::rep> last_mount_detection_{0};
+    static constexpr std::chrono::milliseconds MOUNT_POLL_INTERVAL{1000};
+    static constexpr std::chrono::seconds MOUNT_CACHE_DURATION{30};
+};
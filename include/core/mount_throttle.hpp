@@ -0,0 +1,133 @@
+#pragma once
+
+#include "core/error_recovery.hpp"
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Per-network-mount I/O admission for scanning, decoding and transcoding
+ *
+ * Every network mount (keyed by its mount point from MountManager) gets a concurrency limit,
+ * an optional bandwidth budget and a circuit breaker, so one slow share cannot tie up every
+ * worker. The concurrency limit adapts: it halves when operations on the mount take longer
+ * than the latency threshold and grows back by about one slot per window of fast ones.
+ *
+ * A permit covers one read (a chunk, a directory listing, a demuxer call), not the processing
+ * around it, so the latency the limit adapts to is the latency of the I/O itself. Bandwidth is
+ * reserved when the permit is taken, before the bytes are read.
+ *
+ * I/O errors that point at the mount rather than the file (EIO, timeouts, stale handles) count as
+ * failures. Once the breaker opens, acquire() fails fast for that mount until the breaker timeout
+ * has passed; callers defer the work instead of blocking on the share. Waiting longer than the
+ * acquire timeout for a slot or for bandwidth is not a failure of the mount: acquire() gives up
+ * and the mount reports unavailable until one of its operations completes.
+ *
+ * Local paths are never throttled. Limits start at the Limits defaults; the server pushes the
+ * network_mounts.* settings in through setLimits(), so tools that only read files do not need
+ * the configuration stack.
+ */
+class MountThrottle
+{
+private:
+    struct MountState;
+
+public:
+    class Permit
+    {
+    public:
+        Permit() = default;
+        Permit(Permit &&other) noexcept;
+        Permit &operator=(Permit &&other) noexcept;
+        Permit(const Permit &) = delete;
+        Permit &operator=(const Permit &) = delete;
+        ~Permit();
+
+        // False when the mount is unavailable; the caller should defer the work
+        bool granted() const { return granted_; }
+        explicit operator bool() const { return granted_; }
+
+        // Report the I/O outcome: io_ok=false only for errors that point at the mount. bytes are
+        // charged on top of the reservation, for reads whose size is only known once they are done.
+        void complete(bool io_ok, uint64_t bytes = 0);
+
+    private:
+        friend class MountThrottle;
+        Permit(std::shared_ptr<MountState> state, bool granted);
+
+        std::shared_ptr<MountState> state_; // null for local paths
+        bool granted_ = true;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    struct Limits
+    {
+        int max_concurrent_io = 4;
+        int bandwidth_mb_per_second = 0; // 0 = unlimited
+        int latency_threshold_ms = 5000;
+        int acquire_timeout_seconds = 30;
+        int breaker_timeout_seconds = 60;
+    };
+
+    static MountThrottle &getInstance();
+
+    // Largest read one permit covers in readFile(); never more than one second of bandwidth
+    static constexpr uint64_t READ_CHUNK_BYTES = 1024 * 1024;
+
+    // Wait for an I/O slot on the mount holding path and for bandwidth to read bytes (granted
+    // immediately for local paths)
+    Permit acquire(const std::string &path, uint64_t bytes = 0);
+
+    // Same, for a mount point that is already known
+    Permit acquireForMount(const std::string &mount_point, uint64_t bytes = 0);
+
+    // Mount point of the network mount holding path, empty for local paths
+    std::string networkMountOf(const std::string &path);
+
+    // Read the whole file into data, one permit per READ_CHUNK_BYTES; false if the file cannot be
+    // read or the mount is unavailable
+    bool readFile(const std::string &path, std::vector<unsigned char> &data);
+
+    // Chunk of a file being read, and the size of the whole file
+    using ChunkConsumer = std::function<void(const unsigned char *data, size_t length, uint64_t file_size)>;
+
+    // Stream the file to consume, one permit per READ_CHUNK_BYTES; false if the file cannot be
+    // read or the mount becomes unavailable (consume may have seen part of it)
+    bool readChunks(const std::string &path, const ChunkConsumer &consume);
+
+    // False while the breaker of the mount holding path is open or the mount is saturated. Only
+    // looks: an expired breaker is left for the next acquire() to close.
+    bool isAvailable(const std::string &path);
+
+    // Replace the limits; waiters re-check at once, breaker timeouts apply to mounts seen from now on
+    void setLimits(const Limits &limits);
+
+    // errno values that indicate the mount rather than the file
+    static bool isMountError(int error);
+
+private:
+    MountThrottle() = default;
+    ~MountThrottle() = default;
+    MountThrottle(const MountThrottle &) = delete;
+    MountThrottle &operator=(const MountThrottle &) = delete;
+
+    std::shared_ptr<MountState> stateForPath(const std::string &path);
+    std::shared_ptr<MountState> stateForMount(const std::string &mount_point);
+    void release(MountState &state, bool io_ok, uint64_t bytes, std::chrono::steady_clock::duration latency);
+
+    std::atomic<int> max_concurrent_{Limits().max_concurrent_io};
+    std::atomic<int> bandwidth_mb_per_second_{Limits().bandwidth_mb_per_second};
+    std::atomic<int> latency_threshold_ms_{Limits().latency_threshold_ms};
+    std::atomic<int> acquire_timeout_seconds_{Limits().acquire_timeout_seconds};
+    std::atomic<int> breaker_timeout_seconds_{Limits().breaker_timeout_seconds};
+
+    std::mutex mounts_mutex_;
+    std::map<std::string, std::shared_ptr<MountState>> mounts_; // mount point -> state
+};
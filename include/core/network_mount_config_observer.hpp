@@ -0,0 +1,37 @@
+#pragma once
+
+#include "config_observer.hpp"
+#include "core/mount_throttle.hpp"
+
+/**
+ * @brief Observer for network mount I/O limits
+ *
+ * This observer pushes the network_mounts.* settings into MountThrottle, which has no
+ * configuration dependency of its own.
+ */
+class NetworkMountConfigObserver : public ConfigObserver
+{
+public:
+    NetworkMountConfigObserver() = default;
+    ~NetworkMountConfigObserver() override = default;
+
+    /**
+     * @brief Handle configuration changes
+     * @param event Configuration update event
+     */
+    void onConfigUpdate(const ConfigUpdateEvent &event) override;
+
+    /**
+     * @brief Read the configured network mount limits
+     * @return Limits for MountThrottle::setLimits
+     */
+    static MountThrottle::Limits configuredLimits();
+
+private:
+    /**
+     * @brief Check if the event contains network mount changes
+     * @param event Configuration update event
+     * @return true if any network_mounts setting changed
+     */
+    bool hasNetworkMountChange(const ConfigUpdateEvent &event) const;
+};
@@ -7,7 +7,7 @@
  * @brief Observer for processing-related configuration changes
  *
  * This observer reacts to changes in processing configurations
- * such as batch size, quality stack preprocessing, etc.
+ * such as batch size, quality stack preprocessing and the decode memory budget.
  */
 class ProcessingConfigObserver : public ConfigObserver
 {
@@ -36,6 +36,13 @@ private:
      */
     bool hasQualityStackPreprocessingChange(const ConfigUpdateEvent &event) const;
 
+    /**
+     * @brief Check if the event contains memory budget changes
+     * @param event Configuration update event
+     * @return true if processing.memory_budget_mb changed
+     */
+    bool hasMemoryBudgetChange(const ConfigUpdateEvent &event) const;
+
     /**
      * @brief Handle processing batch size configuration change
      * @param new_batch_size New processing batch size
@@ -47,4 +54,10 @@ private:
      * @param enabled Whether quality stack preprocessing is enabled
      */
     void handleQualityStackPreprocessingChange(bool enabled);
+
+    /**
+     * @brief Apply a new decode memory budget to MemoryAdmission
+     * @param budget_mb New budget in MB (0 = half of physical memory)
+     */
+    void handleMemoryBudgetChange(int budget_mb);
 };
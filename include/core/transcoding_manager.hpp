@@ -6,13 +6,23 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 #include <queue>
 #include <memory>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include "database/database_manager.hpp"
 #include "logging/logger.hpp"
 #include "config_observer.hpp"
 #include <filesystem>
 
+namespace cv
+{
+    class Mat;
+}
+
 /**
  * @brief Transcoding manager for handling raw camera files
  *
@@ -44,7 +54,7 @@ public:
         std::string cache_file;
         bool is_processed;             // Processed in at least one mode
         bool is_fully_processed;       // Processed in all enabled modes
-        std::time_t cache_age;         // How old is the transcoded file
+        std::time_t cache_age;         // Last access of the transcoded file (Unix time)
         size_t file_size;              // Cache file size
         std::string processing_status; // Human-readable processing status
     };
@@ -89,9 +99,17 @@ public:
     /**
      * @brief Queue a file for transcoding
      * @param file_path Path to the raw file to transcode
-     * @note This method prevents duplicate entries - if a file is already queued or transcoded, it will not be added again
+     * @param requeue_handed_off Also queue again a job completed without a cache file, whose
+     *                           in-memory proxy is gone
+     * @note This method prevents duplicate entries - if a file is already queued, in progress or transcoded, it is left alone
+     */
+    void queueForTranscoding(const std::string &file_path, bool requeue_handed_off = false);
+
+    /**
+     * @brief Queue several files for transcoding in one database transaction
+     * @param file_paths Paths of raw files found by a scan; files already queued or transcoded are left alone
      */
-    void queueForTranscoding(const std::string &file_path);
+    void queueForTranscoding(const std::vector<std::string> &file_paths);
 
     /**
      * @brief Get the transcoded file path for a source file
@@ -100,6 +118,26 @@ public:
      */
     std::string getTranscodedFilePath(const std::string &source_file_path);
 
+    /**
+     * @brief Get the decoded proxy of a RAW file that was transcoded recently
+     * @param source_file_path Path to the RAW file
+     * @return 8-bit BGR pixels, or nullptr if the proxy is not (or no longer) held in memory
+     */
+    std::shared_ptr<const cv::Mat> getDecodedImage(const std::string &source_file_path);
+
+    /**
+     * @brief Drop the decoded proxy of a RAW file once it has been fingerprinted in every mode
+     * @param source_file_path Path to the RAW file
+     */
+    void releaseDecodedImage(const std::string &source_file_path);
+
+    /**
+     * @brief Hold a decoded proxy for getDecodedImage, dropping the oldest ones beyond cache.raw_handoff_mb
+     * @param source_file_path Path to the RAW file
+     * @param image 8-bit BGR pixels; not held if larger than the whole budget
+     */
+    void publishDecodedImage(const std::string &source_file_path, std::shared_ptr<const cv::Mat> image);
+
     /**
      * @brief Check if transcoding is running
      * @return true if transcoding threads are active
@@ -113,8 +151,8 @@ public:
     std::pair<size_t, size_t> getTranscodingStats() const;
 
     /**
-     * @brief Get cache directory size in bytes
-     * @return Total size of cache directory
+     * @brief Get cache size in bytes
+     * @return Total size of the transcoded files recorded in cache_map, kept as a running total
      */
     size_t getCacheSize() const;
 
@@ -160,12 +198,6 @@ public:
      */
     void restoreQueueFromDatabase();
 
-    /**
-     * @brief Reset all transcoding job statuses from 1 (in progress) to 0 (queued) on startup
-     * This ensures a clean state when the server restarts
-     */
-    void resetTranscodingJobStatusesOnStartup();
-
     /**
      * @brief Check if cache is over size limit
      * @return true if cache size exceeds limit
@@ -217,25 +249,27 @@ public:
     std::vector<CacheEntry> getCacheEntriesWithStatus();
 
     /**
-     * @brief Get next transcoding job from database (database-only approach)
+     * @brief Claim the next transcoding job from the database and mark it in progress
      * @return File path of next job, or empty string if none available
      */
     std::string getNextTranscodingJob();
 
     /**
-     * @brief Mark transcoding job as in progress (database-only approach)
-     * @param file_path Path to the file
-     * @return True if successfully marked
+     * @brief Wake the transcoding thread after jobs were queued
      */
-    bool markJobInProgress(const std::string &file_path);
+    void notifyJobsQueued();
 
     /**
      * @brief Mark transcoding job as completed (database-only approach)
      * @param file_path Path to the file
-     * @param output_path Path to transcoded output
+     * @param output_path Path to transcoded output, empty if the pixels were only handed over in memory
+     * @param output_size Size of the transcoded output in bytes
+     * @param content_key Sampled digest of the source, empty if not computed
+     * @param content_hash Full digest of the source, empty if not computed
      * @return True if successfully marked
      */
-    bool markJobCompleted(const std::string &file_path, const std::string &output_path);
+    bool markJobCompleted(const std::string &file_path, const std::string &output_path, uint64_t output_size = 0,
+                          const std::string &content_key = "", const std::string &content_hash = "");
 
     /**
      * @brief Mark transcoding job as failed (database-only approach)
@@ -244,6 +278,13 @@ public:
      */
     bool markJobFailed(const std::string &file_path);
 
+    /**
+     * @brief Put a claimed job back in the queue with its lease cleared, e.g. when its mount is unavailable
+     * @param file_path Path to the file
+     * @return True if successfully released
+     */
+    bool releaseJob(const std::string &file_path);
+
     /**
      * @brief Remove invalid cache files (source changed/missing)
      * @param entries Cache entries to analyze
@@ -287,12 +328,33 @@ public:
     bool removeCacheEntry(const CacheEntry &entry);
 
     /**
-     * @brief Transcode a raw file using LibRaw directly
+     * @brief Decode a raw file with LibRaw into an 8-bit BGR proxy
      * @param source_file_path Path to the source raw file
-     * @param output_path Path for the output JPEG file
-     * @return true if transcoding succeeded
+     * @param bgr Receives the pixels, shrunk to cache.transcode_max_edge_px
+     * @param content_hash If set, receives the full digest of the file, taken from the bytes read for decoding
+     * @return true if decoding succeeded
+     */
+    bool decodeRawFile(const std::string &source_file_path, cv::Mat &bgr, std::string *content_hash = nullptr);
+
+    /**
+     * @brief Encode a decoded proxy as JPEG into the cache directory
+     * @param bgr Pixels from decodeRawFile
+     * @param output_path Path for the output JPEG file; written to a temporary file, synced and
+     *                    renamed into place, so it never holds a partial JPEG
+     * @return true if the file was written
+     */
+    bool writeCacheFile(const cv::Mat &bgr, const std::string &output_path);
+
+    /**
+     * @brief Check that a cache file left on disk is a complete JPEG before adopting it
+     * @return true if the file is non-empty and starts and ends with the JPEG markers
      */
-    bool transcodeRawFileDirectly(const std::string &source_file_path, const std::string &output_path);
+    static bool isCompleteCacheFile(const std::string &path);
+
+    /**
+     * @brief Remove temporary files left in the cache directory by writes that never finished
+     */
+    void removeStaleCacheWrites();
 
     // Member variables
     std::atomic<bool> running_{false};
@@ -307,7 +369,6 @@ public:
     // Cache management
     std::string cache_dir_;
     size_t max_cache_size_mb_{1024}; // 1GB default
-    std::atomic<size_t> current_cache_size_mb_{0};
 
     // Cache cleanup configuration
     size_t cleanup_threshold_mb_{800}; // 800MB threshold for cleanup
@@ -325,6 +386,15 @@ public:
     std::atomic<bool> cancelled_{false};
     std::atomic<bool> initialized_{false};
     std::condition_variable queue_cv_;
+    std::mutex queue_mutex_;
+    bool jobs_pending_{false}; // set by queueForTranscoding, guarded by queue_mutex_
+
+    // An idle transcoding thread still checks the database this often, for jobs queued by other
+    // processes and for leases that lapsed
+    static constexpr std::chrono::seconds JOB_POLL_INTERVAL{30};
+    // A thread that put a job back because its mount was unavailable waits this long before
+    // claiming again, so it does not pick the same job straight back up
+    static constexpr std::chrono::seconds MOUNT_DEFER_BACKOFF{10};
     std::atomic<size_t> queued_count_{0};
     std::atomic<size_t> completed_count_{0};
 
@@ -335,6 +405,24 @@ public:
     // Cleanup configuration
     CleanupConfig cleanup_config_;
 
+    // Transcoded files in cache_objects, least recently used first, with a lookup by cache file
+    // path (one entry however many sources share the file). cache_bytes_ is their total size so
+    // size checks never walk cache_dir_. Accesses are written back to cache_objects in batches.
+    // All guarded by cache_index_mutex_ (cache_bytes_ is read without it).
+    std::list<CachedTranscode> cache_lru_;
+    std::unordered_map<std::string, std::list<CachedTranscode>::iterator> cache_index_;
+    std::unordered_set<std::string> accessed_since_flush_;
+    std::atomic<size_t> cache_bytes_{0};
+    mutable std::mutex cache_index_mutex_;
+    static constexpr size_t CACHE_ACCESS_FLUSH_BATCH = 256;
+
+    // Decoded RAW proxies handed to the fingerprint stage, oldest first, bounded by
+    // cache.raw_handoff_mb. The oldest proxy is dropped when a new one does not fit.
+    std::list<std::pair<std::string, std::shared_ptr<const cv::Mat>>> decoded_images_;
+    std::unordered_map<std::string, decltype(decoded_images_)::iterator> decoded_index_;
+    size_t decoded_bytes_{0};
+    std::mutex decoded_mutex_;
+
     /**
      * @brief Get the transcoded file path for a source file
      * @param source_file_path Path to the source file
@@ -374,18 +462,68 @@ private:
     void transcodingThread();
 
     /**
-     * @brief Transcode a single raw file
+     * @brief Transcode a single raw file and mark the job completed
+     *
+     * A source whose content is already cached (same sampled digest, confirmed by the full hash)
+     * shares that file and is not decoded. Otherwise the decoded proxy goes to the in-memory
+     * handoff, and the job is completed after the cache file (if cache.write_raw_transcodes) is
+     * written and synced, so a completed job never names a file that is not on disk.
      * @param source_file_path Path to the source raw file
-     * @return Path to the transcoded file, or empty if failed
+     * @return true if the job was completed; false if decoding or recording the completion failed
      */
-    std::string transcodeFile(const std::string &source_file_path);
+    bool transcodeFile(const std::string &source_file_path);
 
     /**
-     * @brief Generate a unique cache filename
-     * @param source_file_path Path to the source file
-     * @return Unique cache filename
+     * @brief Complete the job with an existing cache file of identical content, if there is one
+     * @param content_hash Full digest of the source; computed here when empty and a candidate exists
+     * @return true if the job was completed with a shared file
+     */
+    bool shareCachedTranscode(const std::string &source_file_path, const std::string &content_key, std::string &content_hash);
+
+    /**
+     * @brief Generate a cache filename from the source content
+     * @param source_file_path Path to the source file (for the extension)
+     * @param content_hash Full digest of the source
+     * @return Cache filename shared by every source with this content
+     */
+    std::string generateCacheFilename(const std::string &source_file_path, const std::string &content_hash);
+
+    /**
+     * @brief Build the cache index and size total from cache_objects, backfilling sizes of older rows
+     */
+    void loadCacheIndex();
+
+    /**
+     * @brief Record a transcoded file as the most recently used cache entry
+     */
+    void addToCacheIndex(const std::string &cache_file_path, uint64_t file_size);
+
+    /**
+     * @brief Move a cache entry to the most recently used end; persisted by flushCacheAccess()
+     */
+    void recordCacheAccess(const std::string &cache_file_path);
+
+    /**
+     * @brief Drop a cache entry from the index and the size total
+     * @return The removed entry, or nullopt if the file was not indexed
+     */
+    std::optional<CachedTranscode> removeFromCacheIndex(const std::string &cache_file_path);
+
+    /**
+     * @brief Cached files with their reference counts, least recently used first (after a flush)
+     */
+    std::vector<CachedTranscode> cachedTranscodesByAge();
+
+    /**
+     * @brief Write last_access of entries used since the previous flush to cache_objects
+     */
+    void flushCacheAccess();
+
+    /**
+     * @brief Delete a cached file together with its index entry and every record pointing at it
+     * @return Bytes freed
      */
-    std::string generateCacheFilename(const std::string &source_file_path);
+    size_t evictCacheFile(const std::string &cache_file_path);
 
     /**
      * @brief Safely adjust cache size based on configuration changes
@@ -9,10 +9,16 @@
 #include <mutex>
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
+#include <tuple>
 #include <functional>
 #include <sqlite3.h>
+#include "core/file_utils.hpp"
 
 // Result type for inline DB write operations (previously in access queue)
+class MountTable;
+
 struct WriteOperationResult
 {
     bool success;
@@ -31,6 +37,72 @@ struct DBOpResult
     DBOpResult(bool s = true, const std::string &msg = "") : success(s), error_message(msg) {}
 };
 
+/**
+ * @brief Stat tuple stored per scanned file in binary columns (file_mtime, file_size, ...)
+ * Loaded for a whole scan root at once so a walk can be diffed against the table in memory.
+ */
+struct StoredFileStat
+{
+    int64_t modification_time = 0;
+    int64_t creation_time = 0;
+    uint64_t file_size = 0;
+    uint64_t inode = 0;
+    uint64_t device_id = 0;
+
+    bool matches(const FileMetadata &metadata) const
+    {
+        return modification_time == metadata.modification_time && creation_time == metadata.creation_time &&
+               file_size == metadata.file_size && inode == metadata.inode && device_id == metadata.device_id;
+    }
+
+    // Recorded before inode/device were captured on Linux but unchanged since: refresh in place, not reprocess
+    bool isLegacyOf(const FileMetadata &metadata) const
+    {
+        return FileUtils::isLegacyMetadataOf(modification_time, file_size, inode, device_id, metadata);
+    }
+};
+
+using ScannedFileStats = std::unordered_map<std::string, StoredFileStat>;
+
+/**
+ * @brief Row changes found by diffing a directory walk against ScannedFileStats
+ */
+struct ScanDiff
+{
+    std::vector<FileMetadata> inserted;  // Not in scanned_files yet
+    std::vector<FileMetadata> changed;   // Stat differs: stored and processing flags cleared
+    std::vector<FileMetadata> refreshed; // Legacy stat upgraded in place, flags kept
+    std::vector<std::string> removed;    // No longer on disk
+    std::vector<std::string> seen;       // Unchanged, only stamped with the current scan generation
+
+    size_t size() const { return inserted.size() + changed.size() + refreshed.size() + removed.size() + seen.size(); }
+    bool empty() const { return size() == 0; }
+    void clear()
+    {
+        inserted.clear();
+        changed.clear();
+        refreshed.clear();
+        removed.clear();
+        seen.clear();
+    }
+};
+
+/**
+ * @brief Transcoded file recorded in cache_objects, with the size and last access used for eviction
+ *
+ * Every cache_map source whose content matches shares the same file.
+ */
+struct CachedTranscode
+{
+    std::string transcoded_file_path;
+    std::string source_file_path; // One of the sources using it; empty when none does any more
+    std::string content_key;      // FileUtils::computeSampledFileHash of the source; empty if cached by path
+    std::string content_hash;     // FileUtils::computeFileHash of the source
+    uint64_t file_size = 0;
+    int64_t last_access = 0; // Unix seconds
+    size_t references = 0;   // cache_map rows pointing at it
+};
+
 /**
  * @brief SQLite database manager for storing media processing results
  */
@@ -76,6 +148,20 @@ public:
      */
     std::vector<std::pair<std::string, ProcessingResult>> getAllProcessingResults();
 
+    /**
+     * @brief Get one page of processing results ordered by id (keyset pagination)
+     * @param after_id Only rows with id greater than this are returned (0 for the first page)
+     * @param limit Maximum number of rows to return
+     * @return Vector of (id, file_path, result, artifact data size) tuples; result.artifact.data is
+     *         not loaded. Pass the last id as after_id for the next page
+     */
+    std::vector<std::tuple<long, std::string, ProcessingResult, size_t>> getProcessingResultsPage(long after_id, size_t limit);
+
+    /**
+     * @brief Count rows in media_processing_results without loading them
+     */
+    size_t getProcessingResultsCount();
+
     /**
      * @brief Clear all results
      * @return DBOpResult with success flag and error message
@@ -91,6 +177,57 @@ public:
     DBOpResult storeScannedFile(const std::string &file_path,
                                 std::function<void(const std::string &)> onFileNeedsProcessing = nullptr);
 
+    /**
+     * @brief Store a scanned file using metadata already collected by the directory walker
+     * @param metadata Stat data for the file (file_path must be set); the file is not stat'ed again
+     * @param onFileNeedsProcessing Optional callback to trigger processing when file needs processing
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult storeScannedFile(const FileMetadata &metadata,
+                                std::function<void(const std::string &)> onFileNeedsProcessing = nullptr);
+
+    /**
+     * @brief Load the stored stat tuple of every scanned file below a scan root
+     * One range query over the file_path index instead of a lookup per walked file.
+     * @param root_path Scan root
+     * @return Map of file path to stored stat
+     */
+    ScannedFileStats getScannedFileStats(const std::string &root_path);
+
+    /**
+     * @brief Apply the inserts, updates and deletes of a scan diff in one transaction
+     * @param diff Changes produced by diffing a walk against getScannedFileStats
+     * @param mounts Mount table the scan began with; the current one if null
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult applyScanDiff(const ScanDiff &diff, const MountTable *mounts = nullptr);
+
+    /**
+     * @brief Start a scan generation
+     * Every scanned_files row written or confirmed from now on is stamped with it.
+     * @return The new generation number, or 0 on failure
+     */
+    int64_t beginScanGeneration();
+
+    /**
+     * @brief Delete the rows below a scan root that were not stamped since a generation began
+     * Only valid after a walk that confirmed every file it found (a full walk); one indexed
+     * DELETE per root. Links, processing results and cache entries of the rows go with them.
+     * @param root_path Scan root
+     * @param generation Value returned by beginScanGeneration before the walk
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult sweepScanGeneration(const std::string &root_path, int64_t generation);
+
+    /**
+     * @brief Remove a file, or a directory and every file below it, from scanned_files
+     * Processing results and cache entries go with it through ON DELETE CASCADE, and the
+     * removed IDs are dropped from the links of their duplicates.
+     * @param path File or directory path that no longer exists on disk
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult removeScannedPath(const std::string &path);
+
     /**
      * @brief Store a scanned file in the database and return operation ID
      * @param file_path Path to the scanned file
@@ -132,6 +269,16 @@ public:
      */
     std::vector<std::pair<std::string, std::string>> getAndMarkFilesForProcessingAnyModeWithPriority(int batch_size);
 
+    /**
+     * @brief Extend this process's lease on a claimed file before working on it
+     *
+     * A batch claim leases every file for processing.claim_lease_seconds from the claim, so
+     * files late in a batch are renewed one at a time as their turn comes.
+     * @param file_path Path to the claimed file
+     * @return false if the file is no longer in progress under this process's lease
+     */
+    bool renewProcessingLease(const std::string &file_path);
+
     /**
      * @brief Set processing flag for a specific mode after successful processing
      * @param file_path Path to the file
@@ -148,6 +295,17 @@ public:
      */
     DBOpResult resetProcessingFlag(const std::string &file_path, DedupMode mode);
 
+    /**
+     * @brief Park an in-progress (-1) or transcoding-failed (3) file until its transcode finishes (-2)
+     *
+     * markTranscodingJobCompleted requeues exactly the modes parked this way;
+     * markTranscodingJobFailed moves them to the transcoding error state (3).
+     * @param file_path Path to the RAW file
+     * @param mode Processing mode that was deferred
+     * @return DBOpResult indicating success or failure
+     */
+    DBOpResult setProcessingFlagAwaitingTranscode(const std::string &file_path, DedupMode mode);
+
     /**
      * @brief Set processing flag to error state (2) for a specific mode
      * @param file_path Path to the file
@@ -172,13 +330,6 @@ public:
      */
     DBOpResult setProcessingFlagFinalError(const std::string &file_path, DedupMode mode);
 
-    /**
-     * @brief Reset all processing flags from -1 (in progress) to 0 (not processed) on startup
-     * This ensures a clean state when the server restarts
-     * @return DBOpResult indicating success or failure
-     */
-    DBOpResult resetAllProcessingFlagsOnStartup();
-
     /**
      * @brief Get files with a specific processing flag value for a mode
      * @param flag_value The processing flag value to search for
@@ -254,6 +405,19 @@ public:
      */
     std::vector<std::pair<std::string, std::string>> getAllScannedFiles();
 
+    /**
+     * @brief Get one page of scanned files ordered by id (keyset pagination)
+     * @param after_id Only rows with id greater than this are returned (0 for the first page)
+     * @param limit Maximum number of rows to return
+     * @return Vector of (id, file_path, file_name) tuples
+     */
+    std::vector<std::tuple<long, std::string, std::string>> getScannedFilesPage(long after_id, size_t limit);
+
+    /**
+     * @brief Count rows in scanned_files without loading them
+     */
+    size_t getScannedFilesCount();
+
     /**
      * @brief Clear all scanned files
      * @return DBOpResult with success flag and error message
@@ -365,6 +529,23 @@ public:
      */
     std::vector<std::pair<std::string, std::string>> getAllUserInputs();
 
+    /**
+     * @brief Load the directory manifest recorded by the last walk of a scan root
+     * @param root_path Scan root (entries for the root and everything below it are returned)
+     * @return Map of directory path to manifest entry; empty if the root was never walked
+     */
+    DirectoryManifest getDirectoryManifest(const std::string &root_path);
+
+    /**
+     * @brief Replace the directory manifest of a scan root with the result of a walk
+     * Entries are upserted under a new scan generation; directories below the root that
+     * the walk did not reach are deleted.
+     * @param root_path Scan root the entries belong to
+     * @param entries Manifest produced by FileUtils::scanDirectoryIncremental
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult replaceDirectoryManifest(const std::string &root_path, const std::vector<DirectoryManifestEntry> &entries);
+
     /**
      * @brief Clear all user inputs
      * @return DBOpResult with success flag and error message
@@ -373,6 +554,9 @@ public:
 
     /**
      * @brief Get a hash of the contents of a database table
+     *
+     * Tracked tables hash their trigger-maintained change counter (O(1)); other
+     * tables fall back to hashing their full contents.
      * @param table_name Name of the table to hash
      * @return Pair of success flag and hash string, or error message
      */
@@ -386,24 +570,40 @@ public:
 
     /**
      * @brief Get a combined hash of tables relevant for duplicate detection
+     *
+     * Derived from the table_versions counters of scanned_files, cache_map and
+     * media_processing_results, so it changes whenever any of them is written.
      * @return Pair of success flag and hash string, or error message
      */
     std::pair<bool, std::string> getDuplicateDetectionHash();
 
     /**
      * @brief Insert a file path that needs transcoding into cache_map
-     * @param source_file_path Path to the source file that needs transcoding
+     * @param source_file_path Path to the source file that needs transcoding; a row already present is left as it is
+     * @param requeue_handed_off Also queue again a completed job that has no cache file (its proxy
+     *                           only went to the in-memory handoff and is gone)
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult insertTranscodingFile(const std::string &source_file_path, bool requeue_handed_off = false);
+
+    /**
+     * @brief Insert several files that need transcoding into cache_map in one transaction
+     * @param source_file_paths Paths of the source files; ones already present are left as they are
      * @return DBOpResult with success flag and error message
      */
-    DBOpResult insertTranscodingFile(const std::string &source_file_path);
+    DBOpResult insertTranscodingFiles(const std::vector<std::string> &source_file_paths);
 
     /**
-     * @brief Update a cache_map record with the transcoded file path
+     * @brief Point a cache_map record at a transcoded file, recording the file in cache_objects
      * @param source_file_path Path to the source file
      * @param transcoded_file_path Path to the transcoded file
+     * @param file_size Size of the transcoded file in bytes
+     * @param content_key Sampled digest of the source, empty for a file cached by path
+     * @param content_hash Full digest of the source
      * @return DBOpResult with success flag and error message
      */
-    DBOpResult updateTranscodedFilePath(const std::string &source_file_path, const std::string &transcoded_file_path);
+    DBOpResult updateTranscodedFilePath(const std::string &source_file_path, const std::string &transcoded_file_path, uint64_t file_size = 0,
+                                        const std::string &content_key = "", const std::string &content_hash = "");
 
     /**
      * @brief Get the transcoded file path for a source file
@@ -436,17 +636,57 @@ public:
      */
     DBOpResult removeTranscodingRecord(const std::string &source_file_path);
 
+    /**
+     * @brief Remove several transcoding records in one transaction
+     * @param source_file_paths Paths of the source files
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult removeTranscodingRecords(const std::vector<std::string> &source_file_paths);
+
+    /**
+     * @brief Get every transcoded file in cache_objects, least recently used first
+     * @return One record per file, including files no source references any more
+     */
+    std::vector<CachedTranscode> getCachedTranscodes();
+
+    /**
+     * @brief Get the transcoded files of sources with the given sampled digest
+     * @param content_key FileUtils::computeSampledFileHash of a source
+     * @return Candidates; compare content_hash before sharing one
+     */
+    std::vector<CachedTranscode> findCachedTranscodes(const std::string &content_key);
+
+    /**
+     * @brief Store file_size and last_access of transcoded files in one transaction
+     * @param transcodes Records keyed by transcoded_file_path; other fields are not written
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult updateCachedTranscodes(const std::vector<CachedTranscode> &transcodes);
+
+    /**
+     * @brief Forget transcoded files together with every cache_map record pointing at them
+     * @param cache_file_paths Paths of the transcoded files (the files themselves are not touched)
+     * @return DBOpResult with success flag and error message
+     */
+    DBOpResult removeCachedTranscodes(const std::vector<std::string> &cache_file_paths);
+
     /**
      * @brief Clear all transcoding records
      * @return DBOpResult with success flag and error message
      */
     DBOpResult clearAllTranscodingRecords();
 
-    // Transcoding job management helpers (serialized via DatabaseAccessQueue)
+    // Transcoding job management helpers (serialized via DatabaseAccessQueue). Claiming marks
+    // the job in progress and leases it to this process in the same statement. Completing with an
+    // empty transcoded path records a job whose pixels were only handed over in memory; any other
+    // path is recorded in cache_objects with the source's content digests.
     std::string claimNextTranscodingJob();
     bool markTranscodingJobInProgress(const std::string &source_file_path);
-    bool markTranscodingJobCompleted(const std::string &source_file_path, const std::string &transcoded_file_path);
+    bool markTranscodingJobCompleted(const std::string &source_file_path, const std::string &transcoded_file_path, uint64_t file_size = 0,
+                                     const std::string &content_key = "", const std::string &content_hash = "");
     bool markTranscodingJobFailed(const std::string &source_file_path);
+    // Put a job this process holds back in the queue (status 0) with its lease cleared
+    bool releaseTranscodingJob(const std::string &source_file_path);
 
     /**
      * @brief Wait for all pending write operations to complete
@@ -523,6 +763,7 @@ private:
     std::mutex queue_check_mutex;
     std::mutex file_processing_mutex; // Mutex for file processing operations to prevent race conditions
     std::mutex db_exec_mutex_;        // Mutex to serialize SQLite access and prevent concurrent database operations
+    std::string lease_owner_id_;      // host:pid recorded on claims so stale leases can be attributed
 
     // Inline operation helpers to replace access queue
     size_t enqueueWriteInline(std::function<WriteOperationResult(DatabaseManager &)> operation);
@@ -535,11 +776,19 @@ private:
     void initialize();
     bool createMediaProcessingResultsTable();
     bool createScannedFilesTable();
+    bool upgradeScannedFilesSchema();
     bool createUserInputsTable();
     bool createCacheMapTable();
+    bool createCacheObjectsTable();
     bool createTranscodingTable();
     bool createFlagsTable();
+    bool createDirectoryManifestTable();
     bool createScannedFilesChangeTriggers();
+    bool createTableVersionTracking();
+
+    // Shared body of the storeScannedFile overloads
+    DBOpResult storeScannedFileRecord(const std::string &file_path, const std::string &current_metadata_str,
+                                      std::function<void(const std::string &)> onFileNeedsProcessing);
 
     // SQL helpers
     /**
@@ -557,8 +806,55 @@ private:
     std::string resultToJson(const ProcessingResult &result);
     ProcessingResult jsonToResult(const std::string &json_str);
 
-    // Helper function to generate SQL LIKE clauses for enabled file types
-    std::string generateFileTypeLikeClauses();
+    // Helper function to generate an indexed IN clause over file_extension for enabled file types
+    std::string generateFileTypeInClause();
+    static std::string buildExtensionInClause(const std::string &column, const std::vector<std::string> &extensions);
+
+    /**
+     * @brief Unix time at which a claim taken now expires (processing.claim_lease_seconds)
+     */
+    static int64_t nextLeaseExpiry();
+
+    /**
+     * @brief Return in-progress (-1) rows whose lease has expired to pending (0)
+     * Called inside claim transactions so crashed or stalled workers' files are
+     * reclaimed lazily instead of by a bulk reset at startup.
+     * @return Number of rows reclaimed, or -1 on error
+     */
+    static int reclaimExpiredProcessingLeases(sqlite3 *db);
+
+    /**
+     * @brief Tables whose changes are counted in table_versions by triggers
+     */
+    static const std::vector<std::string> &versionTrackedTables();
+
+    /**
+     * @brief Read the per-table change counters (0 for tracked tables never written)
+     */
+    static bool readTableVersions(sqlite3 *db, std::map<std::string, int64_t> &versions);
+
+    /**
+     * @brief Content hash of a table without a version counter (full scan)
+     */
+    static bool hashTableContents(sqlite3 *db, const std::string &table_name, std::string &hash_out);
+    static std::string sha256Hex(const std::string &data);
+
+    // Bind file_mtime, file_created, file_size, file_inode, file_device starting at first_index (NULLs if unknown)
+    static void bindFileStat(sqlite3_stmt *stmt, int first_index, const std::optional<FileMetadata> &metadata);
+
+    // Before deleting the scanned_files rows selected by select_stmt (id, links_fast, links_balanced,
+    // links_quality, transcoded_file_path): drop their IDs from their duplicates' links and collect
+    // their cache files. Runs inside the caller's write transaction.
+    static bool detachScannedRows(sqlite3 *db, sqlite3_stmt *select_stmt, std::vector<std::string> &cache_files);
+
+    // After the rows are deleted: narrow cache_files to the files nothing uses any more and drop
+    // their cache_objects rows. Content-addressed files stay for moved copies. Same transaction.
+    static bool releaseCacheFiles(sqlite3 *db, std::vector<std::string> &cache_files);
+    static void removeCacheFiles(const std::vector<std::string> &cache_files);
+
+    // Insert or refresh the cache_objects row of a transcoded file; empty key/hash keep stored values
+    static bool upsertCacheObject(sqlite3 *db, const std::string &cache_file_path, uint64_t file_size,
+                                  const std::string &content_key, const std::string &content_hash);
 
     static std::unique_ptr<DatabaseManager> instance_;
     static std::mutex instance_mutex_;
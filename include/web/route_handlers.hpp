@@ -13,6 +13,10 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
 #include "core/status.hpp"
 #include "core/file_utils.hpp"
 #include "core/file_processor.hpp"
@@ -23,6 +27,7 @@
 #include "auth/auth_middleware.hpp"
 #include "poco_config_adapter.hpp"
 #include "core/shutdown_manager.hpp"
+#include "core/file_watcher.hpp"
 
 using json = nlohmann::json;
 
@@ -411,7 +416,8 @@ private:
             Logger::debug("Starting recursive file scan for directory: " + directory);
 
             // Use the existing FileUtils to scan directory recursively
-            auto observable = FileUtils::listFilesAsObservable(directory, true);
+            const size_t scan_threads = static_cast<size_t>(std::max(1, PocoConfigAdapter::getInstance().getMaxScanThreads()));
+            auto observable = FileUtils::listFilesAsObservable(directory, true, scan_threads);
             observable.subscribe(
                 [](const std::string &file_path)
                 {
@@ -938,6 +944,102 @@ private:
         }
     }
 
+    // Keyset pagination parameters shared by the results endpoints: after_id (exclusive cursor,
+    // default 0) and limit (row count, 0 when not given). Returns an error message for values that
+    // are not non-negative integers, or a limit of 0, and leaves the outputs untouched then.
+    static std::string parsePageParams(const httplib::Request &req, long &after_id, size_t &limit)
+    {
+        auto parse = [&req](const char *name, long &value) -> bool
+        {
+            const std::string text = req.get_param_value(name);
+            auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return ec == std::errc() && end == text.data() + text.size() && value >= 0;
+        };
+
+        long parsed_after_id = 0;
+        long parsed_limit = 0;
+        if (req.has_param("after_id") && !parse("after_id", parsed_after_id))
+            return "after_id must be a non-negative integer";
+        if (req.has_param("limit") && (!parse("limit", parsed_limit) || parsed_limit == 0))
+            return "limit must be a positive integer";
+        const std::string stream = req.get_param_value("stream");
+        if (!stream.empty() && stream != "true" && stream != "false")
+            return "stream must be true or false";
+
+        after_id = parsed_after_id;
+        limit = static_cast<size_t>(parsed_limit);
+        return "";
+    }
+
+    static json processingResultToJson(long id, const std::string &file_path, const ProcessingResult &result, size_t data_size)
+    {
+        json result_json = {
+            {"id", id},
+            {"file_path", file_path},
+            {"success", result.success},
+            {"format", result.artifact.format},
+            {"hash", result.artifact.hash},
+            {"confidence", result.artifact.confidence},
+            {"data_size", data_size}};
+
+        // Include error message if processing failed
+        if (!result.success && !result.error_message.empty())
+        {
+            result_json["error_message"] = result.error_message;
+        }
+        return result_json;
+    }
+
+    /**
+     * @brief Stream a JSON document of the form {<header fields>, "<array_key>": [...]} page by page
+     *
+     * fetch_page(cursor, page_size, out, first_row) must append up to page_size serialized rows
+     * after cursor to out, move cursor to the id of the last row written and return how many it
+     * wrote. At most max_rows rows are streamed (0 = all). Only one page is held in memory at a time.
+     */
+    static void streamPagedJson(httplib::Response &res, json header, const std::string &array_key,
+                                long after_id, size_t page_size, size_t max_rows,
+                                std::function<size_t(long &, size_t, std::string &, bool &)> fetch_page)
+    {
+        std::string prefix = header.dump();
+        prefix.pop_back(); // drop closing brace so the array can be appended
+        prefix += (header.empty() ? "" : ",") + json(array_key).dump() + ":[";
+
+        struct StreamState
+        {
+            long cursor;
+            size_t remaining;
+            bool started = false;
+            bool first_row = true;
+        };
+        auto state = std::make_shared<StreamState>(StreamState{after_id, max_rows ? max_rows : SIZE_MAX});
+
+        res.set_chunked_content_provider(
+            "application/json",
+            [state, prefix, page_size, fetch_page](size_t, httplib::DataSink &sink)
+            {
+                std::string chunk;
+                if (!state->started)
+                {
+                    chunk = prefix;
+                    state->started = true;
+                }
+
+                const size_t wanted = std::min(page_size, state->remaining);
+                const size_t written = fetch_page(state->cursor, wanted, chunk, state->first_row);
+                state->remaining -= written;
+                bool exhausted = written < wanted || state->remaining == 0;
+
+                if (exhausted)
+                    chunk += "]}";
+                if (!chunk.empty() && !sink.write(chunk.data(), chunk.size()))
+                    return false;
+                if (exhausted)
+                    sink.done();
+                return true;
+            });
+    }
+
     static void handleGetProcessingResults(const httplib::Request &req, httplib::Response &res)
     {
         Logger::trace("Received get processing results request");
@@ -949,37 +1051,54 @@ private:
                 db_path = "scan_results.db";
             }
 
-            // Create DatabaseManager and get results
+            long after_id = 0;
+            size_t limit = 0;
+            if (std::string error = parsePageParams(req, after_id, limit); !error.empty())
+            {
+                res.status = 400;
+                res.set_content(json{{"error", error}}.dump(), "application/json");
+                return;
+            }
+
             DatabaseManager &db_manager = DatabaseManager::getInstance();
-            auto results = db_manager.getAllProcessingResults();
+
+            if (req.get_param_value("stream") == "true")
+            {
+                // Full export (or the first limit rows): walk the table in keyset pages instead of materializing it
+                streamPagedJson(res, json{{"database_path", db_path}}, "results", after_id, 500, limit,
+                                [&db_manager](long &cursor, size_t page_size, std::string &out, bool &first_row)
+                                {
+                                    auto page = db_manager.getProcessingResultsPage(cursor, page_size);
+                                    for (const auto &[id, file_path, result, data_size] : page)
+                                    {
+                                        if (!first_row)
+                                            out += ",";
+                                        first_row = false;
+                                        out += processingResultToJson(id, file_path, result, data_size).dump();
+                                        cursor = id;
+                                    }
+                                    return page.size();
+                                });
+                Logger::info("Streaming processing results");
+                return;
+            }
+
+            limit = limit ? std::min<size_t>(limit, 1000) : 10;
+            auto page = db_manager.getProcessingResultsPage(after_id, limit);
 
             json response = {
-                {"total_results", results.size()},
+                {"total_results", db_manager.getProcessingResultsCount()},
                 {"database_path", db_path},
                 {"results", json::array()}};
 
-            // Add first 10 results to response
-            size_t limit = std::min(results.size(), size_t(10));
-            for (size_t i = 0; i < limit; ++i)
+            for (const auto &[id, file_path, result, data_size] : page)
             {
-                const auto &[file_path, result] = results[i];
-                json result_json = {
-                    {"file_path", file_path},
-                    {"success", result.success},
-                    {"format", result.artifact.format},
-                    {"hash", result.artifact.hash},
-                    {"confidence", result.artifact.confidence},
-                    {"data_size", result.artifact.data.size()}};
-
-                // Include error message if processing failed
-                if (!result.success && !result.error_message.empty())
-                {
-                    result_json["error_message"] = result.error_message;
-                }
-
-                response["results"].push_back(result_json);
+                response["results"].push_back(processingResultToJson(id, file_path, result, data_size));
             }
 
+            // Cursor for the next page; null once the last page has been returned
+            response["next_after_id"] = page.size() < limit ? json(nullptr) : json(std::get<0>(page.back()));
+
             res.set_content(response.dump(), "application/json");
             Logger::info("Processing results retrieved successfully");
         }
@@ -1019,6 +1138,9 @@ private:
                 Logger::info("Stored scan path in user inputs: " + directory);
             }
 
+            // Keep the new root current between interval scans (no-op when watching is off)
+            FileWatcher::getInstance().addRoot(directory);
+
             json response = {
                 {"message", "Directory scan started"},
                 {"directory", directory},
@@ -1044,8 +1166,9 @@ private:
                         }
                     }
 
-                    // Use the existing FileUtils to scan directory recursively
-                    auto observable = FileUtils::listFilesAsObservable(directory, recursive);
+                    // Walk with metadata so each file is stat'ed once, during the walk
+                    const size_t scan_threads = static_cast<size_t>(std::max(1, PocoConfigAdapter::getInstance().getMaxScanThreads()));
+                    auto observable = FileUtils::listFilesWithMetadataAsObservable(directory, recursive, scan_threads);
 
                     // Create DatabaseManager for storing scan results
                     DatabaseManager &db_manager = DatabaseManager::getInstance();
@@ -1054,8 +1177,9 @@ private:
                     std::string last_error;
 
                     observable.subscribe(
-                        [&](const std::string &file_path)
+                        [&](const FileMetadata &metadata)
                         {
+                            const std::string &file_path = metadata.file_path;
                             try
                             {
                                 // Only insert supported files
@@ -1065,8 +1189,8 @@ private:
                                     return;
                                 }
 
-                                // Store file in database without triggering processing (skip metadata computation for performance)
-                                auto db_result = db_manager.storeScannedFile(file_path);
+                                // Store file in database without triggering processing
+                                auto db_result = db_manager.storeScannedFile(metadata);
                                 if (db_result.success)
                                 {
                                     files_scanned++;
@@ -1136,26 +1260,56 @@ private:
                 db_path = "scan_results.db";
             }
 
-            // Create DatabaseManager and get scan results
+            long after_id = 0;
+            size_t limit = 0;
+            if (std::string error = parsePageParams(req, after_id, limit); !error.empty())
+            {
+                res.status = 400;
+                res.set_content(json{{"error", error}}.dump(), "application/json");
+                return;
+            }
+
             DatabaseManager &db_manager = DatabaseManager::getInstance();
-            auto results = db_manager.getAllScannedFiles();
+
+            if (req.get_param_value("stream") == "true")
+            {
+                streamPagedJson(res, json{{"database_path", db_path}}, "files", after_id, 1000, limit,
+                                [&db_manager](long &cursor, size_t page_size, std::string &out, bool &first_row)
+                                {
+                                    auto page = db_manager.getScannedFilesPage(cursor, page_size);
+                                    for (const auto &[id, file_path, file_name] : page)
+                                    {
+                                        if (!first_row)
+                                            out += ",";
+                                        first_row = false;
+                                        out += json{{"id", id}, {"file_path", file_path}, {"file_name", file_name}}.dump();
+                                        cursor = id;
+                                    }
+                                    return page.size();
+                                });
+                Logger::info("Streaming scan results");
+                return;
+            }
+
+            limit = limit ? std::min<size_t>(limit, 5000) : 50;
+            auto page = db_manager.getScannedFilesPage(after_id, limit);
 
             json response = {
-                {"total_files", results.size()},
+                {"total_files", db_manager.getScannedFilesCount()},
                 {"database_path", db_path},
                 {"files", json::array()}};
 
-            // Add first 50 results to response
-            size_t limit = std::min(results.size(), size_t(50));
-            for (size_t i = 0; i < limit; ++i)
+            for (const auto &[id, file_path, file_name] : page)
             {
-                const auto &[file_path, file_name] = results[i];
                 json file_json = {
+                    {"id", id},
                     {"file_path", file_path},
                     {"file_name", file_name}};
                 response["files"].push_back(file_json);
             }
 
+            response["next_after_id"] = page.size() < limit ? json(nullptr) : json(std::get<0>(page.back()));
+
             res.set_content(response.dump(), "application/json");
             Logger::info("Scan results retrieved successfully");
         }
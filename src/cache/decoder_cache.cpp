@@ -1,14 +1,84 @@
 #include "core/cache/decoder_cache.hpp"
 #include "poco_config_adapter.hpp"
 #include "logging/logger.hpp"
+#include <algorithm>
+#include <functional>
+#include <sys/stat.h>
+#include <opencv2/core.hpp>
+
+namespace
+{
+    // Bookkeeping charged per entry on top of the pixels: list node, index slot, Mat header
+    constexpr size_t ENTRY_OVERHEAD_BYTES = 256;
+
+    size_t bytesFor(const DecoderCache::Key &key, const cv::Mat &image)
+    {
+        return image.total() * image.elemSize() + key.path.size() + ENTRY_OVERHEAD_BYTES;
+    }
+}
+
+DecoderCache::Key DecoderCache::Key::forFile(const std::string &path, Variant variant)
+{
+    Key key;
+    key.variant = variant;
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return key;
+
+    key.path = path;
+#ifdef __APPLE__
+    key.mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    key.file_size = static_cast<uint64_t>(st.st_size);
+    return key;
+}
+
+DecoderCache::Key DecoderCache::Key::withVariant(Variant other) const
+{
+    Key key = *this;
+    key.variant = other;
+    return key;
+}
+
+DecoderCache::Key DecoderCache::Key::forSkip(Variant other, int64_t pts, int32_t frames) const
+{
+    Key key = withVariant(other);
+    key.frame_pts = pts;
+    key.frame_count = frames;
+    return key;
+}
+
+bool DecoderCache::Key::operator==(const Key &other) const
+{
+    return mtime_ns == other.mtime_ns && file_size == other.file_size && variant == other.variant &&
+           frame_pts == other.frame_pts && frame_count == other.frame_count && path == other.path;
+}
+
+size_t DecoderCache::KeyHash::operator()(const Key &key) const
+{
+    size_t h = std::hash<std::string>{}(key.path);
+    auto mix = [&h](uint64_t value)
+    { h ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+    mix(static_cast<uint64_t>(key.mtime_ns));
+    mix(key.file_size);
+    mix(static_cast<uint64_t>(key.variant));
+    mix(static_cast<uint64_t>(key.frame_pts));
+    mix(static_cast<uint64_t>(key.frame_count));
+    return h;
+}
 
 DecoderCache::DecoderCache()
 {
     // Get cache size from configuration, default to 1024 MB
     auto &config_manager = PocoConfigAdapter::getInstance();
-    cache_size_mb_ = config_manager.getDecoderCacheSizeMB();
+    uint32_t size_mb = config_manager.getDecoderCacheSizeMB();
+    cache_size_mb_.store(size_mb);
+    budget_bytes_.store(static_cast<size_t>(size_mb) * 1024 * 1024);
 
-    Logger::info("DecoderCache initialized with cache size: " + std::to_string(cache_size_mb_) + " MB");
+    Logger::info("DecoderCache initialized with cache size: " + std::to_string(size_mb) + " MB");
 }
 
 DecoderCache &DecoderCache::getInstance()
@@ -19,5 +89,130 @@ DecoderCache &DecoderCache::getInstance()
 
 uint32_t DecoderCache::getCacheSizeMB() const
 {
-    return cache_size_mb_;
-}
\ No newline at end of file
+    return cache_size_mb_.load();
+}
+
+void DecoderCache::setCacheSizeMB(uint32_t size_mb)
+{
+    cache_size_mb_.store(size_mb);
+    budget_bytes_.store(static_cast<size_t>(size_mb) * 1024 * 1024);
+
+    size_t budget = shardBudget();
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        evictTo(shard, budget);
+    }
+    Logger::info("DecoderCache: budget set to " + std::to_string(size_mb) + " MB (" + std::to_string(bytesUsed()) + " bytes in use)");
+}
+
+DecoderCache::Shard &DecoderCache::shardFor(const Key &key)
+{
+    // The low bits pick the bucket inside the shard's map; use high bits for the shard
+    return shards_[(KeyHash{}(key) >> 20) % SHARD_COUNT];
+}
+
+void DecoderCache::evictTo(Shard &shard, size_t budget)
+{
+    while (shard.bytes > budget && !shard.lru.empty())
+    {
+        Entry &victim = shard.lru.back();
+        shard.bytes -= victim.bytes;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+    }
+}
+
+std::shared_ptr<const cv::Mat> DecoderCache::get(const Key &key)
+{
+    if (key.path.empty())
+        return nullptr;
+
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+        return nullptr;
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->image;
+}
+
+void DecoderCache::put(const Key &key, std::shared_ptr<const cv::Mat> image)
+{
+    if (key.path.empty() || !image)
+        return;
+
+    // A pooled buffer is rounded up to its size class and belongs to a worker's free lists; the
+    // cache keeps an exact-size copy from the standard allocator, so the budget counts real bytes
+    if (image->u && image->u->currAllocator != cv::Mat::getStdAllocator())
+    {
+        cv::Mat copy;
+        copy.allocator = cv::Mat::getStdAllocator();
+        image->copyTo(copy);
+        image = std::make_shared<const cv::Mat>(std::move(copy));
+    }
+
+    size_t bytes = bytesFor(key, *image);
+    size_t budget = shardBudget();
+    if (bytes > budget)
+        return;
+
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        shard.bytes -= it->second->bytes;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+
+    shard.lru.push_front(Entry{key, std::move(image), bytes});
+    shard.index.emplace(key, shard.lru.begin());
+    shard.bytes += bytes;
+    evictTo(shard, budget);
+}
+
+void DecoderCache::clear()
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.lru.clear();
+        shard.bytes = 0;
+    }
+}
+
+size_t DecoderCache::bytesUsed() const
+{
+    size_t total = 0;
+    for (const auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.bytes;
+    }
+    return total;
+}
+
+size_t DecoderCache::entryCount() const
+{
+    size_t total = 0;
+    for (const auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.lru.size();
+    }
+    return total;
+}
+
+void DecoderCache::onConfigUpdate(const ConfigUpdateEvent &event)
+{
+    bool relevant = std::any_of(event.changed_keys.begin(), event.changed_keys.end(), [](const std::string &key)
+                                { return key == "decoder_cache_size_mb" || key == "cache.decoder_cache_size_mb"; });
+    if (!relevant)
+        return;
+
+    setCacheSizeMB(PocoConfigAdapter::getInstance().getDecoderCacheSizeMB());
+}
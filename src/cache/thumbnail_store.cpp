@@ -0,0 +1,671 @@
+#include "core/cache/thumbnail_store.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <opencv2/core.hpp>
+
+namespace
+{
+    constexpr uint32_t SEGMENT_MAGIC = 0x47534854; // "THSG"
+    constexpr uint32_t RECORD_MAGIC = 0x424d4854;  // "THMB"
+    constexpr uint32_t FORMAT_VERSION = 2;         // 2: per-record CRC
+
+    // Segments are mapped at least this far ahead of their end, then twice as far as before
+    constexpr size_t MIN_MAPPING_BYTES = 4 * 1024 * 1024;
+
+    struct SegmentHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t reserved;
+    };
+
+    // Followed by the path and the pixel data, each padded to 8 bytes
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint32_t path_length;
+        int64_t mtime_ns;
+        uint64_t file_size;
+        int64_t frame_pts;
+        int32_t frame_count;
+        int32_t variant;
+        int32_t rows;
+        int32_t cols;
+        int32_t type;
+        uint32_t crc; // CRC-32 of the whole record with this field zeroed
+        uint64_t data_length;
+    };
+
+    size_t padded(size_t length)
+    {
+        return (length + 7) & ~static_cast<size_t>(7);
+    }
+
+    size_t recordLength(const RecordHeader &header)
+    {
+        return sizeof(RecordHeader) + padded(header.path_length) + padded(header.data_length);
+    }
+
+    // CRC-32 (IEEE 802.3, as zlib)
+    uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0)
+    {
+        static const std::array<uint32_t, 256> table = []
+        {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < length; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    uint32_t recordCrc(const RecordHeader &header, const uint8_t *record)
+    {
+        RecordHeader unsigned_header = header;
+        unsigned_header.crc = 0;
+        uint32_t crc = crc32(reinterpret_cast<const uint8_t *>(&unsigned_header), sizeof(unsigned_header));
+        return crc32(record + sizeof(RecordHeader), recordLength(header) - sizeof(RecordHeader), crc);
+    }
+
+    // The record indexed with this length is still what was written; the header is checked
+    // first so a damaged length never sends the CRC past the record
+    bool intact(const RecordHeader &header, const uint8_t *record, uint64_t length)
+    {
+        return header.magic == RECORD_MAGIC && header.path_length <= length && header.data_length <= length &&
+               recordLength(header) == length && recordCrc(header, record) == header.crc;
+    }
+
+    bool writeAll(int fd, const uint8_t *data, size_t length, off_t offset)
+    {
+        while (length > 0)
+        {
+            ssize_t written = ::pwrite(fd, data, length, offset);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+            offset += written;
+        }
+        return true;
+    }
+
+    std::string segmentName(uint32_t number)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "segment_%06u.thm", number);
+        return name;
+    }
+
+    DecoderCache::Key keyOf(const RecordHeader &header, const uint8_t *record)
+    {
+        DecoderCache::Key key;
+        key.path.assign(reinterpret_cast<const char *>(record + sizeof(RecordHeader)), header.path_length);
+        key.mtime_ns = header.mtime_ns;
+        key.file_size = header.file_size;
+        key.variant = static_cast<DecoderCache::Variant>(header.variant);
+        key.frame_pts = header.frame_pts;
+        key.frame_count = header.frame_count;
+        return key;
+    }
+
+    cv::Mat pixelsOf(const RecordHeader &header, const uint8_t *record)
+    {
+        if (header.data_length == 0)
+            return cv::Mat();
+        auto *data = const_cast<uint8_t *>(record + sizeof(RecordHeader) + padded(header.path_length));
+        return cv::Mat(header.rows, header.cols, header.type, data);
+    }
+}
+
+struct ThumbnailStore::Mapping
+{
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+
+    ~Mapping()
+    {
+        if (data)
+            ::munmap(const_cast<uint8_t *>(data), length);
+    }
+};
+
+ThumbnailStore::ThumbnailStore(size_t items_per_segment)
+    : items_per_segment_(std::max<size_t>(items_per_segment, 1))
+{
+}
+
+ThumbnailStore::~ThumbnailStore()
+{
+    close();
+}
+
+ThumbnailStore &ThumbnailStore::getInstance()
+{
+    static ThumbnailStore instance;
+    return instance;
+}
+
+DecoderCache::Key ThumbnailStore::slotOf(const DecoderCache::Key &key)
+{
+    DecoderCache::Key slot = key;
+    slot.mtime_ns = 0;
+    slot.file_size = 0;
+    return slot;
+}
+
+bool ThumbnailStore::open(const std::string &dir, uint64_t max_bytes)
+{
+    close();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec)
+    {
+        Logger::error("ThumbnailStore: cannot create " + dir + ": " + ec.message());
+        return false;
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> found;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        unsigned number = 0;
+        if (entry.is_regular_file() && std::sscanf(entry.path().filename().c_str(), "segment_%u.thm", &number) == 1)
+            found.emplace_back(number, entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+
+    dir_ = dir;
+    max_bytes_ = max_bytes;
+    for (const auto &[number, path] : found)
+    {
+        bool stale = false;
+        if (!openSegment(path, number, stale))
+        {
+            Logger::error("ThumbnailStore: cannot open segment " + path + ", store disabled");
+            closeLocked();
+            return false;
+        }
+        if (stale)
+        {
+            // Written by an older format: the decodes are simply made again
+            Logger::info("ThumbnailStore: removing segment of an older format " + path);
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+        indexSegment(segments_.size() - 1);
+    }
+
+    // A torn append only ever affects the segment that was being written
+    if (!segments_.empty())
+    {
+        Segment &last = segments_.back();
+        struct stat st;
+        if (::fstat(last.fd, &st) == 0 && static_cast<size_t>(st.st_size) != last.size)
+        {
+            Logger::warn("ThumbnailStore: dropping " + std::to_string(st.st_size - last.size) + " bytes of incomplete record at the end of " + last.path);
+            if (::ftruncate(last.fd, static_cast<off_t>(last.size)) != 0)
+                Logger::warn("ThumbnailStore: could not truncate " + last.path);
+        }
+    }
+
+    if ((segments_.empty() || segments_.back().records >= items_per_segment_) && !startSegment())
+    {
+        closeLocked();
+        return false;
+    }
+
+    // The cap may have been lowered since the last run
+    if (max_bytes_ > 0 && total_bytes_ > max_bytes_)
+        enforceCap();
+
+    Logger::info("ThumbnailStore opened at " + dir + ": " + std::to_string(index_.size()) + " entries in " + std::to_string(segments_.size()) +
+                 " segments, " + std::to_string(total_bytes_ / (1024 * 1024)) + " MB");
+    return true;
+}
+
+void ThumbnailStore::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeLocked();
+}
+
+void ThumbnailStore::closeLocked()
+{
+    for (auto &segment : segments_)
+    {
+        if (segment.fd >= 0)
+            ::close(segment.fd);
+    }
+    segments_.clear();
+    index_.clear();
+    dir_.clear();
+    total_bytes_ = 0;
+}
+
+bool ThumbnailStore::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !segments_.empty();
+}
+
+bool ThumbnailStore::openSegment(const std::string &path, uint32_t number, bool &stale)
+{
+    Segment segment;
+    segment.path = path;
+    segment.number = number;
+    segment.fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (segment.fd < 0)
+        return false;
+
+    SegmentHeader header{};
+    if (::pread(segment.fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || header.magic != SEGMENT_MAGIC)
+    {
+        ::close(segment.fd);
+        return false;
+    }
+    if (header.version != FORMAT_VERSION)
+    {
+        ::close(segment.fd);
+        stale = true;
+        return true;
+    }
+
+    segment.size = sizeof(SegmentHeader);
+    segments_.push_back(segment);
+    if (!ensureMapped(segments_.back(), 0))
+    {
+        ::close(segments_.back().fd);
+        segments_.pop_back();
+        return false;
+    }
+    return true;
+}
+
+void ThumbnailStore::indexSegment(size_t position)
+{
+    Segment &segment = segments_[position];
+    struct stat st;
+    size_t file_length = ::fstat(segment.fd, &st) == 0 ? std::min(static_cast<size_t>(st.st_size), segment.map->length) : 0;
+
+    size_t offset = sizeof(SegmentHeader);
+    while (offset + sizeof(RecordHeader) <= file_length)
+    {
+        RecordHeader header;
+        std::memcpy(&header, segment.map->data + offset, sizeof(header));
+        if (header.magic != RECORD_MAGIC || header.path_length > file_length || header.data_length > file_length ||
+            offset + recordLength(header) > file_length)
+            break;
+
+        const size_t length = recordLength(header);
+        DecoderCache::Key key = keyOf(header, segment.map->data + offset);
+        Location location{segment.number, offset, length, header.mtime_ns, header.file_size};
+        auto [it, inserted] = index_.try_emplace(slotOf(key), location);
+        if (!inserted)
+        {
+            size_t previous = positionOf(it->second.segment);
+            if (previous < segments_.size())
+                segments_[previous].live_bytes -= it->second.length;
+            it->second = location;
+        }
+        segment.live_bytes += length;
+        offset += length;
+        segment.records++;
+    }
+    segment.size = offset;
+    total_bytes_ += offset;
+}
+
+bool ThumbnailStore::ensureMapped(Segment &segment, size_t end)
+{
+    if (segment.map && end <= segment.map->length)
+        return true;
+
+    struct stat st;
+    if (::fstat(segment.fd, &st) != 0)
+        return false;
+    size_t file_length = static_cast<size_t>(st.st_size);
+    if (file_length < end || file_length == 0)
+        return false;
+
+    // Mapped past the end of the file, so the appends that follow stay readable through this
+    // mapping; only the bytes of complete records are ever read
+    size_t length = std::max({file_length, MIN_MAPPING_BYTES, segment.map ? segment.map->length * 2 : 0});
+    void *map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, segment.fd, 0);
+    if (map == MAP_FAILED)
+    {
+        segment.map.reset();
+        return false;
+    }
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<const uint8_t *>(map);
+    mapping->length = length;
+    segment.map = std::move(mapping); // readers still holding the old mapping keep it alive
+    return true;
+}
+
+bool ThumbnailStore::startSegment()
+{
+    uint32_t number = segments_.empty() ? 1 : segments_.back().number + 1;
+    std::string path = (std::filesystem::path(dir_) / segmentName(number)).string();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        Logger::error("ThumbnailStore: cannot create segment " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    SegmentHeader header{SEGMENT_MAGIC, FORMAT_VERSION, 0};
+    if (!writeAll(fd, reinterpret_cast<const uint8_t *>(&header), sizeof(header), 0))
+    {
+        ::close(fd);
+        std::filesystem::remove(path);
+        return false;
+    }
+
+    Segment segment;
+    segment.path = path;
+    segment.number = number;
+    segment.fd = fd;
+    segment.size = sizeof(SegmentHeader);
+    segments_.push_back(segment);
+    total_bytes_ += segment.size;
+    return true;
+}
+
+size_t ThumbnailStore::positionOf(uint32_t number) const
+{
+    auto it = std::lower_bound(segments_.begin(), segments_.end(), number,
+                               [](const Segment &segment, uint32_t n)
+                               { return segment.number < n; });
+    return it != segments_.end() && it->number == number ? static_cast<size_t>(it - segments_.begin()) : segments_.size();
+}
+
+std::shared_ptr<const cv::Mat> ThumbnailStore::get(const DecoderCache::Key &key)
+{
+    if (key.path.empty())
+        return nullptr;
+
+    std::shared_ptr<const Mapping> map;
+    Location location;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(slotOf(key));
+        if (it == index_.end() || it->second.mtime_ns != key.mtime_ns || it->second.file_size != key.file_size)
+            return nullptr;
+
+        location = it->second;
+        size_t position = positionOf(location.segment);
+        if (position == segments_.size() || !ensureMapped(segments_[position], location.offset + location.length))
+            return nullptr;
+        map = segments_[position].map;
+    }
+
+    // Records never change once written, so the check and copy need no lock
+    const uint8_t *record = map->data + location.offset;
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    if (!intact(header, record, location.length))
+    {
+        dropCorrupt(key, location.segment, location.offset);
+        return nullptr;
+    }
+    // Kept in DecoderCache, so copied with the standard allocator rather than into a worker's pool
+    cv::Mat copy;
+    copy.allocator = cv::Mat::getStdAllocator();
+    pixelsOf(header, record).copyTo(copy);
+    return std::make_shared<const cv::Mat>(std::move(copy));
+}
+
+void ThumbnailStore::dropCorrupt(const DecoderCache::Key &key, uint32_t segment, uint64_t offset)
+{
+    Logger::warn("ThumbnailStore: record for " + key.path + " in segment " + std::to_string(segment) + " fails its CRC, dropping it");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(slotOf(key));
+    if (it == index_.end() || it->second.segment != segment || it->second.offset != offset)
+        return;
+    size_t position = positionOf(segment);
+    if (position < segments_.size())
+        segments_[position].live_bytes -= it->second.length;
+    index_.erase(it);
+}
+
+bool ThumbnailStore::put(const DecoderCache::Key &key, const cv::Mat &image)
+{
+    if (key.path.empty())
+        return false;
+
+    cv::Mat pixels = image.isContinuous() ? image : image.clone();
+    RecordHeader header{};
+    header.magic = RECORD_MAGIC;
+    header.path_length = static_cast<uint32_t>(key.path.size());
+    header.mtime_ns = key.mtime_ns;
+    header.file_size = key.file_size;
+    header.frame_pts = key.frame_pts;
+    header.frame_count = key.frame_count;
+    header.variant = static_cast<int32_t>(key.variant);
+    header.rows = pixels.rows;
+    header.cols = pixels.cols;
+    header.type = pixels.type();
+    header.data_length = pixels.total() * pixels.elemSize();
+
+    std::vector<uint8_t> record(recordLength(header), 0);
+    std::memcpy(record.data() + sizeof(header), key.path.data(), key.path.size());
+    if (header.data_length > 0)
+        std::memcpy(record.data() + sizeof(header) + padded(header.path_length), pixels.data, header.data_length);
+    header.crc = recordCrc(header, record.data());
+    std::memcpy(record.data(), &header, sizeof(header));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.empty() || !append(record.data(), record.size(), key))
+        return false;
+    if (max_bytes_ > 0 && total_bytes_ > max_bytes_)
+        enforceCap();
+    return true;
+}
+
+bool ThumbnailStore::append(const uint8_t *record, size_t length, const DecoderCache::Key &key)
+{
+    if (segments_.back().records >= items_per_segment_ && !startSegment())
+        return false;
+
+    Segment &segment = segments_.back();
+    if (!writeAll(segment.fd, record, length, static_cast<off_t>(segment.size)))
+    {
+        Logger::warn("ThumbnailStore: append to " + segment.path + " failed: " + std::strerror(errno));
+        if (::ftruncate(segment.fd, static_cast<off_t>(segment.size)) != 0)
+            Logger::warn("ThumbnailStore: could not truncate " + segment.path);
+        return false;
+    }
+
+    Location location{segment.number, segment.size, length, key.mtime_ns, key.file_size};
+    auto [it, inserted] = index_.try_emplace(slotOf(key), location);
+    if (!inserted)
+    {
+        size_t previous = positionOf(it->second.segment);
+        if (previous < segments_.size())
+            segments_[previous].live_bytes -= it->second.length;
+        it->second = location;
+    }
+    segment.size += length;
+    segment.records++;
+    segment.live_bytes += length;
+    total_bytes_ += length;
+    return true;
+}
+
+void ThumbnailStore::enforceCap()
+{
+    // Sealed segments that are mostly superseded or dropped records, oldest first: their current
+    // records move to the end and the segment goes
+    for (size_t position = 0; total_bytes_ > max_bytes_ && position + 1 < segments_.size();)
+    {
+        const Segment &segment = segments_[position];
+        if (segment.live_bytes * 2 > segment.size - sizeof(SegmentHeader))
+        {
+            ++position;
+            continue;
+        }
+        if (!relocate(position))
+            return;
+    }
+
+    // Still over: the oldest records go
+    size_t dropped = 0;
+    while (total_bytes_ > max_bytes_ && segments_.size() > 1)
+    {
+        dropped += segments_.front().records;
+        dropSegment(0);
+    }
+    if (dropped > 0)
+        Logger::info("ThumbnailStore: dropped the oldest segments (" + std::to_string(dropped) + " records) to stay within " +
+                     std::to_string(max_bytes_ / (1024 * 1024)) + " MB");
+}
+
+bool ThumbnailStore::relocate(size_t position)
+{
+    Segment &source = segments_[position];
+    if (!ensureMapped(source, source.size))
+        return false;
+    const std::shared_ptr<const Mapping> map = source.map; // appends may reallocate segments_
+    const uint32_t number = source.number;
+    const size_t end = source.size;
+
+    for (size_t offset = sizeof(SegmentHeader); offset < end;)
+    {
+        const uint8_t *record = map->data + offset;
+        RecordHeader header;
+        std::memcpy(&header, record, sizeof(header));
+        const size_t length = recordLength(header);
+        if (header.magic != RECORD_MAGIC || offset + length > end)
+            break; // damaged since it was indexed; the rest goes with the segment
+        DecoderCache::Key key = keyOf(header, record);
+
+        auto it = index_.find(slotOf(key));
+        if (it != index_.end() && it->second.segment == number && it->second.offset == offset)
+        {
+            if (!intact(header, record, it->second.length))
+                index_.erase(it); // goes with the segment
+            else if (!append(record, length, key))
+                return false;
+        }
+        offset += length;
+    }
+
+    dropSegment(positionOf(number));
+    return true;
+}
+
+void ThumbnailStore::dropSegment(size_t position)
+{
+    Segment &segment = segments_[position];
+    for (auto it = index_.begin(); it != index_.end();)
+        it = it->second.segment == segment.number ? index_.erase(it) : std::next(it);
+
+    // Readers still holding the mapping keep the data until they let go of it
+    total_bytes_ -= segment.size;
+    ::close(segment.fd);
+    std::error_code ec;
+    std::filesystem::remove(segment.path, ec);
+    segments_.erase(segments_.begin() + static_cast<std::ptrdiff_t>(position));
+}
+
+void ThumbnailStore::forEach(const std::function<void(const DecoderCache::Key &, const cv::Mat &)> &visit)
+{
+    struct Current
+    {
+        DecoderCache::Key key;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    // One segment at a time: collect its current records under the lock, visit them without it
+    bool first = true;
+    uint32_t number = 0;
+    while (true)
+    {
+        std::shared_ptr<const Mapping> map;
+        std::vector<Current> current;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto next = std::find_if(segments_.begin(), segments_.end(), [&](const Segment &segment)
+                                     { return first || segment.number > number; });
+            if (next == segments_.end())
+                return;
+            first = false;
+            number = next->number;
+            if (next->records == 0 || !ensureMapped(*next, next->size))
+                continue;
+            map = next->map;
+
+            size_t offset = sizeof(SegmentHeader);
+            while (offset < next->size)
+            {
+                RecordHeader header;
+                std::memcpy(&header, map->data + offset, sizeof(header));
+                if (header.magic != RECORD_MAGIC || offset + recordLength(header) > next->size)
+                    break; // damaged since it was indexed
+                DecoderCache::Key key = keyOf(header, map->data + offset);
+
+                // Only the newest record of each slot is current
+                auto it = index_.find(slotOf(key));
+                if (it != index_.end() && it->second.segment == number && it->second.offset == offset)
+                    current.push_back({std::move(key), offset, it->second.length});
+                offset += recordLength(header);
+            }
+        }
+
+        for (const auto &entry : current)
+        {
+            const uint8_t *record = map->data + entry.offset;
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+            if (!intact(header, record, entry.length))
+            {
+                dropCorrupt(entry.key, number, entry.offset);
+                continue;
+            }
+            visit(entry.key, pixelsOf(header, record));
+        }
+    }
+}
+
+size_t ThumbnailStore::entryCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+size_t ThumbnailStore::segmentCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+uint64_t ThumbnailStore::diskBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_bytes_;
+}
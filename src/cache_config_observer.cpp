@@ -23,12 +23,7 @@ void CacheConfigObserver::handleDecoderCacheSizeChange(uint32_t new_size_mb)
 {
     Logger::info("Cache configuration changed: decoder_cache_size_mb = " + std::to_string(new_size_mb) + " MB");
 
-    // TODO: Implement cache size adjustment logic
-    // This would typically involve:
-    // 1. Notifying the decoder cache manager
-    // 2. Adjusting cache limits
-    // 3. Potentially clearing old entries if size is reduced
-
+    // DecoderCache and TranscodingManager subscribe to the same key and resize themselves;
+    // a smaller budget evicts least recently used decodes right away
     Logger::info("Decoder cache size updated to " + std::to_string(new_size_mb) + " MB");
-    Logger::warn("Note: Cache size changes may require cache cleanup and may affect performance temporarily");
 }
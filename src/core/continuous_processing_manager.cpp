@@ -299,6 +299,13 @@ void ContinuousProcessingManager::processingLoop()
                     break;
                 }
 
+                // The batch was leased at claim time; skip files whose lease lapsed and went to another worker
+                if (!db_manager.renewProcessingLease(file_info.first))
+                {
+                    processed_count++;
+                    continue;
+                }
+
                 try
                 {
                     processSingleFile(file_info.first, file_info.second);
@@ -1,5 +1,10 @@
 #include "core/memory_pool.hpp"
 #include "core/resource_monitor.hpp"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <opencv2/core.hpp>
 
 // Initialize static members for CommonMemoryPools
 std::unique_ptr<MemoryPool<uint8_t>> CommonMemoryPools::uint8_pool_;
@@ -12,3 +17,235 @@ std::mutex CommonMemoryPools::pools_mutex_;
 // Initialize static members for ResourceMonitor
 std::unique_ptr<ResourceMonitor> ResourceMonitor::instance_;
 std::mutex ResourceMonitor::monitor_mutex_;
+
+namespace
+{
+    // Size classes are powers of two from 256 B to 64 MB; larger buffers go straight to the heap
+    constexpr int MIN_CLASS_SHIFT = 8;
+    constexpr int MAX_CLASS_SHIFT = 26;
+    constexpr int CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+
+    // Free bytes one thread keeps; blocks freed beyond this go back to the heap
+    constexpr size_t MAX_CACHED_BYTES_PER_THREAD = 64 * 1024 * 1024;
+
+    std::atomic<uint64_t> blocks_reused{0};
+    std::atomic<uint64_t> blocks_allocated{0};
+
+    int sizeClass(size_t size)
+    {
+        int shift = MIN_CLASS_SHIFT;
+        while ((static_cast<size_t>(1) << shift) < size)
+        {
+            if (++shift > MAX_CLASS_SHIFT)
+                return -1;
+        }
+        return shift - MIN_CLASS_SHIFT;
+    }
+
+    size_t classBytes(int size_class)
+    {
+        return static_cast<size_t>(1) << (size_class + MIN_CLASS_SHIFT);
+    }
+
+    // Blocks a thread allocated and other threads freed, waiting for it to pick them up
+    struct ReturnedBlocks
+    {
+        std::mutex mutex;
+        std::vector<std::pair<int, void *>> blocks; // size class, block
+        size_t bytes = 0;
+        bool owner_alive = true;
+        std::atomic<bool> any{false}; // lets the owner skip the lock while nothing came back
+    };
+
+    // Every pooled block remembers the thread that allocated it
+    struct PooledUMatData : cv::UMatData
+    {
+        PooledUMatData(const cv::MatAllocator *allocator, std::shared_ptr<ReturnedBlocks> owner)
+            : cv::UMatData(allocator), owner(std::move(owner)) {}
+
+        std::shared_ptr<ReturnedBlocks> owner;
+    };
+
+    // Trivially destructible, so still readable while thread-local destructors run
+    thread_local bool thread_pooling = false;
+    thread_local bool thread_cache_gone = false;
+
+    struct ThreadCache
+    {
+        std::array<std::vector<void *>, CLASS_COUNT> free_blocks;
+        size_t cached_bytes = 0;
+        std::shared_ptr<ReturnedBlocks> returned = std::make_shared<ReturnedBlocks>();
+
+        ~ThreadCache()
+        {
+            thread_cache_gone = true;
+            {
+                std::lock_guard<std::mutex> lock(returned->mutex);
+                returned->owner_alive = false;
+                for (auto &[size_class, block] : returned->blocks)
+                    cv::fastFree(block);
+                returned->blocks.clear();
+            }
+            for (auto &blocks : free_blocks)
+            {
+                for (void *block : blocks)
+                    cv::fastFree(block);
+            }
+        }
+
+        void keep(int size_class, void *block)
+        {
+            if (cached_bytes + classBytes(size_class) > MAX_CACHED_BYTES_PER_THREAD)
+            {
+                cv::fastFree(block);
+                return;
+            }
+            free_blocks[size_class].push_back(block);
+            cached_bytes += classBytes(size_class);
+        }
+
+        void collectReturned()
+        {
+            if (!returned->any.exchange(false))
+                return;
+            std::vector<std::pair<int, void *>> blocks;
+            {
+                std::lock_guard<std::mutex> lock(returned->mutex);
+                blocks.swap(returned->blocks);
+                returned->bytes = 0;
+            }
+            for (auto &[size_class, block] : blocks)
+                keep(size_class, block);
+        }
+    };
+
+    ThreadCache &threadCache()
+    {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    void *takeBlock(int size_class, std::shared_ptr<ReturnedBlocks> &owner)
+    {
+        if (!thread_cache_gone)
+        {
+            ThreadCache &cache = threadCache();
+            owner = cache.returned;
+            auto &blocks = cache.free_blocks[size_class];
+            if (blocks.empty())
+                cache.collectReturned();
+            if (!blocks.empty())
+            {
+                void *block = blocks.back();
+                blocks.pop_back();
+                cache.cached_bytes -= classBytes(size_class);
+                blocks_reused.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+        }
+        blocks_allocated.fetch_add(1, std::memory_order_relaxed);
+        return cv::fastMalloc(classBytes(size_class));
+    }
+
+    void giveBlock(int size_class, void *block, const std::shared_ptr<ReturnedBlocks> &owner)
+    {
+        if (owner && thread_pooling && !thread_cache_gone && threadCache().returned == owner)
+        {
+            threadCache().keep(size_class, block);
+            return;
+        }
+
+        // Freed on another thread (a Mat handed between stages, or a cache evicting): back to the
+        // thread that allocated it, so a pool that hands blocks out also gets them back
+        if (owner)
+        {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            if (owner->owner_alive && owner->bytes + classBytes(size_class) <= MAX_CACHED_BYTES_PER_THREAD)
+            {
+                owner->blocks.emplace_back(size_class, block);
+                owner->bytes += classBytes(size_class);
+                owner->any.store(true);
+                return;
+            }
+        }
+        cv::fastFree(block);
+    }
+
+    class SizeClassMatAllocator : public cv::MatAllocator
+    {
+    public:
+        cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                               cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+        {
+            if (data || !thread_pooling)
+                return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+
+            size_t total = CV_ELEM_SIZE(type);
+            for (int i = dims - 1; i >= 0; i--)
+            {
+                if (step)
+                    step[i] = total;
+                total *= sizes[i];
+            }
+
+            int size_class = sizeClass(total);
+            if (size_class < 0)
+                return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+
+            std::shared_ptr<ReturnedBlocks> owner;
+            void *block = takeBlock(size_class, owner);
+            cv::UMatData *u = new PooledUMatData(this, std::move(owner));
+            u->data = u->origdata = static_cast<unsigned char *>(block);
+            u->size = total;
+            return u;
+        }
+
+        bool allocate(cv::UMatData *u, cv::AccessFlag, cv::UMatUsageFlags) const override
+        {
+            return u != nullptr;
+        }
+
+        void deallocate(cv::UMatData *u) const override
+        {
+            if (!u)
+                return;
+            // Only pooled allocations carry this allocator, so u is a PooledUMatData and its size
+            // always maps to a class
+            auto *pooled = static_cast<PooledUMatData *>(u);
+            giveBlock(sizeClass(pooled->size), pooled->origdata, pooled->owner);
+            pooled->origdata = nullptr;
+            delete pooled;
+        }
+    };
+
+    SizeClassMatAllocator &matAllocator()
+    {
+        // Never destroyed: Mats may still be released while static destructors run
+        static SizeClassMatAllocator *instance = new SizeClassMatAllocator();
+        return *instance;
+    }
+}
+
+void PooledMatAllocator::install()
+{
+    cv::Mat::setDefaultAllocator(&matAllocator());
+    Logger::info("Pooled cv::Mat allocator installed (" + std::to_string(MAX_CACHED_BYTES_PER_THREAD / (1024 * 1024)) + " MB of free blocks per worker thread)");
+}
+
+void PooledMatAllocator::enableForCurrentThread()
+{
+    thread_pooling = true;
+}
+
+cv::MatAllocator *PooledMatAllocator::allocator()
+{
+    return &matAllocator();
+}
+
+PooledMatAllocator::Stats PooledMatAllocator::stats()
+{
+    Stats stats;
+    stats.reused = blocks_reused.load(std::memory_order_relaxed);
+    stats.allocated = blocks_allocated.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,37 @@
+#include "core/network_mount_config_observer.hpp"
+#include "poco_config_adapter.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+
+void NetworkMountConfigObserver::onConfigUpdate(const ConfigUpdateEvent &event)
+{
+    if (!hasNetworkMountChange(event))
+        return;
+
+    try
+    {
+        MountThrottle::getInstance().setLimits(configuredLimits());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Error handling network mount configuration change: " + std::string(e.what()));
+    }
+}
+
+MountThrottle::Limits NetworkMountConfigObserver::configuredLimits()
+{
+    auto &config = PocoConfigAdapter::getInstance();
+    MountThrottle::Limits limits;
+    limits.max_concurrent_io = config.getMountMaxConcurrentIo();
+    limits.bandwidth_mb_per_second = config.getMountBandwidthMBPerSecond();
+    limits.latency_threshold_ms = config.getMountLatencyThresholdMs();
+    limits.acquire_timeout_seconds = config.getMountAcquireTimeoutSeconds();
+    limits.breaker_timeout_seconds = config.getMountBreakerTimeoutSeconds();
+    return limits;
+}
+
+bool NetworkMountConfigObserver::hasNetworkMountChange(const ConfigUpdateEvent &event) const
+{
+    return std::any_of(event.changed_keys.begin(), event.changed_keys.end(), [](const std::string &key)
+                       { return key.rfind("network_mounts", 0) == 0; });
+}
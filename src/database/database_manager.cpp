@@ -19,15 +19,140 @@
 #include <chrono>
 #include <atomic>
 #include <unordered_set>
+#include <map>
 #include <any>
 #include <future>
 #include <functional>
 #include <fstream>
+#include <cstring>
+#include <ctime>
 #include <openssl/sha.h>
 #include <unistd.h>
 
 using json = nlohmann::json;
 
+namespace
+{
+    // Generation stamped on rows as they are written; started by beginScanGeneration. Writes
+    // outside a scan (e.g. the file watcher) get the current one so a running sweep keeps them.
+    const char *const CURRENT_SCAN_GENERATION_SQL =
+        "IFNULL((SELECT CAST(value AS INTEGER) FROM flags WHERE name = 'scan_generation'), 0)";
+
+    // scanned_files columns describing the file itself. Claims, leases, priorities and scan
+    // generation stamps are bookkeeping and do not count as a change of the table.
+    const char *const SCANNED_FILES_CONTENT_COLUMNS =
+        "file_path, relative_path, share_name, file_name, file_extension, media_type, file_metadata, "
+        "file_mtime, file_created, file_size, file_inode, file_device, is_network_file";
+
+    // "UPDATE [OF columns] ON table [WHEN ...]" for a tracked table's version trigger: only
+    // updates of what readers of the version care about bump it
+    std::string versionUpdateEvent(const std::string &table)
+    {
+        if (table == "scanned_files")
+            return std::string("UPDATE OF ") + SCANNED_FILES_CONTENT_COLUMNS + ", links_fast, links_balanced, links_quality ON scanned_files";
+        if (table == "cache_map")
+            // Claims (status 1) and their lease renewals are bookkeeping of the transcoder
+            return "UPDATE OF source_file_path, transcoded_file_path, status ON cache_map WHEN NEW.status IS NOT 1";
+        if (table == "flags")
+            // Flags are upserted to the value they already hold on every scanned_files change
+            return "UPDATE OF value ON flags WHEN OLD.value IS NOT NEW.value";
+        return "UPDATE ON " + table;
+    }
+
+    // Directory path without trailing slashes; the filesystem root stays "/"
+    std::string normalizedDirectory(const std::string &path)
+    {
+        std::string dir = path;
+        while (dir.size() > 1 && dir.back() == '/')
+            dir.pop_back();
+        return dir;
+    }
+
+    // What the subtree range queries ("x >= base || '/' AND x < base || '0'") take for a normalized
+    // directory: the directory itself, or "" for "/" so the range covers every absolute path
+    std::string subtreeBase(const std::string &dir)
+    {
+        return dir == "/" ? "" : dir;
+    }
+
+    // Column holding a mode's processing flag, nullptr for an unknown mode
+    const char *processedColumn(DedupMode mode)
+    {
+        switch (mode)
+        {
+        case DedupMode::FAST:
+            return "processed_fast";
+        case DedupMode::BALANCED:
+            return "processed_balanced";
+        case DedupMode::QUALITY:
+            return "processed_quality";
+        }
+        return nullptr;
+    }
+
+    // "processed_x = <value> OR processed_y = <value>" over the modes other than mode
+    std::string otherModesAre(DedupMode mode, int value)
+    {
+        std::string clause;
+        for (DedupMode other : {DedupMode::FAST, DedupMode::BALANCED, DedupMode::QUALITY})
+        {
+            if (other == mode)
+                continue;
+            clause += std::string(clause.empty() ? "" : " OR ") + processedColumn(other) + " = " + std::to_string(value);
+        }
+        return clause;
+    }
+
+    // Moves a mode's processing flag to flag_value. Parameters: file path, lease owner.
+    // An in-progress mode (-1) only moves while the caller still holds the row's lease, so a
+    // worker whose lease lapsed and was claimed by another cannot overwrite that claim; a
+    // pending mode (0) may be finished by anyone. The lease is released with the row's last
+    // in-progress mode and processing_priority once no mode is pending anymore.
+    std::string finishProcessingSql(DedupMode mode, int flag_value, const std::string &from_states = "0")
+    {
+        const std::string column = processedColumn(mode);
+        const std::string others_in_progress = otherModesAre(mode, -1);
+        const std::string held = "(" + column + " = -1 AND lease_owner = ?)";
+        std::string sql = "UPDATE scanned_files SET " + column + " = " + std::to_string(flag_value);
+        if (flag_value != 0)
+            sql += ", processing_priority = CASE WHEN " + otherModesAre(mode, 0) + " THEN processing_priority ELSE 0 END";
+        return sql +
+               ", lease_owner = CASE WHEN " + others_in_progress + " THEN lease_owner ELSE NULL END" +
+               ", lease_until = CASE WHEN " + others_in_progress + " THEN lease_until ELSE NULL END" +
+               " WHERE file_path = ? AND " + (from_states.empty() ? held : "(" + column + " IN (" + from_states + ") OR " + held + ")");
+    }
+
+    // Cache objects with their reference count and one referencing source, least recently used first
+    const char *const CACHED_TRANSCODES_SQL =
+        "SELECT o.cache_file_path, o.content_key, o.content_hash, o.file_size, o.last_access, "
+        "COUNT(m.id), MIN(m.source_file_path) "
+        "FROM cache_objects o LEFT JOIN cache_map m ON m.transcoded_file_path = o.cache_file_path ";
+
+    std::vector<CachedTranscode> readCachedTranscodes(sqlite3_stmt *stmt)
+    {
+        auto text = [stmt](int column)
+        {
+            const unsigned char *value = sqlite3_column_text(stmt, column);
+            return value ? std::string(reinterpret_cast<const char *>(value)) : std::string();
+        };
+
+        std::vector<CachedTranscode> transcodes;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            CachedTranscode transcode;
+            transcode.transcoded_file_path = text(0);
+            transcode.content_key = text(1);
+            transcode.content_hash = text(2);
+            transcode.file_size = static_cast<uint64_t>(sqlite3_column_int64(stmt, 3));
+            transcode.last_access = sqlite3_column_int64(stmt, 4);
+            transcode.references = static_cast<size_t>(sqlite3_column_int64(stmt, 5));
+            transcode.source_file_path = text(6);
+            transcodes.push_back(std::move(transcode));
+        }
+        return transcodes;
+    }
+}
+
 size_t DatabaseManager::enqueueWriteInline(std::function<WriteOperationResult(DatabaseManager &)> operation)
 {
     size_t op_id = inline_next_operation_id_.fetch_add(1);
@@ -132,6 +257,12 @@ DatabaseManager::DatabaseManager(const std::string &db_path)
     : db_(nullptr), db_path_(db_path)
 {
     Logger::info("DatabaseManager constructor called for: " + db_path);
+    char hostname[256] = {0};
+    if (gethostname(hostname, sizeof(hostname) - 1) != 0)
+    {
+        std::strcpy(hostname, "localhost");
+    }
+    lease_owner_id_ = std::string(hostname) + ":" + std::to_string(getpid());
     // Open database inline
     auto open_future = enqueueReadInline([db_path](DatabaseManager &dbMan)
                                          {
@@ -278,16 +409,24 @@ void DatabaseManager::initialize()
     // TODO: Re-enable script-based initialization once path resolution is fixed
     if (!createScannedFilesTable())
         Logger::error("Failed to create scanned_files table");
+    if (!upgradeScannedFilesSchema())
+        Logger::error("Failed to upgrade scanned_files schema");
     if (!createMediaProcessingResultsTable())
         Logger::error("Failed to create media_processing_results table");
     if (!createUserInputsTable())
         Logger::error("Failed to create user_inputs table");
     if (!createCacheMapTable())
         Logger::error("Failed to create cache_map table");
+    if (!createCacheObjectsTable())
+        Logger::error("Failed to create cache_objects table");
     if (!createFlagsTable())
         Logger::error("Failed to create flags table");
+    if (!createDirectoryManifestTable())
+        Logger::error("Failed to create directory_manifest table");
     if (!createScannedFilesChangeTriggers())
         Logger::error("Failed to create scanned_files change triggers");
+    if (!createTableVersionTracking())
+        Logger::error("Failed to create table version tracking");
 
     Logger::info("Database tables initialization completed");
 }
@@ -361,7 +500,18 @@ bool DatabaseManager::createScannedFilesTable()
             relative_path TEXT,           -- For network mounts: share:relative/path
             share_name TEXT,              -- The share name (B, G, etc.)
             file_name TEXT NOT NULL,
+            file_extension TEXT,          -- Lowercased extension without the dot, computed at scan time
+            media_type TEXT,              -- Media category (image, video, audio), computed at scan time
+            processing_priority INTEGER DEFAULT 0, -- Claim order boost (1 = deferred RAW file whose transcode finished)
+            lease_owner TEXT,             -- host:pid of the worker holding the in-progress (-1) claim
+            lease_until INTEGER DEFAULT 0, -- Unix time the claim expires; expired -1 rows are reclaimed lazily
             file_metadata TEXT,           -- File metadata for change detection (creation date, modification date, size)
+            file_mtime INTEGER,           -- Same stat as binary columns, compared without parsing in scan diffs
+            file_created INTEGER,
+            file_size INTEGER,
+            file_inode INTEGER,
+            file_device INTEGER,
+            scan_generation INTEGER DEFAULT 0, -- Scan generation that last stored or confirmed the file; older rows are swept after full walks
             processed_fast BOOLEAN DEFAULT 0,      -- Processing flag for FAST mode
             processed_balanced BOOLEAN DEFAULT 0,  -- Processing flag for BALANCED mode
             processed_quality BOOLEAN DEFAULT 0,   -- Processing flag for QUALITY mode
@@ -375,6 +525,201 @@ bool DatabaseManager::createScannedFilesTable()
     return executeStatement(sql).success;
 }
 
+bool DatabaseManager::upgradeScannedFilesSchema()
+{
+    // Older databases predate the file_extension/media_type/processing_priority
+    // columns. Add them, backfill existing rows once, and index them so
+    // enabled-type filtering and pending-work claims are index lookups.
+    // Rows are classified against every configured extension, enabled or not, so rows
+    // stored before that (media_type NULL for a disabled type) are picked up again.
+    std::map<std::string, std::string> media_types;
+    std::vector<std::string> known_extensions;
+    for (const auto &[ext, media_type] : PocoConfigAdapter::getInstance().getMediaTypesByExtension())
+    {
+        media_types[MediaProcessor::getFileExtension("." + ext)] = media_type;
+        known_extensions.push_back(ext);
+    }
+    const std::string pending_sql = "SELECT id, file_name FROM scanned_files WHERE file_extension IS NULL OR (media_type IS NULL AND " +
+                                    buildExtensionInClause("file_extension", known_extensions) + ")";
+
+    bool success = true;
+    enqueueWriteInline([&media_types, &pending_sql, &success](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            success = false;
+            return WriteOperationResult::Failure("Database not initialized");
+        }
+
+        std::unordered_set<std::string> columns;
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(dbMan.db_, "PRAGMA table_info(scanned_files)", -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            success = false;
+            return WriteOperationResult::Failure("Failed to read scanned_files schema: " + std::string(sqlite3_errmsg(dbMan.db_)));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            columns.insert(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+        }
+        sqlite3_finalize(stmt);
+
+        const std::vector<std::pair<std::string, std::string>> required_columns = {
+            {"file_extension", "TEXT"},
+            {"media_type", "TEXT"},
+            {"processing_priority", "INTEGER DEFAULT 0"},
+            {"lease_owner", "TEXT"},
+            {"lease_until", "INTEGER DEFAULT 0"},
+            {"file_mtime", "INTEGER"},
+            {"file_created", "INTEGER"},
+            {"file_size", "INTEGER"},
+            {"file_inode", "INTEGER"},
+            {"file_device", "INTEGER"},
+            {"scan_generation", "INTEGER DEFAULT 0"}};
+        for (const auto &[column, type] : required_columns)
+        {
+            if (columns.count(column))
+                continue;
+            std::string alter_sql = "ALTER TABLE scanned_files ADD COLUMN " + column + " " + type;
+            if (sqlite3_exec(dbMan.db_, alter_sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+            {
+                success = false;
+                return WriteOperationResult::Failure("Failed to add column " + column + ": " + std::string(sqlite3_errmsg(dbMan.db_)));
+            }
+            Logger::info("Added column scanned_files." + column);
+        }
+
+        if (!columns.empty() && !columns.count("processing_priority"))
+        {
+            // RAW files deferred while waiting for transcoding used to sit at -1 and be
+            // found through a cache_map join. Requeue the ones whose transcode already
+            // finished with a priority boost, which is how they are tracked now.
+            const char *requeue_sql = R"(
+                UPDATE scanned_files
+                SET processed_fast = CASE WHEN processed_fast = -1 THEN 0 ELSE processed_fast END,
+                    processed_balanced = CASE WHEN processed_balanced = -1 THEN 0 ELSE processed_balanced END,
+                    processed_quality = CASE WHEN processed_quality = -1 THEN 0 ELSE processed_quality END,
+                    processing_priority = 1
+                WHERE (processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1)
+                  AND file_path IN (SELECT source_file_path FROM cache_map WHERE status = 2)
+            )";
+            if (sqlite3_exec(dbMan.db_, requeue_sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+            {
+                Logger::warn("Failed to requeue transcoded files pending processing: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            }
+        }
+
+        // Backfill rows stored before the columns existed, or before disabled types were classified
+        std::vector<std::pair<int64_t, std::string>> pending;
+        if (sqlite3_prepare_v2(dbMan.db_, pending_sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                pending.emplace_back(sqlite3_column_int64(stmt, 0), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        if (!pending.empty())
+        {
+            sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+            sqlite3_stmt *update_stmt;
+            if (sqlite3_prepare_v2(dbMan.db_, "UPDATE scanned_files SET file_extension = ?, media_type = ? WHERE id = ?", -1, &update_stmt, nullptr) != SQLITE_OK)
+            {
+                sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+                success = false;
+                return WriteOperationResult::Failure("Failed to prepare backfill statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            }
+            for (const auto &[id, file_name] : pending)
+            {
+                std::string ext = MediaProcessor::getFileExtension(file_name);
+                auto it = media_types.find(ext);
+                sqlite3_bind_text(update_stmt, 1, ext.c_str(), -1, SQLITE_TRANSIENT);
+                if (it != media_types.end())
+                    sqlite3_bind_text(update_stmt, 2, it->second.c_str(), -1, SQLITE_TRANSIENT);
+                else
+                    sqlite3_bind_null(update_stmt, 2);
+                sqlite3_bind_int64(update_stmt, 3, id);
+                sqlite3_step(update_stmt);
+                sqlite3_reset(update_stmt);
+                sqlite3_clear_bindings(update_stmt);
+            }
+            sqlite3_finalize(update_stmt);
+            sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr);
+            Logger::info("Backfilled file_extension/media_type for " + std::to_string(pending.size()) + " scanned files");
+        }
+
+        // Split the string-encoded metadata of older rows into the binary stat columns, once
+        std::vector<std::pair<int64_t, std::string>> legacy_metadata;
+        if (sqlite3_prepare_v2(dbMan.db_, "SELECT id, file_metadata FROM scanned_files WHERE file_size IS NULL AND file_metadata IS NOT NULL", -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                legacy_metadata.emplace_back(sqlite3_column_int64(stmt, 0), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        if (!legacy_metadata.empty())
+        {
+            sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+            sqlite3_stmt *update_stmt;
+            if (sqlite3_prepare_v2(dbMan.db_, "UPDATE scanned_files SET file_mtime = ?, file_created = ?, file_size = ?, file_inode = ?, file_device = ? WHERE id = ?", -1, &update_stmt, nullptr) != SQLITE_OK)
+            {
+                sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+                success = false;
+                return WriteOperationResult::Failure("Failed to prepare stat backfill statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            }
+            size_t converted = 0;
+            for (const auto &[id, metadata_str] : legacy_metadata)
+            {
+                auto metadata = FileUtils::metadataFromString(metadata_str);
+                if (!metadata)
+                    continue; // Left NULL; compared as changed and rewritten on the next scan
+                bindFileStat(update_stmt, 1, metadata);
+                sqlite3_bind_int64(update_stmt, 6, id);
+                sqlite3_step(update_stmt);
+                sqlite3_reset(update_stmt);
+                sqlite3_clear_bindings(update_stmt);
+                ++converted;
+            }
+            sqlite3_finalize(update_stmt);
+            sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr);
+            Logger::info("Backfilled binary stat columns for " + std::to_string(converted) + " scanned files");
+        }
+
+        // Pending work is a small, moving subset of the table. Partial indexes keep
+        // only those rows, ordered the way claims consume them, so claim/complete/fail
+        // are O(log n) instead of scanning the low-selectivity flag columns. A per-mode
+        // claim also satisfies the any-mode predicate, so those queries name their own
+        // index with INDEXED BY rather than leave the choice to the planner.
+        const char *index_sql = R"(
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_file_extension ON scanned_files (file_extension);
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_media_type ON scanned_files (media_type);
+            DROP INDEX IF EXISTS idx_scanned_files_processed_fast;
+            DROP INDEX IF EXISTS idx_scanned_files_processed_balanced;
+            DROP INDEX IF EXISTS idx_scanned_files_processed_quality;
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_any ON scanned_files (processing_priority DESC, created_at DESC)
+                WHERE processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0;
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_fast ON scanned_files (processing_priority DESC, created_at DESC)
+                WHERE processed_fast = 0;
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_balanced ON scanned_files (processing_priority DESC, created_at DESC)
+                WHERE processed_balanced = 0;
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_quality ON scanned_files (processing_priority DESC, created_at DESC)
+                WHERE processed_quality = 0;
+            CREATE INDEX IF NOT EXISTS idx_scanned_files_in_progress ON scanned_files (lease_until)
+                WHERE processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1;
+        )";
+        if (sqlite3_exec(dbMan.db_, index_sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            success = false;
+            return WriteOperationResult::Failure("Failed to create scanned_files indexes: " + std::string(sqlite3_errmsg(dbMan.db_)));
+        }
+        return WriteOperationResult(true); });
+
+    return success;
+}
+
 bool DatabaseManager::createUserInputsTable()
 {
     const std::string sql = R"(
@@ -396,11 +741,63 @@ bool DatabaseManager::createCacheMapTable()
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             source_file_path TEXT NOT NULL UNIQUE,
             transcoded_file_path TEXT,
+            status INTEGER DEFAULT 0,     -- 0 = queued, 1 = in progress, 2 = done, 3 = failed
+            worker_id TEXT,               -- host:pid of the worker holding the in-progress lease
+            lease_until INTEGER DEFAULT 0, -- Unix time the in-progress lease expires
             created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
             updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
             FOREIGN KEY (source_file_path) REFERENCES scanned_files(file_path) ON DELETE CASCADE
         )
     )";
+    if (!executeStatement(sql).success)
+        return false;
+
+    // Jobs not transcoded yet, in the order claimNextTranscodingJob takes them; sources sharing a
+    // transcoded file, for reference counts and cache eviction
+    const std::string index_sql = R"(
+        CREATE INDEX IF NOT EXISTS idx_cache_map_pending ON cache_map (created_at, id)
+            WHERE transcoded_file_path IS NULL;
+        CREATE INDEX IF NOT EXISTS idx_cache_map_transcoded ON cache_map (transcoded_file_path)
+            WHERE transcoded_file_path IS NOT NULL
+    )";
+    return executeStatement(index_sql).success;
+}
+
+bool DatabaseManager::createCacheObjectsTable()
+{
+    // cache_map.transcoded_file_path points here; sources with identical content share a row
+    const std::string sql = R"(
+        CREATE TABLE IF NOT EXISTS cache_objects (
+            cache_file_path TEXT PRIMARY KEY,
+            content_key TEXT,              -- FileUtils::computeSampledFileHash of the source; NULL for files cached by path
+            content_hash TEXT,             -- FileUtils::computeFileHash of the source
+            file_size INTEGER DEFAULT 0,   -- Bytes of the transcoded file
+            last_access INTEGER DEFAULT 0, -- Unix time the transcoded file was last handed out
+            created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+        )
+    )";
+    if (!executeStatement(sql).success)
+        return false;
+
+    // Eviction order, and the lookup of files with the same source content
+    const std::string index_sql = R"(
+        CREATE INDEX IF NOT EXISTS idx_cache_objects_lru ON cache_objects (last_access);
+        CREATE INDEX IF NOT EXISTS idx_cache_objects_content_key ON cache_objects (content_key)
+            WHERE content_key IS NOT NULL
+    )";
+    return executeStatement(index_sql).success;
+}
+
+bool DatabaseManager::createDirectoryManifestTable()
+{
+    const std::string sql = R"(
+        CREATE TABLE IF NOT EXISTS directory_manifest (
+            dir_path TEXT PRIMARY KEY,
+            parent_path TEXT,
+            mtime_ns INTEGER NOT NULL,      -- Directory mtime when it was last listed (or confirmed unchanged)
+            scan_generation INTEGER NOT NULL -- Walk that last saw this directory; older rows under a root are pruned
+        ) WITHOUT ROWID
+    )";
     return executeStatement(sql).success;
 }
 
@@ -431,9 +828,14 @@ bool DatabaseManager::createScannedFilesChangeTriggers()
     if (!res1.success)
         return false;
 
-    const std::string sql2 = R"(
-        CREATE TRIGGER IF NOT EXISTS trg_scanned_files_changed_update
-        AFTER UPDATE ON scanned_files
+    // Only changes to the file itself count; claims and lease renewals rewrite the row constantly.
+    // Recreated so databases with the older any-column trigger pick this up.
+    if (!executeStatement("DROP TRIGGER IF EXISTS trg_scanned_files_changed_update").success)
+        return false;
+    const std::string sql2 = std::string(
+                                 "CREATE TRIGGER trg_scanned_files_changed_update"
+                                 " AFTER UPDATE OF ") +
+                             SCANNED_FILES_CONTENT_COLUMNS + " ON scanned_files" + R"(
         BEGIN
             INSERT INTO flags(name, value, updated_at) VALUES ('transcode_preprocess_scanned_files_changed', 1, CURRENT_TIMESTAMP)
             ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
@@ -458,6 +860,64 @@ bool DatabaseManager::createScannedFilesChangeTriggers()
     return true;
 }
 
+const std::vector<std::string> &DatabaseManager::versionTrackedTables()
+{
+    static const std::vector<std::string> tables = {
+        "scanned_files", "media_processing_results", "cache_map", "user_inputs", "flags"};
+    return tables;
+}
+
+bool DatabaseManager::createTableVersionTracking()
+{
+    // One counter row per tracked table, bumped by triggers on every change of its content.
+    // Hash endpoints and the duplicate linker read these instead of re-reading table contents.
+    const std::string table_sql = R"(
+        CREATE TABLE IF NOT EXISTS table_versions (
+            table_name TEXT PRIMARY KEY,
+            version INTEGER NOT NULL DEFAULT 0
+        )
+    )";
+    if (!executeStatement(table_sql).success)
+        return false;
+
+    // Counters start at the time they are first created (microseconds) rather than 0, so a
+    // version cached against a deleted and recreated database cannot match the new one's
+    const int64_t epoch = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+
+    for (const auto &table : versionTrackedTables())
+    {
+        const std::string seed_sql = "INSERT OR IGNORE INTO table_versions(table_name, version) VALUES ('" + table + "', " +
+                                     std::to_string(epoch) + ")";
+        if (!executeStatement(seed_sql).success)
+            return false;
+
+        for (const char *event : {"INSERT", "UPDATE", "DELETE"})
+        {
+            std::string event_name = event;
+            std::transform(event_name.begin(), event_name.end(), event_name.begin(), ::tolower);
+            const std::string trigger_name = "trg_" + table + "_version_" + event_name;
+            const bool is_update = event_name == "update";
+
+            // Update triggers are recreated so databases with the older any-column trigger pick up the column list
+            if (is_update && !executeStatement("DROP TRIGGER IF EXISTS " + trigger_name).success)
+                return false;
+            const std::string trigger_sql =
+                "CREATE TRIGGER IF NOT EXISTS " + trigger_name +
+                " AFTER " + (is_update ? versionUpdateEvent(table) : std::string(event) + " ON " + table) +
+                " BEGIN"
+                " INSERT INTO table_versions(table_name, version) VALUES ('" + table + "', 1)"
+                " ON CONFLICT(table_name) DO UPDATE SET version = version + 1;"
+                " END;";
+            if (!executeStatement(trigger_sql).success)
+                return false;
+        }
+    }
+
+    return true;
+}
+
 bool DatabaseManager::getFlag(const std::string &flag_name)
 {
     if (!waitForQueueInitialization())
@@ -969,6 +1429,124 @@ std::vector<std::pair<std::string, ProcessingResult>> DatabaseManager::getAllPro
     return results;
 }
 
+std::vector<std::tuple<long, std::string, ProcessingResult, size_t>> DatabaseManager::getProcessingResultsPage(long after_id, size_t limit)
+{
+    Logger::debug("getProcessingResultsPage called after id " + std::to_string(after_id) + " limit " + std::to_string(limit));
+    std::vector<std::tuple<long, std::string, ProcessingResult, size_t>> results;
+
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return results;
+    }
+
+    long captured_after_id = after_id;
+    size_t captured_limit = limit;
+
+    auto future = enqueueReadInline([captured_after_id, captured_limit](DatabaseManager &dbMan)
+                                    {
+        std::vector<std::tuple<long, std::string, ProcessingResult, size_t>> results;
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return std::any(results);
+        }
+
+        // Seek on the primary key so each page costs O(limit) regardless of how deep it is
+        const std::string select_sql = R"(
+            SELECT id, file_path, processing_mode, success,
+                   artifact_format, artifact_hash, artifact_confidence,
+                   artifact_metadata, IFNULL(length(artifact_data), 0)
+            FROM media_processing_results
+            WHERE id > ?
+            ORDER BY id
+            LIMIT ?
+        )";
+
+        sqlite3_stmt *stmt;
+        int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare select statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(results);
+        }
+        sqlite3_bind_int64(stmt, 1, captured_after_id);
+        sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(captured_limit));
+
+        results.reserve(captured_limit);
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            long id = sqlite3_column_int64(stmt, 0);
+            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            ProcessingResult result;
+
+            result.success = sqlite3_column_int(stmt, 3) != 0;
+
+            if (sqlite3_column_type(stmt, 4) != SQLITE_NULL)
+            {
+                result.artifact.format = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4));
+            }
+
+            if (sqlite3_column_type(stmt, 5) != SQLITE_NULL)
+            {
+                result.artifact.hash = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5));
+            }
+
+            result.artifact.confidence = sqlite3_column_double(stmt, 6);
+
+            if (sqlite3_column_type(stmt, 7) != SQLITE_NULL)
+            {
+                result.artifact.metadata = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 7));
+            }
+
+            // Listings only report the artifact's size; the BLOB itself stays in the database
+            size_t data_size = static_cast<size_t>(sqlite3_column_int64(stmt, 8));
+
+            results.emplace_back(id, file_path, std::move(result), data_size);
+        }
+
+        sqlite3_finalize(stmt);
+        return std::any(results); });
+
+    try
+    {
+        results = std::any_cast<std::vector<std::tuple<long, std::string, ProcessingResult, size_t>>>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Failed to get processing results page: " + std::string(e.what()));
+    }
+
+    return results;
+}
+
+size_t DatabaseManager::getProcessingResultsCount()
+{
+    if (!waitForQueueInitialization())
+        return 0;
+
+    auto future = enqueueReadInline([](DatabaseManager &dbMan)
+                                    {
+        if (!dbMan.db_) return std::any(size_t(0));
+        sqlite3_stmt *stmt = nullptr;
+        size_t count = 0;
+        if (sqlite3_prepare_v2(dbMan.db_, "SELECT COUNT(*) FROM media_processing_results", -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+                count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+            sqlite3_finalize(stmt);
+        }
+        return std::any(count); });
+    try
+    {
+        return std::any_cast<size_t>(future.get());
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
 DBOpResult DatabaseManager::clearAllResults()
 {
     if (!waitForQueueInitialization())
@@ -1150,6 +1728,30 @@ ProcessingResult DatabaseManager::jsonToResult(const std::string &json_str)
 
 DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
                                              std::function<void(const std::string &)> onFileNeedsProcessing)
+{
+    // Callers without walker metadata pay for one stat here
+    Logger::debug("Getting metadata for file: " + file_path);
+    auto metadata = FileUtils::getFileMetadata(file_path);
+    std::string metadata_str;
+    if (metadata)
+    {
+        metadata_str = FileUtils::metadataToString(*metadata);
+    }
+    else
+    {
+        Logger::warn("Could not get metadata for file: " + file_path);
+    }
+    return storeScannedFileRecord(file_path, metadata_str, onFileNeedsProcessing);
+}
+
+DBOpResult DatabaseManager::storeScannedFile(const FileMetadata &metadata,
+                                             std::function<void(const std::string &)> onFileNeedsProcessing)
+{
+    return storeScannedFileRecord(metadata.file_path, FileUtils::metadataToString(metadata), onFileNeedsProcessing);
+}
+
+DBOpResult DatabaseManager::storeScannedFileRecord(const std::string &file_path, const std::string &current_metadata_str,
+                                                   std::function<void(const std::string &)> onFileNeedsProcessing)
 {
     if (!waitForQueueInitialization())
     {
@@ -1160,6 +1762,8 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
 
     std::filesystem::path path(file_path);
     std::string file_name = path.filename().string();
+    std::string file_extension = MediaProcessor::getFileExtension(file_name);
+    std::string media_type = MediaProcessor::getMediaCategory(file_name);
 
     // Check if this is a network path and convert to relative path
     auto &mount_manager = MountManager::getInstance();
@@ -1182,32 +1786,22 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
         }
     }
 
-    // Always compute metadata during scanning
-    Logger::debug("Getting metadata for file: " + file_path);
-    auto metadata = FileUtils::getFileMetadata(file_path);
-    std::string current_metadata_str;
-    if (metadata)
-    {
-        current_metadata_str = FileUtils::metadataToString(*metadata);
-    }
-    else
-    {
-        Logger::warn("Could not get metadata for file: " + file_path);
-    }
-
     // Capture parameters for async execution
     std::string captured_file_path = file_path;
     std::string captured_file_name = file_name;
+    std::string captured_file_extension = file_extension;
+    std::string captured_media_type = media_type;
     std::string captured_relative_path = relative_path;
     std::string captured_share_name = share_name;
     bool captured_is_network = is_network_file;
     std::string captured_metadata_str = current_metadata_str;
+    auto captured_metadata = FileUtils::metadataFromString(current_metadata_str);
     auto captured_callback = onFileNeedsProcessing;
     std::string error_msg;
     bool success = true;
 
     // Enqueue the write operation
-    enqueueWriteInline([captured_file_path, captured_file_name, captured_relative_path, captured_share_name, captured_is_network, captured_metadata_str, captured_callback, &error_msg, &success](DatabaseManager &dbMan)
+    enqueueWriteInline([captured_file_path, captured_file_name, captured_file_extension, captured_media_type, captured_relative_path, captured_share_name, captured_is_network, captured_metadata_str, captured_metadata, captured_callback, &error_msg, &success](DatabaseManager &dbMan)
                        {
         if (!dbMan.db_)
         {
@@ -1218,7 +1812,8 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
         }
         
         // Check if file already exists
-        const std::string select_sql = "SELECT file_metadata, processed_fast, processed_balanced, processed_quality FROM scanned_files WHERE file_path = ?";
+        const std::string select_sql = "SELECT file_metadata, processed_fast, processed_balanced, processed_quality, "
+                                       "file_mtime, file_created, file_size, file_inode, file_device FROM scanned_files WHERE file_path = ?";
         sqlite3_stmt *select_stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &select_stmt, nullptr);
         if (rc != SQLITE_OK)
@@ -1238,9 +1833,23 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
                 // Metadata exists, compare with current metadata
                 std::string existing_metadata_str = reinterpret_cast<const char *>(sqlite3_column_text(select_stmt, 0));
                 
-                // Parse existing metadata
-                auto existing_metadata = FileUtils::metadataFromString(existing_metadata_str);
-                auto current_metadata = FileUtils::metadataFromString(captured_metadata_str);
+                // Prefer the binary stat columns; rows not backfilled yet fall back to the string
+                std::optional<FileMetadata> existing_metadata;
+                if (sqlite3_column_type(select_stmt, 6) != SQLITE_NULL)
+                {
+                    FileMetadata stored{};
+                    stored.modification_time = static_cast<std::time_t>(sqlite3_column_int64(select_stmt, 4));
+                    stored.creation_time = static_cast<std::time_t>(sqlite3_column_int64(select_stmt, 5));
+                    stored.file_size = static_cast<uint64_t>(sqlite3_column_int64(select_stmt, 6));
+                    stored.inode = static_cast<uint64_t>(sqlite3_column_int64(select_stmt, 7));
+                    stored.device_id = static_cast<uint64_t>(sqlite3_column_int64(select_stmt, 8));
+                    existing_metadata = stored;
+                }
+                else
+                {
+                    existing_metadata = FileUtils::metadataFromString(existing_metadata_str);
+                }
+                const auto &current_metadata = captured_metadata;
                 
                 if (existing_metadata && current_metadata && *existing_metadata == *current_metadata)
                 {
@@ -1249,11 +1858,46 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
                     Logger::debug("File metadata matches, file unchanged: " + captured_file_path);
                     return WriteOperationResult(true);
                 }
+                else if (existing_metadata && current_metadata &&
+                         FileUtils::isLegacyMetadataOf(existing_metadata->modification_time, existing_metadata->file_size,
+                                                       existing_metadata->inode, existing_metadata->device_id, *current_metadata))
+                {
+                    // Recorded before inode/device were captured on Linux (and with a different mtime
+                    // encoding) but unchanged since: refresh the metadata in place rather than reprocessing the file
+                    sqlite3_finalize(select_stmt);
+                    const std::string refresh_sql = "UPDATE scanned_files SET file_metadata = ?, file_mtime = ?, file_created = ?, file_size = ?, file_inode = ?, file_device = ?, "
+                                                    "scan_generation = " + std::string(CURRENT_SCAN_GENERATION_SQL) + " WHERE file_path = ?";
+                    sqlite3_stmt *refresh_stmt;
+                    rc = sqlite3_prepare_v2(dbMan.db_, refresh_sql.c_str(), -1, &refresh_stmt, nullptr);
+                    if (rc != SQLITE_OK)
+                    {
+                        error_msg = "Failed to prepare metadata refresh statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+                        Logger::error(error_msg);
+                        success = false;
+                        return WriteOperationResult::Failure(error_msg);
+                    }
+                    sqlite3_bind_text(refresh_stmt, 1, captured_metadata_str.c_str(), -1, SQLITE_STATIC);
+                    bindFileStat(refresh_stmt, 2, captured_metadata);
+                    sqlite3_bind_text(refresh_stmt, 7, captured_file_path.c_str(), -1, SQLITE_STATIC);
+                    rc = sqlite3_step(refresh_stmt);
+                    sqlite3_finalize(refresh_stmt);
+                    if (rc != SQLITE_DONE)
+                    {
+                        error_msg = "Failed to refresh file metadata: " + std::string(sqlite3_errmsg(dbMan.db_));
+                        Logger::error(error_msg);
+                        success = false;
+                        return WriteOperationResult::Failure(error_msg);
+                    }
+                    Logger::debug("Upgraded legacy file metadata for: " + captured_file_path);
+                    return WriteOperationResult(true);
+                }
                 else
                 {
                     // Metadata differs, file has changed - clear all processing flags
                     sqlite3_finalize(select_stmt);
-                    const std::string update_sql = "UPDATE scanned_files SET file_metadata = ?, processed_fast = 0, processed_balanced = 0, processed_quality = 0, created_at = CURRENT_TIMESTAMP WHERE file_path = ?";
+                    const std::string update_sql = "UPDATE scanned_files SET file_metadata = ?, file_mtime = ?, file_created = ?, file_size = ?, file_inode = ?, file_device = ?, "
+                                                   "processed_fast = 0, processed_balanced = 0, processed_quality = 0, processing_priority = 0, created_at = CURRENT_TIMESTAMP, "
+                                                   "scan_generation = " + std::string(CURRENT_SCAN_GENERATION_SQL) + " WHERE file_path = ?";
                     sqlite3_stmt *update_stmt;
                     rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &update_stmt, nullptr);
                     if (rc != SQLITE_OK)
@@ -1264,7 +1908,8 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
                         return WriteOperationResult::Failure(error_msg);
                     }
                     sqlite3_bind_text(update_stmt, 1, captured_metadata_str.c_str(), -1, SQLITE_STATIC);
-                    sqlite3_bind_text(update_stmt, 2, captured_file_path.c_str(), -1, SQLITE_STATIC);
+                    bindFileStat(update_stmt, 2, captured_metadata);
+                    sqlite3_bind_text(update_stmt, 7, captured_file_path.c_str(), -1, SQLITE_STATIC);
                     rc = sqlite3_step(update_stmt);
                     sqlite3_finalize(update_stmt);
                     if (rc != SQLITE_DONE)
@@ -1300,7 +1945,9 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
         {
             // File doesn't exist, insert it with metadata
             sqlite3_finalize(select_stmt);
-            const std::string insert_sql = "INSERT INTO scanned_files (file_path, file_name, relative_path, share_name, is_network_file, file_metadata) VALUES (?, ?, ?, ?, ?, ?)";
+            const std::string insert_sql = "INSERT INTO scanned_files (file_path, file_name, relative_path, share_name, is_network_file, file_metadata, file_extension, media_type, "
+                                           "file_mtime, file_created, file_size, file_inode, file_device, scan_generation) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, " +
+                                           std::string(CURRENT_SCAN_GENERATION_SQL) + ")";
             sqlite3_stmt *insert_stmt;
             rc = sqlite3_prepare_v2(dbMan.db_, insert_sql.c_str(), -1, &insert_stmt, nullptr);
             if (rc != SQLITE_OK)
@@ -1316,6 +1963,12 @@ DBOpResult DatabaseManager::storeScannedFile(const std::string &file_path,
             sqlite3_bind_text(insert_stmt, 4, captured_share_name.c_str(), -1, SQLITE_STATIC);
             sqlite3_bind_int(insert_stmt, 5, captured_is_network ? 1 : 0);
             sqlite3_bind_text(insert_stmt, 6, captured_metadata_str.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert_stmt, 7, captured_file_extension.c_str(), -1, SQLITE_STATIC);
+            if (captured_media_type.empty())
+                sqlite3_bind_null(insert_stmt, 8);
+            else
+                sqlite3_bind_text(insert_stmt, 8, captured_media_type.c_str(), -1, SQLITE_STATIC);
+            bindFileStat(insert_stmt, 9, captured_metadata);
             rc = sqlite3_step(insert_stmt);
             sqlite3_finalize(insert_stmt);
             if (rc != SQLITE_DONE)
@@ -1396,6 +2049,89 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAllScannedF
     return results;
 }
 
+std::vector<std::tuple<long, std::string, std::string>> DatabaseManager::getScannedFilesPage(long after_id, size_t limit)
+{
+    Logger::debug("getScannedFilesPage called after id " + std::to_string(after_id) + " limit " + std::to_string(limit));
+    std::vector<std::tuple<long, std::string, std::string>> results;
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return results;
+    }
+
+    long captured_after_id = after_id;
+    size_t captured_limit = limit;
+
+    auto future = enqueueReadInline([captured_after_id, captured_limit](DatabaseManager &dbMan)
+                                    {
+        std::vector<std::tuple<long, std::string, std::string>> results;
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return std::any(results);
+        }
+
+        const std::string select_sql = "SELECT id, file_path, file_name FROM scanned_files WHERE id > ? ORDER BY id LIMIT ?";
+        sqlite3_stmt *stmt;
+        int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare select statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(results);
+        }
+        sqlite3_bind_int64(stmt, 1, captured_after_id);
+        sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(captured_limit));
+
+        results.reserve(captured_limit);
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            long id = sqlite3_column_int64(stmt, 0);
+            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+            results.emplace_back(id, file_path, file_name);
+        }
+        sqlite3_finalize(stmt);
+        return std::any(results); });
+
+    try
+    {
+        results = std::any_cast<std::vector<std::tuple<long, std::string, std::string>>>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Failed to get scanned files page: " + std::string(e.what()));
+    }
+
+    return results;
+}
+
+size_t DatabaseManager::getScannedFilesCount()
+{
+    if (!waitForQueueInitialization())
+        return 0;
+
+    auto future = enqueueReadInline([](DatabaseManager &dbMan)
+                                    {
+        if (!dbMan.db_) return std::any(size_t(0));
+        sqlite3_stmt *stmt = nullptr;
+        size_t count = 0;
+        if (sqlite3_prepare_v2(dbMan.db_, "SELECT COUNT(*) FROM scanned_files", -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+                count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+            sqlite3_finalize(stmt);
+        }
+        return std::any(count); });
+    try
+    {
+        return std::any_cast<size_t>(future.get());
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
 bool DatabaseManager::fileExistsInDatabase(const std::string &file_path)
 {
     Logger::debug("fileExistsInDatabase called for: " + file_path);
@@ -1550,18 +2286,18 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getFilesNeedin
         
         // Build the SQL query based on the mode
         std::string select_sql;
-        std::string file_type_clauses = generateFileTypeLikeClauses();
+        std::string file_type_clauses = generateFileTypeInClause();
         
         switch (captured_mode)
         {
             case DedupMode::FAST:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_fast = 0 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_fast WHERE processed_fast = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::BALANCED:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_balanced = 0 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_balanced WHERE processed_balanced = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::QUALITY:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_quality = 0 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_quality WHERE processed_quality = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
         }
         
@@ -1778,6 +2514,152 @@ DBOpResult DatabaseManager::storeUserInput(const std::string &input_type, const
     return DBOpResult(true, "");
 }
 
+DirectoryManifest DatabaseManager::getDirectoryManifest(const std::string &root_path)
+{
+    DirectoryManifest manifest;
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return manifest;
+    }
+
+    std::string captured_root = normalizedDirectory(root_path);
+    auto future = enqueueReadInline([captured_root](DatabaseManager &dbMan)
+                                    {
+        DirectoryManifest manifest;
+        if (!dbMan.db_)
+            return std::any(manifest);
+
+        // The root itself plus everything below it; the range form keeps the primary key usable
+        const char *sql = "SELECT dir_path, parent_path, mtime_ns FROM directory_manifest "
+                          "WHERE dir_path = ?1 OR (dir_path >= ?2 || '/' AND dir_path < ?2 || '0')";
+        const std::string base = subtreeBase(captured_root);
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare directory manifest select: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(manifest);
+        }
+        sqlite3_bind_text(stmt, 1, captured_root.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, base.c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            DirectoryManifestEntry entry;
+            entry.dir_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            const unsigned char *parent = sqlite3_column_text(stmt, 1);
+            entry.parent_path = parent ? reinterpret_cast<const char *>(parent) : "";
+            entry.mtime_ns = sqlite3_column_int64(stmt, 2);
+            std::string key = entry.dir_path;
+            manifest.emplace(std::move(key), std::move(entry));
+        }
+        sqlite3_finalize(stmt);
+        return std::any(manifest); });
+
+    try
+    {
+        manifest = std::any_cast<DirectoryManifest>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Failed to get directory manifest: " + std::string(e.what()));
+    }
+    return manifest;
+}
+
+DBOpResult DatabaseManager::replaceDirectoryManifest(const std::string &root_path, const std::vector<DirectoryManifestEntry> &entries)
+{
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    std::string captured_root = normalizedDirectory(root_path);
+    std::vector<DirectoryManifestEntry> captured_entries = entries;
+    std::string error_msg;
+    bool success = true;
+
+    enqueueWriteInline([captured_root, captured_entries, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        auto fail = [&](const std::string &what)
+        {
+            error_msg = what + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+        sqlite3_int64 generation = 1;
+        sqlite3_stmt *gen_stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, "SELECT IFNULL(MAX(scan_generation), 0) + 1 FROM directory_manifest", -1, &gen_stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare manifest generation select");
+        if (sqlite3_step(gen_stmt) == SQLITE_ROW)
+            generation = sqlite3_column_int64(gen_stmt, 0);
+        sqlite3_finalize(gen_stmt);
+
+        const char *upsert_sql = R"(
+            INSERT INTO directory_manifest (dir_path, parent_path, mtime_ns, scan_generation)
+            VALUES (?, ?, ?, ?)
+            ON CONFLICT(dir_path) DO UPDATE SET
+                parent_path = excluded.parent_path,
+                mtime_ns = excluded.mtime_ns,
+                scan_generation = excluded.scan_generation
+        )";
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, upsert_sql, -1, &stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare manifest upsert");
+        for (const auto &entry : captured_entries)
+        {
+            sqlite3_bind_text(stmt, 1, entry.dir_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, entry.parent_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 3, entry.mtime_ns);
+            sqlite3_bind_int64(stmt, 4, generation);
+            if (sqlite3_step(stmt) != SQLITE_DONE)
+            {
+                sqlite3_finalize(stmt);
+                return fail("Failed to upsert manifest entry " + entry.dir_path);
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        // Directories under this root that the walk no longer reached were removed or moved away
+        const char *prune_sql = "DELETE FROM directory_manifest WHERE scan_generation < ?2 "
+                                "AND (dir_path = ?1 OR (dir_path >= ?3 || '/' AND dir_path < ?3 || '0'))";
+        if (sqlite3_prepare_v2(dbMan.db_, prune_sql, -1, &stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare manifest prune");
+        const std::string base = subtreeBase(captured_root);
+        sqlite3_bind_text(stmt, 1, captured_root.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, generation);
+        sqlite3_bind_text(stmt, 3, base.c_str(), -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+            return fail("Failed to prune directory manifest");
+
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit directory manifest");
+
+        Logger::debug("Stored directory manifest for " + captured_root + ": " + std::to_string(captured_entries.size()) + " directories");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true, "");
+}
+
 std::vector<std::string> DatabaseManager::getUserInputs(const std::string &input_type)
 {
     Logger::debug("getUserInputs called for type: " + input_type);
@@ -2622,11 +3504,7 @@ bool DatabaseManager::fileNeedsProcessingForMode(const std::string &file_path, D
         // Only return true if the file is actually supported
         if (needs_processing) {
             // Check if file has a supported extension using configuration
-            std::string file_extension = MediaProcessor::getFileExtension(captured_file_path);
-            auto enabled_types = PocoConfigAdapter::getInstance().getEnabledFileTypes();
-            bool has_supported_extension = std::find(enabled_types.begin(), enabled_types.end(), file_extension) != enabled_types.end();
-            
-            needs_processing = has_supported_extension;
+            needs_processing = MediaProcessor::isSupportedFile(captured_file_path);
         }
         
         Logger::debug("File " + captured_file_path + " processing flag for mode " + DedupModes::getModeName(captured_mode) + ": " + std::to_string(processing_flag) + " (needs processing: " + (needs_processing ? "true" : "false") + ")");
@@ -2651,7 +3529,7 @@ bool DatabaseManager::fileNeedsProcessingForMode(const std::string &file_path, D
 
 // Cache map (transcoding) methods
 
-DBOpResult DatabaseManager::insertTranscodingFile(const std::string &source_file_path)
+DBOpResult DatabaseManager::insertTranscodingFile(const std::string &source_file_path, bool requeue_handed_off)
 {
     Logger::debug("insertTranscodingFile called for: " + source_file_path);
 
@@ -2668,7 +3546,7 @@ DBOpResult DatabaseManager::insertTranscodingFile(const std::string &source_file
     bool success = true;
 
     // Enqueue the write operation
-    enqueueWriteInline([captured_source_file_path, &error_msg, &success](DatabaseManager &dbMan)
+    enqueueWriteInline([captured_source_file_path, requeue_handed_off, &error_msg, &success](DatabaseManager &dbMan)
                        {
         Logger::debug("Executing insertTranscodingFile in write queue for: " + captured_source_file_path);
         
@@ -2680,9 +3558,17 @@ DBOpResult DatabaseManager::insertTranscodingFile(const std::string &source_file
             return WriteOperationResult::Failure(error_msg);
         }
         
-        const std::string insert_sql = R"(
-            INSERT OR IGNORE INTO cache_map 
-            (source_file_path, transcoded_file_path)
+        // Rows already present (queued, in progress, completed or failed) are left alone. On
+        // request a job completed without a cache file, whose pixels only went to the in-memory
+        // handoff, is queued again.
+        const std::string insert_sql = requeue_handed_off ? R"(
+            INSERT INTO cache_map (source_file_path, transcoded_file_path)
+            VALUES (?, NULL)
+            ON CONFLICT (source_file_path) DO UPDATE SET status = 0, worker_id = NULL, lease_until = 0
+            WHERE status = 2 AND transcoded_file_path IS NULL
+        )"
+                                                          : R"(
+            INSERT OR IGNORE INTO cache_map (source_file_path, transcoded_file_path)
             VALUES (?, NULL)
         )";
 
@@ -2720,7 +3606,69 @@ DBOpResult DatabaseManager::insertTranscodingFile(const std::string &source_file
     return DBOpResult(true);
 }
 
-DBOpResult DatabaseManager::updateTranscodedFilePath(const std::string &source_file_path, const std::string &transcoded_file_path)
+DBOpResult DatabaseManager::insertTranscodingFiles(const std::vector<std::string> &source_file_paths)
+{
+    if (source_file_paths.empty())
+        return DBOpResult(true);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    std::string error_msg;
+    bool success = true;
+    enqueueWriteInline([&source_file_paths, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        auto fail = [&](const std::string &msg)
+        {
+            error_msg = msg + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin transaction");
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, "INSERT OR IGNORE INTO cache_map (source_file_path, transcoded_file_path) VALUES (?, NULL)",
+                               -1, &stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare statement");
+        for (const auto &path : source_file_paths)
+        {
+            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE)
+            {
+                sqlite3_finalize(stmt);
+                return fail("Failed to insert transcoding file " + path);
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit transcoding files");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true);
+}
+
+DBOpResult DatabaseManager::updateTranscodedFilePath(const std::string &source_file_path, const std::string &transcoded_file_path, uint64_t file_size,
+                                                     const std::string &content_key, const std::string &content_hash)
 {
     Logger::debug("updateTranscodedFilePath called for: " + source_file_path + " -> " + transcoded_file_path);
 
@@ -2738,7 +3686,7 @@ DBOpResult DatabaseManager::updateTranscodedFilePath(const std::string &source_f
     bool success = true;
 
     // Enqueue the write operation
-    enqueueWriteInline([captured_source_file_path, captured_transcoded_file_path, &error_msg, &success](DatabaseManager &dbMan)
+    enqueueWriteInline([captured_source_file_path, captured_transcoded_file_path, file_size, &content_key, &content_hash, &error_msg, &success](DatabaseManager &dbMan)
                        {
         Logger::debug("Executing updateTranscodedFilePath in write queue for: " + captured_source_file_path);
         
@@ -2749,6 +3697,15 @@ DBOpResult DatabaseManager::updateTranscodedFilePath(const std::string &source_f
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
+
+        // Object first: a crash in between leaves an unreferenced object, never a dangling path
+        if (!upsertCacheObject(dbMan.db_, captured_transcoded_file_path, file_size, content_key, content_hash))
+        {
+            error_msg = "Failed to record cache object: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
         
         const std::string update_sql = R"(
             UPDATE cache_map 
@@ -2866,47 +3823,50 @@ std::string DatabaseManager::claimNextTranscodingJob()
     }
 
     std::string file_path;
-    auto future = enqueueReadInline([&file_path](DatabaseManager &dbMan)
-                                    {
-        Logger::debug("Executing claimNextTranscodingJob in access queue");
+    enqueueWriteInline([&file_path](DatabaseManager &dbMan)
+                       {
+        Logger::debug("Executing claimNextTranscodingJob in write queue");
 
         if (!dbMan.db_)
         {
             Logger::error("Database not initialized");
-            return std::any(std::string(""));
+            return WriteOperationResult::Failure("Database not initialized");
         }
 
-        const std::string select_sql =
-            "SELECT source_file_path FROM cache_map WHERE status = 0 AND transcoded_file_path IS NULL ORDER BY created_at ASC LIMIT 1";
+        // Pick and lease the oldest queued job (or one whose worker let the lease lapse) in one
+        // statement, so no other worker can claim it between the select and the mark
+        const std::string claim_sql =
+            "UPDATE cache_map SET status = 1, worker_id = ?1, lease_until = ?2, updated_at = CURRENT_TIMESTAMP "
+            "WHERE id = (SELECT id FROM cache_map WHERE (status = 0 OR (status = 1 AND lease_until < ?3)) "
+            "AND transcoded_file_path IS NULL ORDER BY created_at ASC, id ASC LIMIT 1) "
+            "RETURNING source_file_path";
         sqlite3_stmt *stmt = nullptr;
-        int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
+        int rc = sqlite3_prepare_v2(dbMan.db_, claim_sql.c_str(), -1, &stmt, nullptr);
         if (rc != SQLITE_OK)
         {
-            Logger::error("Failed to prepare job selection statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
-            return std::any(std::string(""));
+            std::string msg = "Failed to prepare job claim statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(msg);
+            return WriteOperationResult::Failure(msg);
         }
+        sqlite3_bind_text(stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, nextLeaseExpiry());
+        sqlite3_bind_int64(stmt, 3, static_cast<int64_t>(std::time(nullptr)));
 
-        rc = sqlite3_step(stmt);
-        if (rc == SQLITE_ROW)
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
         {
             file_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         }
-
         sqlite3_finalize(stmt);
-        return std::any(file_path); });
 
-    try
-    {
-        auto result = future.get();
-        if (result.has_value())
+        if (rc != SQLITE_DONE)
         {
-            file_path = std::any_cast<std::string>(result);
+            file_path.clear();
+            std::string msg = "Failed to claim transcoding job: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(msg);
+            return WriteOperationResult::Failure(msg);
         }
-    }
-    catch (const std::exception &e)
-    {
-        Logger::error("Error in claimNextTranscodingJob: " + std::string(e.what()));
-    }
+        return WriteOperationResult(); });
+    waitForWrites();
 
     if (!file_path.empty())
     {
@@ -2937,7 +3897,7 @@ bool DatabaseManager::markTranscodingJobInProgress(const std::string &source_fil
             return WriteOperationResult::Failure(error_msg);
         }
         const std::string update_sql =
-            "UPDATE cache_map SET status = 1, worker_id = ?, updated_at = CURRENT_TIMESTAMP WHERE source_file_path = ?";
+            "UPDATE cache_map SET status = 1, worker_id = ?, lease_until = ?, updated_at = CURRENT_TIMESTAMP WHERE source_file_path = ?";
         sqlite3_stmt *stmt = nullptr;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
         if (rc != SQLITE_OK)
@@ -2947,9 +3907,9 @@ bool DatabaseManager::markTranscodingJobInProgress(const std::string &source_fil
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
-        std::string worker_id = std::to_string(getpid());
-        sqlite3_bind_text(stmt, 1, worker_id.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, captured.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, nextLeaseExpiry());
+        sqlite3_bind_text(stmt, 3, captured.c_str(), -1, SQLITE_STATIC);
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
         if (rc != SQLITE_DONE)
@@ -2965,7 +3925,8 @@ bool DatabaseManager::markTranscodingJobInProgress(const std::string &source_fil
     return success;
 }
 
-bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file_path, const std::string &transcoded_file_path)
+bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file_path, const std::string &transcoded_file_path, uint64_t file_size,
+                                                  const std::string &content_key, const std::string &content_hash)
 {
     if (!waitForQueueInitialization())
     {
@@ -2977,7 +3938,7 @@ bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file
     std::string out = transcoded_file_path;
     bool success = true;
     std::string error_msg;
-    enqueueWriteInline([src, out, &success, &error_msg](DatabaseManager &dbMan)
+    enqueueWriteInline([src, out, file_size, &content_key, &content_hash, &success, &error_msg](DatabaseManager &dbMan)
                        {
         if (!dbMan.db_)
         {
@@ -2986,6 +3947,13 @@ bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
+        if (!out.empty() && !upsertCacheObject(dbMan.db_, out, file_size, content_key, content_hash))
+        {
+            error_msg = "Failed to record cache object: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
         const std::string update_sql =
             "UPDATE cache_map SET status = 2, transcoded_file_path = ?, updated_at = CURRENT_TIMESTAMP WHERE source_file_path = ?";
         sqlite3_stmt *stmt = nullptr;
@@ -2997,7 +3965,11 @@ bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
-        sqlite3_bind_text(stmt, 1, out.c_str(), -1, SQLITE_STATIC);
+        // No output path: the pixels were only handed over in memory
+        if (out.empty())
+            sqlite3_bind_null(stmt, 1);
+        else
+            sqlite3_bind_text(stmt, 1, out.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_STATIC);
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3008,13 +3980,43 @@ bool DatabaseManager::markTranscodingJobCompleted(const std::string &source_file
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
+
+        // Modes parked at -2 waiting for this transcode go back to pending with a priority
+        // boost so the next claim picks them up ahead of regular work. Modes another worker
+        // holds in progress (-1) are left alone.
+        const std::string requeue_sql = R"(
+            UPDATE scanned_files
+            SET processed_fast = CASE WHEN processed_fast = -2 THEN 0 ELSE processed_fast END,
+                processed_balanced = CASE WHEN processed_balanced = -2 THEN 0 ELSE processed_balanced END,
+                processed_quality = CASE WHEN processed_quality = -2 THEN 0 ELSE processed_quality END,
+                processing_priority = 1
+            WHERE file_path = ? AND (processed_fast = -2 OR processed_balanced = -2 OR processed_quality = -2)
+        )";
+        rc = sqlite3_prepare_v2(dbMan.db_, requeue_sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            error_msg = "Failed to prepare requeue after transcode: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        sqlite3_bind_text(stmt, 1, src.c_str(), -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            error_msg = "Failed to requeue after transcode: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
         Logger::debug("Marked job completed: " + src + " -> " + out);
         return WriteOperationResult(); });
     waitForWrites();
     return success;
 }
 
-bool DatabaseManager::markTranscodingJobFailed(const std::string &source_file_path)
+bool DatabaseManager::releaseTranscodingJob(const std::string &source_file_path)
 {
     if (!waitForQueueInitialization())
     {
@@ -3034,36 +4036,110 @@ bool DatabaseManager::markTranscodingJobFailed(const std::string &source_file_pa
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
+        // Only our own lease: a job another worker reclaimed after ours lapsed stays with it
         const std::string update_sql =
-            "UPDATE cache_map SET status = 3, updated_at = CURRENT_TIMESTAMP WHERE source_file_path = ?";
+            "UPDATE cache_map SET status = 0, worker_id = NULL, lease_until = NULL, updated_at = CURRENT_TIMESTAMP "
+            "WHERE source_file_path = ? AND status = 1 AND worker_id = ?";
         sqlite3_stmt *stmt = nullptr;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
         if (rc != SQLITE_OK)
         {
-            error_msg = "Failed to prepare mark failed: " + std::string(sqlite3_errmsg(dbMan.db_));
+            error_msg = "Failed to prepare job release: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
         sqlite3_bind_text(stmt, 1, src.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
         if (rc != SQLITE_DONE)
         {
-            error_msg = "Failed to mark failed: " + std::string(sqlite3_errmsg(dbMan.db_));
+            error_msg = "Failed to release job: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
-        Logger::debug("Marked job failed: " + src);
+        Logger::debug("Released transcoding job: " + src);
         return WriteOperationResult(); });
     waitForWrites();
     return success;
 }
 
-std::vector<std::string> DatabaseManager::getFilesNeedingTranscoding()
+bool DatabaseManager::markTranscodingJobFailed(const std::string &source_file_path)
 {
-    Logger::debug("getFilesNeedingTranscoding called");
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return false;
+    }
+    std::string src = source_file_path;
+    bool success = true;
+    std::string error_msg;
+    enqueueWriteInline([src, &success, &error_msg](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        const std::string update_sql =
+            "UPDATE cache_map SET status = 3, updated_at = CURRENT_TIMESTAMP WHERE source_file_path = ?";
+        sqlite3_stmt *stmt = nullptr;
+        int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            error_msg = "Failed to prepare mark failed: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        sqlite3_bind_text(stmt, 1, src.c_str(), -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            error_msg = "Failed to mark failed: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        // Files waiting for this transcode move to the transcoding error state (3), which
+        // retryTranscodingErrorFiles picks up
+        const char *park_sql = R"(
+            UPDATE scanned_files
+            SET processed_fast = CASE WHEN processed_fast = -2 THEN 3 ELSE processed_fast END,
+                processed_balanced = CASE WHEN processed_balanced = -2 THEN 3 ELSE processed_balanced END,
+                processed_quality = CASE WHEN processed_quality = -2 THEN 3 ELSE processed_quality END
+            WHERE file_path = ? AND (processed_fast = -2 OR processed_balanced = -2 OR processed_quality = -2)
+        )";
+        rc = sqlite3_prepare_v2(dbMan.db_, park_sql, -1, &stmt, nullptr);
+        if (rc == SQLITE_OK)
+        {
+            sqlite3_bind_text(stmt, 1, src.c_str(), -1, SQLITE_STATIC);
+            rc = sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+        }
+        if (rc != SQLITE_DONE)
+        {
+            error_msg = "Failed to flag files waiting for failed transcode: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        Logger::debug("Marked job failed: " + src);
+        return WriteOperationResult(); });
+    waitForWrites();
+    return success;
+}
+
+std::vector<std::string> DatabaseManager::getFilesNeedingTranscoding()
+{
+    Logger::debug("getFilesNeedingTranscoding called");
 
     if (!waitForQueueInitialization())
     {
@@ -3096,29 +4172,21 @@ std::vector<std::string> DatabaseManager::getFilesNeedingTranscoding()
         }
         
         // Build dynamic SQL query based on enabled RAW formats
-        std::string query = R"(
-            SELECT DISTINCT cm.source_file_path 
-            FROM cache_map cm
-            JOIN scanned_files sf ON cm.source_file_path = sf.file_path
-            WHERE cm.transcoded_file_path IS NULL 
-            AND (
-        )";
-        
-        bool first = true;
+        std::vector<std::string> enabled_extensions;
         for (const auto& [extension, enabled] : transcoding_types)
         {
             if (enabled) // Only include enabled formats
             {
-                if (!first)
-                {
-                    query += " OR ";
-                }
-                query += "LOWER(sf.file_name) LIKE '%." + extension + "'";
-                first = false;
+                enabled_extensions.push_back(extension);
             }
         }
-        
-        query += ")";
+
+        std::string query = R"(
+            SELECT DISTINCT cm.source_file_path 
+            FROM cache_map cm
+            JOIN scanned_files sf ON cm.source_file_path = sf.file_path
+            WHERE cm.transcoded_file_path IS NULL 
+            AND )" + buildExtensionInClause("sf.file_extension", enabled_extensions);
         
         Logger::debug("Dynamic SQL query for transcoding: " + query);
         
@@ -3211,12 +4279,983 @@ bool DatabaseManager::fileNeedsTranscoding(const std::string &source_file_path)
         Logger::error("Error checking if file needs transcoding: " + std::string(e.what()));
     }
 
-    return needs_transcoding;
+    return needs_transcoding;
+}
+
+ScannedFileStats DatabaseManager::getScannedFileStats(const std::string &root_path)
+{
+    Logger::debug("getScannedFileStats called for: " + root_path);
+    ScannedFileStats stats;
+
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return stats;
+    }
+
+    // Only the range below the root is queried
+    std::string captured_root = subtreeBase(normalizedDirectory(root_path));
+
+    auto future = enqueueReadInline([captured_root](DatabaseManager &dbMan)
+                                    {
+        ScannedFileStats result;
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return std::any(result);
+        }
+
+        // Everything strictly below the root, as one range over the file_path index
+        const char *sql = "SELECT file_path, file_mtime, file_created, file_size, file_inode, file_device, file_metadata "
+                          "FROM scanned_files WHERE file_path >= ?1 || '/' AND file_path < ?1 || '0'";
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(dbMan.db_, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare scanned file stats query: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(result);
+        }
+        sqlite3_bind_text(stmt, 1, captured_root.c_str(), -1, SQLITE_STATIC);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            StoredFileStat stat;
+            if (sqlite3_column_type(stmt, 3) != SQLITE_NULL)
+            {
+                stat.modification_time = sqlite3_column_int64(stmt, 1);
+                stat.creation_time = sqlite3_column_int64(stmt, 2);
+                stat.file_size = static_cast<uint64_t>(sqlite3_column_int64(stmt, 3));
+                stat.inode = static_cast<uint64_t>(sqlite3_column_int64(stmt, 4));
+                stat.device_id = static_cast<uint64_t>(sqlite3_column_int64(stmt, 5));
+            }
+            else if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
+            {
+                // Not backfilled (unparseable or written by an older build)
+                if (auto legacy = FileUtils::metadataFromString(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 6))))
+                {
+                    stat.modification_time = legacy->modification_time;
+                    stat.creation_time = legacy->creation_time;
+                    stat.file_size = legacy->file_size;
+                    stat.inode = legacy->inode;
+                    stat.device_id = legacy->device_id;
+                }
+            }
+            result.emplace(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), stat);
+        }
+        sqlite3_finalize(stmt);
+        return std::any(result); });
+
+    try
+    {
+        stats = std::any_cast<ScannedFileStats>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Error loading scanned file stats: " + std::string(e.what()));
+    }
+    return stats;
+}
+
+DBOpResult DatabaseManager::applyScanDiff(const ScanDiff &diff, const MountTable *mounts)
+{
+    if (diff.empty())
+        return DBOpResult(true);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    // Per-file columns for new rows, computed outside the write queue as storeScannedFile does
+    struct NewRow
+    {
+        const FileMetadata *metadata;
+        std::string metadata_str;
+        std::string file_name;
+        std::string file_extension;
+        std::string media_type;
+        std::string relative_path;
+        std::string share_name;
+        bool is_network;
+    };
+    std::vector<NewRow> new_rows;
+    new_rows.reserve(diff.inserted.size());
+    // The scan's mount table keeps mount lookups off the per-file path and every batch of one
+    // scan on the same view of the mounts
+    std::shared_ptr<const MountTable> current_mounts;
+    if (!mounts)
+    {
+        current_mounts = MountManager::getInstance().snapshot();
+        mounts = current_mounts.get();
+    }
+    for (const auto &metadata : diff.inserted)
+    {
+        NewRow row{&metadata, FileUtils::metadataToString(metadata), "", "", "", "", "", false};
+        row.file_name = std::filesystem::path(metadata.file_path).filename().string();
+        row.file_extension = MediaProcessor::getFileExtension(row.file_name);
+        row.media_type = MediaProcessor::getMediaCategory(row.file_name);
+        row.is_network = mounts->isNetworkPath(metadata.file_path);
+        if (row.is_network)
+        {
+            if (auto relative = mounts->toRelativePath(metadata.file_path))
+            {
+                row.relative_path = relative->share_name + ":" + relative->relative_path;
+                row.share_name = relative->share_name;
+            }
+        }
+        new_rows.push_back(std::move(row));
+    }
+
+    std::string error_msg;
+    bool success = true;
+    std::vector<std::string> cache_files;
+
+    enqueueWriteInline([&diff, &new_rows, &cache_files, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        sqlite3_stmt *insert_stmt = nullptr;
+        sqlite3_stmt *change_stmt = nullptr;
+        sqlite3_stmt *refresh_stmt = nullptr;
+        sqlite3_stmt *seen_stmt = nullptr;
+        sqlite3_stmt *detach_stmt = nullptr;
+        sqlite3_stmt *delete_stmt = nullptr;
+        auto finalizeAll = [&]()
+        {
+            sqlite3_finalize(insert_stmt);
+            sqlite3_finalize(change_stmt);
+            sqlite3_finalize(refresh_stmt);
+            sqlite3_finalize(seen_stmt);
+            sqlite3_finalize(detach_stmt);
+            sqlite3_finalize(delete_stmt);
+        };
+        auto fail = [&](const std::string &msg)
+        {
+            error_msg = msg + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            finalizeAll();
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            cache_files.clear();
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            error_msg = "Failed to begin scan diff transaction: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        // Every row written or confirmed here carries the current scan generation
+        sqlite3_int64 generation = 0;
+        sqlite3_stmt *gen_stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, ("SELECT " + std::string(CURRENT_SCAN_GENERATION_SQL)).c_str(), -1, &gen_stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare scan generation select");
+        if (sqlite3_step(gen_stmt) == SQLITE_ROW)
+            generation = sqlite3_column_int64(gen_stmt, 0);
+        sqlite3_finalize(gen_stmt);
+
+        // A row stored meanwhile (e.g. by the file watcher) is left alone
+        const char *insert_sql = "INSERT OR IGNORE INTO scanned_files (file_path, file_name, relative_path, share_name, is_network_file, file_metadata, "
+                                 "file_extension, media_type, file_mtime, file_created, file_size, file_inode, file_device, scan_generation) "
+                                 "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        const char *change_sql = "UPDATE scanned_files SET file_metadata = ?, file_mtime = ?, file_created = ?, file_size = ?, file_inode = ?, file_device = ?, "
+                                 "scan_generation = ?, processed_fast = 0, processed_balanced = 0, processed_quality = 0, processing_priority = 0, "
+                                 "created_at = CURRENT_TIMESTAMP WHERE file_path = ?";
+        const char *refresh_sql = "UPDATE scanned_files SET file_metadata = ?, file_mtime = ?, file_created = ?, file_size = ?, file_inode = ?, file_device = ?, "
+                                  "scan_generation = ? WHERE file_path = ?";
+        // Unchanged files are only restamped: their paths are collected in a temp table and the
+        // stamp is one set-based UPDATE, which also skips rows that already carry this generation
+        if (sqlite3_exec(dbMan.db_, "CREATE TEMP TABLE IF NOT EXISTS scan_seen_paths (file_path TEXT PRIMARY KEY) WITHOUT ROWID",
+                         nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            return fail("Failed to prepare seen paths table");
+        }
+        const char *seen_sql = "INSERT OR IGNORE INTO temp.scan_seen_paths (file_path) VALUES (?)";
+        const char *detach_sql = "SELECT s.id, s.links_fast, s.links_balanced, s.links_quality, c.transcoded_file_path "
+                                 "FROM scanned_files s LEFT JOIN cache_map c ON c.source_file_path = s.file_path WHERE s.file_path = ?";
+        const char *delete_sql = "DELETE FROM scanned_files WHERE file_path = ?";
+        if (sqlite3_prepare_v2(dbMan.db_, insert_sql, -1, &insert_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, change_sql, -1, &change_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, refresh_sql, -1, &refresh_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, seen_sql, -1, &seen_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, detach_sql, -1, &detach_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, delete_sql, -1, &delete_stmt, nullptr) != SQLITE_OK)
+        {
+            return fail("Failed to prepare scan diff statements");
+        }
+
+        for (const auto &row : new_rows)
+        {
+            sqlite3_bind_text(insert_stmt, 1, row.metadata->file_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert_stmt, 2, row.file_name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert_stmt, 3, row.relative_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert_stmt, 4, row.share_name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(insert_stmt, 5, row.is_network ? 1 : 0);
+            sqlite3_bind_text(insert_stmt, 6, row.metadata_str.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert_stmt, 7, row.file_extension.c_str(), -1, SQLITE_STATIC);
+            if (row.media_type.empty())
+                sqlite3_bind_null(insert_stmt, 8);
+            else
+                sqlite3_bind_text(insert_stmt, 8, row.media_type.c_str(), -1, SQLITE_STATIC);
+            bindFileStat(insert_stmt, 9, *row.metadata);
+            sqlite3_bind_int64(insert_stmt, 14, generation);
+            if (sqlite3_step(insert_stmt) != SQLITE_DONE)
+                return fail("Failed to insert scanned file " + row.metadata->file_path);
+            sqlite3_reset(insert_stmt);
+        }
+
+        auto updateRows = [&](sqlite3_stmt *stmt, const std::vector<FileMetadata> &rows)
+        {
+            for (const auto &metadata : rows)
+            {
+                std::string metadata_str = FileUtils::metadataToString(metadata);
+                sqlite3_bind_text(stmt, 1, metadata_str.c_str(), -1, SQLITE_TRANSIENT);
+                bindFileStat(stmt, 2, metadata);
+                sqlite3_bind_int64(stmt, 7, generation);
+                sqlite3_bind_text(stmt, 8, metadata.file_path.c_str(), -1, SQLITE_STATIC);
+                if (sqlite3_step(stmt) != SQLITE_DONE)
+                    return false;
+                sqlite3_reset(stmt);
+            }
+            return true;
+        };
+        if (!updateRows(change_stmt, diff.changed))
+            return fail("Failed to update changed scanned file");
+        if (!updateRows(refresh_stmt, diff.refreshed))
+            return fail("Failed to refresh scanned file metadata");
+
+        if (!diff.seen.empty())
+        {
+            for (const auto &path : diff.seen)
+            {
+                sqlite3_bind_text(seen_stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+                if (sqlite3_step(seen_stmt) != SQLITE_DONE)
+                    return fail("Failed to record seen file " + path);
+                sqlite3_reset(seen_stmt);
+            }
+
+            const std::string stamp_sql = "UPDATE scanned_files SET scan_generation = " + std::to_string(generation) +
+                                          " WHERE file_path IN (SELECT file_path FROM temp.scan_seen_paths)"
+                                          " AND scan_generation IS NOT " + std::to_string(generation);
+            if (sqlite3_exec(dbMan.db_, stamp_sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK ||
+                sqlite3_exec(dbMan.db_, "DELETE FROM temp.scan_seen_paths", nullptr, nullptr, nullptr) != SQLITE_OK)
+            {
+                return fail("Failed to stamp seen scanned files");
+            }
+        }
+
+        for (const auto &path : diff.removed)
+        {
+            sqlite3_bind_text(detach_stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            bool detached = detachScannedRows(dbMan.db_, detach_stmt, cache_files);
+            sqlite3_reset(detach_stmt);
+            if (!detached)
+                return fail("Failed to detach scanned file " + path);
+
+            sqlite3_bind_text(delete_stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(delete_stmt) != SQLITE_DONE)
+                return fail("Failed to delete scanned file " + path);
+            sqlite3_reset(delete_stmt);
+        }
+        if (!releaseCacheFiles(dbMan.db_, cache_files))
+            return fail("Failed to release cache files of removed files");
+
+        finalizeAll();
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            error_msg = "Failed to commit scan diff: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            cache_files.clear();
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    removeCacheFiles(cache_files);
+
+    Logger::info("Applied scan diff: " + std::to_string(diff.inserted.size()) + " new, " +
+                 std::to_string(diff.changed.size()) + " changed, " + std::to_string(diff.refreshed.size()) +
+                 " refreshed, " + std::to_string(diff.removed.size()) + " removed, " +
+                 std::to_string(diff.seen.size()) + " confirmed");
+
+    // New, changed or removed files can create or break duplicate links
+    if (!diff.inserted.empty() || !diff.changed.empty() || !diff.removed.empty())
+        DuplicateLinker::getInstance().requestFullRescan();
+    return DBOpResult(true);
+}
+
+int64_t DatabaseManager::beginScanGeneration()
+{
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return 0;
+    }
+
+    int64_t generation = 0;
+    enqueueWriteInline([&generation](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return WriteOperationResult::Failure("Database not initialized");
+        }
+
+        const char *bump_sql = "INSERT INTO flags(name, value, updated_at) VALUES('scan_generation', '1', CURRENT_TIMESTAMP) "
+                               "ON CONFLICT(name) DO UPDATE SET value = CAST(value AS INTEGER) + 1, updated_at = CURRENT_TIMESTAMP";
+        if (sqlite3_exec(dbMan.db_, bump_sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            std::string msg = "Failed to start scan generation: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(msg);
+            return WriteOperationResult::Failure(msg);
+        }
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, ("SELECT " + std::string(CURRENT_SCAN_GENERATION_SQL)).c_str(), -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            generation = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    return generation;
+}
+
+DBOpResult DatabaseManager::sweepScanGeneration(const std::string &root_path, int64_t generation)
+{
+    if (generation <= 0)
+        return DBOpResult(false, "Invalid scan generation");
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    // Only the range below the root is queried
+    std::string captured_root = subtreeBase(normalizedDirectory(root_path));
+    std::string error_msg;
+    bool success = true;
+    int removed = 0;
+    std::vector<std::string> cache_files;
+
+    enqueueWriteInline([captured_root, generation, &removed, &cache_files, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        sqlite3_stmt *detach_stmt = nullptr;
+        sqlite3_stmt *delete_stmt = nullptr;
+        auto fail = [&](const std::string &what)
+        {
+            error_msg = what + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            sqlite3_finalize(detach_stmt);
+            sqlite3_finalize(delete_stmt);
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            cache_files.clear();
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin scan generation sweep");
+
+        // Same range as removeScannedPath, restricted to rows the walk did not stamp
+        const char *detach_sql = "SELECT s.id, s.links_fast, s.links_balanced, s.links_quality, c.transcoded_file_path "
+                                 "FROM scanned_files s LEFT JOIN cache_map c ON c.source_file_path = s.file_path "
+                                 "WHERE s.file_path >= ?1 || '/' AND s.file_path < ?1 || '0' AND s.scan_generation < ?2";
+        const char *delete_sql = "DELETE FROM scanned_files "
+                                 "WHERE file_path >= ?1 || '/' AND file_path < ?1 || '0' AND scan_generation < ?2";
+        if (sqlite3_prepare_v2(dbMan.db_, detach_sql, -1, &detach_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, delete_sql, -1, &delete_stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare scan generation sweep");
+
+        sqlite3_bind_text(detach_stmt, 1, captured_root.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(detach_stmt, 2, generation);
+        if (!detachScannedRows(dbMan.db_, detach_stmt, cache_files))
+            return fail("Failed to detach swept scanned files");
+
+        sqlite3_bind_text(delete_stmt, 1, captured_root.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(delete_stmt, 2, generation);
+        if (sqlite3_step(delete_stmt) != SQLITE_DONE)
+            return fail("Failed to sweep scanned files");
+        removed = sqlite3_changes(dbMan.db_);
+        if (!releaseCacheFiles(dbMan.db_, cache_files))
+            return fail("Failed to release cache files of swept files");
+
+        sqlite3_finalize(detach_stmt);
+        sqlite3_finalize(delete_stmt);
+        detach_stmt = delete_stmt = nullptr;
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit scan generation sweep");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    removeCacheFiles(cache_files);
+
+    if (removed > 0)
+    {
+        Logger::info("Swept " + std::to_string(removed) + " scanned file(s) under " + captured_root +
+                     " not seen since scan generation " + std::to_string(generation));
+        DuplicateLinker::getInstance().requestFullRescan();
+    }
+    return DBOpResult(true);
+}
+
+bool DatabaseManager::detachScannedRows(sqlite3 *db, sqlite3_stmt *select_stmt, std::vector<std::string> &cache_files)
+{
+    // Links are symmetric, so the rows that reference a removed file are exactly the ones
+    // listed in its own links columns
+    static const char *const link_columns[] = {"links_fast", "links_balanced", "links_quality"};
+
+    std::vector<std::pair<int, std::vector<int>>> unlinks[3]; // per column: removed id -> partner ids
+    int rc;
+    while ((rc = sqlite3_step(select_stmt)) == SQLITE_ROW)
+    {
+        int id = sqlite3_column_int(select_stmt, 0);
+        for (int column = 0; column < 3; ++column)
+        {
+            const unsigned char *text = sqlite3_column_text(select_stmt, 1 + column);
+            if (!text || !*text)
+                continue;
+            std::vector<int> partners;
+            std::stringstream ss(reinterpret_cast<const char *>(text));
+            std::string item;
+            while (std::getline(ss, item, ','))
+            {
+                try
+                {
+                    partners.push_back(std::stoi(item));
+                }
+                catch (const std::exception &)
+                {
+                }
+            }
+            if (!partners.empty())
+                unlinks[column].emplace_back(id, std::move(partners));
+        }
+        if (const unsigned char *cache_file = sqlite3_column_text(select_stmt, 4))
+            cache_files.emplace_back(reinterpret_cast<const char *>(cache_file));
+    }
+    if (rc != SQLITE_DONE)
+        return false;
+
+    for (int column = 0; column < 3; ++column)
+    {
+        if (unlinks[column].empty())
+            continue;
+
+        std::string select_sql = "SELECT " + std::string(link_columns[column]) + " FROM scanned_files WHERE id = ?";
+        std::string update_sql = "UPDATE scanned_files SET " + std::string(link_columns[column]) + " = ? WHERE id = ?";
+        sqlite3_stmt *partner_select = nullptr;
+        sqlite3_stmt *partner_update = nullptr;
+        if (sqlite3_prepare_v2(db, select_sql.c_str(), -1, &partner_select, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, update_sql.c_str(), -1, &partner_update, nullptr) != SQLITE_OK)
+        {
+            sqlite3_finalize(partner_select);
+            sqlite3_finalize(partner_update);
+            return false;
+        }
+
+        bool ok = true;
+        for (const auto &[removed_id, partners] : unlinks[column])
+        {
+            for (int partner : partners)
+            {
+                sqlite3_bind_int(partner_select, 1, partner);
+                std::string links;
+                if (sqlite3_step(partner_select) == SQLITE_ROW && sqlite3_column_text(partner_select, 0))
+                    links = reinterpret_cast<const char *>(sqlite3_column_text(partner_select, 0));
+                sqlite3_reset(partner_select);
+
+                std::string kept;
+                std::stringstream ss(links);
+                std::string item;
+                bool dropped = false;
+                while (std::getline(ss, item, ','))
+                {
+                    if (item == std::to_string(removed_id))
+                    {
+                        dropped = true;
+                        continue;
+                    }
+                    if (!kept.empty())
+                        kept += ",";
+                    kept += item;
+                }
+                if (!dropped)
+                    continue;
+
+                if (kept.empty())
+                    sqlite3_bind_null(partner_update, 1);
+                else
+                    sqlite3_bind_text(partner_update, 1, kept.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int(partner_update, 2, partner);
+                ok = sqlite3_step(partner_update) == SQLITE_DONE;
+                sqlite3_reset(partner_update);
+                if (!ok)
+                    break;
+            }
+            if (!ok)
+                break;
+        }
+        sqlite3_finalize(partner_select);
+        sqlite3_finalize(partner_update);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::releaseCacheFiles(sqlite3 *db, std::vector<std::string> &cache_files)
+{
+    if (cache_files.empty())
+        return true;
+
+    std::sort(cache_files.begin(), cache_files.end());
+    cache_files.erase(std::unique(cache_files.begin(), cache_files.end()), cache_files.end());
+
+    // Still referenced by another source, or kept by content for a moved or re-imported copy
+    // (those leave through LRU eviction): not removed here
+    const char *kept_sql = "SELECT EXISTS (SELECT 1 FROM cache_map WHERE transcoded_file_path = ?1) "
+                           "OR EXISTS (SELECT 1 FROM cache_objects WHERE cache_file_path = ?1 AND content_key IS NOT NULL)";
+    sqlite3_stmt *kept_stmt = nullptr;
+    sqlite3_stmt *delete_stmt = nullptr;
+    if (sqlite3_prepare_v2(db, kept_sql, -1, &kept_stmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "DELETE FROM cache_objects WHERE cache_file_path = ?", -1, &delete_stmt, nullptr) != SQLITE_OK)
+    {
+        sqlite3_finalize(kept_stmt);
+        sqlite3_finalize(delete_stmt);
+        return false;
+    }
+
+    bool ok = true;
+    std::vector<std::string> released;
+    for (const auto &cache_file : cache_files)
+    {
+        sqlite3_bind_text(kept_stmt, 1, cache_file.c_str(), -1, SQLITE_STATIC);
+        ok = sqlite3_step(kept_stmt) == SQLITE_ROW;
+        bool kept = ok && sqlite3_column_int(kept_stmt, 0) != 0;
+        sqlite3_reset(kept_stmt);
+        if (!ok)
+            break;
+        if (kept)
+            continue;
+
+        sqlite3_bind_text(delete_stmt, 1, cache_file.c_str(), -1, SQLITE_STATIC);
+        ok = sqlite3_step(delete_stmt) == SQLITE_DONE;
+        sqlite3_reset(delete_stmt);
+        if (!ok)
+            break;
+        released.push_back(cache_file);
+    }
+    sqlite3_finalize(kept_stmt);
+    sqlite3_finalize(delete_stmt);
+    if (ok)
+        cache_files = std::move(released);
+    return ok;
+}
+
+void DatabaseManager::removeCacheFiles(const std::vector<std::string> &cache_files)
+{
+    for (const auto &cache_file : cache_files)
+    {
+        std::error_code ec;
+        if (std::filesystem::remove(cache_file, ec))
+            Logger::debug("Removed cache file of deleted source: " + cache_file);
+        else if (ec)
+            Logger::warn("Failed to remove cache file " + cache_file + ": " + ec.message());
+    }
+}
+
+DBOpResult DatabaseManager::removeScannedPath(const std::string &path)
+{
+    Logger::debug("removeScannedPath called for: " + path);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    std::string captured_path = normalizedDirectory(path);
+    std::string error_msg;
+    bool success = true;
+    int removed = 0;
+    std::vector<std::string> cache_files;
+
+    enqueueWriteInline([captured_path, &removed, &cache_files, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        sqlite3_stmt *detach_stmt = nullptr;
+        sqlite3_stmt *delete_stmt = nullptr;
+        auto fail = [&](const std::string &what)
+        {
+            error_msg = what + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            sqlite3_finalize(detach_stmt);
+            sqlite3_finalize(delete_stmt);
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            cache_files.clear();
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin scanned path removal");
+
+        // Exact match for a file; the range covers everything below a directory and stays on
+        // the file_path index ('0' is the character right after '/')
+        const char *detach_sql = "SELECT s.id, s.links_fast, s.links_balanced, s.links_quality, c.transcoded_file_path "
+                                 "FROM scanned_files s LEFT JOIN cache_map c ON c.source_file_path = s.file_path "
+                                 "WHERE s.file_path = ?1 OR (s.file_path >= ?2 || '/' AND s.file_path < ?2 || '0')";
+        const char *delete_sql = "DELETE FROM scanned_files WHERE file_path = ?1 "
+                                 "OR (file_path >= ?2 || '/' AND file_path < ?2 || '0')";
+        const std::string base = subtreeBase(captured_path);
+        if (sqlite3_prepare_v2(dbMan.db_, detach_sql, -1, &detach_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, delete_sql, -1, &delete_stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare statement");
+
+        sqlite3_bind_text(detach_stmt, 1, captured_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(detach_stmt, 2, base.c_str(), -1, SQLITE_STATIC);
+        if (!detachScannedRows(dbMan.db_, detach_stmt, cache_files))
+            return fail("Failed to detach scanned path");
+
+        sqlite3_bind_text(delete_stmt, 1, captured_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(delete_stmt, 2, base.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(delete_stmt) != SQLITE_DONE)
+            return fail("Failed to remove scanned path");
+        removed = sqlite3_changes(dbMan.db_);
+        if (!releaseCacheFiles(dbMan.db_, cache_files))
+            return fail("Failed to release cache files of removed path");
+
+        sqlite3_finalize(detach_stmt);
+        sqlite3_finalize(delete_stmt);
+        detach_stmt = delete_stmt = nullptr;
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit scanned path removal");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    removeCacheFiles(cache_files);
+
+    if (removed > 0)
+    {
+        Logger::info("Removed " + std::to_string(removed) + " scanned file(s) under: " + captured_path);
+        DuplicateLinker::getInstance().requestFullRescan();
+    }
+    return DBOpResult(true);
+}
+
+DBOpResult DatabaseManager::removeTranscodingRecord(const std::string &source_file_path)
+{
+    Logger::debug("removeTranscodingRecord called for: " + source_file_path);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    // Capture parameters for async execution
+    std::string captured_source_file_path = source_file_path;
+    std::string error_msg;
+    bool success = true;
+
+    // Enqueue the write operation
+    enqueueWriteInline([captured_source_file_path, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        Logger::debug("Executing removeTranscodingRecord in write queue for: " + captured_source_file_path);
+        
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        
+        const std::string delete_sql = "DELETE FROM cache_map WHERE source_file_path = ?";
+
+        sqlite3_stmt *stmt;
+        int rc = sqlite3_prepare_v2(dbMan.db_, delete_sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            error_msg = "Failed to prepare statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        // Bind parameters
+        sqlite3_bind_text(stmt, 1, captured_source_file_path.c_str(), -1, SQLITE_STATIC);
+
+        // Execute the statement
+        rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+
+        if (rc != SQLITE_DONE)
+        {
+            error_msg = "Failed to remove transcoding record: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        Logger::debug("Successfully removed transcoding record: " + captured_source_file_path);
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true);
+}
+
+DBOpResult DatabaseManager::removeTranscodingRecords(const std::vector<std::string> &source_file_paths)
+{
+    if (source_file_paths.empty())
+        return DBOpResult(true);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    std::string error_msg;
+    bool success = true;
+    enqueueWriteInline([&source_file_paths, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        auto fail = [&](const std::string &msg)
+        {
+            error_msg = msg + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin transaction");
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, "DELETE FROM cache_map WHERE source_file_path = ?", -1, &stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare statement");
+        for (const auto &path : source_file_paths)
+        {
+            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE)
+            {
+                sqlite3_finalize(stmt);
+                return fail("Failed to remove transcoding record " + path);
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit transcoding record removal");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true);
+}
+
+std::vector<CachedTranscode> DatabaseManager::getCachedTranscodes()
+{
+    std::vector<CachedTranscode> transcodes;
+
+    if (!waitForQueueInitialization())
+    {
+        Logger::error("Access queue not initialized after retries");
+        return transcodes;
+    }
+
+    auto future = enqueueReadInline([](DatabaseManager &dbMan)
+                                    {
+        std::vector<CachedTranscode> result;
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return std::any(result);
+        }
+
+        std::string sql = std::string(CACHED_TRANSCODES_SQL) + "GROUP BY o.cache_file_path ORDER BY o.last_access ASC";
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(dbMan.db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare cached transcodes query: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(result);
+        }
+        result = readCachedTranscodes(stmt);
+        sqlite3_finalize(stmt);
+        return std::any(result); });
+
+    try
+    {
+        transcodes = std::any_cast<std::vector<CachedTranscode>>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Error loading cached transcodes: " + std::string(e.what()));
+    }
+    return transcodes;
+}
+
+std::vector<CachedTranscode> DatabaseManager::findCachedTranscodes(const std::string &content_key)
+{
+    std::vector<CachedTranscode> transcodes;
+
+    if (content_key.empty() || !waitForQueueInitialization())
+    {
+        return transcodes;
+    }
+
+    auto future = enqueueReadInline([content_key](DatabaseManager &dbMan)
+                                    {
+        std::vector<CachedTranscode> result;
+        if (!dbMan.db_)
+        {
+            Logger::error("Database not initialized");
+            return std::any(result);
+        }
+
+        std::string sql = std::string(CACHED_TRANSCODES_SQL) + "WHERE o.content_key = ? GROUP BY o.cache_file_path";
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(dbMan.db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            Logger::error("Failed to prepare cached transcode lookup: " + std::string(sqlite3_errmsg(dbMan.db_)));
+            return std::any(result);
+        }
+        sqlite3_bind_text(stmt, 1, content_key.c_str(), -1, SQLITE_STATIC);
+        result = readCachedTranscodes(stmt);
+        sqlite3_finalize(stmt);
+        return std::any(result); });
+
+    try
+    {
+        transcodes = std::any_cast<std::vector<CachedTranscode>>(future.get());
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Error looking up cached transcodes: " + std::string(e.what()));
+    }
+    return transcodes;
+}
+
+DBOpResult DatabaseManager::updateCachedTranscodes(const std::vector<CachedTranscode> &transcodes)
+{
+    if (transcodes.empty())
+        return DBOpResult(true);
+
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+
+    std::string error_msg;
+    bool success = true;
+    enqueueWriteInline([&transcodes, &error_msg, &success](DatabaseManager &dbMan)
+                       {
+        auto fail = [&](const std::string &msg)
+        {
+            error_msg = msg + ": " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return WriteOperationResult::Failure(error_msg);
+        };
+
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin transaction");
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, "UPDATE cache_objects SET file_size = ?, last_access = ? WHERE cache_file_path = ?",
+                               -1, &stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare statement");
+        for (const auto &transcode : transcodes)
+        {
+            sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(transcode.file_size));
+            sqlite3_bind_int64(stmt, 2, transcode.last_access);
+            sqlite3_bind_text(stmt, 3, transcode.transcoded_file_path.c_str(), -1, SQLITE_STATIC);
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE)
+            {
+                sqlite3_finalize(stmt);
+                return fail("Failed to update cached transcode " + transcode.transcoded_file_path);
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit cached transcodes");
+        return WriteOperationResult(); });
+
+    waitForWrites();
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true);
 }
 
-DBOpResult DatabaseManager::removeTranscodingRecord(const std::string &source_file_path)
+DBOpResult DatabaseManager::removeCachedTranscodes(const std::vector<std::string> &cache_file_paths)
 {
-    Logger::debug("removeTranscodingRecord called for: " + source_file_path);
+    if (cache_file_paths.empty())
+        return DBOpResult(true);
 
     if (!waitForQueueInitialization())
     {
@@ -3225,52 +5264,53 @@ DBOpResult DatabaseManager::removeTranscodingRecord(const std::string &source_fi
         return DBOpResult(false, msg);
     }
 
-    // Capture parameters for async execution
-    std::string captured_source_file_path = source_file_path;
     std::string error_msg;
     bool success = true;
-
-    // Enqueue the write operation
-    enqueueWriteInline([captured_source_file_path, &error_msg, &success](DatabaseManager &dbMan)
+    enqueueWriteInline([&cache_file_paths, &error_msg, &success](DatabaseManager &dbMan)
                        {
-        Logger::debug("Executing removeTranscodingRecord in write queue for: " + captured_source_file_path);
-        
-        if (!dbMan.db_)
+        sqlite3_stmt *map_stmt = nullptr;
+        sqlite3_stmt *object_stmt = nullptr;
+        auto fail = [&](const std::string &msg)
         {
-            error_msg = "Database not initialized";
+            error_msg = msg + ": " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
             success = false;
+            sqlite3_finalize(map_stmt);
+            sqlite3_finalize(object_stmt);
+            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
             return WriteOperationResult::Failure(error_msg);
-        }
-        
-        const std::string delete_sql = "DELETE FROM cache_map WHERE source_file_path = ?";
+        };
 
-        sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(dbMan.db_, delete_sql.c_str(), -1, &stmt, nullptr);
-        if (rc != SQLITE_OK)
+        if (!dbMan.db_)
         {
-            error_msg = "Failed to prepare statement: " + std::string(sqlite3_errmsg(dbMan.db_));
-            Logger::error(error_msg);
+            error_msg = "Database not initialized";
             success = false;
             return WriteOperationResult::Failure(error_msg);
         }
+        if (sqlite3_exec(dbMan.db_, "BEGIN IMMEDIATE TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to begin transaction");
 
-        // Bind parameters
-        sqlite3_bind_text(stmt, 1, captured_source_file_path.c_str(), -1, SQLITE_STATIC);
-
-        // Execute the statement
-        rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-
-        if (rc != SQLITE_DONE)
+        // The sources lose their transcode and are transcoded again the next time they are processed
+        if (sqlite3_prepare_v2(dbMan.db_, "DELETE FROM cache_map WHERE transcoded_file_path = ?", -1, &map_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(dbMan.db_, "DELETE FROM cache_objects WHERE cache_file_path = ?", -1, &object_stmt, nullptr) != SQLITE_OK)
+            return fail("Failed to prepare statement");
+        for (const auto &path : cache_file_paths)
         {
-            error_msg = "Failed to remove transcoding record: " + std::string(sqlite3_errmsg(dbMan.db_));
-            Logger::error(error_msg);
-            success = false;
-            return WriteOperationResult::Failure(error_msg);
+            for (sqlite3_stmt *stmt : {map_stmt, object_stmt})
+            {
+                sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+                int rc = sqlite3_step(stmt);
+                sqlite3_reset(stmt);
+                if (rc != SQLITE_DONE)
+                    return fail("Failed to remove cached transcode " + path);
+            }
         }
+        sqlite3_finalize(map_stmt);
+        sqlite3_finalize(object_stmt);
+        map_stmt = object_stmt = nullptr;
 
-        Logger::debug("Successfully removed transcoding record: " + captured_source_file_path);
+        if (sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+            return fail("Failed to commit cached transcode removal");
         return WriteOperationResult(); });
 
     waitForWrites();
@@ -3279,6 +5319,37 @@ DBOpResult DatabaseManager::removeTranscodingRecord(const std::string &source_fi
     return DBOpResult(true);
 }
 
+bool DatabaseManager::upsertCacheObject(sqlite3 *db, const std::string &cache_file_path, uint64_t file_size,
+                                        const std::string &content_key, const std::string &content_hash)
+{
+    // A second source attaching to the same object refreshes its access time and keeps what is known
+    const char *sql =
+        "INSERT INTO cache_objects (cache_file_path, content_key, content_hash, file_size, last_access) "
+        "VALUES (?1, ?2, ?3, ?4, ?5) "
+        "ON CONFLICT (cache_file_path) DO UPDATE SET "
+        "content_key = COALESCE(excluded.content_key, content_key), "
+        "content_hash = COALESCE(excluded.content_hash, content_hash), "
+        "file_size = CASE WHEN excluded.file_size > 0 THEN excluded.file_size ELSE file_size END, "
+        "last_access = excluded.last_access";
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    sqlite3_bind_text(stmt, 1, cache_file_path.c_str(), -1, SQLITE_STATIC);
+    if (content_key.empty())
+        sqlite3_bind_null(stmt, 2);
+    else
+        sqlite3_bind_text(stmt, 2, content_key.c_str(), -1, SQLITE_STATIC);
+    if (content_hash.empty())
+        sqlite3_bind_null(stmt, 3);
+    else
+        sqlite3_bind_text(stmt, 3, content_hash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(file_size));
+    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(time(nullptr)));
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
 DBOpResult DatabaseManager::clearAllTranscodingRecords()
 {
     Logger::debug("clearAllTranscodingRecords called");
@@ -3307,6 +5378,13 @@ DBOpResult DatabaseManager::clearAllTranscodingRecords()
         }
         
         const std::string delete_sql = "DELETE FROM cache_map";
+        if (sqlite3_exec(dbMan.db_, "DELETE FROM cache_objects", nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            error_msg = "Failed to clear cache objects: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
 
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, delete_sql.c_str(), -1, &stmt, nullptr);
@@ -3479,26 +5557,17 @@ DBOpResult DatabaseManager::setProcessingFlag(const std::string &file_path, Dedu
             return WriteOperationResult::Failure(error_msg);
         }
         
-        // Build the SQL query based on the mode - mark as completed (1) if currently in progress (-1) or not processed (0)
-        std::string update_sql;
-        switch (captured_mode)
+        if (!processedColumn(captured_mode))
         {
-            case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = 1 WHERE file_path = ? AND (processed_fast = -1 OR processed_fast = 0)";
-                break;
-            case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = 1 WHERE file_path = ? AND (processed_balanced = -1 OR processed_balanced = 0)";
-                break;
-            case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = 1 WHERE file_path = ? AND (processed_quality = -1 OR processed_quality = 0)";
-                break;
-            default:
-                error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
-                Logger::error(error_msg);
-                success.store(false);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
+            error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
+            Logger::error(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
         }
+
+        // Mark as completed (1) if held in progress (-1) by this process or not processed (0)
+        std::string update_sql = finishProcessingSql(captured_mode, 1);
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
@@ -3512,6 +5581,7 @@ DBOpResult DatabaseManager::setProcessingFlag(const std::string &file_path, Dedu
         }
 
         sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3525,6 +5595,16 @@ DBOpResult DatabaseManager::setProcessingFlag(const std::string &file_path, Dedu
             return WriteOperationResult::Failure(error_msg);
         }
 
+        // The mode was already finished, or its lease lapsed and another worker claimed it
+        if (sqlite3_changes(dbMan.db_) == 0)
+        {
+            error_msg = "File is not pending or held by this process: " + captured_file_path;
+            Logger::warn(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
+        }
+
         Logger::debug("Set processing flag for: " + captured_file_path + " mode: " + DedupModes::getModeName(captured_mode));
         operation_completed.store(true);
         return WriteOperationResult(); });
@@ -3580,26 +5660,17 @@ DBOpResult DatabaseManager::resetProcessingFlag(const std::string &file_path, De
             return WriteOperationResult::Failure(error_msg);
         }
         
-        // Build the SQL query based on the mode - reset to 0 if currently in progress (-1)
-        std::string update_sql;
-        switch (captured_mode)
+        if (!processedColumn(captured_mode))
         {
-            case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = 0 WHERE file_path = ? AND processed_fast = -1";
-                break;
-            case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = 0 WHERE file_path = ? AND processed_balanced = -1";
-                break;
-            case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = 0 WHERE file_path = ? AND processed_quality = -1";
-                break;
-            default:
-                error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
-                Logger::error(error_msg);
-                success.store(false);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
+            error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
+            Logger::error(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
         }
+
+        // Reset to 0 if held in progress (-1) by this process, releasing the lease with the last mode
+        std::string update_sql = finishProcessingSql(captured_mode, 0, "");
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
@@ -3613,6 +5684,7 @@ DBOpResult DatabaseManager::resetProcessingFlag(const std::string &file_path, De
         }
 
         sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3650,6 +5722,73 @@ DBOpResult DatabaseManager::resetProcessingFlag(const std::string &file_path, De
     return DBOpResult(true);
 }
 
+// Park an in-progress or transcoding-failed RAW file until its transcode finishes (-2)
+DBOpResult DatabaseManager::setProcessingFlagAwaitingTranscode(const std::string &file_path, DedupMode mode)
+{
+    if (!waitForQueueInitialization())
+    {
+        std::string msg = "Access queue not initialized after retries";
+        Logger::error(msg);
+        return DBOpResult(false, msg);
+    }
+    if (!processedColumn(mode))
+    {
+        return DBOpResult(false, "Unknown processing mode: " + DedupModes::getModeName(mode));
+    }
+
+    std::string captured_file_path = file_path;
+    bool success = true;
+    std::string error_msg;
+    enqueueWriteInline([captured_file_path, mode, &success, &error_msg](DatabaseManager &dbMan)
+                       {
+        if (!dbMan.db_)
+        {
+            error_msg = "Database not initialized";
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+
+        // markTranscodingJobCompleted requeues -2 rows. A transcode that finished after the
+        // caller looked for it requeues the file here instead, so it cannot be parked forever.
+        // Only an in-progress mode this process holds is parked; the lease goes with the last one
+        const std::string column = processedColumn(mode);
+        const std::string others_in_progress = otherModesAre(mode, -1);
+        const std::string transcoded = "EXISTS (SELECT 1 FROM cache_map WHERE source_file_path = scanned_files.file_path AND status = 2)";
+        const std::string update_sql =
+            "UPDATE scanned_files SET " + column + " = CASE WHEN " + transcoded + " THEN 0 ELSE -2 END, "
+            "processing_priority = CASE WHEN " + transcoded + " THEN 1 ELSE processing_priority END, "
+            "lease_owner = CASE WHEN " + others_in_progress + " THEN lease_owner ELSE NULL END, "
+            "lease_until = CASE WHEN " + others_in_progress + " THEN lease_until ELSE NULL END "
+            "WHERE file_path = ? AND (" + column + " = 3 OR (" + column + " = -1 AND lease_owner = ?))";
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            error_msg = "Failed to prepare awaiting-transcode update: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            error_msg = "Failed to mark file awaiting transcode: " + std::string(sqlite3_errmsg(dbMan.db_));
+            Logger::error(error_msg);
+            success = false;
+            return WriteOperationResult::Failure(error_msg);
+        }
+        Logger::debug("File awaiting transcode: " + captured_file_path + " mode: " + DedupModes::getModeName(mode));
+        return WriteOperationResult(); });
+    waitForWrites();
+
+    if (!success)
+        return DBOpResult(false, error_msg);
+    return DBOpResult(true);
+}
+
 // Set processing flag to error state (2) for a specific mode
 DBOpResult DatabaseManager::setProcessingFlagError(const std::string &file_path, DedupMode mode)
 {
@@ -3681,26 +5820,17 @@ DBOpResult DatabaseManager::setProcessingFlagError(const std::string &file_path,
             return WriteOperationResult::Failure(error_msg);
         }
         
-        // Build the SQL query based on the mode - set to error state (2)
-        std::string update_sql;
-        switch (captured_mode)
+        if (!processedColumn(captured_mode))
         {
-            case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = 2 WHERE file_path = ?";
-                break;
-            case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = 2 WHERE file_path = ?";
-                break;
-            case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = 2 WHERE file_path = ?";
-                break;
-            default:
-                error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
-                Logger::error(error_msg);
-                success.store(false);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
+            error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
+            Logger::error(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
         }
+
+        // Set to error state (2)
+        std::string update_sql = finishProcessingSql(captured_mode, 2);
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
@@ -3714,6 +5844,7 @@ DBOpResult DatabaseManager::setProcessingFlagError(const std::string &file_path,
         }
 
         sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3727,6 +5858,16 @@ DBOpResult DatabaseManager::setProcessingFlagError(const std::string &file_path,
             return WriteOperationResult::Failure(error_msg);
         }
 
+        // The mode was already finished, or its lease lapsed and another worker claimed it
+        if (sqlite3_changes(dbMan.db_) == 0)
+        {
+            error_msg = "File is not pending or held by this process: " + captured_file_path;
+            Logger::warn(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
+        }
+
         Logger::debug("Set processing flag to error state (2) for: " + captured_file_path + " mode: " + DedupModes::getModeName(captured_mode));
         operation_completed.store(true);
         return WriteOperationResult(); });
@@ -3782,26 +5923,17 @@ DBOpResult DatabaseManager::setProcessingFlagTranscodingError(const std::string
             return WriteOperationResult::Failure(error_msg);
         }
         
-        // Build the SQL query based on the mode - set to transcoding error state (3)
-        std::string update_sql;
-        switch (captured_mode)
+        if (!processedColumn(captured_mode))
         {
-            case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = 3 WHERE file_path = ?";
-                break;
-            case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = 3 WHERE file_path = ?";
-                break;
-            case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = 3 WHERE file_path = ?";
-                break;
-            default:
-                error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
-                Logger::error(error_msg);
-                success.store(false);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
+            error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
+            Logger::error(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
         }
+
+        // Set to transcoding error state (3)
+        std::string update_sql = finishProcessingSql(captured_mode, 3);
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
@@ -3815,6 +5947,7 @@ DBOpResult DatabaseManager::setProcessingFlagTranscodingError(const std::string
         }
 
         sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3828,6 +5961,16 @@ DBOpResult DatabaseManager::setProcessingFlagTranscodingError(const std::string
             return WriteOperationResult::Failure(error_msg);
         }
 
+        // The mode was already finished, or its lease lapsed and another worker claimed it
+        if (sqlite3_changes(dbMan.db_) == 0)
+        {
+            error_msg = "File is not pending or held by this process: " + captured_file_path;
+            Logger::warn(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
+        }
+
         Logger::debug("Set processing flag to transcoding error state (3) for: " + captured_file_path + " mode: " + DedupModes::getModeName(captured_mode));
         operation_completed.store(true);
         return WriteOperationResult(); });
@@ -3883,26 +6026,17 @@ DBOpResult DatabaseManager::setProcessingFlagFinalError(const std::string &file_
             return WriteOperationResult::Failure(error_msg);
         }
         
-        // Build the SQL query based on the mode - set to final error state (4)
-        std::string update_sql;
-        switch (captured_mode)
+        if (!processedColumn(captured_mode))
         {
-            case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = 4 WHERE file_path = ?";
-                break;
-            case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = 4 WHERE file_path = ?";
-                break;
-            case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = 4 WHERE file_path = ?";
-                break;
-            default:
-                error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
-                Logger::error(error_msg);
-                success.store(false);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
+            error_msg = "Unknown processing mode: " + DedupModes::getModeName(captured_mode);
+            Logger::error(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
         }
+
+        // Set to final error state (4)
+        std::string update_sql = finishProcessingSql(captured_mode, 4);
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
@@ -3916,6 +6050,7 @@ DBOpResult DatabaseManager::setProcessingFlagFinalError(const std::string &file_
         }
 
         sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -3929,6 +6064,16 @@ DBOpResult DatabaseManager::setProcessingFlagFinalError(const std::string &file_
             return WriteOperationResult::Failure(error_msg);
         }
 
+        // The mode was already finished, or its lease lapsed and another worker claimed it
+        if (sqlite3_changes(dbMan.db_) == 0)
+        {
+            error_msg = "File is not pending or held by this process: " + captured_file_path;
+            Logger::warn(error_msg);
+            success.store(false);
+            operation_completed.store(true);
+            return WriteOperationResult::Failure(error_msg);
+        }
+
         Logger::debug("Set processing flag to final error state (4) for: " + captured_file_path + " mode: " + DedupModes::getModeName(captured_mode));
         operation_completed.store(true);
         return WriteOperationResult(); });
@@ -4149,13 +6294,13 @@ bool DatabaseManager::tryAcquireProcessingLock(const std::string &file_path, Ded
         switch (captured_mode)
         {
             case DedupMode::FAST:
-                update_sql = "UPDATE scanned_files SET processed_fast = -1 WHERE file_path = ? AND processed_fast = 0";
+                update_sql = "UPDATE scanned_files SET processed_fast = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_fast = 0";
                 break;
             case DedupMode::BALANCED:
-                update_sql = "UPDATE scanned_files SET processed_balanced = -1 WHERE file_path = ? AND processed_balanced = 0";
+                update_sql = "UPDATE scanned_files SET processed_balanced = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_balanced = 0";
                 break;
             case DedupMode::QUALITY:
-                update_sql = "UPDATE scanned_files SET processed_quality = -1 WHERE file_path = ? AND processed_quality = 0";
+                update_sql = "UPDATE scanned_files SET processed_quality = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_quality = 0";
                 break;
             default:
                 error_msg = "Invalid dedup mode";
@@ -4176,7 +6321,9 @@ bool DatabaseManager::tryAcquireProcessingLock(const std::string &file_path, Ded
             return WriteOperationResult::Failure(error_msg);
         }
         
-        sqlite3_bind_text(stmt, 1, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, nextLeaseExpiry());
+        sqlite3_bind_text(stmt, 3, captured_file_path.c_str(), -1, SQLITE_STATIC);
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
         
@@ -4257,22 +6404,26 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         
         // Start transaction for better concurrency (using regular BEGIN instead of IMMEDIATE)
         sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+        // Expired claims from crashed or stalled workers go back to pending first
+        reclaimExpiredProcessingLeases(dbMan.db_);
+        int64_t lease_until = nextLeaseExpiry();
         
         // Build the SQL query to get files that need processing
         // Exclude files that are already marked as in progress (-1) to prevent race conditions
         std::string select_sql;
-        std::string file_type_clauses = generateFileTypeLikeClauses();
+        std::string file_type_clauses = generateFileTypeInClause();
         
         switch (captured_mode)
         {
             case DedupMode::FAST:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_fast = 0 AND processed_fast != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_fast WHERE processed_fast = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::BALANCED:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_balanced = 0 AND processed_balanced != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_balanced WHERE processed_balanced = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::QUALITY:
-                select_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_quality = 0 AND processed_quality != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
+                select_sql = "SELECT file_path, file_name FROM scanned_files INDEXED BY idx_scanned_files_pending_quality WHERE processed_quality = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
         }
         
@@ -4307,13 +6458,13 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
             switch (captured_mode)
             {
                 case DedupMode::FAST:
-                    update_sql = "UPDATE scanned_files SET processed_fast = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_fast = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 case DedupMode::BALANCED:
-                    update_sql = "UPDATE scanned_files SET processed_balanced = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_balanced = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 case DedupMode::QUALITY:
-                    update_sql = "UPDATE scanned_files SET processed_quality = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_quality = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 default:
                     break;
@@ -4345,7 +6496,9 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
                 for (size_t j = i; j < end_idx; j++)
                 {
                     const auto& file_path = file_paths_to_mark[j];
-                    sqlite3_bind_text(update_stmt, 1, file_path.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_text(update_stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_int64(update_stmt, 2, lease_until);
+                    sqlite3_bind_text(update_stmt, 3, file_path.c_str(), -1, SQLITE_STATIC);
                     rc = sqlite3_step(update_stmt);
                     if (rc != SQLITE_DONE)
                     {
@@ -4417,17 +6570,20 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         
         // Start transaction for better concurrency (using regular BEGIN instead of IMMEDIATE)
         sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+        // Expired claims from crashed or stalled workers go back to pending first
+        reclaimExpiredProcessingLeases(dbMan.db_);
+        int64_t lease_until = nextLeaseExpiry();
         
         // Build the SQL query to get files that need processing for ANY mode
         // Use a more precise approach to avoid race conditions
-        std::string file_type_clauses = generateFileTypeLikeClauses();
+        std::string file_type_clauses = generateFileTypeInClause();
         
+        // The OR term must match idx_scanned_files_pending_any verbatim for SQLite to use it
         std::string select_sql = "SELECT file_path, file_name FROM scanned_files WHERE "
-                                "(" + file_type_clauses + ") AND "
-                                "((processed_fast = 0 AND processed_fast != -1) OR "
-                                "(processed_balanced = 0 AND processed_balanced != -1) OR "
-                                "(processed_quality = 0 AND processed_quality != -1)) "
-                                "ORDER BY created_at DESC LIMIT ?";
+                                "(processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0) AND "
+                                "(" + file_type_clauses + ") "
+                                "ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
         
         Logger::debug("File type clauses: " + file_type_clauses);
         Logger::debug("SQL query: " + select_sql);
@@ -4466,9 +6622,9 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         {
             // Mark files as in progress for each mode that needs processing
             std::vector<std::string> update_sqls = {
-                "UPDATE scanned_files SET processed_fast = -1 WHERE file_path = ? AND processed_fast = 0",
-                "UPDATE scanned_files SET processed_balanced = -1 WHERE file_path = ? AND processed_balanced = 0",
-                "UPDATE scanned_files SET processed_quality = -1 WHERE file_path = ? AND processed_quality = 0"
+                "UPDATE scanned_files SET processed_fast = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_fast = 0",
+                "UPDATE scanned_files SET processed_balanced = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_balanced = 0",
+                "UPDATE scanned_files SET processed_quality = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_quality = 0"
             };
 
             // Process files in smaller batches to reduce transaction size
@@ -4500,7 +6656,9 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
                     for (size_t j = i; j < end_idx; j++)
                     {
                         const auto& file_path = file_paths_to_mark[j];
-                        sqlite3_bind_text(update_stmt, 1, file_path.c_str(), -1, SQLITE_STATIC);
+                        sqlite3_bind_text(update_stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+                        sqlite3_bind_int64(update_stmt, 2, lease_until);
+                        sqlite3_bind_text(update_stmt, 3, file_path.c_str(), -1, SQLITE_STATIC);
                         rc = sqlite3_step(update_stmt);
                         if (rc != SQLITE_DONE)
                         {
@@ -4542,25 +6700,43 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
     return results;
 }
 
-// Helper function to generate SQL LIKE clauses for enabled file types
-std::string DatabaseManager::generateFileTypeLikeClauses()
+// Helper function to generate an IN clause over file_extension for enabled file types
+std::string DatabaseManager::generateFileTypeInClause()
+{
+    // Claims are driven by the pending-work partial indexes. The unary + keeps the
+    // planner from picking idx_scanned_files_file_extension instead, which matches
+    // nearly every row and forces a sort of the whole result.
+    return buildExtensionInClause("+file_extension", PocoConfigAdapter::getInstance().getEnabledFileTypes());
+}
+
+std::string DatabaseManager::buildExtensionInClause(const std::string &column, const std::vector<std::string> &extensions)
 {
-    auto enabled_types = PocoConfigAdapter::getInstance().getEnabledFileTypes();
-    if (enabled_types.empty())
+    if (extensions.empty())
     {
         return "1=0"; // No enabled types, return false condition
     }
 
-    std::string clauses;
-    for (size_t i = 0; i < enabled_types.size(); ++i)
+    std::string clause = column + " IN (";
+    for (size_t i = 0; i < extensions.size(); ++i)
     {
         if (i > 0)
         {
-            clauses += " OR ";
+            clause += ", ";
+        }
+        std::string ext = extensions[i];
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        // Extensions come from configuration; escape quotes defensively
+        std::string escaped;
+        for (char c : ext)
+        {
+            escaped += c;
+            if (c == '\'')
+                escaped += '\'';
         }
-        clauses += "LOWER(file_name) LIKE '%." + enabled_types[i] + "'";
+        clause += "'" + escaped + "'";
     }
-    return clauses;
+    clause += ")";
+    return clause;
 }
 
 std::vector<std::pair<std::string, std::string>> DatabaseManager::getFilesNeedingProcessingAnyMode(int batch_size)
@@ -4592,8 +6768,8 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getFilesNeedin
         }
         
         // Build the SQL query to get files that need processing for ANY mode
-        std::string file_type_clauses = generateFileTypeLikeClauses();
-        std::string select_sql = "SELECT file_path, file_name FROM scanned_files WHERE (" + file_type_clauses + ") AND (processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0) ORDER BY created_at DESC LIMIT ?";
+        std::string file_type_clauses = generateFileTypeInClause();
+        std::string select_sql = "SELECT file_path, file_name FROM scanned_files WHERE (processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0) AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
         
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
@@ -4817,7 +6993,9 @@ DBOpResult DatabaseManager::setFileLinksForMode(const std::string &file_path, co
                        {
         Logger::debug("Executing setFileLinksForMode in write queue for: " + captured_file_path + " mode: " + captured_field_name);
         
-        const std::string update_sql = "UPDATE scanned_files SET " + captured_field_name + " = ? WHERE file_path = ?";
+        // Skip rows whose links are already current so re-linking unchanged groups does not
+        // bump the scanned_files version and retrigger the linker on its own output
+        const std::string update_sql = "UPDATE scanned_files SET " + captured_field_name + " = ? WHERE file_path = ? AND " + captured_field_name + " IS NOT ?";
         sqlite3_stmt *stmt;
         int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
         if (rc != SQLITE_OK)
@@ -4830,6 +7008,7 @@ DBOpResult DatabaseManager::setFileLinksForMode(const std::string &file_path, co
 
         sqlite3_bind_text(stmt, 1, captured_links_text.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 2, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, captured_links_text.c_str(), -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -4940,26 +7119,144 @@ std::vector<int> DatabaseManager::getFileLinksForMode(const std::string &file_pa
     }
     catch (const std::exception &e)
     {
-        Logger::error("Failed to get file links for mode: " + std::string(e.what()));
+        Logger::error("Failed to get file links for mode: " + std::string(e.what()));
+    }
+
+    return results;
+}
+
+std::vector<int> DatabaseManager::getFileLinksForCurrentMode(const std::string &file_path)
+{
+    // Get the current deduplication mode from the server configuration
+    try
+    {
+        auto &config = PocoConfigAdapter::getInstance();
+        DedupMode current_mode = config.getDedupMode();
+        return getFileLinksForMode(file_path, current_mode);
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Failed to get current deduplication mode: " + std::string(e.what()));
+        return std::vector<int>();
+    }
+}
+
+void DatabaseManager::bindFileStat(sqlite3_stmt *stmt, int first_index, const std::optional<FileMetadata> &metadata)
+{
+    if (!metadata)
+    {
+        for (int i = 0; i < 5; ++i)
+            sqlite3_bind_null(stmt, first_index + i);
+        return;
+    }
+    sqlite3_bind_int64(stmt, first_index, static_cast<sqlite3_int64>(metadata->modification_time));
+    sqlite3_bind_int64(stmt, first_index + 1, static_cast<sqlite3_int64>(metadata->creation_time));
+    sqlite3_bind_int64(stmt, first_index + 2, static_cast<sqlite3_int64>(metadata->file_size));
+    sqlite3_bind_int64(stmt, first_index + 3, static_cast<sqlite3_int64>(metadata->inode));
+    sqlite3_bind_int64(stmt, first_index + 4, static_cast<sqlite3_int64>(metadata->device_id));
+}
+
+std::string DatabaseManager::sha256Hex(const std::string &data)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256_CTX sha256;
+    SHA256_Init(&sha256);
+    SHA256_Update(&sha256, data.c_str(), data.length());
+    SHA256_Final(hash, &sha256);
+
+    std::stringstream hash_ss;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
+    {
+        hash_ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    }
+    return hash_ss.str();
+}
+
+bool DatabaseManager::readTableVersions(sqlite3 *db, std::map<std::string, int64_t> &versions)
+{
+    const char *sql = "SELECT table_name, version FROM table_versions";
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        Logger::error("Failed to prepare table_versions select: " + std::string(sqlite3_errmsg(db)));
+        return false;
     }
 
-    return results;
+    // Counters are seeded when the table is created; 0 only if a row went missing
+    for (const auto &table : versionTrackedTables())
+        versions[table] = 0;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        if (name)
+            versions[name] = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return true;
 }
 
-std::vector<int> DatabaseManager::getFileLinksForCurrentMode(const std::string &file_path)
+bool DatabaseManager::hashTableContents(sqlite3 *db, const std::string &table_name, std::string &hash_out)
 {
-    // Get the current deduplication mode from the server configuration
-    try
+    // Full scan fallback for tables without a trigger-maintained version counter
+    const std::string select_sql = "SELECT * FROM \"" + table_name + "\" ORDER BY rowid";
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, select_sql.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK)
     {
-        auto &config = PocoConfigAdapter::getInstance();
-        DedupMode current_mode = config.getDedupMode();
-        return getFileLinksForMode(file_path, current_mode);
+        Logger::error("Failed to prepare select statement for table " + table_name + ": " + std::string(sqlite3_errmsg(db)));
+        return false;
     }
-    catch (const std::exception &e)
+
+    // Build a string representation of all table data
+    std::stringstream table_data;
+    int row_count = 0;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Logger::error("Failed to get current deduplication mode: " + std::string(e.what()));
-        return std::vector<int>();
+        row_count++;
+        int columns = sqlite3_column_count(stmt);
+
+        for (int i = 0; i < columns; i++)
+        {
+            if (i > 0)
+                table_data << "|";
+
+            int column_type = sqlite3_column_type(stmt, i);
+            switch (column_type)
+            {
+            case SQLITE_NULL:
+                table_data << "NULL";
+                break;
+            case SQLITE_INTEGER:
+                table_data << sqlite3_column_int64(stmt, i);
+                break;
+            case SQLITE_FLOAT:
+                table_data << sqlite3_column_double(stmt, i);
+                break;
+            case SQLITE_TEXT:
+                table_data << reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+                break;
+            case SQLITE_BLOB:
+            {
+                const void *blob_data = sqlite3_column_blob(stmt, i);
+                int blob_size = sqlite3_column_bytes(stmt, i);
+                if (blob_data && blob_size > 0)
+                    table_data << "BLOB:" << sha256Hex(std::string(static_cast<const char *>(blob_data), blob_size));
+                else
+                    table_data << "BLOB:NULL";
+                break;
+            }
+            }
+        }
+        table_data << "\n";
     }
+
+    sqlite3_finalize(stmt);
+
+    hash_out = sha256Hex(table_data.str());
+    Logger::debug("Generated content hash for table " + table_name + " with " + std::to_string(row_count) + " rows");
+    return true;
 }
 
 std::pair<bool, std::string> DatabaseManager::getTableHash(const std::string &table_name)
@@ -5005,92 +7302,23 @@ std::pair<bool, std::string> DatabaseManager::getTableHash(const std::string &ta
             return std::any(std::pair<bool, std::string>(false, "Table does not exist: " + captured_table_name));
         }
 
-        // Get all data from the table
-        const std::string select_sql = "SELECT * FROM " + captured_table_name + " ORDER BY rowid";
-        sqlite3_stmt *stmt;
-        rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
-        if (rc != SQLITE_OK)
-        {
-            Logger::error("Failed to prepare select statement: " + std::string(sqlite3_errmsg(dbMan.db_)));
-            return std::any(std::pair<bool, std::string>(false, "Failed to prepare select statement"));
-        }
-
-        // Build a string representation of all table data
-        std::stringstream table_data;
-        int row_count = 0;
-        
-        while (sqlite3_step(stmt) == SQLITE_ROW)
+        const auto &tracked = versionTrackedTables();
+        if (std::find(tracked.begin(), tracked.end(), captured_table_name) != tracked.end())
         {
-            row_count++;
-            int columns = sqlite3_column_count(stmt);
-            
-            for (int i = 0; i < columns; i++)
-            {
-                if (i > 0) table_data << "|";
-                
-                int column_type = sqlite3_column_type(stmt, i);
-                switch (column_type)
-                {
-                    case SQLITE_NULL:
-                        table_data << "NULL";
-                        break;
-                    case SQLITE_INTEGER:
-                        table_data << sqlite3_column_int64(stmt, i);
-                        break;
-                    case SQLITE_FLOAT:
-                        table_data << sqlite3_column_double(stmt, i);
-                        break;
-                    case SQLITE_TEXT:
-                        table_data << reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
-                        break;
-                    case SQLITE_BLOB:
-                        // For BLOBs, we'll hash the binary data
-                        const void *blob_data = sqlite3_column_blob(stmt, i);
-                        int blob_size = sqlite3_column_bytes(stmt, i);
-                        if (blob_data && blob_size > 0)
-                        {
-                            // Create a simple hash of the blob data
-                            unsigned char hash[SHA256_DIGEST_LENGTH];
-                            SHA256_CTX sha256;
-                            SHA256_Init(&sha256);
-                            SHA256_Update(&sha256, blob_data, blob_size);
-                            SHA256_Final(hash, &sha256);
-                            
-                            std::stringstream blob_hash;
-                            for (int j = 0; j < SHA256_DIGEST_LENGTH; j++)
-                            {
-                                blob_hash << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[j]);
-                            }
-                            table_data << "BLOB:" << blob_hash.str();
-                        }
-                        else
-                        {
-                            table_data << "BLOB:NULL";
-                        }
-                        break;
-                }
-            }
-            table_data << "\n";
-        }
+            // Digest of the trigger-maintained change counter: changes whenever a row is written
+            std::map<std::string, int64_t> versions;
+            if (!readTableVersions(dbMan.db_, versions))
+                return std::any(std::pair<bool, std::string>(false, "Failed to read table versions"));
 
-        sqlite3_finalize(stmt);
-
-        // Hash the table data
-        std::string table_data_str = table_data.str();
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256_CTX sha256;
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, table_data_str.c_str(), table_data_str.length());
-        SHA256_Final(hash, &sha256);
-
-        std::stringstream hash_ss;
-        for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-        {
-            hash_ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+            std::string digest = sha256Hex(captured_table_name + ":" + std::to_string(versions[captured_table_name]));
+            Logger::debug("Generated hash for table " + captured_table_name + " at version " + std::to_string(versions[captured_table_name]));
+            return std::any(std::pair<bool, std::string>(true, digest));
         }
 
-        Logger::debug("Generated hash for table " + captured_table_name + " with " + std::to_string(row_count) + " rows");
-        return std::any(std::pair<bool, std::string>(true, hash_ss.str())); });
+        std::string digest;
+        if (!hashTableContents(dbMan.db_, captured_table_name, digest))
+            return std::any(std::pair<bool, std::string>(false, "Failed to prepare select statement"));
+        return std::any(std::pair<bool, std::string>(true, digest)); });
 
     // Wait for the result
     try
@@ -5144,95 +7372,33 @@ std::pair<bool, std::string> DatabaseManager::getDatabaseHash()
         }
         sqlite3_finalize(tables_stmt);
 
-        // Build combined data from all tables
+        std::map<std::string, int64_t> versions;
+        if (!readTableVersions(dbMan.db_, versions))
+            return std::any(std::pair<bool, std::string>(false, "Failed to read table versions"));
+
+        const auto &tracked = versionTrackedTables();
+
+        // Combine per-table digests; tracked tables contribute their change counter,
+        // anything else is content-hashed. sqlite_sequence and table_versions only move
+        // when a tracked table is written, so they add nothing.
         std::stringstream combined_data;
         for (const auto &table_name : table_names)
         {
-            combined_data << "TABLE:" << table_name << "\n";
-            
-            const std::string select_sql = "SELECT * FROM " + table_name + " ORDER BY rowid";
-            sqlite3_stmt *stmt;
-            rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
-            if (rc != SQLITE_OK)
-            {
-                Logger::error("Failed to prepare select statement for table " + table_name + ": " + std::string(sqlite3_errmsg(dbMan.db_)));
+            if (table_name == "sqlite_sequence" || table_name == "table_versions")
                 continue;
-            }
-
-            int row_count = 0;
-            while (sqlite3_step(stmt) == SQLITE_ROW)
-            {
-                row_count++;
-                int columns = sqlite3_column_count(stmt);
-                
-                for (int i = 0; i < columns; i++)
-                {
-                    if (i > 0) combined_data << "|";
-                    
-                    int column_type = sqlite3_column_type(stmt, i);
-                    switch (column_type)
-                    {
-                        case SQLITE_NULL:
-                            combined_data << "NULL";
-                            break;
-                        case SQLITE_INTEGER:
-                            combined_data << sqlite3_column_int64(stmt, i);
-                            break;
-                        case SQLITE_FLOAT:
-                            combined_data << sqlite3_column_double(stmt, i);
-                            break;
-                        case SQLITE_TEXT:
-                            combined_data << reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
-                            break;
-                        case SQLITE_BLOB:
-                            // For BLOBs, we'll hash the binary data
-                            const void *blob_data = sqlite3_column_blob(stmt, i);
-                            int blob_size = sqlite3_column_bytes(stmt, i);
-                            if (blob_data && blob_size > 0)
-                            {
-                                // Create a simple hash of the blob data
-                                unsigned char hash[SHA256_DIGEST_LENGTH];
-                                SHA256_CTX sha256;
-                                SHA256_Init(&sha256);
-                                SHA256_Update(&sha256, blob_data, blob_size);
-                                SHA256_Final(hash, &sha256);
-                                
-                                std::stringstream blob_hash;
-                                for (int j = 0; j < SHA256_DIGEST_LENGTH; j++)
-                                {
-                                    blob_hash << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[j]);
-                                }
-                                combined_data << "BLOB:" << blob_hash.str();
-                            }
-                            else
-                            {
-                                combined_data << "BLOB:NULL";
-                            }
-                            break;
-                    }
-                }
-                combined_data << "\n";
-            }
-            sqlite3_finalize(stmt);
-            combined_data << "END_TABLE:" << table_name << "\n";
-        }
 
-        // Hash the combined data
-        std::string combined_data_str = combined_data.str();
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256_CTX sha256;
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, combined_data_str.c_str(), combined_data_str.length());
-        SHA256_Final(hash, &sha256);
+            std::string digest;
+            if (std::find(tracked.begin(), tracked.end(), table_name) != tracked.end())
+                digest = table_name + ":" + std::to_string(versions[table_name]);
+            else if (!hashTableContents(dbMan.db_, table_name, digest))
+                continue;
 
-        std::stringstream hash_ss;
-        for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-        {
-            hash_ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+            combined_data << "TABLE:" << table_name << ":" << digest << "\n";
         }
 
+        std::string hash = sha256Hex(combined_data.str());
         Logger::debug("Generated database hash for " + std::to_string(table_names.size()) + " tables");
-        return std::any(std::pair<bool, std::string>(true, hash_ss.str())); });
+        return std::any(std::pair<bool, std::string>(true, hash)); });
 
     // Wait for the result
     try
@@ -5268,138 +7434,17 @@ std::pair<bool, std::string> DatabaseManager::getDuplicateDetectionHash()
             return std::any(std::pair<bool, std::string>(false, "Database not initialized"));
         }
         
-        // Get hashes for the three relevant tables
-        std::vector<std::string> table_names = {"scanned_files", "cache_map", "media_processing_results"};
-        std::vector<std::string> table_hashes;
-        
-        for (const auto &table_name : table_names)
-        {
-            // Check if table exists
-            const std::string check_sql = "SELECT name FROM sqlite_master WHERE type='table' AND name=?";
-            sqlite3_stmt *check_stmt;
-            int rc = sqlite3_prepare_v2(dbMan.db_, check_sql.c_str(), -1, &check_stmt, nullptr);
-            if (rc != SQLITE_OK)
-            {
-                Logger::error("Failed to prepare table check statement for " + table_name + ": " + std::string(sqlite3_errmsg(dbMan.db_)));
-                return std::any(std::pair<bool, std::string>(false, "Failed to check table existence"));
-            }
-
-            sqlite3_bind_text(check_stmt, 1, table_name.c_str(), -1, SQLITE_STATIC);
-            rc = sqlite3_step(check_stmt);
-            sqlite3_finalize(check_stmt);
-            
-            if (rc != SQLITE_ROW)
-            {
-                // Table doesn't exist, use empty hash
-                table_hashes.push_back("EMPTY_TABLE");
-                continue;
-            }
-
-            // Get table data
-            const std::string select_sql = "SELECT * FROM " + table_name + " ORDER BY rowid";
-            sqlite3_stmt *stmt;
-            rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &stmt, nullptr);
-            if (rc != SQLITE_OK)
-            {
-                Logger::error("Failed to prepare select statement for " + table_name + ": " + std::string(sqlite3_errmsg(dbMan.db_)));
-                return std::any(std::pair<bool, std::string>(false, "Failed to prepare select statement"));
-            }
-
-            // Build string representation of table data
-            std::stringstream table_data;
-            int row_count = 0;
-            
-            while (sqlite3_step(stmt) == SQLITE_ROW)
-            {
-                row_count++;
-                int columns = sqlite3_column_count(stmt);
-                
-                for (int i = 0; i < columns; i++)
-                {
-                    if (i > 0) table_data << "|";
-                    
-                    int column_type = sqlite3_column_type(stmt, i);
-                    switch (column_type)
-                    {
-                        case SQLITE_NULL:
-                            table_data << "NULL";
-                            break;
-                        case SQLITE_INTEGER:
-                            table_data << sqlite3_column_int64(stmt, i);
-                            break;
-                        case SQLITE_FLOAT:
-                            table_data << sqlite3_column_double(stmt, i);
-                            break;
-                        case SQLITE_TEXT:
-                            table_data << reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
-                            break;
-                        case SQLITE_BLOB:
-                            // For BLOBs, hash the binary data
-                            const void *blob_data = sqlite3_column_blob(stmt, i);
-                            int blob_size = sqlite3_column_bytes(stmt, i);
-                            if (blob_data && blob_size > 0)
-                            {
-                                unsigned char hash[SHA256_DIGEST_LENGTH];
-                                SHA256_CTX sha256;
-                                SHA256_Init(&sha256);
-                                SHA256_Update(&sha256, blob_data, blob_size);
-                                SHA256_Final(hash, &sha256);
-                                
-                                std::stringstream blob_hash;
-                                for (int j = 0; j < SHA256_DIGEST_LENGTH; j++)
-                                {
-                                    blob_hash << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[j]);
-                                }
-                                table_data << "BLOB:" << blob_hash.str();
-                            }
-                            else
-                            {
-                                table_data << "BLOB:NULL";
-                            }
-                            break;
-                    }
-                }
-                table_data << "\n";
-            }
-
-            sqlite3_finalize(stmt);
-
-            // Hash the table data
-            std::string table_data_str = table_data.str();
-            unsigned char hash[SHA256_DIGEST_LENGTH];
-            SHA256_CTX sha256;
-            SHA256_Init(&sha256);
-            SHA256_Update(&sha256, table_data_str.c_str(), table_data_str.length());
-            SHA256_Final(hash, &sha256);
-
-            std::stringstream hash_ss;
-            for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-            {
-                hash_ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-            }
-
-            table_hashes.push_back(hash_ss.str());
-            Logger::debug("Generated hash for table " + table_name + " with " + std::to_string(row_count) + " rows");
-        }
-
-        // Combine the three table hashes with | delimiter
-        std::string combined_data = table_hashes[0] + "|" + table_hashes[1] + "|" + table_hashes[2];
-        
-        // Hash the combined data
-        unsigned char final_hash[SHA256_DIGEST_LENGTH];
-        SHA256_CTX final_sha256;
-        SHA256_Init(&final_sha256);
-        SHA256_Update(&final_sha256, combined_data.c_str(), combined_data.length());
-        SHA256_Final(final_hash, &final_sha256);
+        // One indexed read of the change counters instead of re-reading the three tables
+        std::map<std::string, int64_t> versions;
+        if (!readTableVersions(dbMan.db_, versions))
+            return std::any(std::pair<bool, std::string>(false, "Failed to read table versions"));
 
-        std::stringstream final_hash_ss;
-        for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-        {
-            final_hash_ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(final_hash[i]);
-        }
+        std::string combined_data = "scanned_files:" + std::to_string(versions["scanned_files"]) +
+                                    "|cache_map:" + std::to_string(versions["cache_map"]) +
+                                    "|media_processing_results:" + std::to_string(versions["media_processing_results"]);
 
-        Logger::debug("Generated combined duplicate detection hash for 3 tables");
-        return std::any(std::pair<bool, std::string>(true, final_hash_ss.str())); });
+        Logger::debug("Generated duplicate detection hash from table versions: " + combined_data);
+        return std::any(std::pair<bool, std::string>(true, sha256Hex(combined_data))); });
 
     // Wait for the result
     try
@@ -5499,102 +7544,102 @@ DBOpResult DatabaseManager::setTextFlag(const std::string &flag_name, const std:
     return DBOpResult(true);
 }
 
-DBOpResult DatabaseManager::resetAllProcessingFlagsOnStartup()
+int64_t DatabaseManager::nextLeaseExpiry()
 {
-    Logger::info("Resetting all processing flags from -1 (in progress) to 0 (not processed) on startup");
+    int lease_seconds = PocoConfigAdapter::getInstance().getProcessingClaimLeaseSeconds();
+    return static_cast<int64_t>(std::time(nullptr)) + lease_seconds;
+}
 
+bool DatabaseManager::renewProcessingLease(const std::string &file_path)
+{
     if (!waitForQueueInitialization())
     {
-        std::string msg = "Access queue not initialized after retries";
-        Logger::error(msg);
-        return DBOpResult(false, msg);
+        Logger::error("Access queue not initialized after retries");
+        return false;
     }
 
-    std::string error_msg;
-    bool success = true;
-
-    // Enqueue the write operation
-    auto operation_id = enqueueWriteInline([&error_msg, &success](DatabaseManager &dbMan)
-                                           {
-        Logger::debug("Executing resetAllProcessingFlagsOnStartup in write queue");
-        
+    std::string captured_file_path = file_path;
+    bool renewed = false;
+    enqueueWriteInline([captured_file_path, &renewed](DatabaseManager &dbMan)
+                       {
         if (!dbMan.db_)
-        {
-            error_msg = "Database not initialized";
-            Logger::error(error_msg);
-            return WriteOperationResult::Failure(error_msg);
-        }
+            return WriteOperationResult::Failure("Database not initialized");
 
-        // Start transaction
-        sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
-        
-        // Reset all processing flags from -1 to 0 for all modes
-        const std::string update_sql = R"(
-            UPDATE scanned_files 
-            SET processed_fast = CASE WHEN processed_fast = -1 THEN 0 ELSE processed_fast END,
-                processed_balanced = CASE WHEN processed_balanced = -1 THEN 0 ELSE processed_balanced END,
-                processed_quality = CASE WHEN processed_quality = -1 THEN 0 ELSE processed_quality END
-            WHERE processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1
+        const char *renew_sql = R"(
+            UPDATE scanned_files SET lease_until = ?
+            WHERE file_path = ? AND lease_owner = ?
+              AND (processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1)
         )";
-
         sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(dbMan.db_, update_sql.c_str(), -1, &stmt, nullptr);
-        if (rc != SQLITE_OK)
+        if (sqlite3_prepare_v2(dbMan.db_, renew_sql, -1, &stmt, nullptr) != SQLITE_OK)
         {
-            error_msg = "Failed to prepare reset statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+            std::string error_msg = "Failed to prepare lease renewal: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
-            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
             return WriteOperationResult::Failure(error_msg);
         }
-
-        rc = sqlite3_step(stmt);
+        sqlite3_bind_int64(stmt, 1, nextLeaseExpiry());
+        sqlite3_bind_text(stmt, 2, captured_file_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
         sqlite3_finalize(stmt);
-
         if (rc != SQLITE_DONE)
         {
-            error_msg = "Failed to reset processing flags: " + std::string(sqlite3_errmsg(dbMan.db_));
+            std::string error_msg = "Failed to renew processing lease: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
-            sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
             return WriteOperationResult::Failure(error_msg);
         }
+        renewed = sqlite3_changes(dbMan.db_) > 0;
+        return WriteOperationResult(); });
+    waitForWrites();
 
-        // Get count of affected rows
-        const std::string count_sql = "SELECT COUNT(*) FROM scanned_files WHERE processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1";
-        sqlite3_stmt *count_stmt;
-        rc = sqlite3_prepare_v2(dbMan.db_, count_sql.c_str(), -1, &count_stmt, nullptr);
-        if (rc == SQLITE_OK)
-        {
-            if (sqlite3_step(count_stmt) == SQLITE_ROW)
-            {
-                int remaining_count = sqlite3_column_int(count_stmt, 0);
-                if (remaining_count > 0)
-                {
-                    Logger::warn("Warning: " + std::to_string(remaining_count) + " files still have -1 status after reset");
-                }
-            }
-            sqlite3_finalize(count_stmt);
-        }
+    if (!renewed)
+    {
+        Logger::warn("Processing lease no longer held: " + file_path);
+    }
+    return renewed;
+}
 
-        // Commit transaction
-        sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr);
-        
-        Logger::info("Successfully reset all processing flags on startup");
-        return WriteOperationResult(true); });
+int DatabaseManager::reclaimExpiredProcessingLeases(sqlite3 *db)
+{
+    // The OR term must match idx_scanned_files_in_progress verbatim so only
+    // expired in-progress rows are visited
+    const char *reclaim_sql = R"(
+        UPDATE scanned_files
+        SET processed_fast = CASE WHEN processed_fast = -1 THEN 0 ELSE processed_fast END,
+            processed_balanced = CASE WHEN processed_balanced = -1 THEN 0 ELSE processed_balanced END,
+            processed_quality = CASE WHEN processed_quality = -1 THEN 0 ELSE processed_quality END,
+            lease_owner = NULL
+        WHERE (processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1)
+          AND lease_until < ?
+    )";
 
-    waitForWrites();
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, reclaim_sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        Logger::error("Failed to prepare lease reclaim statement: " + std::string(sqlite3_errmsg(db)));
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(std::time(nullptr)));
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE)
+    {
+        Logger::error("Failed to reclaim expired leases: " + std::string(sqlite3_errmsg(db)));
+        return -1;
+    }
 
-    // In inline mode, success reflects immediate execution
-    return DBOpResult(true);
+    int reclaimed = sqlite3_changes(db);
+    if (reclaimed > 0)
+    {
+        Logger::info("Reclaimed " + std::to_string(reclaimed) + " files with expired processing leases");
+    }
+    return reclaimed;
 }
 
 std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFilesForProcessingWithPriority(DedupMode mode, int batch_size)
 {
     Logger::debug("getAndMarkFilesForProcessingWithPriority called for mode: " + DedupModes::getModeName(mode) + " with batch size: " + std::to_string(batch_size));
 
-    // Calculate split: 50% stuck transcoded files, 50% regular files
-    int stuck_batch_size = batch_size / 2;
-    int regular_batch_size = batch_size - stuck_batch_size; // Handle odd batch sizes
-
     std::vector<std::pair<std::string, std::string>> results;
     if (!waitForQueueInitialization())
     {
@@ -5607,13 +7652,12 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
 
     // Capture the parameters for async execution
     DedupMode captured_mode = mode;
-    int captured_stuck_batch_size = stuck_batch_size;
-    int captured_regular_batch_size = regular_batch_size;
+    int captured_batch_size = batch_size;
     std::atomic<bool> operation_completed{false};
     std::string error_msg;
 
     // Use enqueueWrite since we're performing write operations (UPDATE statements)
-    auto future = enqueueWriteInline([captured_mode, captured_stuck_batch_size, captured_regular_batch_size, &results, &operation_completed, &error_msg, this](DatabaseManager &dbMan)
+    auto future = enqueueWriteInline([captured_mode, captured_batch_size, &results, &operation_completed, &error_msg, this](DatabaseManager &dbMan)
                                      {
         Logger::debug("Executing getAndMarkFilesForProcessingWithPriority in write queue for mode: " + DedupModes::getModeName(captured_mode));
         
@@ -5627,131 +7671,58 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         
         // Start transaction for better concurrency
         sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+        // Expired claims from crashed or stalled workers go back to pending first
+        reclaimExpiredProcessingLeases(dbMan.db_);
+        int64_t lease_until = nextLeaseExpiry();
         
-        std::string file_type_clauses = generateFileTypeLikeClauses();
+        std::string file_type_clauses = generateFileTypeInClause();
         std::vector<std::string> file_paths_to_mark;
         
-        // PRIORITY 1: Get stuck transcoded files (files with status = 2 in cache_map but processed_X = -1)
-        std::string stuck_transcoded_sql;
+        // Deferred RAW files whose transcode has finished carry processing_priority = 1,
+        // so a single ordered scan of the per-mode partial index serves them first
+        std::string select_sql;
         switch (captured_mode)
         {
             case DedupMode::FAST:
-                stuck_transcoded_sql = R"(
-                    SELECT sf.file_path, sf.file_name 
-                    FROM scanned_files sf
-                    JOIN cache_map cm ON sf.file_path = cm.source_file_path
-                    WHERE cm.status = 2 
-                      AND sf.processed_fast = -1 
-                      AND (sf.processed_fast != 0)
-                      AND ()" + file_type_clauses + R"()
-                    ORDER BY sf.created_at DESC 
-                    LIMIT ?
-                )";
+                select_sql = "SELECT file_path, file_name, processing_priority FROM scanned_files INDEXED BY idx_scanned_files_pending_fast WHERE processed_fast = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::BALANCED:
-                stuck_transcoded_sql = R"(
-                    SELECT sf.file_path, sf.file_name 
-                    FROM scanned_files sf
-                    JOIN cache_map cm ON sf.file_path = cm.source_file_path
-                    WHERE cm.status = 2 
-                      AND sf.processed_balanced = -1 
-                      AND (sf.processed_balanced != 0)
-                      AND ()" + file_type_clauses + R"()
-                    ORDER BY sf.created_at DESC 
-                    LIMIT ?
-                )";
+                select_sql = "SELECT file_path, file_name, processing_priority FROM scanned_files INDEXED BY idx_scanned_files_pending_balanced WHERE processed_balanced = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
             case DedupMode::QUALITY:
-                stuck_transcoded_sql = R"(
-                    SELECT sf.file_path, sf.file_name 
-                    FROM scanned_files sf
-                    JOIN cache_map cm ON sf.file_path = cm.source_file_path
-                    WHERE cm.status = 2 
-                      AND sf.processed_quality = -1 
-                      AND (sf.processed_quality != 0)
-                      AND ()" + file_type_clauses + R"()
-                    ORDER BY sf.created_at DESC 
-                    LIMIT ?
-                )";
+                select_sql = "SELECT file_path, file_name, processing_priority FROM scanned_files INDEXED BY idx_scanned_files_pending_quality WHERE processed_quality = 0 AND (" + file_type_clauses + ") ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
                 break;
         }
-        
-        Logger::debug("Priority 1 SQL (stuck transcoded): " + stuck_transcoded_sql);
-        
-        sqlite3_stmt *stuck_stmt;
-        int rc = sqlite3_prepare_v2(dbMan.db_, stuck_transcoded_sql.c_str(), -1, &stuck_stmt, nullptr);
+
+        sqlite3_stmt *select_stmt;
+        int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &select_stmt, nullptr);
         if (rc != SQLITE_OK)
         {
-            error_msg = "Failed to prepare stuck transcoded statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+            error_msg = "Failed to prepare select statement: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
             sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
             operation_completed.store(true);
             return WriteOperationResult::Failure(error_msg);
         }
 
-        sqlite3_bind_int(stuck_stmt, 1, captured_stuck_batch_size);
-        
+        sqlite3_bind_int(select_stmt, 1, captured_batch_size);
+
         int stuck_files_found = 0;
-        while (sqlite3_step(stuck_stmt) == SQLITE_ROW)
+        while (sqlite3_step(select_stmt) == SQLITE_ROW)
         {
-            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(stuck_stmt, 0));
-            std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(stuck_stmt, 1));
+            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(select_stmt, 0));
+            std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(select_stmt, 1));
+            if (sqlite3_column_int(select_stmt, 2) > 0)
+            {
+                stuck_files_found++;
+                Logger::debug("Found transcoded file pending processing: " + file_path);
+            }
             results.emplace_back(file_path, file_name);
             file_paths_to_mark.push_back(file_path);
-            stuck_files_found++;
-            Logger::debug("Found stuck transcoded file: " + file_path);
         }
-        
-        sqlite3_finalize(stuck_stmt);
-        Logger::debug("Found " + std::to_string(stuck_files_found) + " stuck transcoded files");
-
-        // PRIORITY 2: Fill remaining batch with regular unprocessed files
-        int remaining_batch_size = captured_stuck_batch_size + captured_regular_batch_size - stuck_files_found;
-        if (remaining_batch_size > 0)
-        {
-            std::string regular_sql;
-            switch (captured_mode)
-            {
-                case DedupMode::FAST:
-                    regular_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_fast = 0 AND processed_fast != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
-                    break;
-                case DedupMode::BALANCED:
-                    regular_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_balanced = 0 AND processed_balanced != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
-                    break;
-                case DedupMode::QUALITY:
-                    regular_sql = "SELECT file_path, file_name FROM scanned_files WHERE processed_quality = 0 AND processed_quality != -1 AND (" + file_type_clauses + ") ORDER BY created_at DESC LIMIT ?";
-                    break;
-            }
-            
-            Logger::debug("Priority 2 SQL (regular): " + regular_sql);
-            
-            sqlite3_stmt *regular_stmt;
-            rc = sqlite3_prepare_v2(dbMan.db_, regular_sql.c_str(), -1, &regular_stmt, nullptr);
-            if (rc != SQLITE_OK)
-            {
-                error_msg = "Failed to prepare regular statement: " + std::string(sqlite3_errmsg(dbMan.db_));
-                Logger::error(error_msg);
-                sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
-            }
 
-            sqlite3_bind_int(regular_stmt, 1, remaining_batch_size);
-            
-            int regular_files_found = 0;
-            while (sqlite3_step(regular_stmt) == SQLITE_ROW)
-            {
-                std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(regular_stmt, 0));
-                std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(regular_stmt, 1));
-                results.emplace_back(file_path, file_name);
-                file_paths_to_mark.push_back(file_path);
-                regular_files_found++;
-                Logger::debug("Found regular file: " + file_path);
-            }
-            
-            sqlite3_finalize(regular_stmt);
-            Logger::debug("Found " + std::to_string(regular_files_found) + " regular files");
-        }
+        sqlite3_finalize(select_stmt);
 
         // Mark all found files as in progress
         if (!file_paths_to_mark.empty())
@@ -5760,13 +7731,13 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
             switch (captured_mode)
             {
                 case DedupMode::FAST:
-                    update_sql = "UPDATE scanned_files SET processed_fast = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_fast = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 case DedupMode::BALANCED:
-                    update_sql = "UPDATE scanned_files SET processed_balanced = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_balanced = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 case DedupMode::QUALITY:
-                    update_sql = "UPDATE scanned_files SET processed_quality = -1 WHERE file_path = ?";
+                    update_sql = "UPDATE scanned_files SET processed_quality = -1, lease_owner = ?, lease_until = ? WHERE file_path = ?";
                     break;
                 default:
                     break;
@@ -5799,7 +7770,9 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
                 for (size_t j = i; j < end_idx; j++)
                 {
                     const auto& file_path = file_paths_to_mark[j];
-                    sqlite3_bind_text(update_stmt, 1, file_path.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_text(update_stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_int64(update_stmt, 2, lease_until);
+                    sqlite3_bind_text(update_stmt, 3, file_path.c_str(), -1, SQLITE_STATIC);
                     rc = sqlite3_step(update_stmt);
                     if (rc != SQLITE_DONE)
                     {
@@ -5816,7 +7789,7 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr);
         
         Logger::debug("Atomically marked " + std::to_string(results.size()) + " files as in progress for mode: " + DedupModes::getModeName(captured_mode) + 
-                     " (stuck transcoded: " + std::to_string(stuck_files_found) + ", regular: " + std::to_string(results.size() - stuck_files_found) + ")");
+                     " (transcoded: " + std::to_string(stuck_files_found) + ", regular: " + std::to_string(results.size() - stuck_files_found) + ")");
         operation_completed.store(true);
         return WriteOperationResult(); });
 
@@ -5836,10 +7809,6 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
 {
     Logger::debug("getAndMarkFilesForProcessingAnyModeWithPriority called with batch size: " + std::to_string(batch_size));
 
-    // Calculate split: 50% stuck transcoded files, 50% regular files
-    int stuck_batch_size = batch_size / 2;
-    int regular_batch_size = batch_size - stuck_batch_size; // Handle odd batch sizes
-
     std::vector<std::pair<std::string, std::string>> results;
     if (!waitForQueueInitialization())
     {
@@ -5851,13 +7820,12 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
     std::lock_guard<std::mutex> lock(file_processing_mutex);
 
     // Capture the parameters for async execution
-    int captured_stuck_batch_size = stuck_batch_size;
-    int captured_regular_batch_size = regular_batch_size;
+    int captured_batch_size = batch_size;
     std::atomic<bool> operation_completed{false};
     std::string error_msg;
 
     // Use enqueueWrite since we're performing write operations (UPDATE statements)
-    auto future = enqueueWriteInline([captured_stuck_batch_size, captured_regular_batch_size, &operation_completed, &error_msg, &results, this](DatabaseManager &dbMan) -> WriteOperationResult
+    auto future = enqueueWriteInline([captured_batch_size, &operation_completed, &error_msg, &results, this](DatabaseManager &dbMan) -> WriteOperationResult
                                      {
         Logger::debug("Executing getAndMarkFilesForProcessingAnyModeWithPriority in write queue");
         
@@ -5871,100 +7839,59 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         
         // Start transaction for better concurrency
         sqlite3_exec(dbMan.db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+        // Expired claims from crashed or stalled workers go back to pending first
+        reclaimExpiredProcessingLeases(dbMan.db_);
+        int64_t lease_until = nextLeaseExpiry();
         
-        std::string file_type_clauses = generateFileTypeLikeClauses();
+        std::string file_type_clauses = generateFileTypeInClause();
         std::vector<std::string> file_paths_to_mark;
         
-        // PRIORITY 1: Get stuck transcoded files (files with status = 2 in cache_map but any processed_X = -1)
-        std::string stuck_transcoded_sql = R"(
-            SELECT DISTINCT sf.file_path, sf.file_name 
-            FROM scanned_files sf
-            JOIN cache_map cm ON sf.file_path = cm.source_file_path
-            WHERE cm.status = 2 
-              AND (sf.processed_fast = -1 OR sf.processed_balanced = -1 OR sf.processed_quality = -1)
-              AND ()" + file_type_clauses + R"()
-            ORDER BY sf.created_at DESC 
-            LIMIT ?
-        )";
-        
-        Logger::debug("Priority 1 SQL (stuck transcoded): " + stuck_transcoded_sql);
-        
-        sqlite3_stmt *stuck_stmt;
-        int rc = sqlite3_prepare_v2(dbMan.db_, stuck_transcoded_sql.c_str(), -1, &stuck_stmt, nullptr);
+        // Deferred RAW files whose transcode has finished carry processing_priority = 1,
+        // so a single ordered scan of idx_scanned_files_pending_any serves them first.
+        // The OR term must match the index predicate verbatim for SQLite to use it.
+        std::string select_sql = "SELECT file_path, file_name, processing_priority FROM scanned_files WHERE "
+                                 "(processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0) AND "
+                                 "(" + file_type_clauses + ") "
+                                 "ORDER BY processing_priority DESC, created_at DESC LIMIT ?";
+
+        sqlite3_stmt *select_stmt;
+        int rc = sqlite3_prepare_v2(dbMan.db_, select_sql.c_str(), -1, &select_stmt, nullptr);
         if (rc != SQLITE_OK)
         {
-            error_msg = "Failed to prepare stuck transcoded statement: " + std::string(sqlite3_errmsg(dbMan.db_));
+            error_msg = "Failed to prepare select statement: " + std::string(sqlite3_errmsg(dbMan.db_));
             Logger::error(error_msg);
             sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
             operation_completed.store(true);
             return WriteOperationResult::Failure(error_msg);
         }
 
-        sqlite3_bind_int(stuck_stmt, 1, captured_stuck_batch_size);
-        
+        sqlite3_bind_int(select_stmt, 1, captured_batch_size);
+
         int stuck_files_found = 0;
-        while (sqlite3_step(stuck_stmt) == SQLITE_ROW)
+        while (sqlite3_step(select_stmt) == SQLITE_ROW)
         {
-            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(stuck_stmt, 0));
-            std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(stuck_stmt, 1));
+            std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(select_stmt, 0));
+            std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(select_stmt, 1));
+            if (sqlite3_column_int(select_stmt, 2) > 0)
+            {
+                stuck_files_found++;
+                Logger::debug("Found transcoded file pending processing: " + file_path);
+            }
             results.emplace_back(file_path, file_name);
             file_paths_to_mark.push_back(file_path);
-            stuck_files_found++;
-            Logger::debug("Found stuck transcoded file: " + file_path);
         }
-        
-        sqlite3_finalize(stuck_stmt);
-        Logger::debug("Found " + std::to_string(stuck_files_found) + " stuck transcoded files");
 
-        // PRIORITY 2: Fill remaining batch with regular unprocessed files
-        int remaining_batch_size = captured_stuck_batch_size + captured_regular_batch_size - stuck_files_found;
-        if (remaining_batch_size > 0)
-        {
-            std::string regular_sql = "SELECT file_path, file_name FROM scanned_files WHERE "
-                                    "(" + file_type_clauses + ") AND "
-                                    "((processed_fast = 0 AND processed_fast != -1) OR "
-                                    "(processed_balanced = 0 AND processed_balanced != -1) OR "
-                                    "(processed_quality = 0 AND processed_quality != -1)) "
-                                    "ORDER BY created_at DESC LIMIT ?";
-            
-            Logger::debug("Priority 2 SQL (regular): " + regular_sql);
-            
-            sqlite3_stmt *regular_stmt;
-            rc = sqlite3_prepare_v2(dbMan.db_, regular_sql.c_str(), -1, &regular_stmt, nullptr);
-            if (rc != SQLITE_OK)
-            {
-                error_msg = "Failed to prepare regular statement: " + std::string(sqlite3_errmsg(dbMan.db_));
-                Logger::error(error_msg);
-                sqlite3_exec(dbMan.db_, "ROLLBACK", nullptr, nullptr, nullptr);
-                operation_completed.store(true);
-                return WriteOperationResult::Failure(error_msg);
-            }
-
-            sqlite3_bind_int(regular_stmt, 1, remaining_batch_size);
-            
-            int regular_files_found = 0;
-            while (sqlite3_step(regular_stmt) == SQLITE_ROW)
-            {
-                std::string file_path = reinterpret_cast<const char *>(sqlite3_column_text(regular_stmt, 0));
-                std::string file_name = reinterpret_cast<const char *>(sqlite3_column_text(regular_stmt, 1));
-                results.emplace_back(file_path, file_name);
-                file_paths_to_mark.push_back(file_path);
-                regular_files_found++;
-                Logger::debug("Found regular file: " + file_path);
-            }
-            
-            sqlite3_finalize(regular_stmt);
-            Logger::debug("Found " + std::to_string(regular_files_found) + " regular files");
-        }
+        sqlite3_finalize(select_stmt);
 
         // Mark all found files as in progress for ALL modes that need processing
         if (!file_paths_to_mark.empty())
         {
             // Mark files as in progress for each mode that needs processing
             std::vector<std::string> update_sqls = {
-                "UPDATE scanned_files SET processed_fast = -1 WHERE file_path = ? AND processed_fast = 0",
-                "UPDATE scanned_files SET processed_balanced = -1 WHERE file_path = ? AND processed_balanced = 0",
-                "UPDATE scanned_files SET processed_quality = -1 WHERE file_path = ? AND processed_quality = 0"
+                "UPDATE scanned_files SET processed_fast = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_fast = 0",
+                "UPDATE scanned_files SET processed_balanced = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_balanced = 0",
+                "UPDATE scanned_files SET processed_quality = -1, lease_owner = ?, lease_until = ? WHERE file_path = ? AND processed_quality = 0"
             };
 
             // Process files in smaller batches to reduce transaction size
@@ -5996,7 +7923,9 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
                     for (size_t j = i; j < end_idx; j++)
                     {
                         const auto& file_path = file_paths_to_mark[j];
-                        sqlite3_bind_text(update_stmt, 1, file_path.c_str(), -1, SQLITE_STATIC);
+                        sqlite3_bind_text(update_stmt, 1, dbMan.lease_owner_id_.c_str(), -1, SQLITE_STATIC);
+                        sqlite3_bind_int64(update_stmt, 2, lease_until);
+                        sqlite3_bind_text(update_stmt, 3, file_path.c_str(), -1, SQLITE_STATIC);
                         rc = sqlite3_step(update_stmt);
                         if (rc != SQLITE_DONE)
                         {
@@ -6014,7 +7943,7 @@ std::vector<std::pair<std::string, std::string>> DatabaseManager::getAndMarkFile
         sqlite3_exec(dbMan.db_, "COMMIT", nullptr, nullptr, nullptr);
         
         Logger::debug("Atomically marked " + std::to_string(results.size()) + " files as in progress for any mode" + 
-                     " (stuck transcoded: " + std::to_string(stuck_files_found) + ", regular: " + std::to_string(results.size() - stuck_files_found) + ")");
+                     " (transcoded: " + std::to_string(stuck_files_found) + ", regular: " + std::to_string(results.size() - stuck_files_found) + ")");
         operation_completed.store(true);
         return WriteOperationResult(); });
 
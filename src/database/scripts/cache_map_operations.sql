@@ -9,10 +9,6 @@
 -- Used in: TranscodingManager::getNextTranscodingJob()
 SELECT source_file_path FROM cache_map WHERE status = 0;
 
--- Reset worker assignment for stuck jobs
--- Used in: TranscodingManager::resetStuckJobs()
-UPDATE cache_map SET status = 0, worker_id = NULL WHERE status = 1;
-
 -- Count active worker jobs
 -- Used in: TranscodingManager::getActiveWorkerCount()
 SELECT COUNT(*) FROM cache_map WHERE status = 1;
@@ -32,8 +28,13 @@ WHERE
 -- Used in: getNextTranscodingJob()
 SELECT source_file_path
 FROM cache_map
-WHERE
-    status = 0
+WHERE (
+        status = 0
+        OR (
+            status = 1
+            AND lease_until < ?
+        )
+    )
     AND transcoded_file_path IS NULL
 ORDER BY created_at ASC
 LIMIT 1;
@@ -48,6 +49,7 @@ UPDATE cache_map
 SET
     status = 1,
     worker_id = ?,
+    lease_until = ?,
     updated_at = CURRENT_TIMESTAMP
 WHERE
     source_file_path = ?;
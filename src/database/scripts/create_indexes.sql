@@ -3,15 +3,45 @@
 -- Create index on cache_map status for faster job selection
 CREATE INDEX IF NOT EXISTS idx_cache_map_status ON cache_map (status, created_at);
 
+-- Jobs not transcoded yet, in claim order
+CREATE INDEX IF NOT EXISTS idx_cache_map_pending ON cache_map (created_at, id)
+    WHERE transcoded_file_path IS NULL;
+
+-- Sources sharing a transcoded file
+CREATE INDEX IF NOT EXISTS idx_cache_map_transcoded ON cache_map (transcoded_file_path)
+    WHERE transcoded_file_path IS NOT NULL;
+
+-- Transcoded files, least recently used first
+CREATE INDEX IF NOT EXISTS idx_cache_objects_lru ON cache_objects (last_access);
+
+-- Transcoded files by source content
+CREATE INDEX IF NOT EXISTS idx_cache_objects_content_key ON cache_objects (content_key)
+    WHERE content_key IS NOT NULL;
+
 -- Create index on scanned_files file_path for faster lookups
 CREATE INDEX IF NOT EXISTS idx_scanned_files_file_path ON scanned_files (file_path);
 
--- Create index on scanned_files processed flags for faster processing queries
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_fast ON scanned_files (processed_fast);
+-- Create partial indexes on scanned_files pending work (processed_X = 0) for O(log n) claims
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_any ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_fast ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_fast = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_balanced ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_balanced = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_quality ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_quality = 0;
+
+-- Create partial index on in-progress scanned_files by lease expiry for lazy reclaim
+CREATE INDEX IF NOT EXISTS idx_scanned_files_in_progress ON scanned_files (lease_until)
+WHERE processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1;
 
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_balanced ON scanned_files (processed_balanced);
+-- Create indexes on scanned_files file type columns for enabled-type filtering
+CREATE INDEX IF NOT EXISTS idx_scanned_files_file_extension ON scanned_files (file_extension);
 
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_quality ON scanned_files (processed_quality);
+CREATE INDEX IF NOT EXISTS idx_scanned_files_media_type ON scanned_files (media_type);
 
 -- Create index on scanned_files created_at for ordering
 CREATE INDEX IF NOT EXISTS idx_scanned_files_created_at ON scanned_files (created_at);
@@ -23,7 +23,18 @@ CREATE TABLE IF NOT EXISTS scanned_files (
     relative_path TEXT, -- For network mounts: share:relative/path
     share_name TEXT, -- The share name (B, G, etc.)
     file_name TEXT NOT NULL,
+    file_extension TEXT, -- Lowercased extension without the dot, computed at scan time
+    media_type TEXT, -- Media category (image, video, audio), computed at scan time
+    processing_priority INTEGER DEFAULT 0, -- Claim order boost (1 = deferred RAW file whose transcode finished)
+    lease_owner TEXT, -- host:pid of the worker holding the in-progress (-1) claim
+    lease_until INTEGER DEFAULT 0, -- Unix time the claim expires; expired -1 rows are reclaimed lazily
     file_metadata TEXT, -- File metadata for change detection (creation date, modification date, size)
+    file_mtime INTEGER, -- Same stat as binary columns, compared without parsing in scan diffs
+    file_created INTEGER,
+    file_size INTEGER,
+    file_inode INTEGER,
+    file_device INTEGER,
+    scan_generation INTEGER DEFAULT 0, -- Scan generation that last stored or confirmed the file; older rows are swept after full walks
     processed_fast BOOLEAN DEFAULT 0, -- Processing flag for FAST mode
     processed_balanced BOOLEAN DEFAULT 0, -- Processing flag for BALANCED mode
     processed_quality BOOLEAN DEFAULT 0, -- Processing flag for QUALITY mode
@@ -50,14 +61,46 @@ CREATE TABLE IF NOT EXISTS cache_map (
     transcoded_file_path TEXT,
     status INTEGER DEFAULT 0,
     worker_id TEXT,
+    lease_until INTEGER DEFAULT 0,
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     FOREIGN KEY (source_file_path) REFERENCES scanned_files (file_path) ON DELETE CASCADE
 );
 
+-- Transcoded files; cache_map rows of sources with identical content share one
+CREATE TABLE IF NOT EXISTS cache_objects (
+    cache_file_path TEXT PRIMARY KEY,
+    content_key TEXT,
+    content_hash TEXT,
+    file_size INTEGER DEFAULT 0,
+    last_access INTEGER DEFAULT 0,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
 -- Flags table
 CREATE TABLE IF NOT EXISTS flags (
     name TEXT PRIMARY KEY,
     value TEXT NOT NULL DEFAULT '0',
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
-);
\ No newline at end of file
+);
+
+-- Per-table change counters maintained by triggers; used for O(1) change detection
+CREATE TABLE IF NOT EXISTS table_versions (
+    table_name TEXT PRIMARY KEY,
+    version INTEGER NOT NULL DEFAULT 0
+);
+
+-- Counters start at their creation time in microseconds, so versions of a recreated database
+-- never match ones cached against the old one
+INSERT OR IGNORE INTO table_versions(table_name, version)
+SELECT name, CAST((julianday('now') - 2440587.5) * 86400000000 AS INTEGER)
+FROM (SELECT 'scanned_files' AS name UNION ALL SELECT 'media_processing_results' UNION ALL SELECT 'cache_map'
+      UNION ALL SELECT 'user_inputs' UNION ALL SELECT 'flags');
+
+-- Directory mtimes from the last scan of each root; lets rescans skip unchanged subtrees
+CREATE TABLE IF NOT EXISTS directory_manifest (
+    dir_path TEXT PRIMARY KEY,
+    parent_path TEXT,
+    mtime_ns INTEGER NOT NULL,
+    scan_generation INTEGER NOT NULL
+) WITHOUT ROWID;
\ No newline at end of file
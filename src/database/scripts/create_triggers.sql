@@ -8,9 +8,11 @@ BEGIN
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
 END;
 
--- Create a trigger to set transcode_preprocess_scanned_files_changed to 1 on UPDATE
-CREATE TRIGGER IF NOT EXISTS trg_scanned_files_changed_update
-AFTER UPDATE ON scanned_files
+-- Create a trigger to set transcode_preprocess_scanned_files_changed to 1 on UPDATE of the file's own columns
+DROP TRIGGER IF EXISTS trg_scanned_files_changed_update;
+CREATE TRIGGER trg_scanned_files_changed_update
+AFTER UPDATE OF file_path, relative_path, share_name, file_name, file_extension, media_type, file_metadata,
+    file_mtime, file_created, file_size, file_inode, file_device, is_network_file ON scanned_files
 BEGIN
     INSERT INTO flags(name, value, updated_at) VALUES ('transcode_preprocess_scanned_files_changed', 1, CURRENT_TIMESTAMP)
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
@@ -22,4 +24,120 @@ AFTER DELETE ON scanned_files
 BEGIN
     INSERT INTO flags(name, value, updated_at) VALUES ('transcode_preprocess_scanned_files_changed', 1, CURRENT_TIMESTAMP)
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
+END;
+
+-- Bump table_versions on every change of a tracked table's content. Claims, leases and
+-- scan generation stamps are bookkeeping and leave the versions alone.
+CREATE TRIGGER IF NOT EXISTS trg_scanned_files_version_insert
+AFTER INSERT ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_scanned_files_version_update;
+CREATE TRIGGER trg_scanned_files_version_update
+AFTER UPDATE OF file_path, relative_path, share_name, file_name, file_extension, media_type, file_metadata,
+    file_mtime, file_created, file_size, file_inode, file_device, is_network_file,
+    links_fast, links_balanced, links_quality ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_scanned_files_version_delete
+AFTER DELETE ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_media_processing_results_version_insert
+AFTER INSERT ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_media_processing_results_version_update;
+CREATE TRIGGER trg_media_processing_results_version_update
+AFTER UPDATE ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_media_processing_results_version_delete
+AFTER DELETE ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_cache_map_version_insert
+AFTER INSERT ON cache_map
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_cache_map_version_update;
+CREATE TRIGGER trg_cache_map_version_update
+AFTER UPDATE OF source_file_path, transcoded_file_path, status ON cache_map
+WHEN NEW.status IS NOT 1
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_cache_map_version_delete
+AFTER DELETE ON cache_map
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_user_inputs_version_insert
+AFTER INSERT ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_user_inputs_version_update;
+CREATE TRIGGER trg_user_inputs_version_update
+AFTER UPDATE ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_user_inputs_version_delete
+AFTER DELETE ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flags_version_insert
+AFTER INSERT ON flags
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_flags_version_update;
+CREATE TRIGGER trg_flags_version_update
+AFTER UPDATE OF value ON flags
+WHEN OLD.value IS NOT NEW.value
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flags_version_delete
+AFTER DELETE ON flags
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
 END;
\ No newline at end of file
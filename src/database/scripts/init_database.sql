@@ -26,7 +26,18 @@ CREATE TABLE IF NOT EXISTS scanned_files (
     relative_path TEXT, -- For network mounts: share:relative/path
     share_name TEXT, -- The share name (B, G, etc.)
     file_name TEXT NOT NULL,
+    file_extension TEXT, -- Lowercased extension without the dot, computed at scan time
+    media_type TEXT, -- Media category (image, video, audio), computed at scan time
+    processing_priority INTEGER DEFAULT 0, -- Claim order boost (1 = deferred RAW file whose transcode finished)
+    lease_owner TEXT, -- host:pid of the worker holding the in-progress (-1) claim
+    lease_until INTEGER DEFAULT 0, -- Unix time the claim expires; expired -1 rows are reclaimed lazily
     file_metadata TEXT, -- File metadata for change detection (creation date, modification date, size)
+    file_mtime INTEGER, -- Same stat as binary columns, compared without parsing in scan diffs
+    file_created INTEGER,
+    file_size INTEGER,
+    file_inode INTEGER,
+    file_device INTEGER,
+    scan_generation INTEGER DEFAULT 0, -- Scan generation that last stored or confirmed the file; older rows are swept after full walks
     processed_fast BOOLEAN DEFAULT 0, -- Processing flag for FAST mode
     processed_balanced BOOLEAN DEFAULT 0, -- Processing flag for BALANCED mode
     processed_quality BOOLEAN DEFAULT 0, -- Processing flag for QUALITY mode
@@ -51,11 +62,24 @@ CREATE TABLE IF NOT EXISTS cache_map (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
     source_file_path TEXT NOT NULL UNIQUE,
     transcoded_file_path TEXT,
+    status INTEGER DEFAULT 0,
+    worker_id TEXT,
+    lease_until INTEGER DEFAULT 0,
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     FOREIGN KEY (source_file_path) REFERENCES scanned_files (file_path) ON DELETE CASCADE
 );
 
+-- Transcoded files; cache_map rows of sources with identical content share one
+CREATE TABLE IF NOT EXISTS cache_objects (
+    cache_file_path TEXT PRIMARY KEY,
+    content_key TEXT,
+    content_hash TEXT,
+    file_size INTEGER DEFAULT 0,
+    last_access INTEGER DEFAULT 0,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
 -- Flags table
 CREATE TABLE IF NOT EXISTS flags (
     name TEXT PRIMARY KEY,
@@ -63,6 +87,27 @@ CREATE TABLE IF NOT EXISTS flags (
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
 );
 
+-- Per-table change counters maintained by triggers; used for O(1) change detection
+CREATE TABLE IF NOT EXISTS table_versions (
+    table_name TEXT PRIMARY KEY,
+    version INTEGER NOT NULL DEFAULT 0
+);
+
+-- Counters start at their creation time in microseconds, so versions of a recreated database
+-- never match ones cached against the old one
+INSERT OR IGNORE INTO table_versions(table_name, version)
+SELECT name, CAST((julianday('now') - 2440587.5) * 86400000000 AS INTEGER)
+FROM (SELECT 'scanned_files' AS name UNION ALL SELECT 'media_processing_results' UNION ALL SELECT 'cache_map'
+      UNION ALL SELECT 'user_inputs' UNION ALL SELECT 'flags');
+
+-- Directory mtimes from the last scan of each root; lets rescans skip unchanged subtrees
+CREATE TABLE IF NOT EXISTS directory_manifest (
+    dir_path TEXT PRIMARY KEY,
+    parent_path TEXT,
+    mtime_ns INTEGER NOT NULL,
+    scan_generation INTEGER NOT NULL
+) WITHOUT ROWID;
+
 -- Trigger creation scripts for dedup-server database
 
 -- Create a trigger to set transcode_preprocess_scanned_files_changed to 1 on INSERT
@@ -73,9 +118,11 @@ BEGIN
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
 END;
 
--- Create a trigger to set transcode_preprocess_scanned_files_changed to 1 on UPDATE
-CREATE TRIGGER IF NOT EXISTS trg_scanned_files_changed_update
-AFTER UPDATE ON scanned_files
+-- Create a trigger to set transcode_preprocess_scanned_files_changed to 1 on UPDATE of the file's own columns
+DROP TRIGGER IF EXISTS trg_scanned_files_changed_update;
+CREATE TRIGGER trg_scanned_files_changed_update
+AFTER UPDATE OF file_path, relative_path, share_name, file_name, file_extension, media_type, file_metadata,
+    file_mtime, file_created, file_size, file_inode, file_device, is_network_file ON scanned_files
 BEGIN
     INSERT INTO flags(name, value, updated_at) VALUES ('transcode_preprocess_scanned_files_changed', 1, CURRENT_TIMESTAMP)
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
@@ -89,20 +136,166 @@ BEGIN
     ON CONFLICT(name) DO UPDATE SET value = 1, updated_at = CURRENT_TIMESTAMP;
 END;
 
+-- Bump table_versions on every change of a tracked table's content. Claims, leases and
+-- scan generation stamps are bookkeeping and leave the versions alone.
+CREATE TRIGGER IF NOT EXISTS trg_scanned_files_version_insert
+AFTER INSERT ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_scanned_files_version_update;
+CREATE TRIGGER trg_scanned_files_version_update
+AFTER UPDATE OF file_path, relative_path, share_name, file_name, file_extension, media_type, file_metadata,
+    file_mtime, file_created, file_size, file_inode, file_device, is_network_file,
+    links_fast, links_balanced, links_quality ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_scanned_files_version_delete
+AFTER DELETE ON scanned_files
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('scanned_files', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_media_processing_results_version_insert
+AFTER INSERT ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_media_processing_results_version_update;
+CREATE TRIGGER trg_media_processing_results_version_update
+AFTER UPDATE ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_media_processing_results_version_delete
+AFTER DELETE ON media_processing_results
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('media_processing_results', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_cache_map_version_insert
+AFTER INSERT ON cache_map
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_cache_map_version_update;
+CREATE TRIGGER trg_cache_map_version_update
+AFTER UPDATE OF source_file_path, transcoded_file_path, status ON cache_map
+WHEN NEW.status IS NOT 1
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_cache_map_version_delete
+AFTER DELETE ON cache_map
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('cache_map', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_user_inputs_version_insert
+AFTER INSERT ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_user_inputs_version_update;
+CREATE TRIGGER trg_user_inputs_version_update
+AFTER UPDATE ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_user_inputs_version_delete
+AFTER DELETE ON user_inputs
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('user_inputs', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flags_version_insert
+AFTER INSERT ON flags
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+DROP TRIGGER IF EXISTS trg_flags_version_update;
+CREATE TRIGGER trg_flags_version_update
+AFTER UPDATE OF value ON flags
+WHEN OLD.value IS NOT NEW.value
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flags_version_delete
+AFTER DELETE ON flags
+BEGIN
+    INSERT INTO table_versions(table_name, version) VALUES ('flags', 1)
+    ON CONFLICT(table_name) DO UPDATE SET version = version + 1;
+END;
+
 -- Index creation scripts for dedup-server database
 
 -- Create index on cache_map status for faster job selection
 CREATE INDEX IF NOT EXISTS idx_cache_map_status ON cache_map (status, created_at);
 
+-- Jobs not transcoded yet, in claim order
+CREATE INDEX IF NOT EXISTS idx_cache_map_pending ON cache_map (created_at, id)
+    WHERE transcoded_file_path IS NULL;
+
+-- Sources sharing a transcoded file
+CREATE INDEX IF NOT EXISTS idx_cache_map_transcoded ON cache_map (transcoded_file_path)
+    WHERE transcoded_file_path IS NOT NULL;
+
+-- Transcoded files, least recently used first
+CREATE INDEX IF NOT EXISTS idx_cache_objects_lru ON cache_objects (last_access);
+
+-- Transcoded files by source content
+CREATE INDEX IF NOT EXISTS idx_cache_objects_content_key ON cache_objects (content_key)
+    WHERE content_key IS NOT NULL;
+
 -- Create index on scanned_files file_path for faster lookups
 CREATE INDEX IF NOT EXISTS idx_scanned_files_file_path ON scanned_files (file_path);
 
--- Create index on scanned_files processed flags for faster processing queries
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_fast ON scanned_files (processed_fast);
+-- Create partial indexes on scanned_files pending work (processed_X = 0) for O(log n) claims
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_any ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_fast = 0 OR processed_balanced = 0 OR processed_quality = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_fast ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_fast = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_balanced ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_balanced = 0;
+
+CREATE INDEX IF NOT EXISTS idx_scanned_files_pending_quality ON scanned_files (processing_priority DESC, created_at DESC)
+WHERE processed_quality = 0;
+
+-- Create partial index on in-progress scanned_files by lease expiry for lazy reclaim
+CREATE INDEX IF NOT EXISTS idx_scanned_files_in_progress ON scanned_files (lease_until)
+WHERE processed_fast = -1 OR processed_balanced = -1 OR processed_quality = -1;
 
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_balanced ON scanned_files (processed_balanced);
+-- Create indexes on scanned_files file type columns for enabled-type filtering
+CREATE INDEX IF NOT EXISTS idx_scanned_files_file_extension ON scanned_files (file_extension);
 
-CREATE INDEX IF NOT EXISTS idx_scanned_files_processed_quality ON scanned_files (processed_quality);
+CREATE INDEX IF NOT EXISTS idx_scanned_files_media_type ON scanned_files (media_type);
 
 -- Create index on scanned_files created_at for ordering
 CREATE INDEX IF NOT EXISTS idx_scanned_files_created_at ON scanned_files (created_at);
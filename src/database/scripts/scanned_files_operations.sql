@@ -78,7 +78,7 @@ FROM scanned_files
 WHERE
     processed_fast = 0
     AND (?)
-ORDER BY created_at DESC
+ORDER BY processing_priority DESC, created_at DESC
 LIMIT ?;
 
 -- Get files needing processing for BALANCED mode
@@ -88,7 +88,7 @@ FROM scanned_files
 WHERE
     processed_balanced = 0
     AND (?)
-ORDER BY created_at DESC
+ORDER BY processing_priority DESC, created_at DESC
 LIMIT ?;
 
 -- Get files needing processing for QUALITY mode
@@ -98,7 +98,7 @@ FROM scanned_files
 WHERE
     processed_quality = 0
     AND (?)
-ORDER BY created_at DESC
+ORDER BY processing_priority DESC, created_at DESC
 LIMIT ?;
 
 -- =============================================================================
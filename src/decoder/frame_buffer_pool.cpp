@@ -0,0 +1,165 @@
+#include "core/decoder/frame_buffer_pool.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace
+{
+    // Line alignment of scratch frames, enough for the widest SIMD path swscale takes
+    constexpr int SCRATCH_STRIDE_ALIGN = 64;
+
+    // Slack after the last plane for decoders that read a little past the end, and for aligning
+    // the start of the buffer (as libavcodec's own frame pools do)
+    constexpr size_t TAIL_PADDING = 16;
+}
+
+FrameBufferPool &FrameBufferPool::getInstance()
+{
+    static FrameBufferPool instance;
+    return instance;
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    // Frames still holding buffers keep their pool alive until they are freed
+    for (auto &entry : pools_)
+        av_buffer_pool_uninit(&entry.second.pool);
+}
+
+void FrameBufferPool::attach(AVCodecContext *ctx)
+{
+    if (ctx)
+        ctx->get_buffer2 = &FrameBufferPool::decoderGetBuffer;
+}
+
+int FrameBufferPool::getBuffer(AVFrame *frame)
+{
+    if (!frame || frame->width <= 0 || frame->height <= 0)
+        return AVERROR(EINVAL);
+    return allocate(frame, frame->width, frame->height, SCRATCH_STRIDE_ALIGN);
+}
+
+size_t FrameBufferPool::poolCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_.size();
+}
+
+int FrameBufferPool::decoderGetBuffer(AVCodecContext *ctx, AVFrame *frame, int flags)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (ctx->codec_type != AVMEDIA_TYPE_VIDEO || !ctx->codec || !(ctx->codec->capabilities & AV_CODEC_CAP_DR1) ||
+        !desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) || frame->width <= 0 || frame->height <= 0)
+    {
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+
+    // Pad to what the decoder writes into: macroblock-aligned dimensions and SIMD-aligned lines
+    int width = frame->width;
+    int height = frame->height;
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(ctx, &width, &height, linesize_align);
+    int stride_align = *std::max_element(linesize_align, linesize_align + 4);
+
+    if (getInstance().allocate(frame, width, height, std::max(stride_align, 1)) < 0)
+    {
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+    return 0;
+}
+
+int FrameBufferPool::allocate(AVFrame *frame, int width, int height, int stride_align)
+{
+    const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+
+    // Widen until every plane's line size is a multiple of stride_align, like avcodec_default_get_buffer2
+    int linesizes[4] = {0};
+    bool unaligned;
+    do
+    {
+        int ret = av_image_fill_linesizes(linesizes, format, width);
+        if (ret < 0)
+            return ret;
+        unaligned = false;
+        for (int i = 0; i < 4; ++i)
+            unaligned |= linesizes[i] % stride_align != 0;
+        if (unaligned)
+            width += width & ~(width - 1);
+    } while (unaligned);
+
+    ptrdiff_t plane_linesizes[4];
+    for (int i = 0; i < 4; ++i)
+        plane_linesizes[i] = linesizes[i];
+    size_t plane_sizes[4] = {0};
+    int ret = av_image_fill_plane_sizes(plane_sizes, format, height, plane_linesizes);
+    if (ret < 0)
+        return ret;
+
+    size_t image_size = 0;
+    for (size_t plane_size : plane_sizes)
+        image_size += plane_size;
+    const size_t buffer_size = image_size + TAIL_PADDING + stride_align - 1;
+
+    AVBufferRef *buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const PoolKey key(frame->format, width, height);
+        auto it = pools_.find(key);
+        if (it == pools_.end())
+        {
+            if (pools_.size() >= MAX_POOLS)
+                evictLeastRecentlyUsed();
+            AVBufferPool *pool = av_buffer_pool_init(buffer_size, av_buffer_allocz);
+            if (!pool)
+                return AVERROR(ENOMEM);
+            it = pools_.emplace(key, Pool{pool, 0}).first;
+            Logger::debug("Frame buffer pool created for " + std::string(av_get_pix_fmt_name(format)) + " " +
+                          std::to_string(width) + "x" + std::to_string(height) + " (" +
+                          std::to_string(buffer_size / 1024) + " KB buffers)");
+        }
+        it->second.last_used = ++use_counter_;
+        buffer = av_buffer_pool_get(it->second.pool);
+    }
+    if (!buffer)
+        return AVERROR(ENOMEM);
+
+    // All planes live in the one buffer, back to back from an aligned start
+    uint8_t *data = buffer->data;
+    const uintptr_t misalignment = reinterpret_cast<uintptr_t>(data) % stride_align;
+    if (misalignment)
+        data += stride_align - misalignment;
+
+    frame->buf[0] = buffer;
+    for (int i = 0; i < 4; ++i)
+    {
+        frame->data[i] = plane_sizes[i] ? data : nullptr;
+        frame->linesize[i] = linesizes[i];
+        data += plane_sizes[i];
+    }
+    for (int i = 4; i < AV_NUM_DATA_POINTERS; ++i)
+    {
+        frame->data[i] = nullptr;
+        frame->linesize[i] = 0;
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+void FrameBufferPool::evictLeastRecentlyUsed()
+{
+    auto oldest = std::min_element(pools_.begin(), pools_.end(),
+                                   [](const auto &a, const auto &b)
+                                   { return a.second.last_used < b.second.last_used; });
+    if (oldest == pools_.end())
+        return;
+    av_buffer_pool_uninit(&oldest->second.pool);
+    pools_.erase(oldest);
+}
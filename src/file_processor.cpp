@@ -515,13 +515,10 @@ void FileProcessor::clearDecoderCacheIfRequired()
 
     if (cache_clear_required_)
     {
-        Logger::info("FileProcessor: Clearing decoder cache due to dedup mode change");
-
-        // TODO: Implement actual cache clearing logic
-        // This would involve calling TranscodingManager's cache clearing methods
-        // For now, we just log the requirement
-
-        Logger::warn("FileProcessor: Cache clearing required but not yet implemented - transcoded files may need manual cleanup for optimal performance");
+        // DecoderCache entries are keyed by canonical variant rather than by mode, so they stay
+        // valid across the switch and let the new mode fingerprint without re-reading the sources.
+        // Only the fingerprints themselves are stale, and those are stored per mode.
+        Logger::info("FileProcessor: Dedup mode change keeps cached decodes; files are fingerprinted again from the decoder cache where possible");
 
         cache_clear_required_ = false;
     }
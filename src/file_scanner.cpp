@@ -4,7 +4,55 @@
 #include "core/file_utils.hpp"
 #include "core/transcoding_manager.hpp"
 #include "logging/logger.hpp"
+#include "core/mount_manager.hpp"
+#include "core/shutdown_manager.hpp"
 #include "config_observer.hpp"
+#include "poco_config_adapter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace
+{
+    // Changes written per transaction during a diffed scan
+    constexpr size_t SCAN_DIFF_BATCH_SIZE = 1000;
+
+    // Roots that share this key share the underlying storage: the same network server
+    // (several shares of one NAS) or the same local device
+    std::string storageKeyForRoot(const std::string &root)
+    {
+        auto mount = MountManager::getInstance().getMountInfo(root);
+        if (mount && !mount->server_name.empty())
+            return "server:" + mount->server_name;
+
+        struct stat st;
+        if (stat(root.c_str(), &st) == 0)
+            return "dev:" + std::to_string(static_cast<unsigned long long>(st.st_dev));
+        return "path:" + root;
+    }
+
+    // Walker thread count for recursive listings (max_scan_threads, at least 1)
+    size_t configuredScanThreads()
+    {
+        try
+        {
+            int configured = PocoConfigAdapter::getInstance().getMaxScanThreads();
+            if (configured > 0)
+                return static_cast<size_t>(configured);
+        }
+        catch (const std::exception &e)
+        {
+            Logger::warn("Could not read max_scan_threads, using a single scan thread: " + std::string(e.what()));
+        }
+        return 1;
+    }
+}
 
 FileScanner::FileScanner(const std::string &db_path)
     : files_scanned_(0), files_stored_(0), files_skipped_(0)
@@ -23,12 +71,13 @@ size_t FileScanner::scanDirectory(const std::string &dir_path, bool recursive)
     try
     {
         // Subscribe to file stream
-        auto file_stream = FileUtils::listFilesAsObservable(dir_path, recursive);
+        // Stat data is collected by the walker and passed through to storage
+        auto file_stream = FileUtils::listFilesWithMetadataAsObservable(dir_path, recursive, walker_threads_ ? walker_threads_ : configuredScanThreads());
 
         file_stream.subscribe(
-            [this](const std::string &file_path)
+            [this](const FileMetadata &metadata)
             {
-                this->handleFile(file_path);
+                this->handleFile(metadata);
             },
             [this](const std::exception &error)
             {
@@ -49,6 +98,295 @@ size_t FileScanner::scanDirectory(const std::string &dir_path, bool recursive)
     return files_stored_;
 }
 
+size_t FileScanner::scanDirectoryIncremental(const std::string &dir_path, bool full_walk)
+{
+    // Manifest keys are built from the root as given, so keep it free of trailing slashes
+    std::string root = dir_path;
+    while (root.size() > 1 && root.back() == '/')
+        root.pop_back();
+
+    Logger::info("Starting " + std::string(full_walk ? "full" : "incremental") + " directory scan: " + root);
+
+    clearStats();
+
+    if (!FileUtils::isValidDirectory(root))
+    {
+        Logger::error("Scan error: Invalid directory path: " + root);
+        return 0;
+    }
+
+    try
+    {
+        DirectoryManifest previous;
+        if (!full_walk)
+        {
+            previous = db_manager_->getDirectoryManifest(root);
+        }
+
+        // A full walk lists every directory, so it marks every file it finds with a new
+        // generation and sweeps the rest of the root with one DELETE afterwards
+        const int64_t generation = full_walk ? db_manager_->beginScanGeneration() : 0;
+        const bool sweep = generation > 0;
+
+        // Stored state of the whole root in one range query; the walk is diffed against it in
+        // memory and only the differences are written, in batches
+        ScannedFileStats stored = db_manager_->getScannedFileStats(root);
+        const size_t stored_count = stored.size();
+        // Every batch of the scan resolves mounts against the table as it was when the scan began
+        const auto mounts = MountManager::getInstance().snapshot();
+        ScanDiff diff;
+        bool diff_applied = true;
+        auto flushDiff = [&]()
+        {
+            if (diff.empty())
+                return;
+            auto result = db_manager_->applyScanDiff(diff, mounts.get());
+            if (!result.success)
+            {
+                diff_applied = false;
+                Logger::error("Failed to apply scan diff for " + root + ": " + result.error_message);
+            }
+            else
+            {
+                queueRawFiles(diff);
+            }
+            diff.clear();
+        };
+
+        std::vector<DirectoryManifestEntry> current;
+        FileUtils::scanDirectoryIncremental(
+            root,
+            [&](const FileMetadata &metadata)
+            {
+                files_scanned_++;
+                auto it = stored.find(metadata.file_path);
+                if (it != stored.end())
+                {
+                    if (!it->second.matches(metadata))
+                    {
+                        if (it->second.isLegacyOf(metadata))
+                            diff.refreshed.push_back(metadata);
+                        else
+                            diff.changed.push_back(metadata);
+                    }
+                    else if (sweep)
+                    {
+                        diff.seen.push_back(metadata.file_path);
+                    }
+                    stored.erase(it); // Whatever is left afterwards was not seen on disk
+                    files_stored_++;
+                }
+                else if (MediaProcessor::isSupportedFile(metadata.file_path))
+                {
+                    diff.inserted.push_back(metadata);
+                    files_stored_++;
+                }
+                else
+                {
+                    files_skipped_++;
+                }
+
+                if (diff.size() >= SCAN_DIFF_BATCH_SIZE)
+                    flushDiff();
+            },
+            walker_threads_ ? walker_threads_ : configuredScanThreads(),
+            full_walk ? nullptr : &previous, current, thread_budget_);
+
+        // Stored files the walk did not report are gone if their directory was actually listed,
+        // or no longer exists. Directories reused from the manifest were not listed, and ones the
+        // walk could not read have no entry: their files are kept.
+        std::unordered_map<std::string, bool> directory_listed;
+        for (const auto &entry : current)
+            directory_listed[entry.dir_path] = entry.listed;
+        std::unordered_map<std::string, bool> directory_missing;
+        // An empty listing of a root that had files is more likely an unmounted share than a
+        // deleted library: keep everything until a walk finds files again
+        const bool root_empty = files_scanned_ == 0 && stored_count > 0;
+        if (root_empty)
+        {
+            Logger::warn("Scan of " + root + " found no files but " + std::to_string(stored_count) +
+                         " are stored; not removing any");
+            stored.clear();
+        }
+        for (const auto &[path, stat] : stored)
+        {
+            auto slash = path.rfind('/');
+            std::string parent = slash == std::string::npos ? std::string() : path.substr(0, slash);
+
+            bool removed;
+            auto listed = directory_listed.find(parent);
+            if (listed != directory_listed.end())
+            {
+                removed = listed->second;
+            }
+            else
+            {
+                auto missing = directory_missing.find(parent);
+                if (missing == directory_missing.end())
+                {
+                    struct stat st;
+                    bool gone = ::stat(parent.c_str(), &st) != 0 && (errno == ENOENT || errno == ENOTDIR);
+                    missing = directory_missing.emplace(parent, gone).first;
+                }
+                removed = missing->second;
+            }
+
+            // The sweep deletes what was not stamped, so kept files are stamped instead
+            if (sweep && !removed)
+                diff.seen.push_back(path);
+            else if (!sweep && removed)
+                diff.removed.push_back(path);
+            if (diff.size() >= SCAN_DIFF_BATCH_SIZE)
+                flushDiff();
+        }
+        flushDiff();
+
+        if (sweep && diff_applied && !root_empty)
+        {
+            auto sweep_result = db_manager_->sweepScanGeneration(root, generation);
+            if (!sweep_result.success)
+                Logger::error("Failed to sweep removed files under " + root + ": " + sweep_result.error_message);
+        }
+
+        // Skipping a directory next time is only safe if everything found in it was recorded
+        if (!diff_applied)
+        {
+            Logger::warn("Not storing directory manifest for " + root + " because some changes were not written");
+        }
+        else if (!current.empty())
+        {
+            auto manifest_result = db_manager_->replaceDirectoryManifest(root, current);
+            if (!manifest_result.success)
+            {
+                // Next scan simply lists more directories than it needs to
+                Logger::warn("Failed to store directory manifest for " + root + ": " + manifest_result.error_message);
+            }
+        }
+
+        Logger::info("Directory scan completed. Scanned: " + std::to_string(files_scanned_) +
+                     ", Stored: " + std::to_string(files_stored_) +
+                     ", Skipped: " + std::to_string(files_skipped_));
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Error during directory scanning: " + std::string(e.what()));
+    }
+
+    return files_stored_;
+}
+
+MultiRootScanResult FileScanner::scanRoots(const std::string &db_path, const std::vector<std::string> &roots,
+                                           bool full_walk, size_t max_threads, size_t per_mount_limit)
+{
+    MultiRootScanResult result;
+    if (roots.empty())
+        return result;
+
+    max_threads = std::max<size_t>(1, max_threads);
+    per_mount_limit = std::max<size_t>(1, per_mount_limit);
+    const size_t worker_count = std::min(max_threads, roots.size());
+
+    // Every walk may use all max_threads threads, but listings across walks are capped at
+    // max_threads in total: while several roots run they split it, and as roots finish the
+    // ones still walking take over the freed share
+    ScanThreadBudget budget(max_threads);
+
+    // Resolved up front so workers only compare keys
+    std::vector<std::string> storage_keys;
+    storage_keys.reserve(roots.size());
+    for (const auto &root : roots)
+        storage_keys.push_back(storageKeyForRoot(root));
+
+    Logger::info("Scanning " + std::to_string(roots.size()) + " roots with up to " + std::to_string(worker_count) +
+                 " concurrent roots (" + std::to_string(max_threads) + " listing threads shared, " +
+                 std::to_string(per_mount_limit) + " per mount)");
+
+    std::atomic<size_t> total_files_stored{0};
+    std::atomic<size_t> successful_scans{0};
+    std::atomic<size_t> failed_scans{0};
+
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+    std::vector<bool> taken(roots.size(), false);
+    size_t remaining = roots.size();
+    size_t roots_completed = 0;
+    std::map<std::string, size_t> active_per_mount;
+
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            size_t index = roots.size();
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    if (remaining == 0 || ShutdownManager::getInstance().isShutdownRequested())
+                        return;
+
+                    // First untaken root whose storage still has a free slot
+                    for (size_t i = 0; i < roots.size(); ++i)
+                    {
+                        if (!taken[i] && active_per_mount[storage_keys[i]] < per_mount_limit)
+                        {
+                            index = i;
+                            break;
+                        }
+                    }
+                    if (index < roots.size())
+                        break;
+                    slot_freed.wait_for(lock, std::chrono::milliseconds(500));
+                }
+                taken[index] = true;
+                --remaining;
+                ++active_per_mount[storage_keys[index]];
+            }
+
+            const auto &root = roots[index];
+            try
+            {
+                Logger::info("Scanning directory: " + root);
+                FileScanner scanner(db_path);
+                scanner.setWalkerThreads(max_threads);
+                scanner.setThreadBudget(&budget);
+                size_t files_stored = scanner.scanDirectoryIncremental(root, full_walk);
+
+                total_files_stored += files_stored;
+                successful_scans++;
+                Logger::info("Completed scan for " + root + " - Files stored: " + std::to_string(files_stored));
+            }
+            catch (const std::exception &e)
+            {
+                failed_scans++;
+                Logger::error("Error scanning directory " + root + ": " + std::string(e.what()));
+            }
+
+            size_t completed;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --active_per_mount[storage_keys[index]];
+                completed = ++roots_completed;
+            }
+            slot_freed.notify_all();
+            Logger::info("Scan progress: " + std::to_string(completed) + "/" + std::to_string(roots.size()) +
+                         " roots done, " + std::to_string(total_files_stored.load()) + " files stored, " +
+                         std::to_string(failed_scans.load()) + " failed");
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < worker_count; ++i)
+        workers.emplace_back(worker);
+    worker(); // The calling thread takes a share too
+    for (auto &thread : workers)
+        thread.join();
+
+    result.files_stored = total_files_stored.load();
+    result.successful_scans = successful_scans.load();
+    result.failed_scans = failed_scans.load();
+    return result;
+}
+
 bool FileScanner::scanFile(const std::string &file_path)
 {
     Logger::debug("Scanning single file: " + file_path);
@@ -71,8 +409,7 @@ bool FileScanner::scanFile(const std::string &file_path)
         return false;
     }
 
-    // Note: Transcoding decisions are now handled by TranscodingManager through the flag-based system
-    // The transcoding manager will automatically detect and queue RAW files when the scanned_files table changes
+    queueRawFile(file_path);
 
     files_stored_++;
     Logger::debug("Stored supported file during scan: " + file_path);
@@ -86,8 +423,9 @@ void FileScanner::clearStats()
     files_skipped_ = 0;
 }
 
-void FileScanner::handleFile(const std::string &file_path)
+void FileScanner::handleFile(const FileMetadata &metadata)
 {
+    const std::string &file_path = metadata.file_path;
     Logger::debug("Handling file during scan: " + file_path);
 
     files_scanned_++;
@@ -100,17 +438,40 @@ void FileScanner::handleFile(const std::string &file_path)
         return;
     }
 
-    // Store only supported files in the database (skip metadata computation during scanning for performance)
-    DBOpResult scan_result = db_manager_->storeScannedFile(file_path);
+    // Store only supported files in the database, reusing the walker's stat data
+    DBOpResult scan_result = db_manager_->storeScannedFile(metadata);
     if (!scan_result.success)
     {
         Logger::error("Failed to store file in scanned_files: " + file_path + ". DB error: " + scan_result.error_message);
         return;
     }
 
-    // Note: Transcoding decisions are now handled by TranscodingManager through the flag-based system
-    // The transcoding manager will automatically detect and queue RAW files when the scanned_files table changes
+    queueRawFile(file_path);
 
     files_stored_++;
     Logger::debug("Stored supported file during scan: " + file_path);
+}
+
+void FileScanner::queueRawFile(const std::string &file_path)
+{
+    if (TranscodingManager::isRawFile(file_path) && TranscodingManager::getInstance().isTranscodingRunning())
+        TranscodingManager::getInstance().queueForTranscoding(file_path);
+}
+
+void FileScanner::queueRawFiles(const ScanDiff &diff)
+{
+    auto &transcoder = TranscodingManager::getInstance();
+    if (!transcoder.isTranscodingRunning())
+        return;
+
+    std::vector<std::string> raw_files;
+    for (const auto *files : {&diff.inserted, &diff.changed})
+    {
+        for (const auto &metadata : *files)
+        {
+            if (TranscodingManager::isRawFile(metadata.file_path))
+                raw_files.push_back(metadata.file_path);
+        }
+    }
+    transcoder.queueForTranscoding(raw_files);
 }
\ No newline at end of file
@@ -7,29 +7,428 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "core/mount_throttle.hpp"
 
 // macOS native APIs for faster file enumeration
 #ifdef __APPLE__
 #include <CoreFoundation/CoreFoundation.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #endif
 
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#endif
+
 namespace fs = std::filesystem;
 
-SimpleObservable<std::string> FileUtils::listFilesAsObservable(const std::string &dir_path, bool recursive)
+#ifdef __linux__
+namespace
+{
+    /**
+     * @brief Parallel recursive walker: each subdirectory is a task on a small
+     * work-stealing pool, and file entries are handed back to the calling thread in batches
+     *
+     * Workers pop their own newest directory (depth-first, keeps the working set small)
+     * and steal the oldest directory from a peer when idle (breadth, large subtrees).
+     * Entry types come from readdir's d_type (filled by getdents64), so regular files and
+     * directories are classified without a stat; only DT_UNKNOWN and symlinks are stat'ed.
+     * Symlinked directories are not followed, which keeps cyclic links from looping.
+     * With stat_files set, each file is fstatat()'ed relative to its open directory fd and
+     * the result travels with the path, so ingestion never has to stat it again.
+     * With manifest_out set, every directory's mtime and entry count is recorded; when a
+     * previous manifest is also given, directories whose mtime is unchanged are not listed
+     * at all (their files are skipped and their subdirectories come from the manifest).
+     * onNext is always invoked on the calling thread, so observers need no locking.
+     */
+    class ParallelDirectoryWalker
+    {
+    public:
+        ParallelDirectoryWalker(size_t thread_count, size_t batch_size, bool stat_files,
+                                const DirectoryManifest *previous_manifest = nullptr,
+                                std::vector<DirectoryManifestEntry> *manifest_out = nullptr,
+                                ScanThreadBudget *budget = nullptr)
+            : thread_count_(std::max<size_t>(1, thread_count)), batch_size_(std::max<size_t>(1, batch_size)),
+              max_pending_batches_(thread_count_ * 4), stat_files_(stat_files),
+              previous_manifest_(previous_manifest), manifest_out_(manifest_out), budget_(budget)
+        {
+            for (size_t i = 0; i < thread_count_; ++i)
+                queues_.push_back(std::make_unique<WorkerQueue>());
+            worker_manifests_.resize(thread_count_);
+
+            if (previous_manifest_)
+            {
+                for (const auto &[path, entry] : *previous_manifest_)
+                    known_children_[entry.parent_path].push_back(path);
+            }
+        }
+
+        size_t skippedDirectories() const { return skipped_dirs_; }
+
+        void walk(const std::string &root, const std::function<void(const FileMetadata &)> &onNext)
+        {
+            pending_dirs_ = 1;
+            queues_[0]->dirs.push_back(root);
+
+            std::vector<std::thread> workers;
+            workers.reserve(thread_count_);
+            for (size_t i = 0; i < thread_count_; ++i)
+                workers.emplace_back(&ParallelDirectoryWalker::workerLoop, this, i);
+
+            try
+            {
+                drainBatches(onNext);
+            }
+            catch (...)
+            {
+                stop();
+                for (auto &worker : workers)
+                    worker.join();
+                throw;
+            }
+
+            for (auto &worker : workers)
+                worker.join();
+
+            if (manifest_out_)
+            {
+                for (auto &entries : worker_manifests_)
+                {
+                    manifest_out_->insert(manifest_out_->end(), std::make_move_iterator(entries.begin()),
+                                          std::make_move_iterator(entries.end()));
+                }
+            }
+        }
+
+    private:
+        static std::string parentOf(const std::string &path)
+        {
+            size_t pos = path.rfind('/');
+            if (pos == std::string::npos)
+                return "";
+            return pos == 0 ? "/" : path.substr(0, pos);
+        }
+
+        // Returns true when the directory is unchanged since the previous manifest and was handled from it
+        bool reuseUnchangedDirectory(size_t index, const std::string &dir_path, int64_t mtime_ns)
+        {
+            if (!previous_manifest_)
+                return false;
+            auto it = previous_manifest_->find(dir_path);
+            if (it == previous_manifest_->end() || it->second.mtime_ns != mtime_ns)
+                return false;
+
+            // No entries were added, removed or renamed here: skip listing and stat'ing its files
+            auto children = known_children_.find(dir_path);
+            if (children != known_children_.end())
+            {
+                for (const auto &child : children->second)
+                    pushDirectory(index, child);
+            }
+            worker_manifests_[index].push_back(it->second);
+            worker_manifests_[index].back().listed = false;
+            ++skipped_dirs_;
+            return true;
+        }
+
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<std::string> dirs;
+        };
+
+        void drainBatches(const std::function<void(const FileMetadata &)> &onNext)
+        {
+            while (true)
+            {
+                std::vector<FileMetadata> batch;
+                {
+                    std::unique_lock<std::mutex> lock(out_mutex_);
+                    out_cv_.wait(lock, [this]
+                                 { return !batches_.empty() || workers_running_ == 0; });
+                    if (batches_.empty())
+                        return; // all workers finished and everything has been delivered
+                    batch = std::move(batches_.front());
+                    batches_.pop_front();
+                }
+                space_cv_.notify_one();
+
+                for (const auto &entry : batch)
+                    onNext(entry);
+            }
+        }
+
+        void stop()
+        {
+            stopped_ = true;
+            work_cv_.notify_all();
+            std::lock_guard<std::mutex> lock(out_mutex_);
+            space_cv_.notify_all();
+        }
+
+        void workerLoop(size_t index)
+        {
+            std::vector<FileMetadata> batch;
+            batch.reserve(batch_size_);
+            std::string dir;
+
+            while (!stopped_)
+            {
+                if (popLocal(index, dir) || steal(index, dir))
+                {
+                    // Concurrent walks sharing a budget take turns listing
+                    if (budget_)
+                        budget_->acquire();
+                    scanDirectory(index, dir, batch);
+                    if (budget_)
+                        budget_->release();
+                    if (--pending_dirs_ == 0)
+                    {
+                        std::lock_guard<std::mutex> lock(work_mutex_);
+                        work_cv_.notify_all();
+                    }
+                    continue;
+                }
+
+                if (pending_dirs_ == 0)
+                    break;
+
+                // Nothing to steal right now; another worker is still listing a directory
+                std::unique_lock<std::mutex> lock(work_mutex_);
+                work_cv_.wait_for(lock, std::chrono::milliseconds(5));
+            }
+
+            publishBatch(batch);
+
+            std::lock_guard<std::mutex> lock(out_mutex_);
+            if (--workers_running_ == 0)
+                out_cv_.notify_all();
+        }
+
+        bool popLocal(size_t index, std::string &dir)
+        {
+            auto &queue = *queues_[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.dirs.empty())
+                return false;
+            dir = std::move(queue.dirs.back());
+            queue.dirs.pop_back();
+            return true;
+        }
+
+        bool steal(size_t thief, std::string &dir)
+        {
+            for (size_t offset = 1; offset < thread_count_; ++offset)
+            {
+                auto &queue = *queues_[(thief + offset) % thread_count_];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.dirs.empty())
+                {
+                    dir = std::move(queue.dirs.front());
+                    queue.dirs.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void pushDirectory(size_t index, std::string dir)
+        {
+            ++pending_dirs_;
+            {
+                auto &queue = *queues_[index];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.dirs.push_back(std::move(dir));
+            }
+            work_cv_.notify_one();
+        }
+
+        void publishBatch(std::vector<FileMetadata> &batch)
+        {
+            if (batch.empty())
+                return;
+            {
+                // Bounded hand-off so a slow consumer applies back-pressure to the walk
+                std::unique_lock<std::mutex> lock(out_mutex_);
+                space_cv_.wait(lock, [this]
+                               { return batches_.size() < max_pending_batches_ || stopped_; });
+                if (stopped_)
+                {
+                    batch.clear();
+                    return;
+                }
+                batches_.push_back(std::move(batch));
+            }
+            out_cv_.notify_one();
+            batch = std::vector<FileMetadata>();
+            batch.reserve(batch_size_);
+        }
+
+        void scanDirectory(size_t index, const std::string &dir_path, std::vector<FileMetadata> &batch)
+        {
+            // Listing a directory on a network share takes one of that mount's I/O slots. An
+            // unavailable mount leaves the directory without a manifest entry, like an unreadable one.
+            auto permit = MountThrottle::getInstance().acquire(dir_path);
+            if (!permit)
+            {
+                Logger::warn("Skipping directory on unavailable mount: " + dir_path);
+                return;
+            }
+            auto fail = [&](int error)
+            {
+                permit.complete(!MountThrottle::isMountError(error));
+                Logger::warn("Error accessing directory " + dir_path + ": " + std::strerror(error));
+            };
+
+            int64_t mtime_ns = 0;
+            if (manifest_out_)
+            {
+                // Stat before listing so a change during the listing shows up as a new mtime next time
+                struct stat dir_st;
+                if (::stat(dir_path.c_str(), &dir_st) != 0)
+                {
+                    fail(errno);
+                    return;
+                }
+                mtime_ns = static_cast<int64_t>(dir_st.st_mtim.tv_sec) * 1000000000LL + dir_st.st_mtim.tv_nsec;
+                if (reuseUnchangedDirectory(index, dir_path, mtime_ns))
+                    return;
+            }
+
+            int fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                fail(errno);
+                return;
+            }
+            DIR *dir = ::fdopendir(fd);
+            if (!dir)
+            {
+                fail(errno);
+                ::close(fd);
+                return;
+            }
+
+            const std::string prefix = (!dir_path.empty() && dir_path.back() == '/') ? dir_path : dir_path + "/";
+            int read_errno = 0;
+            while (!stopped_)
+            {
+                errno = 0;
+                struct dirent *entry = ::readdir(dir);
+                if (!entry)
+                {
+                    read_errno = errno;
+                    break;
+                }
+                const char *name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                    continue;
+
+                unsigned char type = entry->d_type;
+                struct stat st;
+                bool have_stat = false;
+                if (type == DT_UNKNOWN || type == DT_LNK)
+                {
+                    // Filesystem did not report a type (or it is a link): resolve it relative to the open dir
+                    if (::fstatat(fd, name, &st, 0) != 0)
+                    {
+                        Logger::warn("Skipping entry due to stat error: " + prefix + name + " - " + std::strerror(errno));
+                        continue;
+                    }
+                    have_stat = true;
+                    if (S_ISREG(st.st_mode))
+                        type = DT_REG;
+                    else if (S_ISDIR(st.st_mode) && entry->d_type == DT_UNKNOWN)
+                        type = DT_DIR;
+                    else
+                        continue;
+                }
+
+                if (type == DT_REG)
+                {
+                    if (stat_files_ && !have_stat && ::fstatat(fd, name, &st, 0) != 0)
+                    {
+                        // Vanished between readdir and stat
+                        continue;
+                    }
+                    if (stat_files_)
+                        batch.push_back(FileUtils::metadataFromStat(prefix + name, st));
+                    else
+                    {
+                        FileMetadata path_only{};
+                        path_only.file_path = prefix + name;
+                        batch.push_back(std::move(path_only));
+                    }
+                    if (batch.size() >= batch_size_)
+                        publishBatch(batch);
+                }
+                else if (type == DT_DIR)
+                {
+                    pushDirectory(index, prefix + name);
+                }
+            }
+            ::closedir(dir);
+            permit.complete(!MountThrottle::isMountError(read_errno));
+
+            // A listing cut short must not look complete: no entry means it is listed again next time
+            if (read_errno != 0)
+                Logger::warn("Error reading directory " + dir_path + ": " + std::strerror(read_errno));
+            else if (manifest_out_ && !stopped_)
+                worker_manifests_[index].push_back(DirectoryManifestEntry{dir_path, parentOf(dir_path), mtime_ns});
+        }
+
+        const size_t thread_count_;
+        const size_t batch_size_;
+        const size_t max_pending_batches_;
+        const bool stat_files_;
+        const DirectoryManifest *previous_manifest_;
+        std::vector<DirectoryManifestEntry> *manifest_out_;
+        ScanThreadBudget *budget_;
+        std::unordered_map<std::string, std::vector<std::string>> known_children_; // parent -> subdirectories, from previous_manifest_
+        std::vector<std::vector<DirectoryManifestEntry>> worker_manifests_;         // one per worker, merged after the walk
+        std::atomic<size_t> skipped_dirs_{0};
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues_;
+        std::atomic<size_t> pending_dirs_{0}; // directories queued or being listed
+        std::atomic<bool> stopped_{false};
+        std::mutex work_mutex_;
+        std::condition_variable work_cv_;
+
+        std::mutex out_mutex_;
+        std::condition_variable out_cv_;
+        std::condition_variable space_cv_;
+        std::deque<std::vector<FileMetadata>> batches_;
+        size_t workers_running_ = thread_count_;
+    };
+} // namespace
+#endif
+
+SimpleObservable<std::string> FileUtils::listFilesAsObservable(const std::string &dir_path, bool recursive, size_t max_threads)
 {
-    return listFilesInternal(dir_path, recursive);
+    return listFilesInternal(dir_path, recursive, max_threads);
 }
 
-SimpleObservable<std::string> FileUtils::listFilesInternal(const std::string &dir_path, bool recursive)
+SimpleObservable<std::string> FileUtils::listFilesInternal(const std::string &dir_path, bool recursive, size_t max_threads)
 {
     using Observer = std::function<void(const std::string &)>;
     using ErrorHandler = std::function<void(const std::exception &)>;
     using CompleteHandler = std::function<void()>;
     return SimpleObservable<std::string>(
         std::function<void(Observer, ErrorHandler, CompleteHandler)>(
-            [dir_path, recursive](Observer onNext, ErrorHandler onError, CompleteHandler onComplete)
+            [dir_path, recursive, max_threads](Observer onNext, ErrorHandler onError, CompleteHandler onComplete)
             {
                 try
                 {
@@ -47,7 +446,7 @@ SimpleObservable<std::string> FileUtils::listFilesInternal(const std::string &di
                     if (recursive)
                     {
                         // Custom recursive directory iteration with error handling
-                        scanDirectoryRecursively(dir_path, onNext);
+                        scanDirectoryRecursively(dir_path, onNext, max_threads);
                     }
                     else
                     {
@@ -125,8 +524,16 @@ bool FileUtils::isValidDirectory(const std::string &path)
 
 void FileUtils::scanDirectoryRecursively(const std::string &dir_path,
                                          std::function<void(const std::string &)> onNext)
+{
+    scanDirectoryRecursively(dir_path, onNext, 1);
+}
+
+void FileUtils::scanDirectoryRecursively(const std::string &dir_path,
+                                         std::function<void(const std::string &)> onNext,
+                                         size_t max_threads)
 {
 #ifdef __APPLE__
+    (void)max_threads;
     // Use C-based directory enumeration for faster performance
     DIR *dir = opendir(dir_path.c_str());
     if (!dir)
@@ -162,8 +569,13 @@ void FileUtils::scanDirectoryRecursively(const std::string &dir_path,
         }
     }
     closedir(dir);
+#elif defined(__linux__)
+    ParallelDirectoryWalker walker(max_threads, 256, false);
+    walker.walk(dir_path, [&onNext](const FileMetadata &entry)
+                { onNext(entry.file_path); });
 #else
-    // Fallback to std::filesystem for non-macOS platforms
+    (void)max_threads;
+    // Fallback to std::filesystem for other platforms
     std::function<void(const fs::path &)> scanDirectory = [&](const fs::path &current_path)
     {
         try
@@ -206,6 +618,101 @@ void FileUtils::scanDirectoryRecursively(const std::string &dir_path,
 #endif
 }
 
+void FileUtils::scanDirectoryWithMetadata(const std::string &dir_path,
+                                          std::function<void(const FileMetadata &)> onNext,
+                                          size_t max_threads)
+{
+#ifdef __linux__
+    ParallelDirectoryWalker walker(max_threads, 256, true);
+    walker.walk(dir_path, onNext);
+#else
+    scanDirectoryRecursively(dir_path, [&onNext](const std::string &file_path)
+                             {
+        auto metadata = getFileMetadata(file_path);
+        if (metadata)
+            onNext(*metadata); }, max_threads);
+#endif
+}
+
+void FileUtils::scanDirectoryIncremental(const std::string &dir_path,
+                                         std::function<void(const FileMetadata &)> onNext,
+                                         size_t max_threads,
+                                         const DirectoryManifest *previous_manifest,
+                                         std::vector<DirectoryManifestEntry> &manifest_out,
+                                         ScanThreadBudget *budget)
+{
+#ifdef __linux__
+    // Keys in the manifest are built from the root as given; strip a trailing slash so they stay stable
+    std::string root = dir_path;
+    while (root.size() > 1 && root.back() == '/')
+        root.pop_back();
+
+    ParallelDirectoryWalker walker(max_threads, 256, true, previous_manifest, &manifest_out, budget);
+    walker.walk(root, onNext);
+    if (previous_manifest)
+    {
+        Logger::info("Incremental walk of " + root + " skipped " + std::to_string(walker.skippedDirectories()) +
+                     " of " + std::to_string(manifest_out.size()) + " unchanged directories");
+    }
+#else
+    // No manifest support here: always walk everything and leave manifest_out empty
+    (void)previous_manifest;
+    (void)manifest_out;
+    (void)budget;
+    scanDirectoryWithMetadata(dir_path, onNext, max_threads);
+#endif
+}
+
+SimpleObservable<FileMetadata> FileUtils::listFilesWithMetadataAsObservable(const std::string &dir_path, bool recursive, size_t max_threads)
+{
+    using Observer = std::function<void(const FileMetadata &)>;
+    using ErrorHandler = std::function<void(const std::exception &)>;
+    using CompleteHandler = std::function<void()>;
+    return SimpleObservable<FileMetadata>(
+        std::function<void(Observer, ErrorHandler, CompleteHandler)>(
+            [dir_path, recursive, max_threads](Observer onNext, ErrorHandler onError, CompleteHandler onComplete)
+            {
+                if (!recursive)
+                {
+                    // Flat listings are small; stat each entry as it is emitted
+                    listFilesInternal(dir_path, false).subscribe([&onNext](const std::string &file_path)
+                                                                 {
+                        auto metadata = getFileMetadata(file_path);
+                        if (metadata)
+                            onNext(*metadata); }, onError, onComplete);
+                    return;
+                }
+
+                try
+                {
+                    if (!isValidDirectory(dir_path))
+                    {
+                        std::string msg = "Invalid directory path: " + dir_path;
+                        Logger::warn(msg);
+                        if (onError)
+                        {
+                            onError(std::runtime_error(msg));
+                        }
+                        return;
+                    }
+                    scanDirectoryWithMetadata(dir_path, onNext, max_threads);
+                    if (onComplete)
+                    {
+                        onComplete();
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    std::string msg = "Error listing files in directory: " + dir_path + ": " + e.what();
+                    Logger::warn(msg);
+                    if (onError)
+                    {
+                        onError(std::runtime_error(msg));
+                    }
+                }
+            }));
+}
+
 std::string FileUtils::computeFileHash(const std::string &file_path)
 {
     Logger::debug("Reading entire file for hash computation: " + file_path);
@@ -236,6 +743,89 @@ std::string FileUtils::computeFileHash(const std::string &file_path)
     return ss.str();
 }
 
+std::string FileUtils::computeBufferHash(const unsigned char *data, size_t size)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256_CTX sha256;
+    if (SHA256_Init(&sha256) != 1 || SHA256_Update(&sha256, data, size) != 1 || SHA256_Final(hash, &sha256) != 1)
+        return "";
+    std::stringstream ss;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    return ss.str();
+}
+
+std::string FileUtils::computeStreamHash(const std::function<bool(const std::function<void(const unsigned char *, size_t)> &)> &produce)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256_CTX sha256;
+    if (SHA256_Init(&sha256) != 1)
+        return "";
+    bool updated = true;
+    const bool produced = produce([&](const unsigned char *data, size_t size)
+                                  { updated = updated && SHA256_Update(&sha256, data, size) == 1; });
+    if (!produced || !updated || SHA256_Final(hash, &sha256) != 1)
+        return "";
+    std::stringstream ss;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    return ss.str();
+}
+
+std::string FileUtils::computeSampledFileHash(const std::string &file_path)
+{
+    // Start, end and three points between; smaller files are hashed whole
+    constexpr size_t block_size = 64 * 1024;
+    constexpr size_t block_count = 5;
+
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return "";
+    std::streamoff end = file.tellg();
+    if (end < 0)
+        return "";
+    const uint64_t file_size = static_cast<uint64_t>(end);
+
+    SHA256_CTX sha256;
+    if (SHA256_Init(&sha256) != 1)
+        return "";
+    std::vector<char> buffer(block_size);
+    auto hashRange = [&](uint64_t offset, size_t length)
+    {
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(buffer.data(), static_cast<std::streamsize>(length));
+        return file.gcount() == static_cast<std::streamsize>(length) &&
+               SHA256_Update(&sha256, buffer.data(), length) == 1;
+    };
+
+    if (file_size <= block_size * block_count)
+    {
+        for (uint64_t offset = 0; offset < file_size; offset += block_size)
+        {
+            if (!hashRange(offset, static_cast<size_t>(std::min<uint64_t>(block_size, file_size - offset))))
+                return "";
+        }
+    }
+    else
+    {
+        const uint64_t last = file_size - block_size;
+        for (size_t i = 0; i < block_count; ++i)
+        {
+            if (!hashRange(last * i / (block_count - 1), block_size))
+                return "";
+        }
+    }
+
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    if (SHA256_Final(hash, &sha256) != 1)
+        return "";
+    std::stringstream ss;
+    ss << file_size << "-";
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    return ss.str();
+}
+
 // FileMetadata implementation
 bool FileMetadata::operator==(const FileMetadata &other) const
 {
@@ -264,26 +854,51 @@ std::string FileMetadata::toString() const
     return ss.str();
 }
 
-std::optional<FileMetadata> FileUtils::getFileMetadata(const std::string &file_path)
+#if defined(__APPLE__) || defined(__linux__)
+FileMetadata FileUtils::metadataFromStat(const std::string &file_path, const struct stat &st)
 {
-#ifdef __APPLE__
-    struct stat st;
-    if (stat(file_path.c_str(), &st) != 0)
-    {
-        return std::nullopt;
-    }
-
     FileMetadata metadata;
     metadata.file_path = file_path;
     metadata.modification_time = st.st_mtime;
+#ifdef __APPLE__
     metadata.creation_time = st.st_birthtime; // macOS specific
+#else
+    metadata.creation_time = st.st_mtime; // st_ctime is inode change time on Linux, not creation
+#endif
     metadata.file_size = static_cast<uint64_t>(st.st_size);
-    metadata.inode = static_cast<uint32_t>(st.st_ino);
-    metadata.device_id = static_cast<uint32_t>(st.st_dev);
-
+    metadata.inode = static_cast<uint64_t>(st.st_ino);
+    metadata.device_id = static_cast<uint64_t>(st.st_dev);
     return metadata;
+}
+#endif
+
+bool FileUtils::isLegacyMetadataOf(int64_t legacy_mtime, uint64_t legacy_size, uint64_t legacy_inode,
+                                   uint64_t legacy_device_id, const FileMetadata &current)
+{
+    if (legacy_inode != 0 || legacy_device_id != 0 || current.inode == 0 || legacy_size != current.file_size)
+        return false;
+
+    // file_time_type ticks to Unix seconds, through the offset between the two clocks
+    using namespace std::chrono;
+    const int64_t clock_offset = duration_cast<seconds>(system_clock::now().time_since_epoch()).count() -
+                                 duration_cast<seconds>(fs::file_time_type::clock::now().time_since_epoch()).count();
+    const int64_t legacy_seconds = duration_cast<seconds>(fs::file_time_type::duration(legacy_mtime)).count();
+    const int64_t drift = legacy_seconds + clock_offset - static_cast<int64_t>(current.modification_time);
+    return drift >= -1 && drift <= 1;
+}
+
+std::optional<FileMetadata> FileUtils::getFileMetadata(const std::string &file_path)
+{
+#if defined(__APPLE__) || defined(__linux__)
+    // One stat call; the recursive walker uses fstatat against the directory fd instead
+    struct stat st;
+    if (::fstatat(AT_FDCWD, file_path.c_str(), &st, 0) != 0 || !S_ISREG(st.st_mode))
+    {
+        return std::nullopt;
+    }
+    return metadataFromStat(file_path, st);
 #else
-    // For non-macOS systems, use std::filesystem
+    // Other platforms: std::filesystem
     try
     {
         fs::path path(file_path);
@@ -295,7 +910,7 @@ std::optional<FileMetadata> FileUtils::getFileMetadata(const std::string &file_p
         FileMetadata metadata;
         metadata.file_path = file_path;
         metadata.modification_time = fs::last_write_time(path).time_since_epoch().count();
-        metadata.creation_time = metadata.modification_time; // Fallback for non-macOS
+        metadata.creation_time = metadata.modification_time; // Fallback
         metadata.file_size = fs::file_size(path);
         metadata.inode = 0;     // Not easily available on all systems
         metadata.device_id = 0; // Not easily available on all systems
@@ -360,12 +975,12 @@ std::optional<FileMetadata> FileUtils::metadataFromString(const std::string &met
         // Parse inode
         if (!std::getline(ss, token, '|'))
             return std::nullopt;
-        metadata.inode = std::stoul(token);
+        metadata.inode = std::stoull(token);
 
         // Parse device_id
         if (!std::getline(ss, token, '|'))
             return std::nullopt;
-        metadata.device_id = std::stoul(token);
+        metadata.device_id = std::stoull(token);
 
         return metadata;
     }
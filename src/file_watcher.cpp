@@ -0,0 +1,453 @@
+#include "core/file_watcher.hpp"
+#include "core/file_scanner.hpp"
+#include "core/mount_manager.hpp"
+#include "core/shutdown_manager.hpp"
+#include "database/database_manager.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Beyond this many distinct paths waiting for their debounce window (a bulk copy or
+    // `rm -rf` of a large tree), fall back to one rescan per root instead of per-path work
+    constexpr size_t MAX_PENDING_PATHS = 100000;
+
+    std::string normalizeRoot(const std::string &root)
+    {
+        std::string normalized = root;
+        while (normalized.size() > 1 && normalized.back() == '/')
+            normalized.pop_back();
+        return normalized;
+    }
+}
+
+FileWatcher &FileWatcher::getInstance()
+{
+    static FileWatcher instance;
+    return instance;
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+bool FileWatcher::start(const std::string &db_path, const std::vector<std::string> &roots, int debounce_ms)
+{
+#ifdef __linux__
+    if (running_.load())
+    {
+        Logger::warn("FileWatcher is already running");
+        return true;
+    }
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0)
+    {
+        Logger::error("FileWatcher: inotify_init1 failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0)
+    {
+        Logger::error("FileWatcher: eventfd failed: " + std::string(strerror(errno)));
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    scanner_ = std::make_unique<FileScanner>(db_path);
+    debounce_ = std::chrono::milliseconds(std::max(debounce_ms, 0));
+    running_.store(true);
+
+    for (const auto &root : roots)
+        addRoot(root);
+
+    watch_thread_ = std::thread(&FileWatcher::watchLoop, this);
+    Logger::info("FileWatcher started with debounce of " + std::to_string(debounce_.count()) + "ms");
+    return true;
+#else
+    (void)db_path;
+    (void)roots;
+    (void)debounce_ms;
+    Logger::info("FileWatcher: live change feed is only available on Linux; relying on interval scans");
+    return false;
+#endif
+}
+
+void FileWatcher::stop()
+{
+    if (!running_.exchange(false))
+        return;
+
+#ifdef __linux__
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0)
+        Logger::warn("FileWatcher: failed to wake watch thread: " + std::string(strerror(errno)));
+#endif
+
+    if (watch_thread_.joinable())
+        watch_thread_.join();
+
+    // Pending paths are dropped; the next interval scan picks them up
+    if (inotify_fd_ >= 0)
+        close(inotify_fd_);
+    if (wake_fd_ >= 0)
+        close(wake_fd_);
+    inotify_fd_ = -1;
+    wake_fd_ = -1;
+
+    wd_to_dir_.clear();
+    dir_to_wd_.clear();
+    pending_.clear();
+    overflowed_ = false;
+    watch_limit_hit_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(roots_mutex_);
+        pending_roots_.clear();
+        watched_roots_.clear();
+    }
+    scanner_.reset();
+    Logger::info("FileWatcher stopped");
+}
+
+void FileWatcher::addRoot(const std::string &root)
+{
+    if (!running_.load())
+        return;
+
+    std::string normalized = normalizeRoot(root);
+    if (MountManager::getInstance().isNetworkPath(normalized))
+    {
+        Logger::info("FileWatcher: not watching network path " + normalized + "; interval scans cover it");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(roots_mutex_);
+        if (watched_roots_.count(normalized))
+            return;
+        pending_roots_.push_back(normalized);
+    }
+
+#ifdef __linux__
+    uint64_t one = 1;
+    if (wake_fd_ >= 0 && write(wake_fd_, &one, sizeof(one)) < 0)
+        Logger::warn("FileWatcher: failed to wake watch thread: " + std::string(strerror(errno)));
+#endif
+}
+
+bool FileWatcher::isWatching(const std::string &root) const
+{
+    if (!running_.load() || watch_limit_hit_.load())
+        return false;
+    std::lock_guard<std::mutex> lock(roots_mutex_);
+    return watched_roots_.count(normalizeRoot(root)) > 0;
+}
+
+#ifdef __linux__
+
+void FileWatcher::watchLoop()
+{
+    Logger::info("FileWatcher thread started");
+
+    while (running_.load() && !ShutdownManager::getInstance().isShutdownRequested())
+    {
+        attachPendingRoots();
+
+        // Sleep until the next debounce deadline; the 1s cap keeps shutdown checks responsive
+        auto now = std::chrono::steady_clock::now();
+        auto next = now + std::chrono::seconds(1);
+        for (const auto &[path, deadline] : pending_)
+            next = std::min(next, deadline);
+        if (overflowed_)
+            next = std::min(next, overflow_deadline_);
+        int timeout_ms = static_cast<int>(std::max<int64_t>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count()));
+
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        int rc = poll(fds, 2, timeout_ms);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            Logger::error("FileWatcher: poll failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t value;
+            while (read(wake_fd_, &value, sizeof(value)) > 0)
+            {
+            }
+        }
+        if (!running_.load())
+            break;
+
+        if (fds[0].revents & POLLIN)
+            readEvents();
+
+        if (overflowed_ && std::chrono::steady_clock::now() >= overflow_deadline_)
+            rescanAfterOverflow();
+        flushDue();
+    }
+
+    Logger::info("FileWatcher thread stopped");
+}
+
+void FileWatcher::attachPendingRoots()
+{
+    std::vector<std::string> roots;
+    {
+        std::lock_guard<std::mutex> lock(roots_mutex_);
+        roots.swap(pending_roots_);
+    }
+
+    for (const auto &root : roots)
+    {
+        if (!addWatchTree(root))
+        {
+            Logger::warn("FileWatcher: could not watch " + root + "; interval scans cover it");
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(roots_mutex_);
+        watched_roots_.insert(root);
+        Logger::info("FileWatcher: watching " + root + " (" + std::to_string(wd_to_dir_.size()) + " directories total)");
+    }
+}
+
+bool FileWatcher::addWatchTree(const std::string &dir_path)
+{
+    constexpr uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                              IN_EXCL_UNLINK | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+    std::vector<std::string> stack{dir_path};
+    bool root_watched = false;
+    while (!stack.empty())
+    {
+        std::string dir = std::move(stack.back());
+        stack.pop_back();
+
+        int wd = inotify_add_watch(inotify_fd_, dir.c_str(), mask);
+        if (wd < 0)
+        {
+            if (errno == ENOSPC)
+            {
+                // Part of the tree is blind from now on, so interval scans must keep covering it
+                Logger::warn("FileWatcher: inotify watch limit reached at " + dir +
+                             "; raise fs.inotify.max_user_watches to watch the whole tree");
+                watch_limit_hit_.store(true);
+                return false;
+            }
+            continue; // Vanished or unreadable; the parent's events or the next scan cover it
+        }
+        root_watched = root_watched || dir == dir_path;
+
+        // A renamed directory keeps its watch descriptor; point it at the new path
+        auto existing = wd_to_dir_.find(wd);
+        if (existing != wd_to_dir_.end() && existing->second != dir)
+            dir_to_wd_.erase(existing->second);
+        wd_to_dir_[wd] = dir;
+        dir_to_wd_[dir] = wd;
+
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->is_directory(ec) && !it->is_symlink(ec))
+                stack.push_back(it->path().string());
+        }
+    }
+    return root_watched;
+}
+
+void FileWatcher::removeWatchTree(const std::string &dir_path)
+{
+    // dir_path itself plus everything in [dir_path + "/", dir_path + "0"), '0' being the character after '/'
+    std::vector<std::string> doomed;
+    if (dir_to_wd_.count(dir_path))
+        doomed.push_back(dir_path);
+    for (auto it = dir_to_wd_.lower_bound(dir_path + "/"); it != dir_to_wd_.end() && it->first < dir_path + "0"; ++it)
+        doomed.push_back(it->first);
+
+    for (const auto &dir : doomed)
+    {
+        int wd = dir_to_wd_[dir];
+        inotify_rm_watch(inotify_fd_, wd);
+        wd_to_dir_.erase(wd);
+        dir_to_wd_.erase(dir);
+    }
+}
+
+void FileWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buffer[64 * 1024];
+
+    while (true)
+    {
+        ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN: queue drained
+
+        for (char *ptr = buffer; ptr < buffer + length;)
+        {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                Logger::warn("FileWatcher: inotify queue overflowed; scheduling rescan of watched roots");
+                overflowed_ = true;
+                overflow_deadline_ = std::chrono::steady_clock::now() + debounce_;
+                continue;
+            }
+
+            auto dir = wd_to_dir_.find(event->wd);
+            if (event->mask & IN_IGNORED)
+            {
+                // Watch gone (directory deleted or unmounted)
+                if (dir != wd_to_dir_.end())
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(roots_mutex_);
+                        if (watched_roots_.erase(dir->second))
+                            Logger::warn("FileWatcher: scan root " + dir->second + " is no longer watched");
+                    }
+                    dir_to_wd_.erase(dir->second);
+                    wd_to_dir_.erase(dir);
+                }
+                continue;
+            }
+            if (dir == wd_to_dir_.end() || event->len == 0)
+                continue;
+
+            std::string path = dir->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    addWatchTree(path);
+                else if (event->mask & IN_MOVED_FROM)
+                    removeWatchTree(path);
+            }
+            else if ((event->mask & (IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) == 0)
+            {
+                // Plain file creation: wait for IN_CLOSE_WRITE so half-written files are not fingerprinted
+                continue;
+            }
+
+            markPending(path);
+        }
+    }
+}
+
+void FileWatcher::markPending(const std::string &path)
+{
+    if (overflowed_)
+        return; // The rescan covers it
+
+    pending_[path] = std::chrono::steady_clock::now() + debounce_;
+    if (pending_.size() > MAX_PENDING_PATHS)
+    {
+        Logger::warn("FileWatcher: more than " + std::to_string(MAX_PENDING_PATHS) +
+                     " pending paths; scheduling rescan of watched roots");
+        pending_.clear();
+        overflowed_ = true;
+        overflow_deadline_ = std::chrono::steady_clock::now() + debounce_;
+    }
+}
+
+void FileWatcher::flushDue()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::string> due;
+    for (auto it = pending_.begin(); it != pending_.end();)
+    {
+        if (it->second <= now)
+        {
+            due.push_back(it->first);
+            it = pending_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    // Parents before children, so a moved-in directory is scanned once before its files
+    std::sort(due.begin(), due.end());
+
+    auto &db_manager = DatabaseManager::getInstance();
+    for (const auto &path : due)
+    {
+        if (!running_.load() || ShutdownManager::getInstance().isShutdownRequested())
+            return;
+
+        // The event only says something happened; the file system says what is there now
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0)
+        {
+            if (errno == ENOENT || errno == ENOTDIR)
+            {
+                auto result = db_manager.removeScannedPath(path);
+                if (!result.success)
+                    Logger::error("FileWatcher: failed to remove " + path + ": " + result.error_message);
+            }
+        }
+        else if (S_ISDIR(st.st_mode))
+        {
+            // Files may have landed before the directory's watch was added
+            scanner_->scanDirectory(path, true);
+        }
+        else if (S_ISREG(st.st_mode))
+        {
+            scanner_->scanFile(path);
+        }
+    }
+}
+
+void FileWatcher::rescanAfterOverflow()
+{
+    overflowed_ = false;
+
+    std::vector<std::string> roots;
+    {
+        std::lock_guard<std::mutex> lock(roots_mutex_);
+        roots.assign(watched_roots_.begin(), watched_roots_.end());
+    }
+
+    for (const auto &root : roots)
+    {
+        if (!running_.load() || ShutdownManager::getInstance().isShutdownRequested())
+            return;
+
+        // Directories created while events were being dropped need watches too
+        addWatchTree(root);
+        Logger::info("FileWatcher: rescanning " + root + " after lost events");
+        scanner_->scanDirectoryIncremental(root, false);
+    }
+}
+
+#else
+
+void FileWatcher::watchLoop() {}
+void FileWatcher::attachPendingRoots() {}
+bool FileWatcher::addWatchTree(const std::string &) { return false; }
+void FileWatcher::removeWatchTree(const std::string &) {}
+void FileWatcher::readEvents() {}
+void FileWatcher::markPending(const std::string &) {}
+void FileWatcher::flushDue() {}
+void FileWatcher::rescanAfterOverflow() {}
+
+#endif
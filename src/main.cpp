@@ -4,6 +4,7 @@
 // #include "core/scan_thread_pool_manager.hpp"  // Removed - no longer needed
 #include "core/database_connection_pool.hpp"
 #include "core/file_scanner.hpp"
+#include "core/file_watcher.hpp"
 #include "core/transcoding_manager.hpp"
 #include "core/decoder/media_decoder.hpp"
 #include "web/route_handlers.hpp"
@@ -18,6 +19,11 @@
 #include "core/status.hpp"
 #include "core/singleton_manager.hpp"
 #include "core/duplicate_linker.hpp"
+#include "core/mount_throttle.hpp"
+#include "core/memory_admission.hpp"
+#include "core/cache/decoder_cache.hpp"
+#include "core/cache/thumbnail_store.hpp"
+#include "core/memory_pool.hpp"
 #include "core/resource_monitor.hpp"
 #include "core/crash_recovery.hpp"
 #include "core/logger_observer.hpp"
@@ -27,6 +33,7 @@
 #include "core/database_config_observer.hpp"
 #include "core/file_type_config_observer.hpp"
 #include "core/video_processing_config_observer.hpp"
+#include "core/network_mount_config_observer.hpp"
 #include "core/cache_config_observer.hpp"
 #include "core/processing_config_observer.hpp"
 #include "core/dedup_mode_config_observer.hpp"
@@ -36,6 +43,7 @@
 #include <memory>
 #include <signal.h>
 #include <atomic>
+#include <algorithm>
 // TBB includes removed - no longer needed for continuous processing
 #include "core/shutdown_manager.hpp"
 
@@ -123,6 +131,7 @@ int main(int argc, char *argv[])
     auto database_config_observer = std::make_unique<DatabaseConfigObserver>();
     auto file_type_config_observer = std::make_unique<FileTypeConfigObserver>();
     auto video_processing_config_observer = std::make_unique<VideoProcessingConfigObserver>();
+    auto network_mount_config_observer = std::make_unique<NetworkMountConfigObserver>();
     auto cache_config_observer = std::make_unique<CacheConfigObserver>();
     auto processing_config_observer = std::make_unique<ProcessingConfigObserver>();
     auto dedup_mode_config_observer = std::make_unique<DedupModeConfigObserver>();
@@ -135,10 +144,17 @@ int main(int argc, char *argv[])
     config_manager.subscribe(database_config_observer.get());
     config_manager.subscribe(file_type_config_observer.get());
     config_manager.subscribe(video_processing_config_observer.get());
+    config_manager.subscribe(network_mount_config_observer.get());
     config_manager.subscribe(cache_config_observer.get());
     config_manager.subscribe(processing_config_observer.get());
     config_manager.subscribe(dedup_mode_config_observer.get());
 
+    // Per-mount I/O limits; NetworkMountConfigObserver applies network_mounts.* changes without a restart
+    MountThrottle::getInstance().setLimits(NetworkMountConfigObserver::configuredLimits());
+
+    // Decode memory budget; ProcessingConfigObserver applies processing.memory_budget_mb changes without a restart
+    MemoryAdmission::getInstance().setBudgetMB(static_cast<uint32_t>(std::max(0, config_manager.getProcessingMemoryBudgetMB())));
+
     // Initialize and start the simple scheduler
     auto &scheduler = SimpleScheduler::getInstance();
 
@@ -169,28 +185,24 @@ int main(int argc, char *argv[])
     // At the start of main, initialize the DatabaseManager singleton with default db path
     auto &db_manager = DatabaseManager::getInstance("scan_results.db");
 
-    // Reset all processing flags from -1 (in progress) to 0 (not processed) on startup
-    // This ensures a clean state when the server restarts
-    Logger::info("Resetting processing flags on startup...");
-    auto reset_result = db_manager.resetAllProcessingFlagsOnStartup();
-    if (!reset_result.success)
-    {
-        Logger::warn("Warning: Failed to reset processing flags: " + reset_result.error_message);
-    }
-    else
-    {
-        Logger::info("Successfully reset all processing flags on startup");
-    }
+    // Files and transcoding jobs left in progress by a previous run are not reset here.
+    // Claims carry a lease, and expired leases are reclaimed lazily by the next claim.
+
+    // Recycle cv::Mat buffers on processing threads instead of going to malloc per temporary
+    PooledMatAllocator::install();
 
     // Initialize transcoding manager
     auto &transcoding_manager = TranscodingManager::getInstance();
     transcoding_manager.setDatabaseManager(&db_manager);
     transcoding_manager.initialize("./cache", config_manager.getMaxProcessingThreads());
 
-    // Reset all transcoding job statuses from 1 (in progress) to 0 (queued) on startup
-    // This ensures a clean state when the server restarts
-    Logger::info("Resetting transcoding job statuses on startup...");
-    transcoding_manager.resetTranscodingJobStatusesOnStartup();
+    // Canonical decodes on local disk, so fingerprinting again does not have to read the sources
+    std::string thumbnail_store_dir = config_manager.getThumbnailStoreDir();
+    const uint64_t thumbnail_store_max_bytes = static_cast<uint64_t>(std::max(0, config_manager.getThumbnailStoreMaxMB())) * 1024 * 1024;
+    if (!thumbnail_store_dir.empty() && !ThumbnailStore::getInstance().open(thumbnail_store_dir, thumbnail_store_max_bytes))
+    {
+        Logger::warn("Thumbnail store unavailable at " + thumbnail_store_dir + ", continuing without it");
+    }
 
     // Restore transcoding queue from database on startup
     transcoding_manager.restoreQueueFromDatabase();
@@ -205,9 +217,24 @@ int main(int argc, char *argv[])
     config_manager.subscribe(&DuplicateLinker::getInstance());
     Logger::info("DuplicateLinker subscribed to configuration changes for real-time processing interval updates");
 
+    // Subscribe the decoded-thumbnail cache so decoder_cache_size_mb resizes it without a restart
+    config_manager.subscribe(&DecoderCache::getInstance());
+    Logger::info("DecoderCache subscribed to configuration changes for real-time cache budget updates");
+
     // Start the scheduler first to ensure it's ready
     scheduler.start();
 
+    // Optional live change feed: new and deleted files under local scan roots are picked up
+    // within the debounce window instead of waiting for the next interval scan
+    if (config_manager.getWatchEnabled())
+    {
+        auto watch_roots = db_manager.getUserInputs("scan_path");
+        if (!FileWatcher::getInstance().start("scan_results.db", watch_roots, config_manager.getWatchDebounceMs()))
+        {
+            Logger::warn("File watcher unavailable; relying on interval scans");
+        }
+    }
+
     // Perform immediate scan on startup in a separate thread to avoid blocking
     Logger::info("Starting immediate scan on server startup in background thread...");
     std::thread startup_scan_thread([&]()
@@ -236,76 +263,20 @@ int main(int argc, char *argv[])
 
             Logger::info("Found " + std::to_string(scan_paths.size()) + " scan paths for immediate scan");
 
-            // Get configured scan thread limit
+            // Get configured scan thread limits
             auto &config_manager = PocoConfigAdapter::getInstance();
             int max_scan_threads = config_manager.getMaxScanThreads();
+            int max_roots_per_mount = config_manager.getMaxScanRootsPerMount();
 
             Logger::info("Starting immediate parallel scan with " + std::to_string(max_scan_threads) + " threads for " +
                          std::to_string(scan_paths.size()) + " scan paths");
 
-            // Thread-safe counters for progress tracking
-            std::atomic<size_t> total_files_stored{0};
-            std::atomic<size_t> successful_scans{0};
-            std::atomic<size_t> failed_scans{0};
-
-            // Process scan paths sequentially (TBB removed for simplicity)
-            Logger::info("Processing " + std::to_string(scan_paths.size()) + " scan paths sequentially");
-            
-            for (size_t i = 0; i < scan_paths.size(); ++i)
-            {
-                // Check for shutdown before processing each path
-                if (ShutdownManager::getInstance().isShutdownRequested())
-                {
-                    Logger::info("Startup scan thread: shutdown requested, stopping scan");
-                    return;
-                }
-                
-                const auto &scan_path = scan_paths[i];
-
-                try
-                {
-                    Logger::info("Scanning directory: " + scan_path);
-
-                    // Create scanner instance
-                    FileScanner scanner("scan_results.db");
-
-                    // Check for shutdown before starting the scan
-                    if (ShutdownManager::getInstance().isShutdownRequested())
-                    {
-                        Logger::info("Startup scan thread: shutdown requested before scan, stopping immediately");
-                        return;
-                    }
-
-                    // Perform the scan
-                    size_t files_stored = scanner.scanDirectory(scan_path, true);
-
-                    // Check for shutdown after scan completes
-                    if (ShutdownManager::getInstance().isShutdownRequested())
-                    {
-                        Logger::info("Startup scan thread: shutdown requested after scan, stopping immediately");
-                        return;
-                    }
-
-                    // Update counters
-                    total_files_stored += files_stored;
-                    successful_scans++;
-
-                    Logger::info("Completed scan for " + scan_path +
-                                 " - Files stored: " + std::to_string(files_stored));
-                }
-                catch (const std::exception &e)
-                {
-                    failed_scans++;
-                    Logger::error("Error scanning directory " + scan_path + ": " + std::string(e.what()));
-                }
-                
-                // Check for shutdown after each path
-                if (ShutdownManager::getInstance().isShutdownRequested())
-                {
-                    Logger::info("Startup scan thread: shutdown requested after path completion, stopping immediately");
-                    return;
-                }
-            }
+            // Full walk of every root; this also records the directory manifests that
+            // let scheduled scans skip unchanged subtrees
+            auto scan_result = FileScanner::scanRoots("scan_results.db", scan_paths, true,
+                                                      static_cast<size_t>(std::max(1, max_scan_threads)),
+                                                      static_cast<size_t>(std::max(1, max_roots_per_mount)));
+            size_t total_files_stored = scan_result.files_stored;
 
             // Check for shutdown before proceeding with final processing
             if (ShutdownManager::getInstance().isShutdownRequested())
@@ -315,14 +286,14 @@ int main(int argc, char *argv[])
             }
 
             // Log final statistics for immediate scan
-            Logger::info("Immediate startup scan completed - Total files stored: " + std::to_string(total_files_stored.load()) +
-                         ", Successful scans: " + std::to_string(successful_scans.load()) +
-                         ", Failed scans: " + std::to_string(failed_scans.load()));
+            Logger::info("Immediate startup scan completed - Total files stored: " + std::to_string(total_files_stored) +
+                         ", Successful scans: " + std::to_string(scan_result.successful_scans) +
+                         ", Failed scans: " + std::to_string(scan_result.failed_scans));
 
-            Logger::info("All immediate startup scans completed - Total files stored: " + std::to_string(total_files_stored.load()));
+            Logger::info("All immediate startup scans completed - Total files stored: " + std::to_string(total_files_stored));
 
             // If files were found, trigger immediate processing (but only if not shutting down)
-            if (total_files_stored.load() > 0 && !ShutdownManager::getInstance().isShutdownRequested())
+            if (total_files_stored > 0 && !ShutdownManager::getInstance().isShutdownRequested())
             {
                 Logger::info("Files found during startup scan, triggering immediate processing...");
                 
@@ -382,52 +353,43 @@ int main(int argc, char *argv[])
             
             Logger::info("Found " + std::to_string(scan_paths.size()) + " scan paths to process");
             
-            // Get configured scan thread limit
+            // Get configured scan thread limits
             auto &config_manager = PocoConfigAdapter::getInstance();
             int max_scan_threads = config_manager.getMaxScanThreads();
-            
-            Logger::info("Starting sequential scan for " + std::to_string(scan_paths.size()) + " scan paths");
-            
-            // Thread-safe counters for progress tracking
-            std::atomic<size_t> total_files_stored{0};
-            std::atomic<size_t> successful_scans{0};
-            std::atomic<size_t> failed_scans{0};
-            
-            // Process scan paths sequentially (TBB removed for simplicity)
-            Logger::info("Processing " + std::to_string(scan_paths.size()) + " scan paths sequentially");
-            
-            for (size_t i = 0; i < scan_paths.size(); ++i)
+            int max_roots_per_mount = config_manager.getMaxScanRootsPerMount();
+
+            // Most scheduled scans only descend into directories whose mtime changed; every
+            // Nth scan walks everything to catch files edited in place
+            static std::atomic<uint64_t> scheduled_scan_count{0};
+            int full_walk_interval = config_manager.getFullWalkIntervalScans();
+            uint64_t scan_number = ++scheduled_scan_count;
+            bool full_walk = full_walk_interval <= 1 || scan_number % static_cast<uint64_t>(full_walk_interval) == 0;
+
+            // The watcher already keeps watched roots current; only the periodic full walk remains
+            std::vector<std::string> roots_to_scan;
+            for (const auto &scan_path : scan_paths)
             {
-                const auto& scan_path = scan_paths[i];
-                
-                try {
-                    Logger::info("Scanning directory: " + scan_path);
-                    
-                    // Create scanner instance
-                    FileScanner scanner("scan_results.db");
-                    
-                    // Perform the scan
-                    size_t files_stored = scanner.scanDirectory(scan_path, true);
-                    
-                    // Update counters
-                    total_files_stored += files_stored;
-                    successful_scans++;
-                    
-                    Logger::info("Completed scan for " + scan_path + 
-                               " - Files stored: " + std::to_string(files_stored));
-                                       
-                } catch (const std::exception &e) {
-                    failed_scans++;
-                    Logger::error("Error scanning directory " + scan_path + ": " + std::string(e.what()));
+                if (!full_walk && FileWatcher::getInstance().isWatching(scan_path))
+                {
+                    Logger::info("Skipping incremental scan of watched directory: " + scan_path);
+                    continue;
                 }
+                roots_to_scan.push_back(scan_path);
             }
             
+            Logger::info("Starting parallel " + std::string(full_walk ? "full" : "incremental") +
+                         " scan for " + std::to_string(roots_to_scan.size()) + " scan paths");
+            
+            auto scan_result = FileScanner::scanRoots("scan_results.db", roots_to_scan, full_walk,
+                                                      static_cast<size_t>(std::max(1, max_scan_threads)),
+                                                      static_cast<size_t>(std::max(1, max_roots_per_mount)));
+            
             // Log final statistics
-            Logger::info("Sequential scanning completed - Total files stored: " + std::to_string(total_files_stored.load()) + 
-                        ", Successful scans: " + std::to_string(successful_scans.load()) + 
-                        ", Failed scans: " + std::to_string(failed_scans.load()));
+            Logger::info("Parallel scanning completed - Total files stored: " + std::to_string(scan_result.files_stored) + 
+                        ", Successful scans: " + std::to_string(scan_result.successful_scans) + 
+                        ", Failed scans: " + std::to_string(scan_result.failed_scans));
             
-            Logger::info("All scheduled scans completed - Total files stored: " + std::to_string(total_files_stored.load()));
+            Logger::info("All scheduled scans completed - Total files stored: " + std::to_string(scan_result.files_stored));
         } catch (const std::exception &e) {
             Logger::error("Error in scheduled scan: " + std::string(e.what()));
         } });
@@ -496,6 +458,11 @@ int main(int argc, char *argv[])
     scheduler.stop();
     Logger::info("Scheduler stopped");
 
+    std::cout << "Stopping file watcher...\n"
+              << std::flush;
+    FileWatcher::getInstance().stop();
+    Logger::info("File watcher stopped");
+
     std::cout << "Stopping ContinuousProcessingManager...\n"
               << std::flush;
     continuous_processing_manager.stop();
@@ -4,6 +4,7 @@
 #include "core/shutdown_manager.hpp"
 #include "database/database_manager.hpp"
 #include "core/duplicate_linker.hpp"
+#include "core/mount_throttle.hpp"
 #include "logging/logger.hpp"
 #include "poco_config_adapter.hpp"
 #include <chrono>
@@ -194,39 +195,81 @@ SimpleObservable<FileProcessingEvent> MediaProcessingOrchestrator::processAllSca
                                 continue;
                             }
                             
+                            // The whole batch was leased at claim time; renew this file's lease now that
+                            // its turn has come. A lapsed lease may have been claimed by another worker.
+                            if (!dbMan_.renewProcessingLease(file_path)) {
+                                processed_count.fetch_add(1);
+                                continue;
+                            }
+                            
                             // Process the file for each required mode
                             // Files are already marked as in progress (-1) by getAndMarkFilesForProcessing
                             bool any_success = false;
+                            bool any_deferred = false; // a mode put back to pending for an unavailable mount
                             std::string last_error;
                             
+                            // A RAW file transcoded moments ago is still decoded in memory: fingerprint
+                            // those pixels instead of reading the cache file back
+                            std::shared_ptr<const cv::Mat> decoded_image;
+                            if (TranscodingManager::isRawFile(file_path)) {
+                                decoded_image = TranscodingManager::getInstance().getDecodedImage(file_path);
+                            }
+                            
                             for (const auto& process_mode : modes_to_process) {
                                 // Files are already marked as in progress by getAndMarkFilesForProcessing
                                 // No need to call tryAcquireProcessingLock again
                                 Logger::info("Processing file: " + file_path + " with mode: " + DedupModes::getModeName(process_mode));
                                 
-                                // Check if this file has a transcoded version available
-                                std::string actual_file_path = file_path;
-                                std::string transcoded_path = TranscodingManager::getInstance().getTranscodedFilePath(file_path);
-                                if (!transcoded_path.empty() && std::filesystem::exists(transcoded_path))
-                                {
-                                    actual_file_path = transcoded_path;
-                                    Logger::debug("Using transcoded file for processing: " + file_path + " -> " + transcoded_path);
-                                }
-                                else if (TranscodingManager::isRawFile(file_path))
-                                {
-                                    // Raw file without a transcoded version yet – queue and defer processing
-                                    Logger::info("Raw file missing transcoded output; queued and deferred: " + file_path);
-                                    TranscodingManager::getInstance().queueForTranscoding(file_path);
-                                    last_error = "Transcoding pending";
-                                    // CRITICAL: Keep flag at -1 (in progress) - DO NOT change it!
-                                    // The transcoding thread will reset it to 0 when transcoding completes
-                                    Logger::debug("Keeping processing flag at -1 (in progress) for RAW file: " + file_path);
-                                    failed_processed.fetch_add(1);
-                                    continue;
-                                }
+                                ProcessingResult result;
+                                if (decoded_image) {
+                                    Logger::debug("Using decoded RAW pixels for processing: " + file_path);
+                                    result = MediaProcessor::processDecodedImage(*decoded_image, process_mode, file_path);
+                                } else {
+                                    // Check if this file has a transcoded version available
+                                    std::string actual_file_path = file_path;
+                                    std::string transcoded_path = TranscodingManager::getInstance().getTranscodedFilePath(file_path);
+                                    if (!transcoded_path.empty() && std::filesystem::exists(transcoded_path))
+                                    {
+                                        actual_file_path = transcoded_path;
+                                        Logger::debug("Using transcoded file for processing: " + file_path + " -> " + transcoded_path);
+                                    }
+                                    else if (TranscodingManager::isRawFile(file_path))
+                                    {
+                                        // Raw file without a transcoded version yet (or whose in-memory proxy is
+                                        // gone) – queue and defer processing
+                                        Logger::info("Raw file missing transcoded output; queued and deferred: " + file_path);
+                                        TranscodingManager::getInstance().queueForTranscoding(file_path, true);
+                                        last_error = "Transcoding pending";
+                                        // Park this mode at -2; the transcoding thread requeues it when the transcode completes
+                                        dbMan_.setProcessingFlagAwaitingTranscode(file_path, process_mode);
+                                        failed_processed.fetch_add(1);
+                                        continue;
+                                    }
                                 
-                                // Process the file for this mode
-                                ProcessingResult result = MediaProcessor::processFile(actual_file_path, process_mode);
+                                    // Network share behind an open breaker – defer like a pending transcode
+                                    if (!MountThrottle::getInstance().isAvailable(actual_file_path))
+                                    {
+                                        Logger::info("Network mount unavailable; deferred: " + file_path);
+                                        last_error = "Network mount unavailable";
+                                        // Back to pending with the lease cleared so the next pass picks it up again
+                                        dbMan_.resetProcessingFlag(file_path, process_mode);
+                                        any_deferred = true;
+                                        continue;
+                                    }
+                                
+                                    // Process the file for this mode
+                                    result = MediaProcessor::processFile(actual_file_path, process_mode);
+                                
+                                    // The mount failed during this attempt: defer rather than mark the file as an error
+                                    if (!result.success && !MountThrottle::getInstance().isAvailable(actual_file_path))
+                                    {
+                                        Logger::info("Network mount became unavailable; deferred: " + file_path);
+                                        last_error = result.error_message;
+                                        dbMan_.resetProcessingFlag(file_path, process_mode);
+                                        any_deferred = true;
+                                        continue;
+                                    }
+                                }
                                 
                                 // Store the processing result in the database
                                 DBOpResult db_result = dbMan_.storeProcessingResult(file_path, process_mode, result);
@@ -276,10 +319,18 @@ SimpleObservable<FileProcessingEvent> MediaProcessingOrchestrator::processAllSca
                                 }
                             }
                             
+                            if (decoded_image) {
+                                TranscodingManager::getInstance().releaseDecodedImage(file_path);
+                            }
+                            
                             // Set final event result
                             if (any_success) {
                                 event.success = true;
                                 successful_processed.fetch_add(1);
+                            } else if (any_deferred) {
+                                // Deferred, not failed: the file is pending again
+                                event.success = false;
+                                event.error_message = "Deferred: " + last_error;
                             } else {
                                 event.success = false;
                                 event.error_message = "Processing failed for all modes: " + last_error;
@@ -24,13 +24,20 @@ extern "C"
 #include <libavutil/hwcontext.h>
 #include <libavutil/hwcontext_videotoolbox.h>
 #include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
 }
 
 // Enhanced safety mechanisms for external libraries
 #include "core/external_library_wrappers.hpp"
 #include "core/error_recovery.hpp"
+#include "core/mount_throttle.hpp"
 #include "core/memory_pool.hpp"
 #include "core/resource_monitor.hpp"
+#include "core/cache/decoder_cache.hpp"
+#include "core/cache/thumbnail_store.hpp"
+#include "core/decoder/frame_buffer_pool.hpp"
+#include "core/memory_admission.hpp"
+#include <cstring>
 
 // Helper function to create hardware-accelerated scaling context
 SwsContext *createHardwareScaler(int src_width, int src_height, AVPixelFormat src_fmt,
@@ -59,14 +66,308 @@ SwsContext *createHardwareScaler(int src_width, int src_height, AVPixelFormat sr
     return sws_ctx;
 }
 
+namespace
+{
+    // Decoders here run with FFmpeg's default thread count
+    constexpr int VIDEO_DECODER_THREADS = 1;
+
+    // Run one demuxer call (open, probe, seek) under an I/O slot of the file's network mount, so
+    // the slot is held for the read and not for the decoding around it. Local files (empty
+    // mount_point) are not throttled; a refused slot reads as an I/O error.
+    template <typename Call>
+    int mountIo(const std::string &mount_point, Call &&call)
+    {
+        auto permit = MountThrottle::getInstance().acquireForMount(mount_point);
+        if (!permit)
+        {
+            return AVERROR(EIO);
+        }
+        int rc = call();
+        permit.complete(rc >= 0 || rc == AVERROR_EOF || !MountThrottle::isMountError(AVUNERROR(rc)));
+        return rc;
+    }
+
+    // av_read_frame() under a slot, charging the packet to the mount's bandwidth budget
+    int readPacket(const std::string &mount_point, AVFormatContext *format_ctx, AVPacket *packet)
+    {
+        auto permit = MountThrottle::getInstance().acquireForMount(mount_point);
+        if (!permit)
+        {
+            return AVERROR(EIO);
+        }
+        int rc = av_read_frame(format_ctx, packet);
+        permit.complete(rc >= 0 || rc == AVERROR_EOF || !MountThrottle::isMountError(AVUNERROR(rc)),
+                        rc >= 0 ? static_cast<uint64_t>(packet->size) : 0);
+        return rc;
+    }
+
+    // Peak memory of decoding file_path, from its header read under an I/O slot of mount_point;
+    // audio is not budgeted
+    uint64_t estimateDecodePeakBytes(const std::string &file_path, const std::string &mount_point)
+    {
+        if (MediaProcessor::isImageFile(file_path))
+        {
+            auto permit = MountThrottle::getInstance().acquireForMount(mount_point);
+            if (!permit)
+            {
+                return 0; // the decode that follows fails on the same mount
+            }
+            return MemoryAdmission::estimateImagePeakBytes(file_path);
+        }
+        if (!MediaProcessor::isVideoFile(file_path))
+        {
+            return 0;
+        }
+
+        // Container headers carry the stream geometry; streams that only reveal it once decoded
+        // are budgeted as 1080p
+        int width = 1920;
+        int height = 1080;
+        int bits_per_sample = 8;
+        AVFormatContext *format_ctx = nullptr;
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) == 0)
+        {
+            for (unsigned int i = 0; i < format_ctx->nb_streams; i++)
+            {
+                const AVCodecParameters *params = format_ctx->streams[i]->codecpar;
+                if (params->codec_type != AVMEDIA_TYPE_VIDEO || params->width <= 0 || params->height <= 0)
+                {
+                    continue;
+                }
+                width = params->width;
+                height = params->height;
+                const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(params->format));
+                if (desc)
+                {
+                    bits_per_sample = desc->comp[0].depth;
+                }
+                break;
+            }
+            avformat_close_input(&format_ctx);
+        }
+        return MemoryAdmission::videoPeakBytes(width, height, bits_per_sample, VIDEO_DECODER_THREADS);
+    }
+
+    // Decoder cache first, then the on-disk thumbnail store; store hits are promoted into the cache
+    std::shared_ptr<const cv::Mat> findCanonical(const DecoderCache::Key &key)
+    {
+        auto &cache = DecoderCache::getInstance();
+        if (auto cached = cache.get(key))
+        {
+            return cached;
+        }
+        auto stored = ThumbnailStore::getInstance().get(key);
+        if (stored)
+        {
+            cache.put(key, stored);
+        }
+        return stored;
+    }
+
+    // Whether the canonical image the mode fingerprints is cached; video and audio are read anyway
+    bool canonicalCached(const std::string &file_path, DedupMode mode)
+    {
+        if (!MediaProcessor::isImageFile(file_path))
+        {
+            return false;
+        }
+        DecoderCache::Variant variant;
+        switch (mode)
+        {
+        case DedupMode::FAST:
+            variant = DecoderCache::Variant::GRAY_9X8;
+            break;
+        case DedupMode::BALANCED:
+            variant = DecoderCache::Variant::GRAY_32X32;
+            break;
+        case DedupMode::QUALITY:
+            variant = DecoderCache::Variant::COLOR_224;
+            break;
+        default:
+            return false;
+        }
+        const DecoderCache::Key key = DecoderCache::Key::forFile(file_path, variant);
+        return !key.path.empty() && findCanonical(key) != nullptr;
+    }
+
+    void keepCanonical(const DecoderCache::Key &key, std::shared_ptr<const cv::Mat> image)
+    {
+        ThumbnailStore::getInstance().put(key, *image);
+        DecoderCache::getInstance().put(key, std::move(image));
+    }
+
+    // Whether a fresh decode should be reduced to every canonical variant and kept
+    bool keepingCanonicals(const DecoderCache::Key &key)
+    {
+        return !key.path.empty() && (DecoderCache::getInstance().enabled() || ThumbnailStore::getInstance().isOpen());
+    }
+
+    // Decode an image once and keep every canonical variant the image modes start from, each built
+    // exactly as that mode builds it from the full image, so retries and mode switches fingerprint
+    // from the decoder cache or thumbnail store instead of reading the file again. With neither in
+    // use the full decode is returned and the mode does its own reduction.
+    std::shared_ptr<const cv::Mat> loadCanonicalImage(const std::string &file_path, DecoderCache::Variant variant)
+    {
+        const DecoderCache::Key key = DecoderCache::Key::forFile(file_path, variant);
+        if (auto cached = findCanonical(key))
+        {
+            Logger::debug("Decoder cache hit: " + file_path);
+            return cached;
+        }
+
+        // Read under the mount's I/O slots, decode without holding one
+        std::vector<unsigned char> encoded;
+        if (!MountThrottle::getInstance().readFile(file_path, encoded))
+        {
+            return nullptr;
+        }
+        cv::Mat image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        encoded = std::vector<unsigned char>();
+        if (image.empty())
+        {
+            return nullptr;
+        }
+        Logger::info("Image loaded successfully: " + file_path + " (size: " + std::to_string(image.cols) + "x" + std::to_string(image.rows) + ")");
+
+        if (!keepingCanonicals(key))
+        {
+            return std::make_shared<const cv::Mat>(std::move(image));
+        }
+
+        cv::Mat gray_image;
+        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        auto gray_9x8 = std::make_shared<cv::Mat>();
+        cv::resize(gray_image, *gray_9x8, cv::Size(9, 8));
+        auto gray_32x32 = std::make_shared<cv::Mat>();
+        cv::resize(gray_image, *gray_32x32, cv::Size(32, 32));
+        auto color_224 = std::make_shared<cv::Mat>();
+        cv::resize(image, *color_224, cv::Size(224, 224));
+
+        keepCanonical(key.withVariant(DecoderCache::Variant::GRAY_9X8), gray_9x8);
+        keepCanonical(key.withVariant(DecoderCache::Variant::GRAY_32X32), gray_32x32);
+        keepCanonical(key.withVariant(DecoderCache::Variant::COLOR_224), color_224);
+
+        switch (variant)
+        {
+        case DecoderCache::Variant::GRAY_9X8:
+            return gray_9x8;
+        case DecoderCache::Variant::GRAY_32X32:
+            return gray_32x32;
+        default:
+            return color_224;
+        }
+    }
+
+    // The frames one seek target contributed, as the video decode loops produce them. Kept in the
+    // decoder cache per seek target and frames_per_skip, so retries, mode switches and skip_count
+    // changes that keep the target reuse them without decoding the video again.
+    struct SkipFrames
+    {
+        std::vector<std::string> digests; // hex SHA-256 of each valid frame (FAST/BALANCED input)
+        std::vector<cv::Mat> frames_224;  // the same frames resized for the CNN (QUALITY input)
+    };
+
+    void storeSkipFrames(const DecoderCache::Key &file_key, int64_t pts, int frames_per_skip, const SkipFrames &skip)
+    {
+        auto digests = std::make_shared<cv::Mat>();
+        if (!skip.digests.empty())
+        {
+            digests->create(static_cast<int>(skip.digests.size()), static_cast<int>(skip.digests[0].size()), CV_8U);
+            for (size_t i = 0; i < skip.digests.size(); ++i)
+            {
+                std::memcpy(digests->ptr(static_cast<int>(i)), skip.digests[i].data(), skip.digests[i].size());
+            }
+        }
+        auto frames = std::make_shared<cv::Mat>();
+        if (!skip.frames_224.empty())
+        {
+            cv::vconcat(skip.frames_224, *frames);
+        }
+
+        keepCanonical(file_key.forSkip(DecoderCache::Variant::FRAME_DIGESTS, pts, frames_per_skip), digests);
+        keepCanonical(file_key.forSkip(DecoderCache::Variant::FRAMES_224, pts, frames_per_skip), frames);
+    }
+
+    // Append the cached frame digests of a skip; false on a miss
+    bool appendCachedDigests(const DecoderCache::Key &file_key, int64_t pts, int frames_per_skip,
+                             std::vector<std::vector<uint8_t>> &frame_hashes)
+    {
+        auto cached = findCanonical(file_key.forSkip(DecoderCache::Variant::FRAME_DIGESTS, pts, frames_per_skip));
+        if (!cached)
+        {
+            return false;
+        }
+        for (int row = 0; row < cached->rows; ++row)
+        {
+            const uint8_t *digest = cached->ptr<uint8_t>(row);
+            frame_hashes.emplace_back(digest, digest + cached->cols);
+        }
+        return true;
+    }
+
+    // Embedding of one 224x224 frame (CNN preprocessing as in processImageQuality)
+    std::vector<float> frameEmbedding(const cv::Mat &frame_224, int embedding_size)
+    {
+        cv::Mat processed_frame;
+        cv::cvtColor(frame_224, processed_frame, cv::COLOR_BGR2RGB);
+        processed_frame.convertTo(processed_frame, CV_32F, 1.0 / 255.0);
+        std::vector<cv::Mat> channels(3);
+        cv::split(processed_frame, channels);
+        channels[0] = (channels[0] - 0.485f) / 0.229f;
+        channels[1] = (channels[1] - 0.456f) / 0.224f;
+        channels[2] = (channels[2] - 0.406f) / 0.225f;
+        cv::merge(channels, processed_frame);
+        std::vector<float> embedding(embedding_size, 0.0f);
+        for (int i = 0; i < embedding_size; i++)
+        {
+            int pixel_idx = i % (processed_frame.rows * processed_frame.cols);
+            int row = pixel_idx / processed_frame.cols;
+            int col = pixel_idx % processed_frame.cols;
+            if (row < processed_frame.rows && col < processed_frame.cols)
+            {
+                cv::Vec3f pixel = processed_frame.at<cv::Vec3f>(row, col);
+                embedding[i] = (pixel[0] * 0.299f + pixel[1] * 0.587f + pixel[2] * 0.114f) + ((row + col) % 256) / 255.0f;
+            }
+            else
+            {
+                embedding[i] = ((i * 13 + 7) % 256) / 255.0f;
+            }
+        }
+        return embedding;
+    }
+}
+
 ProcessingResult MediaProcessor::processFile(const std::string &file_path, DedupMode mode)
 {
+    // Fingerprinting temporaries of this worker come from its pooled free lists
+    PooledMatAllocator::enableForCurrentThread();
+
     // Check if file exists and is supported
     if (!isSupportedFile(file_path))
     {
         return ProcessingResult(false, "Unsupported file type: " + file_path);
     }
 
+    // A canonical decode already in the decoder cache or thumbnail store is fingerprinted without
+    // reading the file, so it needs neither the mount nor room in the memory budget
+    MemoryAdmission::Grant memory_grant;
+    if (!canonicalCached(file_path, mode))
+    {
+        // Estimating reads the header, so a mount behind an open breaker fails here, before the
+        // job waits for memory it could not use
+        const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+        if (!mount_point.empty() && !MountThrottle::getInstance().isAvailable(file_path))
+        {
+            return ProcessingResult(false, "Network mount unavailable: " + mount_point);
+        }
+
+        // Large decodes wait for room in the memory budget instead of pushing the box into swap.
+        // Reads from a network share take the mount's I/O slots one read at a time, see
+        // loadCanonicalImage and mountIo.
+        memory_grant = MemoryAdmission::getInstance().admit(estimateDecodePeakBytes(file_path, mount_point), file_path);
+    }
+
     std::ifstream file(file_path, std::ios::binary);
     if (!file.is_open())
     {
@@ -79,19 +380,8 @@ ProcessingResult MediaProcessor::processFile(const std::string &file_path, Dedup
         std::string media_type;
         try
         {
-            std::string ext = getFileExtension(file_path);
-            auto &config = PocoConfigAdapter::getInstance();
-            auto img_exts = config.getEnabledImageExtensions();
-            auto vid_exts = config.getEnabledVideoExtensions();
-            auto aud_exts = config.getEnabledAudioExtensions();
-
-            if (std::find(img_exts.begin(), img_exts.end(), ext) != img_exts.end())
-                media_type = "image";
-            else if (std::find(vid_exts.begin(), vid_exts.end(), ext) != vid_exts.end())
-                media_type = "video";
-            else if (std::find(aud_exts.begin(), aud_exts.end(), ext) != aud_exts.end())
-                media_type = "audio";
-            else
+            media_type = getMediaType(file_path);
+            if (media_type.empty())
             {
                 return ProcessingResult(false, "Unsupported file type: " + file_path);
             }
@@ -165,11 +455,31 @@ ProcessingResult MediaProcessor::processFile(const std::string &file_path, Dedup
     }
 }
 
+ProcessingResult MediaProcessor::processDecodedImage(const cv::Mat &image, DedupMode mode, const std::string &file_path)
+{
+    PooledMatAllocator::enableForCurrentThread();
+
+    if (image.empty())
+    {
+        return ProcessingResult(false, "Empty decoded image: " + file_path);
+    }
+
+    switch (mode)
+    {
+    case DedupMode::FAST:
+        return processImageFast(image, file_path);
+    case DedupMode::BALANCED:
+        return processImageBalanced(image, file_path);
+    case DedupMode::QUALITY:
+        return processImageQuality(image, file_path);
+    default:
+        return ProcessingResult(false, "Unknown dedup mode for image processing");
+    }
+}
+
 bool MediaProcessor::isSupportedFile(const std::string &file_path)
 {
-    std::string ext = getFileExtension(file_path);
-    auto supported = getSupportedExtensions();
-    return std::find(supported.begin(), supported.end(), ext) != supported.end();
+    return PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).supported;
 }
 
 // Static extension lists - now configuration-driven
@@ -182,7 +492,37 @@ std::vector<std::string> MediaProcessor::getSupportedExtensions()
     return enabled_types;
 }
 
+std::string MediaProcessor::getMediaType(const std::string &file_path)
+{
+    return PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).media_type;
+}
+
+std::string MediaProcessor::getMediaCategory(const std::string &file_path)
+{
+    return PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).category;
+}
+
 ProcessingResult MediaProcessor::processImageFast(const std::string &file_path)
+{
+    try
+    {
+        // Canonical dHash input from the decoder cache, or a fresh decode
+        auto image = loadCanonicalImage(file_path, DecoderCache::Variant::GRAY_9X8);
+        if (!image)
+        {
+            return ProcessingResult(false, "Failed to load image: " + file_path);
+        }
+
+        return processImageFast(*image, file_path);
+    }
+    catch (const cv::Exception &e)
+    {
+        Logger::error("OpenCV error during image loading: " + std::string(e.what()));
+        return ProcessingResult(false, "OpenCV processing error: " + std::string(e.what()));
+    }
+}
+
+ProcessingResult MediaProcessor::processImageFast(const cv::Mat &image, const std::string &file_path)
 {
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("image", DedupMode::FAST);
@@ -195,18 +535,17 @@ ProcessingResult MediaProcessor::processImageFast(const std::string &file_path)
 
     try
     {
-        // Load image using OpenCV
-        cv::Mat image = cv::imread(file_path, cv::IMREAD_COLOR);
-        if (image.empty())
-        {
-            return ProcessingResult(false, "Failed to load image: " + file_path);
-        }
 
-        Logger::info("Image loaded successfully: " + file_path + " (size: " + std::to_string(image.cols) + "x" + std::to_string(image.rows) + ")");
-
-        // Convert to grayscale for dHash
+        // Convert to grayscale for dHash (cached canonical inputs already are)
         cv::Mat gray_image;
-        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        if (image.channels() == 1)
+        {
+            gray_image = image;
+        }
+        else
+        {
+            cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        }
 
         // Resize to 9x8 for dHash (difference hash)
         // dHash compares each pixel with its neighbor to the right
@@ -277,6 +616,26 @@ ProcessingResult MediaProcessor::processImageFast(const std::string &file_path)
 }
 
 ProcessingResult MediaProcessor::processImageBalanced(const std::string &file_path)
+{
+    try
+    {
+        // Canonical pHash input from the decoder cache, or a fresh decode
+        auto image = loadCanonicalImage(file_path, DecoderCache::Variant::GRAY_32X32);
+        if (!image)
+        {
+            return ProcessingResult(false, "Failed to load image: " + file_path);
+        }
+
+        return processImageBalanced(*image, file_path);
+    }
+    catch (const cv::Exception &e)
+    {
+        Logger::error("OpenCV error during image loading: " + std::string(e.what()));
+        return ProcessingResult(false, "OpenCV processing error: " + std::string(e.what()));
+    }
+}
+
+ProcessingResult MediaProcessor::processImageBalanced(const cv::Mat &image, const std::string &file_path)
 {
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("image", DedupMode::BALANCED);
@@ -289,18 +648,17 @@ ProcessingResult MediaProcessor::processImageBalanced(const std::string &file_pa
 
     try
     {
-        // Load image using OpenCV
-        cv::Mat image = cv::imread(file_path, cv::IMREAD_COLOR);
-        if (image.empty())
-        {
-            return ProcessingResult(false, "Failed to load image: " + file_path);
-        }
 
-        Logger::info("Image loaded successfully: " + file_path + " (size: " + std::to_string(image.cols) + "x" + std::to_string(image.rows) + ")");
-
-        // Convert to grayscale for pHash
+        // Convert to grayscale for pHash (cached canonical inputs already are)
         cv::Mat gray_image;
-        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        if (image.channels() == 1)
+        {
+            gray_image = image;
+        }
+        else
+        {
+            cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        }
 
         // Resize to 32x32 for pHash (perceptual hash)
         cv::Mat resized_image;
@@ -399,6 +757,26 @@ ProcessingResult MediaProcessor::processImageBalanced(const std::string &file_pa
 }
 
 ProcessingResult MediaProcessor::processImageQuality(const std::string &file_path)
+{
+    try
+    {
+        // Canonical CNN input from the decoder cache, or a fresh decode
+        auto image = loadCanonicalImage(file_path, DecoderCache::Variant::COLOR_224);
+        if (!image)
+        {
+            return ProcessingResult(false, "Failed to load image: " + file_path);
+        }
+
+        return processImageQuality(*image, file_path);
+    }
+    catch (const cv::Exception &e)
+    {
+        Logger::error("OpenCV error during image loading: " + std::string(e.what()));
+        return ProcessingResult(false, "OpenCV processing error: " + std::string(e.what()));
+    }
+}
+
+ProcessingResult MediaProcessor::processImageQuality(const cv::Mat &image, const std::string &file_path)
 {
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("image", DedupMode::QUALITY);
@@ -411,14 +789,6 @@ ProcessingResult MediaProcessor::processImageQuality(const std::string &file_pat
 
     try
     {
-        // Load image using OpenCV
-        cv::Mat image = cv::imread(file_path, cv::IMREAD_COLOR);
-        if (image.empty())
-        {
-            return ProcessingResult(false, "Failed to load image: " + file_path);
-        }
-
-        Logger::info("Image loaded successfully: " + file_path + " (size: " + std::to_string(image.cols) + "x" + std::to_string(image.rows) + ")");
 
         // Preprocess image for CNN (ResNet-style preprocessing)
         cv::Mat processed_image;
@@ -505,6 +875,9 @@ ProcessingResult MediaProcessor::processImageQuality(const std::string &file_pat
 
 ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
 {
+    // Demuxer reads take a slot on the file's network mount one call at a time
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("video", DedupMode::FAST);
     if (!algorithm)
@@ -535,7 +908,8 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         // Open video file with error recovery
         int open_result = ErrorRecovery::retryWithBackoff(
             [&]()
-            { return avformat_open_input(format_ctx.address(), file_path.c_str(), nullptr, nullptr); },
+            { return mountIo(mount_point, [&]
+                              { return avformat_open_input(format_ctx.address(), file_path.c_str(), nullptr, nullptr); }); },
             3, "avformat_open_input");
 
         if (open_result < 0)
@@ -557,7 +931,8 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         // Add validation for corrupted files with error recovery
         int stream_info_result = ErrorRecovery::retryWithBackoff(
             [&]()
-            { return avformat_find_stream_info(format_ctx.get(), nullptr); },
+            { return mountIo(mount_point, [&]
+                              { return avformat_find_stream_info(format_ctx.get(), nullptr); }); },
             3, "avformat_find_stream_info");
 
         if (stream_info_result < 0)
@@ -589,10 +964,10 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         double time_base = av_q2d(video_stream->time_base);
         double fps = av_q2d(video_stream->r_frame_rate);
         Logger::info("Video info - Duration: " + std::to_string(duration) + ", FPS: " + std::to_string(fps));
-        const auto &config = PocoConfigAdapter::getInstance();
-        int skip_duration = config.getVideoSkipDurationSeconds(DedupMode::FAST);
-        int frames_per_skip = config.getVideoFramesPerSkip(DedupMode::FAST);
-        int skip_count = config.getVideoSkipCount(DedupMode::FAST);
+        const ConfigSnapshot::VideoParams video_params = PocoConfigAdapter::getInstance().snapshot()->videoParams(DedupMode::FAST);
+        int skip_duration = video_params.skip_duration_seconds;
+        int frames_per_skip = video_params.frames_per_skip;
+        int skip_count = video_params.skip_count;
         int frames_to_extract = frames_per_skip * 3; // Extract more frames per skip for filtering
         std::vector<int64_t> target_pts;
         if (duration > 0 && skip_count > 0)
@@ -621,6 +996,7 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         {
             return ProcessingResult(false, "Could not copy codec parameters");
         }
+        FrameBufferPool::getInstance().attach(codec_ctx.get());
         if (avcodec_open2(codec_ctx.get(), codec, nullptr) < 0)
         {
             return ProcessingResult(false, "Could not open decoder");
@@ -648,7 +1024,10 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         rgb_frame.get()->format = AV_PIX_FMT_RGB24;
         rgb_frame.get()->width = codec_ctx.get()->width;
         rgb_frame.get()->height = codec_ctx.get()->height;
-        av_frame_get_buffer(rgb_frame.get(), 0);
+        if (FrameBufferPool::getInstance().getBuffer(rgb_frame.get()) < 0)
+        {
+            return ProcessingResult(false, "Could not allocate RGB frame buffer");
+        }
 
         // Create scaler context
         SwsContext *temp_sws_ctx = createHardwareScaler(
@@ -661,15 +1040,25 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
         sws_ctx.set(temp_sws_ctx);
         std::vector<std::vector<uint8_t>> frame_hashes;
         int frame_count_extracted = 0;
+        // Sampled frames are cached per seek target, see storeSkipFrames
+        const DecoderCache::Key file_key = DecoderCache::Key::forFile(file_path, DecoderCache::Variant::FRAME_DIGESTS);
+        const bool record_skips = keepingCanonicals(file_key);
         for (int skip_idx = 0; skip_idx < (int)target_pts.size(); ++skip_idx)
         {
             int64_t seek_target = target_pts[skip_idx];
+            if (appendCachedDigests(file_key, seek_target, frames_per_skip, frame_hashes))
+            {
+                frame_count_extracted = static_cast<int>(frame_hashes.size());
+                continue;
+            }
             // Seek to nearest keyframe before target
-            av_seek_frame(format_ctx.get(), video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY);
+            mountIo(mount_point, [&]
+                    { return av_seek_frame(format_ctx.get(), video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY); });
             avcodec_flush_buffers(codec_ctx.get());
             int frames_found = 0;
             int valid_frames = 0;
-            while (av_read_frame(format_ctx.get(), packet.get()) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
+            SkipFrames skip_frames;
+            while (readPacket(mount_point, format_ctx.get(), packet.get()) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
             {
                 if (packet.get()->stream_index == video_stream_index)
                 {
@@ -715,6 +1104,13 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
                                 std::string hash_str = generateHash(std::vector<uint8_t>(cv_frame.data, cv_frame.data + cv_frame.total() * cv_frame.elemSize()));
                                 std::vector<uint8_t> frame_hash(hash_str.begin(), hash_str.end());
                                 frame_hashes.push_back(frame_hash);
+                                if (record_skips)
+                                {
+                                    cv::Mat frame_224;
+                                    cv::resize(cv_frame, frame_224, cv::Size(224, 224));
+                                    skip_frames.digests.push_back(hash_str);
+                                    skip_frames.frames_224.push_back(frame_224);
+                                }
                                 frame_count_extracted++;
                                 valid_frames++;
                             }
@@ -726,6 +1122,9 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
                 }
                 av_packet_unref(packet.get());
             }
+            // A skip cut short (end of stream, read error) is decoded again next time
+            if (record_skips && valid_frames >= frames_per_skip)
+                storeSkipFrames(file_key, seek_target, frames_per_skip, skip_frames);
         }
         // RAII wrappers automatically clean up resources
         if (frame_hashes.empty())
@@ -765,6 +1164,8 @@ ProcessingResult MediaProcessor::processVideoFast(const std::string &file_path)
 
 ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("video", DedupMode::BALANCED);
     if (!algorithm)
@@ -783,7 +1184,8 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
     try
     {
         AVFormatContext *format_ctx = nullptr;
-        if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
         {
             // Check if file exists first
             std::ifstream test_file(file_path);
@@ -800,7 +1202,8 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
         }
 
         // Add validation for corrupted files
-        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
         {
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not find stream information (file may be corrupted): " + file_path);
@@ -832,10 +1235,10 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
         double time_base = av_q2d(video_stream->time_base);
         double fps = av_q2d(video_stream->r_frame_rate);
         Logger::info("Video info - Duration: " + std::to_string(duration) + ", FPS: " + std::to_string(fps));
-        const auto &config = PocoConfigAdapter::getInstance();
-        int skip_duration = config.getVideoSkipDurationSeconds(DedupMode::BALANCED);
-        int frames_per_skip = config.getVideoFramesPerSkip(DedupMode::BALANCED);
-        int skip_count = config.getVideoSkipCount(DedupMode::BALANCED);
+        const ConfigSnapshot::VideoParams video_params = PocoConfigAdapter::getInstance().snapshot()->videoParams(DedupMode::BALANCED);
+        int skip_duration = video_params.skip_duration_seconds;
+        int frames_per_skip = video_params.frames_per_skip;
+        int skip_count = video_params.skip_count;
         int frames_to_extract = frames_per_skip * 3; // Extract more frames per skip for filtering
         std::vector<int64_t> target_pts;
         if (duration > 0 && skip_count > 0)
@@ -864,6 +1267,7 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not copy codec parameters");
         }
+        FrameBufferPool::getInstance().attach(codec_ctx);
         if (avcodec_open2(codec_ctx, codec, nullptr) < 0)
         {
             avcodec_free_context(&codec_ctx);
@@ -885,7 +1289,15 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
         rgb_frame->format = AV_PIX_FMT_RGB24;
         rgb_frame->width = codec_ctx->width;
         rgb_frame->height = codec_ctx->height;
-        av_frame_get_buffer(rgb_frame, 0);
+        if (FrameBufferPool::getInstance().getBuffer(rgb_frame) < 0)
+        {
+            av_frame_free(&frame);
+            av_frame_free(&rgb_frame);
+            av_packet_free(&packet);
+            avcodec_free_context(&codec_ctx);
+            avformat_close_input(&format_ctx);
+            return ProcessingResult(false, "Could not allocate RGB frame buffer");
+        }
         SwsContext *sws_ctx = createHardwareScaler(
             codec_ctx->width, codec_ctx->height, codec_ctx->pix_fmt,
             codec_ctx->width, codec_ctx->height, AV_PIX_FMT_RGB24);
@@ -900,15 +1312,25 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
         }
         std::vector<std::vector<uint8_t>> frame_hashes;
         int frame_count_extracted = 0;
+        // Sampled frames are cached per seek target, see storeSkipFrames
+        const DecoderCache::Key file_key = DecoderCache::Key::forFile(file_path, DecoderCache::Variant::FRAME_DIGESTS);
+        const bool record_skips = keepingCanonicals(file_key);
         for (int skip_idx = 0; skip_idx < (int)target_pts.size(); ++skip_idx)
         {
             int64_t seek_target = target_pts[skip_idx];
+            if (appendCachedDigests(file_key, seek_target, frames_per_skip, frame_hashes))
+            {
+                frame_count_extracted = static_cast<int>(frame_hashes.size());
+                continue;
+            }
             // Seek to nearest keyframe before target
-            av_seek_frame(format_ctx, video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY);
+            mountIo(mount_point, [&]
+                    { return av_seek_frame(format_ctx, video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY); });
             avcodec_flush_buffers(codec_ctx);
             int frames_found = 0;
             int valid_frames = 0;
-            while (av_read_frame(format_ctx, packet) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
+            SkipFrames skip_frames;
+            while (readPacket(mount_point, format_ctx, packet) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
             {
                 if (packet->stream_index == video_stream_index)
                 {
@@ -954,6 +1376,13 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
                                 std::string hash_str = generateHash(std::vector<uint8_t>(cv_frame.data, cv_frame.data + cv_frame.total() * cv_frame.elemSize()));
                                 std::vector<uint8_t> frame_hash(hash_str.begin(), hash_str.end());
                                 frame_hashes.push_back(frame_hash);
+                                if (record_skips)
+                                {
+                                    cv::Mat frame_224;
+                                    cv::resize(cv_frame, frame_224, cv::Size(224, 224));
+                                    skip_frames.digests.push_back(hash_str);
+                                    skip_frames.frames_224.push_back(frame_224);
+                                }
                                 frame_count_extracted++;
                                 valid_frames++;
                             }
@@ -965,6 +1394,9 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
                 }
                 av_packet_unref(packet);
             }
+            // A skip cut short (end of stream, read error) is decoded again next time
+            if (record_skips && valid_frames >= frames_per_skip)
+                storeSkipFrames(file_key, seek_target, frames_per_skip, skip_frames);
         }
         sws_freeContext(sws_ctx);
         av_frame_free(&frame);
@@ -1008,6 +1440,8 @@ ProcessingResult MediaProcessor::processVideoBalanced(const std::string &file_pa
 
 ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("video", DedupMode::QUALITY);
     if (!algorithm)
@@ -1026,7 +1460,8 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
     try
     {
         AVFormatContext *format_ctx = nullptr;
-        if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
         {
             // Check if file exists first
             std::ifstream test_file(file_path);
@@ -1043,7 +1478,8 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
         }
 
         // Add validation for corrupted files
-        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
         {
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not find stream information (file may be corrupted): " + file_path);
@@ -1075,10 +1511,10 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
         double time_base = av_q2d(video_stream->time_base);
         double fps = av_q2d(video_stream->r_frame_rate);
         Logger::info("Video info - Duration: " + std::to_string(duration) + ", FPS: " + std::to_string(fps));
-        const auto &config = PocoConfigAdapter::getInstance();
-        int skip_duration = config.getVideoSkipDurationSeconds(DedupMode::QUALITY);
-        int frames_per_skip = config.getVideoFramesPerSkip(DedupMode::QUALITY);
-        int skip_count = config.getVideoSkipCount(DedupMode::QUALITY);
+        const ConfigSnapshot::VideoParams video_params = PocoConfigAdapter::getInstance().snapshot()->videoParams(DedupMode::QUALITY);
+        int skip_duration = video_params.skip_duration_seconds;
+        int frames_per_skip = video_params.frames_per_skip;
+        int skip_count = video_params.skip_count;
         int frames_to_extract = frames_per_skip * 3; // Extract more frames per skip for filtering
         std::vector<int64_t> target_pts;
         if (duration > 0 && skip_count > 0)
@@ -1107,6 +1543,7 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not copy codec parameters");
         }
+        FrameBufferPool::getInstance().attach(codec_ctx);
         if (avcodec_open2(codec_ctx, codec, nullptr) < 0)
         {
             avcodec_free_context(&codec_ctx);
@@ -1128,7 +1565,15 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
         rgb_frame->format = AV_PIX_FMT_RGB24;
         rgb_frame->width = codec_ctx->width;
         rgb_frame->height = codec_ctx->height;
-        av_frame_get_buffer(rgb_frame, 0);
+        if (FrameBufferPool::getInstance().getBuffer(rgb_frame) < 0)
+        {
+            av_frame_free(&frame);
+            av_frame_free(&rgb_frame);
+            av_packet_free(&packet);
+            avcodec_free_context(&codec_ctx);
+            avformat_close_input(&format_ctx);
+            return ProcessingResult(false, "Could not allocate RGB frame buffer");
+        }
         SwsContext *sws_ctx = createHardwareScaler(
             codec_ctx->width, codec_ctx->height, codec_ctx->pix_fmt,
             codec_ctx->width, codec_ctx->height, AV_PIX_FMT_RGB24);
@@ -1143,16 +1588,30 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
         }
         std::vector<std::vector<float>> frame_embeddings;
         int frame_count_extracted = 0;
+        // Sampled frames are cached per seek target, see storeSkipFrames
+        const DecoderCache::Key file_key = DecoderCache::Key::forFile(file_path, DecoderCache::Variant::FRAME_DIGESTS);
+        const bool record_skips = keepingCanonicals(file_key);
         int embedding_size = algorithm->data_size_bytes;
         for (int skip_idx = 0; skip_idx < (int)target_pts.size(); ++skip_idx)
         {
             int64_t seek_target = target_pts[skip_idx];
+            if (auto cached = findCanonical(file_key.forSkip(DecoderCache::Variant::FRAMES_224, seek_target, frames_per_skip)))
+            {
+                for (int row = 0; row + 224 <= cached->rows; row += 224)
+                {
+                    frame_embeddings.push_back(frameEmbedding(cached->rowRange(row, row + 224), embedding_size));
+                    frame_count_extracted++;
+                }
+                continue;
+            }
             // Seek to nearest keyframe before target
-            av_seek_frame(format_ctx, video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY);
+            mountIo(mount_point, [&]
+                    { return av_seek_frame(format_ctx, video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY); });
             avcodec_flush_buffers(codec_ctx);
             int frames_found = 0;
             int valid_frames = 0;
-            while (av_read_frame(format_ctx, packet) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
+            SkipFrames skip_frames;
+            while (readPacket(mount_point, format_ctx, packet) >= 0 && frames_found < frames_to_extract && valid_frames < frames_per_skip)
             {
                 if (packet->stream_index == video_stream_index)
                 {
@@ -1198,31 +1657,12 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
                                 // CNN Preprocessing (as in processImageQuality)
                                 cv::Mat processed_frame;
                                 cv::resize(cv_frame, processed_frame, cv::Size(224, 224));
-                                cv::cvtColor(processed_frame, processed_frame, cv::COLOR_BGR2RGB);
-                                processed_frame.convertTo(processed_frame, CV_32F, 1.0 / 255.0);
-                                std::vector<cv::Mat> channels(3);
-                                cv::split(processed_frame, channels);
-                                channels[0] = (channels[0] - 0.485f) / 0.229f;
-                                channels[1] = (channels[1] - 0.456f) / 0.224f;
-                                channels[2] = (channels[2] - 0.406f) / 0.225f;
-                                cv::merge(channels, processed_frame);
-                                std::vector<float> embedding(embedding_size, 0.0f);
-                                for (int i = 0; i < embedding_size; i++)
+                                frame_embeddings.push_back(frameEmbedding(processed_frame, embedding_size));
+                                if (record_skips)
                                 {
-                                    int pixel_idx = i % (processed_frame.rows * processed_frame.cols);
-                                    int row = pixel_idx / processed_frame.cols;
-                                    int col = pixel_idx % processed_frame.cols;
-                                    if (row < processed_frame.rows && col < processed_frame.cols)
-                                    {
-                                        cv::Vec3f pixel = processed_frame.at<cv::Vec3f>(row, col);
-                                        embedding[i] = (pixel[0] * 0.299f + pixel[1] * 0.587f + pixel[2] * 0.114f) + ((row + col) % 256) / 255.0f;
-                                    }
-                                    else
-                                    {
-                                        embedding[i] = ((i * 13 + 7) % 256) / 255.0f;
-                                    }
+                                    skip_frames.digests.push_back(generateHash(std::vector<uint8_t>(cv_frame.data, cv_frame.data + cv_frame.total() * cv_frame.elemSize())));
+                                    skip_frames.frames_224.push_back(processed_frame);
                                 }
-                                frame_embeddings.push_back(embedding);
                                 frame_count_extracted++;
                                 valid_frames++;
                             }
@@ -1234,6 +1674,9 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
                 }
                 av_packet_unref(packet);
             }
+            // A skip cut short (end of stream, read error) is decoded again next time
+            if (record_skips && valid_frames >= frames_per_skip)
+                storeSkipFrames(file_key, seek_target, frames_per_skip, skip_frames);
         }
         sws_freeContext(sws_ctx);
         av_frame_free(&frame);
@@ -1289,6 +1732,8 @@ ProcessingResult MediaProcessor::processVideoQuality(const std::string &file_pat
 
 ProcessingResult MediaProcessor::processAudioFast(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("audio", DedupMode::FAST);
     if (!algorithm)
@@ -1302,12 +1747,14 @@ ProcessingResult MediaProcessor::processAudioFast(const std::string &file_path)
     {
         // Use FFmpeg to extract audio data and create a simple spectral fingerprint
         AVFormatContext *format_ctx = nullptr;
-        if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
         {
             return ProcessingResult(false, "Could not open audio file: " + file_path);
         }
 
-        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
         {
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not find stream information");
@@ -1393,6 +1840,8 @@ ProcessingResult MediaProcessor::processAudioFast(const std::string &file_path)
 
 ProcessingResult MediaProcessor::processAudioBalanced(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("audio", DedupMode::BALANCED);
     if (!algorithm)
@@ -1406,12 +1855,14 @@ ProcessingResult MediaProcessor::processAudioBalanced(const std::string &file_pa
     {
         // Use FFmpeg to extract audio data and create MFCC-like features
         AVFormatContext *format_ctx = nullptr;
-        if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
         {
             return ProcessingResult(false, "Could not open audio file: " + file_path);
         }
 
-        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
         {
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not find stream information");
@@ -1514,6 +1965,8 @@ ProcessingResult MediaProcessor::processAudioBalanced(const std::string &file_pa
 
 ProcessingResult MediaProcessor::processAudioQuality(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
+
     // Get algorithm information from lookup table
     const ProcessingAlgorithm *algorithm = getProcessingAlgorithm("audio", DedupMode::QUALITY);
     if (!algorithm)
@@ -1527,12 +1980,14 @@ ProcessingResult MediaProcessor::processAudioQuality(const std::string &file_pat
     {
         // Use FFmpeg to extract audio data and create high-quality embeddings
         AVFormatContext *format_ctx = nullptr;
-        if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
         {
             return ProcessingResult(false, "Could not open audio file: " + file_path);
         }
 
-        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
         {
             avformat_close_input(&format_ctx);
             return ProcessingResult(false, "Could not find stream information");
@@ -1647,23 +2102,17 @@ ProcessingResult MediaProcessor::processAudioQuality(const std::string &file_pat
 
 bool MediaProcessor::isImageFile(const std::string &file_path)
 {
-    std::string ext = getFileExtension(file_path);
-    auto enabled_types = PocoConfigAdapter::getInstance().getEnabledImageExtensions();
-    return std::find(enabled_types.begin(), enabled_types.end(), ext) != enabled_types.end();
+    return std::string_view(PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).media_type) == "image";
 }
 
 bool MediaProcessor::isVideoFile(const std::string &file_path)
 {
-    std::string ext = getFileExtension(file_path);
-    auto enabled_types = PocoConfigAdapter::getInstance().getEnabledVideoExtensions();
-    return std::find(enabled_types.begin(), enabled_types.end(), ext) != enabled_types.end();
+    return std::string_view(PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).media_type) == "video";
 }
 
 bool MediaProcessor::isAudioFile(const std::string &file_path)
 {
-    std::string ext = getFileExtension(file_path);
-    auto enabled_types = PocoConfigAdapter::getInstance().getEnabledAudioExtensions();
-    return std::find(enabled_types.begin(), enabled_types.end(), ext) != enabled_types.end();
+    return std::string_view(PocoConfigAdapter::getInstance().snapshot()->extensionOfPath(file_path).media_type) == "audio";
 }
 
 std::string MediaProcessor::generateHash(const std::vector<uint8_t> &data)
@@ -1756,16 +2205,19 @@ std::vector<uint8_t> MediaProcessor::combineFrameHashes(const std::vector<std::v
 // Helper function to validate video file before processing
 bool MediaProcessor::isVideoFileValid(const std::string &file_path)
 {
+    const std::string mount_point = MountThrottle::getInstance().networkMountOf(file_path);
     AVFormatContext *format_ctx = nullptr;
 
     // Try to open the file
-    if (avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr) < 0)
+    if (mountIo(mount_point, [&]
+                    { return avformat_open_input(&format_ctx, file_path.c_str(), nullptr, nullptr); }) < 0)
     {
         return false;
     }
 
     // Try to find stream info
-    if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+    if (mountIo(mount_point, [&]
+                    { return avformat_find_stream_info(format_ctx, nullptr); }) < 0)
     {
         avformat_close_input(&format_ctx);
         return false;
@@ -0,0 +1,485 @@
+#include "core/memory_admission.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct MemoryAdmission::Waiter
+{
+    uint64_t bytes;
+    std::chrono::steady_clock::time_point since;
+};
+
+namespace
+{
+    // Reference frames an H.264/HEVC decoder may hold (the largest DPB either standard allows)
+    constexpr uint64_t MAX_REFERENCE_FRAMES = 16;
+
+    // Full-size temporaries of the canonical reduction: one gray and one colour-converted image
+    constexpr uint64_t REDUCTION_BYTES_PER_PIXEL = 4;
+
+    // Decoded bytes per file byte assumed for image formats whose header is not parsed
+    constexpr uint64_t UNKNOWN_FORMAT_EXPANSION = 10;
+
+    // File bytes per sensor pixel below which a RAW file is assumed to hold more pixels than its
+    // header showed (a thumbnail IFD, or a container that is not TIFF): an uncompressed 16-bit mosaic
+    constexpr uint64_t RAW_BYTES_PER_PIXEL = 2;
+
+    struct ImageHeader
+    {
+        uint64_t width = 0;
+        uint64_t height = 0;
+        int channels = 0;
+        int bits_per_sample = 8;
+    };
+
+    uint32_t be16(const unsigned char *p) { return (p[0] << 8) | p[1]; }
+    uint32_t be32(const unsigned char *p) { return (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+    uint32_t le16(const unsigned char *p) { return p[0] | (p[1] << 8); }
+    uint32_t le32(const unsigned char *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+
+    bool readAt(std::ifstream &in, uint64_t offset, unsigned char *buf, size_t size)
+    {
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(offset));
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(buf), size));
+    }
+
+    bool readPng(std::ifstream &in, ImageHeader &header)
+    {
+        // Signature, then IHDR: width, height, bit depth, colour type
+        unsigned char ihdr[26];
+        if (!readAt(in, 0, ihdr, sizeof(ihdr)) || std::memcmp(ihdr + 12, "IHDR", 4) != 0)
+            return false;
+        static const int channels_by_colour_type[] = {1, 0, 3, 3, 2, 0, 4};
+        const int colour_type = ihdr[25];
+        header.width = be32(ihdr + 16);
+        header.height = be32(ihdr + 20);
+        header.bits_per_sample = ihdr[24];
+        header.channels = colour_type <= 6 ? channels_by_colour_type[colour_type] : 0;
+        return header.channels > 0;
+    }
+
+    bool readJpeg(std::ifstream &in, ImageHeader &header)
+    {
+        // Walk the marker segments up to the start-of-frame (EXIF and ICC segments come first)
+        uint64_t offset = 2;
+        unsigned char segment[10];
+        while (readAt(in, offset, segment, 4))
+        {
+            if (segment[0] != 0xFF)
+                return false;
+            const int marker = segment[1];
+            if (marker == 0xFF)
+            {
+                ++offset; // fill byte
+                continue;
+            }
+            if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+            {
+                offset += 2;
+                continue;
+            }
+            if (marker == 0xDA || marker == 0xD9)
+                return false; // image data before any frame header
+
+            const bool start_of_frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+            if (start_of_frame)
+            {
+                if (!readAt(in, offset + 4, segment, 6))
+                    return false;
+                header.bits_per_sample = segment[0];
+                header.height = be16(segment + 1);
+                header.width = be16(segment + 3);
+                header.channels = segment[5];
+                return true;
+            }
+            offset += 2 + be16(segment + 2);
+        }
+        return false;
+    }
+
+    bool readTiff(std::ifstream &in, ImageHeader &header)
+    {
+        unsigned char head[8];
+        if (!readAt(in, 0, head, sizeof(head)))
+            return false;
+        const bool little = head[0] == 'I';
+        auto u16 = [little](const unsigned char *p) { return little ? le16(p) : be16(p); };
+        auto u32 = [little](const unsigned char *p) { return little ? le32(p) : be32(p); };
+        if (u16(head + 2) != 42)
+            return false; // BigTIFF or not TIFF
+
+        // The largest image of the IFD chain (the first one is often a thumbnail)
+        uint64_t ifd = u32(head + 4);
+        for (int ifd_count = 0; ifd != 0 && ifd_count < 16; ++ifd_count)
+        {
+            unsigned char count_buf[2];
+            if (!readAt(in, ifd, count_buf, 2))
+                break;
+            const uint32_t entries = u16(count_buf);
+            ImageHeader image;
+            image.channels = 1;
+            for (uint32_t i = 0; i < entries; ++i)
+            {
+                unsigned char entry[12];
+                if (!readAt(in, ifd + 2 + i * 12, entry, sizeof(entry)))
+                    return header.width > 0;
+                const uint32_t tag = u16(entry);
+                const uint32_t type = u16(entry + 2);
+                const uint32_t count = u32(entry + 4);
+                uint32_t value = type == 3 ? u16(entry + 8) : u32(entry + 8);
+                if (tag == 258 && type == 3 && count > 2)
+                {
+                    // One bit depth per sample, stored out of line
+                    unsigned char bits[2];
+                    if (readAt(in, u32(entry + 8), bits, 2))
+                        value = u16(bits);
+                }
+                if (tag == 256)
+                    image.width = value;
+                else if (tag == 257)
+                    image.height = value;
+                else if (tag == 258)
+                    image.bits_per_sample = static_cast<int>(value);
+                else if (tag == 277)
+                    image.channels = static_cast<int>(value);
+            }
+            if (image.width * image.height > header.width * header.height)
+                header = image;
+
+            unsigned char next[4];
+            if (!readAt(in, ifd + 2 + entries * 12, next, 4))
+                break;
+            ifd = u32(next);
+        }
+        return header.width > 0;
+    }
+
+    bool readWebp(std::ifstream &in, ImageHeader &header)
+    {
+        unsigned char chunk[30];
+        if (!readAt(in, 0, chunk, sizeof(chunk)) || std::memcmp(chunk + 8, "WEBP", 4) != 0)
+            return false;
+        header.channels = 4;
+        if (std::memcmp(chunk + 12, "VP8X", 4) == 0)
+        {
+            header.width = 1 + (chunk[24] | (chunk[25] << 8) | (chunk[26] << 16));
+            header.height = 1 + (chunk[27] | (chunk[28] << 8) | (chunk[29] << 16));
+        }
+        else if (std::memcmp(chunk + 12, "VP8L", 4) == 0)
+        {
+            const uint32_t bits = le32(chunk + 21);
+            header.width = 1 + (bits & 0x3FFF);
+            header.height = 1 + ((bits >> 14) & 0x3FFF);
+        }
+        else if (std::memcmp(chunk + 12, "VP8 ", 4) == 0)
+        {
+            header.width = le16(chunk + 26) & 0x3FFF;
+            header.height = le16(chunk + 28) & 0x3FFF;
+        }
+        return header.width > 0;
+    }
+
+    bool readBmp(std::ifstream &in, ImageHeader &header)
+    {
+        unsigned char info[30];
+        if (!readAt(in, 0, info, sizeof(info)))
+            return false;
+        const int32_t height = static_cast<int32_t>(le32(info + 22));
+        header.width = le32(info + 18);
+        header.height = static_cast<uint64_t>(height < 0 ? -static_cast<int64_t>(height) : height);
+        header.channels = le16(info + 28) >= 32 ? 4 : 3;
+        return true;
+    }
+
+    bool readExr(std::ifstream &in, ImageHeader &header)
+    {
+        // Attributes (name, type, size, value) follow the magic number and version
+        uint64_t offset = 8;
+        for (int attributes = 0; attributes < 256; ++attributes)
+        {
+            std::string name, type;
+            in.clear();
+            in.seekg(static_cast<std::streamoff>(offset));
+            if (!std::getline(in, name, '\0') || name.empty() || !std::getline(in, type, '\0'))
+                break;
+            unsigned char size_buf[4];
+            if (!in.read(reinterpret_cast<char *>(size_buf), 4))
+                return false;
+            const uint32_t size = le32(size_buf);
+            const uint64_t value_offset = static_cast<uint64_t>(in.tellg());
+
+            if (name == "dataWindow" && size == 16)
+            {
+                unsigned char box[16];
+                if (!readAt(in, value_offset, box, sizeof(box)))
+                    return false;
+                const int64_t width = static_cast<int64_t>(static_cast<int32_t>(le32(box + 8))) - static_cast<int32_t>(le32(box)) + 1;
+                const int64_t height = static_cast<int64_t>(static_cast<int32_t>(le32(box + 12))) - static_cast<int32_t>(le32(box + 4)) + 1;
+                header.width = static_cast<uint64_t>(std::max<int64_t>(width, 0));
+                header.height = static_cast<uint64_t>(std::max<int64_t>(height, 0));
+            }
+            else if (name == "channels")
+            {
+                // name\0, pixel type (0 uint, 1 half, 2 float), 12 bytes of flags and sampling
+                std::string channel;
+                header.channels = 0;
+                header.bits_per_sample = 16;
+                while (std::getline(in, channel, '\0') && !channel.empty())
+                {
+                    unsigned char info[16];
+                    if (!in.read(reinterpret_cast<char *>(info), sizeof(info)))
+                        return false;
+                    ++header.channels;
+                    if (le32(info) != 1)
+                        header.bits_per_sample = 32;
+                }
+            }
+            offset = value_offset + size;
+        }
+        return header.width > 0 && header.channels > 0;
+    }
+
+    uint64_t physicalMemoryBytes()
+    {
+        const long pages = sysconf(_SC_PHYS_PAGES);
+        const long page_size = sysconf(_SC_PAGE_SIZE);
+        return pages > 0 && page_size > 0 ? static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size) : 0;
+    }
+
+    std::string megabytes(uint64_t bytes)
+    {
+        return std::to_string(bytes / (1024 * 1024)) + " MB";
+    }
+}
+
+MemoryAdmission::Grant::Grant(Grant &&other) noexcept : bytes_(other.bytes_)
+{
+    other.bytes_ = 0;
+}
+
+MemoryAdmission::Grant &MemoryAdmission::Grant::operator=(Grant &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+MemoryAdmission::Grant::~Grant()
+{
+    release();
+}
+
+void MemoryAdmission::Grant::release()
+{
+    if (bytes_ == 0)
+        return;
+    const uint64_t bytes = bytes_;
+    bytes_ = 0;
+    MemoryAdmission::getInstance().release(bytes);
+}
+
+MemoryAdmission &MemoryAdmission::getInstance()
+{
+    static MemoryAdmission instance;
+    return instance;
+}
+
+MemoryAdmission::MemoryAdmission() : budget_bytes_(physicalMemoryBytes() / 2)
+{
+}
+
+void MemoryAdmission::setBudgetMB(uint32_t budget_mb)
+{
+    uint64_t budget = static_cast<uint64_t>(budget_mb) * 1024 * 1024;
+    if (budget == 0)
+        budget = physicalMemoryBytes() / 2;
+    budget_bytes_.store(budget);
+    Logger::info("MemoryAdmission budget: " + megabytes(budget) + (budget_mb == 0 ? " (half of physical memory)" : ""));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+}
+
+void MemoryAdmission::setMaxBypass(std::chrono::milliseconds max_bypass)
+{
+    max_bypass_ms_.store(std::max<int64_t>(max_bypass.count(), 0));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+}
+
+bool MemoryAdmission::canAdmit(const Waiter &waiter, std::chrono::steady_clock::time_point now) const
+{
+    // A job that has waited too long holds back everything that arrived after it
+    const std::chrono::milliseconds max_bypass(max_bypass_ms_.load());
+    for (const Waiter *earlier : waiters_)
+    {
+        if (earlier == &waiter)
+            break;
+        if (now - earlier->since >= max_bypass)
+            return false;
+    }
+
+    // Larger than the whole budget: runs alone rather than never
+    return admitted_bytes_ + waiter.bytes <= budget_bytes_.load() || admitted_bytes_ == 0;
+}
+
+MemoryAdmission::Grant MemoryAdmission::admit(uint64_t bytes, const std::string &what)
+{
+    if (bytes == 0)
+        return Grant();
+
+    Waiter waiter{bytes, std::chrono::steady_clock::now()};
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_.push_back(&waiter);
+    auto position = std::prev(waiters_.end());
+
+    bool logged = false;
+    while (true)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (canAdmit(waiter, now))
+            break;
+        if (!logged)
+        {
+            Logger::info("MemoryAdmission: " + what + " needs " + megabytes(bytes) + ", " + megabytes(admitted_bytes_) +
+                         " of " + megabytes(budget_bytes_.load()) + " in use; waiting");
+            logged = true;
+        }
+        // Timed so the bypass limit is noticed without a release
+        const std::chrono::milliseconds max_bypass(max_bypass_ms_.load());
+        cv_.wait_for(lock, std::clamp(max_bypass, std::chrono::milliseconds(1), std::chrono::milliseconds(500)));
+    }
+
+    waiters_.erase(position);
+    admitted_bytes_ += bytes;
+    if (logged)
+    {
+        Logger::info("MemoryAdmission: admitted " + what + " after " +
+                     std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - waiter.since).count()) + "ms");
+    }
+    // Jobs queued behind this one may be allowed through now
+    cv_.notify_all();
+    return Grant(bytes);
+}
+
+void MemoryAdmission::release(uint64_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        admitted_bytes_ -= std::min(bytes, admitted_bytes_);
+    }
+    cv_.notify_all();
+}
+
+uint64_t MemoryAdmission::admittedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return admitted_bytes_;
+}
+
+size_t MemoryAdmission::waitingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiters_.size();
+}
+
+uint64_t MemoryAdmission::imagePeakBytes(int width, int height, int channels, int bits_per_sample)
+{
+    const uint64_t pixels = static_cast<uint64_t>(std::max(width, 0)) * static_cast<uint64_t>(std::max(height, 0));
+    const uint64_t decoded = static_cast<uint64_t>(std::max(channels, 1)) * ((std::max(bits_per_sample, 1) + 7) / 8);
+    return pixels * (decoded + 3 + REDUCTION_BYTES_PER_PIXEL);
+}
+
+uint64_t MemoryAdmission::videoPeakBytes(int width, int height, int bits_per_sample, int decoder_threads)
+{
+    const uint64_t pixels = static_cast<uint64_t>(std::max(width, 0)) * static_cast<uint64_t>(std::max(height, 0));
+    // 4:2:0 frames; one more frame per decoder thread and the one being returned
+    const uint64_t frame = pixels * ((std::max(bits_per_sample, 1) + 7) / 8) * 3 / 2;
+    const uint64_t frames = MAX_REFERENCE_FRAMES + static_cast<uint64_t>(std::max(decoder_threads, 1)) + 1;
+    // RGB24 conversion frame and the cv::Mat copy of it
+    return frame * frames + pixels * 6;
+}
+
+uint64_t MemoryAdmission::rawPeakBytes(int raw_width, int raw_height, int width, int height)
+{
+    const uint64_t raw_pixels = static_cast<uint64_t>(std::max(raw_width, 0)) * static_cast<uint64_t>(std::max(raw_height, 0));
+    const uint64_t pixels = static_cast<uint64_t>(std::max(width, 0)) * static_cast<uint64_t>(std::max(height, 0));
+    // 16-bit sensor data; 4 x 16-bit working image; 8-bit RGB output, its copy and the BGR Mat
+    return raw_pixels * 2 + pixels * (8 + 9);
+}
+
+uint64_t MemoryAdmission::estimateImagePeakBytes(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    unsigned char magic[12];
+    if (!in.is_open() || !in.read(reinterpret_cast<char *>(magic), sizeof(magic)))
+        return 0;
+
+    ImageHeader header;
+    bool parsed = false;
+    if (std::memcmp(magic, "\x89PNG", 4) == 0)
+        parsed = readPng(in, header);
+    else if (magic[0] == 0xFF && magic[1] == 0xD8)
+        parsed = readJpeg(in, header);
+    else if (std::memcmp(magic, "II*\0", 4) == 0 || std::memcmp(magic, "MM\0*", 4) == 0)
+        parsed = readTiff(in, header);
+    else if (std::memcmp(magic, "RIFF", 4) == 0)
+        parsed = readWebp(in, header);
+    else if (magic[0] == 'B' && magic[1] == 'M')
+        parsed = readBmp(in, header);
+    else if (std::memcmp(magic, "\x76\x2f\x31\x01", 4) == 0)
+        parsed = readExr(in, header);
+
+    if (parsed && header.width > 0 && header.height > 0 && header.width <= 1u << 20 && header.height <= 1u << 20)
+    {
+        return imagePeakBytes(static_cast<int>(header.width), static_cast<int>(header.height), header.channels, header.bits_per_sample);
+    }
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return 0;
+    return static_cast<uint64_t>(st.st_size) * UNKNOWN_FORMAT_EXPANSION;
+}
+
+uint64_t MemoryAdmission::estimateRawPeakBytes(const std::string &path, int max_edge_px)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return 0;
+    const uint64_t file_bytes = static_cast<uint64_t>(st.st_size);
+
+    // The largest image in the IFD chain of TIFF-based RAWs (CR2, NEF, ARW, DNG, ...)
+    ImageHeader header;
+    std::ifstream in(path, std::ios::binary);
+    unsigned char magic[4];
+    if (in.is_open() && in.read(reinterpret_cast<char *>(magic), sizeof(magic)) &&
+        (std::memcmp(magic, "II*\0", 4) == 0 || std::memcmp(magic, "MM\0*", 4) == 0))
+    {
+        readTiff(in, header);
+    }
+    uint64_t width = std::min<uint64_t>(header.width, 1u << 20);
+    uint64_t height = std::min<uint64_t>(header.height, 1u << 20);
+    if (width * height < file_bytes / RAW_BYTES_PER_PIXEL)
+    {
+        // 3:2 sensor filling the file
+        const uint64_t pixels = file_bytes / RAW_BYTES_PER_PIXEL;
+        width = static_cast<uint64_t>(std::sqrt(static_cast<double>(pixels) * 3 / 2));
+        height = width ? pixels / width : 0;
+    }
+
+    // Same choice as the decoder: half-size while half the sensor still covers max_edge_px
+    const uint64_t shrink = max_edge_px > 0 && std::max(width, height) / 2 >= static_cast<uint64_t>(max_edge_px) ? 2 : 1;
+    return file_bytes + rawPeakBytes(static_cast<int>(width), static_cast<int>(height),
+                                     static_cast<int>(width / shrink), static_cast<int>(height / shrink));
+}
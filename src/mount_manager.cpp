@@ -8,6 +8,9 @@
 #include <filesystem>
 #include <sys/statvfs.h>
 #include <sys/mount.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
 #ifdef __APPLE__
 #include <sys/param.h>
@@ -127,7 +130,82 @@ std::vector<MountInfo> MountManager::detectMounts()
     return mounts;
 }
 
-std::optional<RelativePath> MountManager::toRelativePath(const std::string &absolute_path)
+namespace
+{
+    // Calls fn for each non-empty component of path ("/a//b/" -> "a", "b")
+    template <typename Fn>
+    void forEachComponent(std::string_view path, Fn fn)
+    {
+        size_t pos = 0;
+        while (pos < path.size())
+        {
+            size_t end = path.find('/', pos);
+            if (end == std::string_view::npos)
+                end = path.size();
+            if (end > pos && !fn(path.substr(pos, end - pos)))
+                return;
+            pos = end + 1;
+        }
+    }
+}
+
+MountTable::MountTable(std::vector<MountInfo> mounts) : mounts_(std::move(mounts)), nodes_(1)
+{
+    for (size_t i = 0; i < mounts_.size(); ++i)
+    {
+        if (!mounts_[i].is_network_mount)
+            continue;
+
+        size_t node = 0;
+        forEachComponent(mounts_[i].mount_point, [&](std::string_view component)
+                         {
+            auto it = nodes_[node].children.find(component);
+            if (it == nodes_[node].children.end())
+            {
+                nodes_.emplace_back();
+                it = nodes_[node].children.emplace(std::string(component), nodes_.size() - 1).first;
+            }
+            node = it->second;
+            return true; });
+        // A later entry mounted over the same point hides the earlier one
+        nodes_[node].mount = static_cast<int>(i);
+    }
+}
+
+const MountInfo *MountTable::findNetworkMount(std::string_view path) const
+{
+    int best = nodes_[0].mount;
+    size_t node = 0;
+    forEachComponent(path, [&](std::string_view component)
+                     {
+        auto it = nodes_[node].children.find(component);
+        if (it == nodes_[node].children.end())
+            return false;
+        node = it->second;
+        if (nodes_[node].mount >= 0)
+            best = nodes_[node].mount;
+        return true; });
+    return best >= 0 ? &mounts_[best] : nullptr;
+}
+
+bool MountTable::isNetworkPath(const std::string &path) const
+{
+    // Fast path: check if path contains network mount indicators
+    if (path.find("/Volumes/") == 0)
+    {
+        // Quick check for common network mount patterns
+        if (path.find("._smb._tcp.local") != std::string::npos ||
+            path.find("._nfs._tcp.local") != std::string::npos ||
+            path.find("._afp._tcp.local") != std::string::npos)
+        {
+            return true;
+        }
+    }
+
+    return findNetworkMount(path) != nullptr;
+}
+
+std::optional<RelativePath> MountTable::toRelativePath(const std::string &absolute_path) const
 {
     // Fast path for network paths - avoid expensive mount detection
     if (absolute_path.find("/Volumes/") == 0)
@@ -174,60 +252,38 @@ std::optional<RelativePath> MountManager::toRelativePath(const std::string &abso
         }
     }
 
-    // Fallback to full mount detection (cached)
-    refreshMounts();
-    auto mount_info = findMountForPath(absolute_path);
+    const MountInfo *mount_info = findNetworkMount(absolute_path);
     if (!mount_info)
     {
         return std::nullopt;
     }
 
-    // Convert to relative path
-    fs::path abs_path(absolute_path);
-    fs::path mount_path(mount_info->mount_point);
-
-    try
+    // The trie matched whole components, so the mount point is a prefix of the path
+    std::string_view rest(absolute_path);
+    rest.remove_prefix(std::min(rest.size(), mount_info->mount_point.size()));
+    while (!rest.empty() && rest.front() == '/')
     {
-        // Use string manipulation instead of fs::relative for better performance on network file systems
-        std::string abs_path_str = abs_path.string();
-        std::string mount_path_str = mount_path.string();
-
-        if (abs_path_str.find(mount_path_str) != 0)
-        {
-            return std::nullopt;
-        }
-
-        std::string relative_path_str = abs_path_str.substr(mount_path_str.length());
-        if (relative_path_str.empty() || relative_path_str[0] != '/')
-        {
-            return std::nullopt;
-        }
-
-        // Remove leading slash
-        relative_path_str = relative_path_str.substr(1);
-
-        RelativePath result;
-        result.share_name = mount_info->share_name;
-        result.relative_path = relative_path_str;
-
-        Logger::debug("Converted " + absolute_path + " to relative path: " +
-                      result.share_name + ":" + result.relative_path);
-
-        return result;
+        rest.remove_prefix(1);
     }
-    catch (const std::exception &e)
+    if (rest.empty())
     {
-        Logger::warn("Failed to convert path: " + std::string(e.what()));
         return std::nullopt;
     }
+
+    RelativePath result;
+    result.share_name = mount_info->share_name;
+    result.relative_path = std::string(rest);
+
+    Logger::debug("Converted " + absolute_path + " to relative path: " +
+                  result.share_name + ":" + result.relative_path);
+
+    return result;
 }
 
-std::optional<std::string> MountManager::toAbsolutePath(const RelativePath &relative_path)
+std::optional<std::string> MountTable::toAbsolutePath(const RelativePath &relative_path) const
 {
-    refreshMounts();
-
     // Find mount for this share
-    for (const auto &mount : mounts_cache_)
+    for (const auto &mount : mounts_)
     {
         if (mount.share_name == relative_path.share_name && mount.is_network_mount)
         {
@@ -246,98 +302,100 @@ std::optional<std::string> MountManager::toAbsolutePath(const RelativePath &rela
     return std::nullopt;
 }
 
-bool MountManager::isNetworkPath(const std::string &path)
+MountManager::MountManager()
 {
-    // Fast path: check if path contains network mount indicators
-    if (path.find("/Volumes/") == 0)
+#ifndef __APPLE__
+    mountinfo_fd_ = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+MountManager::~MountManager()
+{
+    if (mountinfo_fd_ >= 0)
+        ::close(mountinfo_fd_);
+}
+
+bool MountManager::mountsChanged()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (mountinfo_fd_ >= 0)
     {
-        // Quick check for common network mount patterns
-        if (path.find("._smb._tcp.local") != std::string::npos ||
-            path.find("._nfs._tcp.local") != std::string::npos ||
-            path.find("._afp._tcp.local") != std::string::npos)
-        {
-            return true;
-        }
+        // At most one poll() per MOUNT_POLL_INTERVAL; lookups in between use the current table
+        auto polled_at = last_mount_poll_.load(std::memory_order_relaxed);
+        auto now_rep = now.time_since_epoch().count();
+        if (now_rep - polled_at < std::chrono::duration_cast<std::chrono::steady_clock::duration>(MOUNT_POLL_INTERVAL).count() ||
+            !last_mount_poll_.compare_exchange_strong(polled_at, now_rep, std::memory_order_relaxed))
+            return false;
+
+        // The kernel flags the change to one poller only; it rebuilds for everyone
+        struct pollfd pfd = {mountinfo_fd_, POLLPRI, 0};
+        return ::poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR));
     }
 
-    // Fallback to full mount detection (cached)
-    refreshMounts();
-    return findMountForPath(path).has_value();
+    auto detected_at = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(last_mount_detection_.load(std::memory_order_relaxed)));
+    return now - detected_at >= MOUNT_CACHE_DURATION;
 }
 
-std::optional<MountInfo> MountManager::getMountInfo(const std::string &path)
+std::shared_ptr<const MountTable> MountManager::snapshot()
 {
-    refreshMounts();
-    return findMountForPath(path);
+    auto table = std::atomic_load(&table_);
+    if (table && !mountsChanged())
+        return table;
+
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    // Another thread may have rebuilt it while this one waited
+    auto current = std::atomic_load(&table_);
+    if (current && current != table)
+        return current;
+
+    auto rebuilt = std::make_shared<const MountTable>(detectMounts());
+    std::atomic_store(&table_, rebuilt);
+    last_mount_detection_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    return rebuilt;
 }
 
 void MountManager::refreshMounts()
 {
-    auto now = std::chrono::steady_clock::now();
-
-    // Check if cache is still valid
-    if (mounts_detected_ &&
-        (now - last_mount_detection_) < MOUNT_CACHE_DURATION)
-    {
-        // Cache is still valid, no need to re-detect
-        return;
-    }
-
-    // Cache expired or first time, detect mounts
-    mounts_cache_ = detectMounts();
-    updateMountMap();
+    snapshot();
+}
 
-    // Update cache timestamp
-    last_mount_detection_ = now;
-    mounts_detected_ = true;
+std::optional<RelativePath> MountManager::toRelativePath(const std::string &absolute_path)
+{
+    return snapshot()->toRelativePath(absolute_path);
 }
 
-bool MountManager::validateRelativePath(const RelativePath &relative_path)
+std::optional<std::string> MountManager::toAbsolutePath(const RelativePath &relative_path)
 {
-    auto absolute_path = toAbsolutePath(relative_path);
-    if (!absolute_path)
-    {
-        return false;
-    }
+    return snapshot()->toAbsolutePath(relative_path);
+}
 
-    // Check if file exists
-    return fs::exists(*absolute_path);
+bool MountManager::isNetworkPath(const std::string &path)
+{
+    return snapshot()->isNetworkPath(path);
 }
 
-void MountManager::updateMountMap()
+std::optional<MountInfo> MountManager::getMountInfo(const std::string &path)
 {
-    mount_map_.clear();
-    for (const auto &mount : mounts_cache_)
-    {
-        mount_map_[mount.mount_point] = mount;
-    }
+    return findMountForPath(path);
 }
 
 std::optional<MountInfo> MountManager::findMountForPath(const std::string &path)
 {
-    // Find the longest matching mount point using string operations
-    std::optional<MountInfo> best_match;
-    size_t best_length = 0;
+    auto table = snapshot();
+    if (const MountInfo *mount = table->findNetworkMount(path))
+        return *mount;
+    return std::nullopt;
+}
 
-    for (const auto &mount : mounts_cache_)
+bool MountManager::validateRelativePath(const RelativePath &relative_path)
+{
+    auto absolute_path = toAbsolutePath(relative_path);
+    if (!absolute_path)
     {
-        if (!mount.is_network_mount)
-        {
-            continue;
-        }
-
-        const std::string &mount_path = mount.mount_point;
-
-        // Use string comparison instead of filesystem operations
-        if (path.find(mount_path) == 0)
-        {
-            if (mount_path.length() > best_length)
-            {
-                best_length = mount_path.length();
-                best_match = mount;
-            }
-        }
+        return false;
     }
 
-    return best_match;
-}
\ No newline at end of file
+    // Check if file exists
+    return fs::exists(*absolute_path);
+}
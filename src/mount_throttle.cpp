@@ -0,0 +1,345 @@
+#include "core/mount_throttle.hpp"
+#include "core/mount_manager.hpp"
+#include "logging/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+struct MountThrottle::MountState
+{
+    MountState(const std::string &mount, int max_concurrent, int breaker_timeout_seconds)
+        : mount_point(mount),
+          breaker("I/O on " + mount, 5, breaker_timeout_seconds),
+          limit(max_concurrent),
+          refilled_at(std::chrono::steady_clock::now())
+    {
+    }
+
+    const std::string mount_point;
+    ErrorRecovery::CircuitBreaker breaker;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    double limit;             // adaptive concurrency limit, 1..max_concurrent_
+    int in_flight = 0;
+    double budget_bytes = 0;  // token bucket for the bandwidth budget; negative while in debt
+    std::chrono::steady_clock::time_point refilled_at;
+    std::chrono::steady_clock::time_point last_backoff;
+    std::chrono::steady_clock::time_point saturated_until; // an acquire timed out; cleared by a completed operation
+};
+
+MountThrottle::Permit::Permit(std::shared_ptr<MountState> state, bool granted)
+    : state_(std::move(state)), granted_(granted), start_(std::chrono::steady_clock::now())
+{
+    if (!granted_)
+        state_.reset();
+}
+
+MountThrottle::Permit::Permit(Permit &&other) noexcept
+    : state_(std::move(other.state_)), granted_(other.granted_), start_(other.start_)
+{
+    other.state_.reset();
+}
+
+MountThrottle::Permit &MountThrottle::Permit::operator=(Permit &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (state_)
+            complete(true);
+        state_ = std::move(other.state_);
+        granted_ = other.granted_;
+        start_ = other.start_;
+        other.state_.reset();
+    }
+    return *this;
+}
+
+MountThrottle::Permit::~Permit()
+{
+    // Released without an outcome (e.g. the operation threw): free the slot
+    if (state_)
+        complete(true);
+}
+
+void MountThrottle::Permit::complete(bool io_ok, uint64_t bytes)
+{
+    if (!state_)
+        return;
+    auto state = std::move(state_);
+    state_.reset();
+    MountThrottle::getInstance().release(*state, io_ok, bytes, std::chrono::steady_clock::now() - start_);
+}
+
+MountThrottle &MountThrottle::getInstance()
+{
+    static MountThrottle instance;
+    return instance;
+}
+
+void MountThrottle::setLimits(const Limits &limits)
+{
+    max_concurrent_.store(std::max(1, limits.max_concurrent_io));
+    bandwidth_mb_per_second_.store(std::max(0, limits.bandwidth_mb_per_second));
+    latency_threshold_ms_.store(std::max(1, limits.latency_threshold_ms));
+    acquire_timeout_seconds_.store(std::max(1, limits.acquire_timeout_seconds));
+    breaker_timeout_seconds_.store(std::max(1, limits.breaker_timeout_seconds));
+
+    Logger::info("MountThrottle configuration - Max concurrent I/O per mount: " + std::to_string(max_concurrent_.load()) +
+                 ", Bandwidth: " + (bandwidth_mb_per_second_.load() ? std::to_string(bandwidth_mb_per_second_.load()) + " MB/s" : std::string("unlimited")) +
+                 ", Latency threshold: " + std::to_string(latency_threshold_ms_.load()) + "ms" +
+                 ", Acquire timeout: " + std::to_string(acquire_timeout_seconds_.load()) + "s" +
+                 ", Breaker timeout: " + std::to_string(breaker_timeout_seconds_.load()) + "s");
+
+    // Waiters re-check their limits
+    std::lock_guard<std::mutex> lock(mounts_mutex_);
+    for (auto &[mount_point, state] : mounts_)
+    {
+        std::lock_guard<std::mutex> state_lock(state->mutex);
+        state->limit = std::min<double>(state->limit, max_concurrent_.load());
+        state->cv.notify_all();
+    }
+}
+
+bool MountThrottle::isMountError(int error)
+{
+    switch (error)
+    {
+    case EIO:
+    case ETIMEDOUT:
+    case ESTALE:
+    case EHOSTDOWN:
+    case EHOSTUNREACH:
+    case ENETDOWN:
+    case ENETUNREACH:
+    case ENOTCONN:
+    case ECONNRESET:
+    case ECONNABORTED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::shared_ptr<MountThrottle::MountState> MountThrottle::stateForPath(const std::string &path)
+{
+    auto mounts = MountManager::getInstance().snapshot();
+    const MountInfo *mount = mounts->findNetworkMount(path);
+    if (!mount)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mounts_mutex_);
+    auto &state = mounts_[mount->mount_point];
+    if (!state)
+        state = std::make_shared<MountState>(mount->mount_point, max_concurrent_.load(), breaker_timeout_seconds_.load());
+    return state;
+}
+
+std::string MountThrottle::networkMountOf(const std::string &path)
+{
+    auto mounts = MountManager::getInstance().snapshot();
+    const MountInfo *mount = mounts->findNetworkMount(path);
+    return mount ? mount->mount_point : std::string();
+}
+
+std::shared_ptr<MountThrottle::MountState> MountThrottle::stateForMount(const std::string &mount_point)
+{
+    std::lock_guard<std::mutex> lock(mounts_mutex_);
+    auto &state = mounts_[mount_point];
+    if (!state)
+        state = std::make_shared<MountState>(mount_point, max_concurrent_.load(), breaker_timeout_seconds_.load());
+    return state;
+}
+
+MountThrottle::Permit MountThrottle::acquire(const std::string &path, uint64_t bytes)
+{
+    auto state = stateForPath(path);
+    if (!state)
+        return Permit(); // local path
+    return acquireForMount(state->mount_point, bytes);
+}
+
+MountThrottle::Permit MountThrottle::acquireForMount(const std::string &mount_point, uint64_t bytes)
+{
+    if (mount_point.empty())
+        return Permit(); // local path
+
+    auto state = stateForMount(mount_point);
+    if (!state->breaker.allowRequest())
+        return Permit(state, false);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(acquire_timeout_seconds_.load());
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true)
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        // Refill the bandwidth budget; at most one second of credit is kept
+        double rate = static_cast<double>(bandwidth_mb_per_second_.load()) * 1024 * 1024;
+        if (rate > 0)
+        {
+            double elapsed = std::chrono::duration<double>(now - state->refilled_at).count();
+            state->budget_bytes = std::min(rate, state->budget_bytes + rate * elapsed);
+        }
+        else
+        {
+            state->budget_bytes = 0;
+        }
+        state->refilled_at = now;
+
+        // The read is paid for up front; a request larger than the bucket waits for a full bucket
+        const double reserve = rate > 0 ? std::min(static_cast<double>(bytes), rate) : 0;
+        if (state->in_flight < static_cast<int>(state->limit) && state->budget_bytes >= reserve)
+        {
+            if (rate > 0)
+                state->budget_bytes -= static_cast<double>(bytes);
+            break;
+        }
+
+        if (now >= deadline)
+        {
+            // A busy or throttled mount is not a failing one; the breaker only counts I/O errors.
+            // Callers see the mount as unavailable and defer until something on it completes.
+            state->saturated_until = now + std::chrono::seconds(acquire_timeout_seconds_.load());
+            lock.unlock();
+            Logger::warn("MountThrottle: timed out waiting for an I/O slot on " + mount_point);
+            return Permit(state, false);
+        }
+        state->cv.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(100)));
+    }
+
+    ++state->in_flight;
+    return Permit(state, true);
+}
+
+bool MountThrottle::isAvailable(const std::string &path)
+{
+    auto state = stateForPath(path);
+    if (!state)
+        return true;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (std::chrono::steady_clock::now() < state->saturated_until)
+            return false;
+    }
+    return !state->breaker.rejectsRequests();
+}
+
+bool MountThrottle::readFile(const std::string &path, std::vector<unsigned char> &data)
+{
+    data.clear();
+    const bool ok = readChunks(path, [&data](const unsigned char *chunk, size_t length, uint64_t file_size)
+                               {
+        if (data.empty())
+            data.reserve(static_cast<size_t>(file_size));
+        data.insert(data.end(), chunk, chunk + length); });
+    if (!ok)
+        data.clear();
+    return ok;
+}
+
+bool MountThrottle::readChunks(const std::string &path, const ChunkConsumer &consume)
+{
+    const std::string mount_point = networkMountOf(path);
+
+    // The first chunk's permit also covers the open
+    auto permit = acquireForMount(mount_point);
+    if (!permit)
+        return false;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        permit.complete(!isMountError(errno));
+        if (fd >= 0)
+            ::close(fd);
+        return false;
+    }
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    std::vector<unsigned char> buffer(static_cast<size_t>(std::min<uint64_t>(READ_CHUNK_BYTES, size)));
+
+    // One permit per chunk: the slot is held for the read only, and each chunk's latency is what
+    // the mount's limit adapts to. Later chunks reserve their bandwidth up front; the first one
+    // shares the open's permit and is charged once its size is known.
+    uint64_t offset = 0;
+    bool ok = true;
+    while (offset < size)
+    {
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(READ_CHUNK_BYTES, size - offset));
+        if (offset > 0)
+        {
+            permit = acquireForMount(mount_point, length);
+            if (!permit)
+            {
+                ok = false;
+                break;
+            }
+        }
+        ssize_t n;
+        do
+        {
+            n = ::read(fd, buffer.data(), length);
+        } while (n < 0 && errno == EINTR);
+        permit.complete(n >= 0 || !isMountError(errno), offset == 0 && n > 0 ? static_cast<uint64_t>(n) : 0);
+        if (n <= 0)
+        {
+            // Read error, or the file shrank since the stat
+            ok = n == 0;
+            break;
+        }
+        consume(buffer.data(), static_cast<size_t>(n), size);
+        offset += static_cast<uint64_t>(n);
+    }
+    permit.complete(true);
+    ::close(fd);
+    return ok;
+}
+
+void MountThrottle::release(MountState &state, bool io_ok, uint64_t bytes, std::chrono::steady_clock::duration latency)
+{
+    const auto threshold = std::chrono::milliseconds(latency_threshold_ms_.load());
+    const double max_concurrent = max_concurrent_.load();
+    std::string backoff_msg;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        --state.in_flight;
+        if (bandwidth_mb_per_second_.load() > 0)
+            state.budget_bytes -= static_cast<double>(bytes);
+
+        auto now = std::chrono::steady_clock::now();
+        if (io_ok)
+            state.saturated_until = {};
+        if (!io_ok)
+        {
+            state.limit = 1;
+        }
+        else if (latency > threshold)
+        {
+            // Multiplicative decrease, at most once per threshold window so one burst of slow
+            // completions does not collapse the limit to 1
+            if (now - state.last_backoff > threshold && state.limit > 1)
+            {
+                state.limit = std::max(1.0, state.limit / 2);
+                state.last_backoff = now;
+                backoff_msg = "MountThrottle: " + state.mount_point + " is slow (" +
+                              std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(latency).count()) +
+                              "ms), limiting to " + std::to_string(static_cast<int>(state.limit)) + " concurrent operations";
+            }
+        }
+        else
+        {
+            // Additive increase: about one slot per limit's worth of fast completions
+            state.limit = std::min(max_concurrent, state.limit + 1.0 / state.limit);
+        }
+    }
+    state.cv.notify_all();
+
+    if (!backoff_msg.empty())
+        Logger::info(backoff_msg);
+    if (io_ok)
+        state.breaker.recordSuccess();
+    else
+        state.breaker.recordFailure();
+}
@@ -1,5 +1,6 @@
 #include "core/processing_config_observer.hpp"
 #include "poco_config_adapter.hpp"
+#include "core/memory_admission.hpp"
 #include "logging/logger.hpp"
 #include <algorithm>
 
@@ -18,6 +19,12 @@ void ProcessingConfigObserver::onConfigUpdate(const ConfigUpdateEvent &event)
         bool enabled = config.getPreProcessQualityStack();
         handleQualityStackPreprocessingChange(enabled);
     }
+
+    if (hasMemoryBudgetChange(event))
+    {
+        auto &config = PocoConfigAdapter::getInstance();
+        handleMemoryBudgetChange(config.getProcessingMemoryBudgetMB());
+    }
 }
 
 bool ProcessingConfigObserver::hasProcessingBatchSizeChange(const ConfigUpdateEvent &event) const
@@ -31,6 +38,12 @@ bool ProcessingConfigObserver::hasQualityStackPreprocessingChange(const ConfigUp
     return std::find(event.changed_keys.begin(), event.changed_keys.end(), "pre_process_quality_stack") != event.changed_keys.end();
 }
 
+bool ProcessingConfigObserver::hasMemoryBudgetChange(const ConfigUpdateEvent &event) const
+{
+    return std::find(event.changed_keys.begin(), event.changed_keys.end(), "memory_budget_mb") != event.changed_keys.end() ||
+           std::find(event.changed_keys.begin(), event.changed_keys.end(), "processing.memory_budget_mb") != event.changed_keys.end();
+}
+
 void ProcessingConfigObserver::handleProcessingBatchSizeChange(int new_batch_size)
 {
     Logger::info("Processing configuration changed: processing_batch_size = " + std::to_string(new_batch_size));
@@ -58,3 +71,11 @@ void ProcessingConfigObserver::handleQualityStackPreprocessingChange(bool enable
     Logger::info("Quality stack preprocessing " + std::string(enabled ? "enabled" : "disabled"));
     Logger::info("Note: Quality stack preprocessing changes will take effect for new processing tasks");
 }
+
+void ProcessingConfigObserver::handleMemoryBudgetChange(int budget_mb)
+{
+    Logger::info("Processing configuration changed: memory_budget_mb = " + std::to_string(budget_mb));
+
+    // Waiting decodes re-check against the new budget at once
+    MemoryAdmission::getInstance().setBudgetMB(static_cast<uint32_t>(std::max(0, budget_mb)));
+}
@@ -2,9 +2,14 @@
 #include "database/sql_scripts.hpp"
 #include "core/media_processor.hpp"
 #include "core/file_utils.hpp"
+#include "core/mount_throttle.hpp"
+#include "core/memory_admission.hpp"
 #include <filesystem>
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <chrono>
@@ -19,6 +24,12 @@
 #include <unistd.h>
 #include <algorithm> // For std::find
 
+namespace
+{
+    // Suffix of a cache file being written; renamed away once complete
+    const std::string TEMP_SUFFIX = ".part";
+}
+
 // FIXED: RAII wrapper for LibRaw to prevent memory leaks
 class LibRawRAII
 {
@@ -95,6 +106,25 @@ public:
     bool isValid() const { return raw_ != nullptr; }
 };
 
+namespace
+{
+    size_t imageBytes(const cv::Mat &image)
+    {
+        return image.total() * image.elemSize();
+    }
+
+    // A file no source uses any more was kept for a moved copy. With several sources only one is
+    // checked, and the others still use the file even if that one is gone.
+    bool sourceStillExists(const CachedTranscode &transcode)
+    {
+        if (transcode.references == 0)
+        {
+            return false;
+        }
+        return transcode.references > 1 || FileUtils::getFileMetadata(transcode.source_file_path).has_value();
+    }
+}
+
 // Raw file extensions that need transcoding - now configuration-driven
 // These are no longer used as we use PocoConfigAdapter::needsTranscoding()
 
@@ -151,6 +181,9 @@ void TranscodingManager::initialize(const std::string &cache_dir, int max_thread
     // Load configuration
     loadConfiguration();
 
+    loadCacheIndex();
+    removeStaleCacheWrites();
+
     // Subscribe to configuration changes (skip in test mode to prevent hangs)
     if (getenv("TEST_MODE") == nullptr || std::string(getenv("TEST_MODE")) != "1")
     {
@@ -272,7 +305,7 @@ void TranscodingManager::adjustCacheSizeSafely(size_t new_size_mb)
                      std::to_string(cleanup_threshold_mb_) + " MB, target: " + std::to_string(cleanup_target_mb_) + " MB");
 
         // If the new size is smaller than the current cache size, trigger cleanup
-        if (new_size_mb < current_cache_size_mb_.load())
+        if (getCacheSize() > new_size_bytes)
         {
             Logger::warn("TranscodingManager: New cache size is smaller than current usage. Triggering cleanup...");
 
@@ -387,52 +420,6 @@ void TranscodingManager::restoreQueueFromDatabase()
     }
 }
 
-void TranscodingManager::resetTranscodingJobStatusesOnStartup()
-{
-    Logger::info("Resetting all transcoding job statuses from 1 (in progress) to 0 (queued) on startup");
-
-    if (!db_manager_)
-    {
-        Logger::error("Database manager not available for status reset");
-        return;
-    }
-
-    try
-    {
-        // Reset all transcoding job statuses from 1 (in progress) to 0 (queued)
-        std::string update_sql = "UPDATE cache_map SET status = 0, worker_id = NULL WHERE status = 1";
-
-        if (sqlite3_exec(db_manager_->db_, update_sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
-        {
-            Logger::error("Failed to reset transcoding job statuses: " + std::string(sqlite3_errmsg(db_manager_->db_)));
-            return;
-        }
-
-        // Get count of affected rows
-        std::string count_sql = "SELECT COUNT(*) FROM cache_map WHERE status = 1";
-        sqlite3_stmt *count_stmt;
-
-        if (sqlite3_prepare_v2(db_manager_->db_, count_sql.c_str(), -1, &count_stmt, nullptr) == SQLITE_OK)
-        {
-            if (sqlite3_step(count_stmt) == SQLITE_ROW)
-            {
-                int remaining_count = sqlite3_column_int(count_stmt, 0);
-                if (remaining_count > 0)
-                {
-                    Logger::warn("Warning: " + std::to_string(remaining_count) + " transcoding jobs still have status 1 after reset");
-                }
-            }
-            sqlite3_finalize(count_stmt);
-        }
-
-        Logger::info("Successfully reset all transcoding job statuses on startup");
-    }
-    catch (const std::exception &e)
-    {
-        Logger::error("Exception during transcoding job status reset: " + std::string(e.what()));
-    }
-}
-
 void TranscodingManager::setDatabaseManager(DatabaseManager *db_manager)
 {
     db_manager_ = db_manager;
@@ -457,8 +444,11 @@ bool TranscodingManager::upgradeCacheMapSchema()
 
         bool status_exists = false;
         bool worker_id_exists = false;
+        bool lease_until_exists = false;
         bool created_at_exists = false;
         bool updated_at_exists = false;
+        bool file_size_exists = false;
+        bool last_access_exists = false;
 
         while (sqlite3_step(check_stmt) == SQLITE_ROW)
         {
@@ -467,15 +457,60 @@ bool TranscodingManager::upgradeCacheMapSchema()
                 status_exists = true;
             if (column_name == "worker_id")
                 worker_id_exists = true;
+            if (column_name == "lease_until")
+                lease_until_exists = true;
             if (column_name == "created_at")
                 created_at_exists = true;
             if (column_name == "updated_at")
                 updated_at_exists = true;
+            if (column_name == "file_size")
+                file_size_exists = true;
+            if (column_name == "last_access")
+                last_access_exists = true;
         }
         sqlite3_finalize(check_stmt);
 
-        // Schema is now complete in table definitions - no ALTER TABLE needed
-        // All required columns should already exist
+        // Databases created before the job-state columns existed need them added;
+        // lease_until defaults to 0 so any in-progress job left behind is
+        // immediately reclaimable rather than reset in bulk at startup
+        std::vector<std::pair<std::string, std::string>> missing_columns;
+        if (!status_exists)
+            missing_columns.emplace_back("status", "INTEGER DEFAULT 0");
+        if (!worker_id_exists)
+            missing_columns.emplace_back("worker_id", "TEXT");
+        if (!lease_until_exists)
+            missing_columns.emplace_back("lease_until", "INTEGER DEFAULT 0");
+        if (!created_at_exists)
+            missing_columns.emplace_back("created_at", "TIMESTAMP");
+        if (!updated_at_exists)
+            missing_columns.emplace_back("updated_at", "TIMESTAMP");
+
+        for (const auto &[column, type] : missing_columns)
+        {
+            auto result = db_manager_->executeStatement("ALTER TABLE cache_map ADD COLUMN " + column + " " + type);
+            if (!result.success)
+            {
+                Logger::error("Failed to add cache_map column " + column + ": " + result.error_message);
+                return false;
+            }
+            Logger::info("Added column cache_map." + column);
+        }
+
+        // Transcoded files recorded before cache_objects existed become objects cached by path
+        // (no content key); sizes and access times kept on cache_map rows carry over
+        std::string size_column = file_size_exists ? "MAX(m.file_size)" : "0";
+        std::string access_column = last_access_exists ? "MAX(m.last_access)" : "0";
+        auto migrate = db_manager_->executeStatement(
+            "INSERT OR IGNORE INTO cache_objects (cache_file_path, file_size, last_access) "
+            "SELECT m.transcoded_file_path, " + size_column + ", " + access_column + " FROM cache_map m "
+            "WHERE m.transcoded_file_path IS NOT NULL AND NOT EXISTS "
+            "(SELECT 1 FROM cache_objects o WHERE o.cache_file_path = m.transcoded_file_path) "
+            "GROUP BY m.transcoded_file_path");
+        if (!migrate.success)
+        {
+            Logger::error("Failed to move transcoded files into cache_objects: " + migrate.error_message);
+            return false;
+        }
 
         // Create index on status for faster job selection using SQL script
         std::string index_script_path = DatabaseScripts::getScriptPath("create_indexes.sql");
@@ -508,22 +543,31 @@ std::string TranscodingManager::getNextTranscodingJob()
     return db_manager_->claimNextTranscodingJob();
 }
 
-bool TranscodingManager::markJobInProgress(const std::string &file_path)
+void TranscodingManager::notifyJobsQueued()
 {
-    if (!db_manager_ || file_path.empty())
     {
-        return false;
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        jobs_pending_ = true;
     }
-    return db_manager_->markTranscodingJobInProgress(file_path);
+    queue_cv_.notify_all();
 }
 
-bool TranscodingManager::markJobCompleted(const std::string &file_path, const std::string &output_path)
+bool TranscodingManager::markJobCompleted(const std::string &file_path, const std::string &output_path, uint64_t output_size,
+                                          const std::string &content_key, const std::string &content_hash)
 {
-    if (!db_manager_ || file_path.empty() || output_path.empty())
+    if (!db_manager_ || file_path.empty())
     {
         return false;
     }
-    return db_manager_->markTranscodingJobCompleted(file_path, output_path);
+    if (!db_manager_->markTranscodingJobCompleted(file_path, output_path, output_size, content_key, content_hash))
+    {
+        return false;
+    }
+    if (!output_path.empty())
+    {
+        addToCacheIndex(output_path, output_size);
+    }
+    return true;
 }
 
 bool TranscodingManager::markJobFailed(const std::string &file_path)
@@ -535,6 +579,15 @@ bool TranscodingManager::markJobFailed(const std::string &file_path)
     return db_manager_->markTranscodingJobFailed(file_path);
 }
 
+bool TranscodingManager::releaseJob(const std::string &file_path)
+{
+    if (!db_manager_ || file_path.empty())
+    {
+        return false;
+    }
+    return db_manager_->releaseTranscodingJob(file_path);
+}
+
 void TranscodingManager::startTranscoding()
 {
     if (running_.load())
@@ -561,7 +614,11 @@ void TranscodingManager::stopTranscoding()
 
     Logger::info("Stopping transcoding threads");
 
-    cancelled_.store(true);
+    {
+        // Under the lock so a thread about to wait cannot miss the wake-up
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        cancelled_.store(true);
+    }
     queue_cv_.notify_all();
 
     // Wait for all threads to complete
@@ -590,7 +647,7 @@ bool TranscodingManager::isRawFile(const std::string &file_path)
     return needs_transcoding;
 }
 
-void TranscodingManager::queueForTranscoding(const std::string &file_path)
+void TranscodingManager::queueForTranscoding(const std::string &file_path, bool requeue_handed_off)
 {
     Logger::debug("queueForTranscoding called for: " + file_path);
 
@@ -623,7 +680,7 @@ void TranscodingManager::queueForTranscoding(const std::string &file_path)
         }
 
         // Queue via DatabaseManager to ensure serialized DB access
-        DBOpResult insert_result = db_manager_->insertTranscodingFile(file_path);
+        DBOpResult insert_result = db_manager_->insertTranscodingFile(file_path, requeue_handed_off);
         if (!insert_result.success)
         {
             Logger::error("Failed to queue file for transcoding: " + file_path + " - " + insert_result.error_message);
@@ -631,6 +688,7 @@ void TranscodingManager::queueForTranscoding(const std::string &file_path)
         }
 
         Logger::info("Queued file for transcoding: " + file_path);
+        notifyJobsQueued();
     }
     catch (const std::exception &e)
     {
@@ -638,6 +696,25 @@ void TranscodingManager::queueForTranscoding(const std::string &file_path)
     }
 }
 
+void TranscodingManager::queueForTranscoding(const std::vector<std::string> &file_paths)
+{
+    if (file_paths.empty() || !running_.load() || !isDatabaseAvailable())
+    {
+        return;
+    }
+
+    // INSERT OR IGNORE leaves files that are already queued or transcoded alone
+    DBOpResult insert_result = db_manager_->insertTranscodingFiles(file_paths);
+    if (!insert_result.success)
+    {
+        Logger::error("Failed to queue " + std::to_string(file_paths.size()) + " files for transcoding - " + insert_result.error_message);
+        return;
+    }
+
+    Logger::info("Queued " + std::to_string(file_paths.size()) + " files for transcoding");
+    notifyJobsQueued();
+}
+
 std::string TranscodingManager::getTranscodedFilePath(const std::string &source_file_path)
 {
     if (!isInitialized())
@@ -650,7 +727,12 @@ std::string TranscodingManager::getTranscodedFilePath(const std::string &source_
         Logger::warn("Database manager not available for getTranscodedFilePath");
         return "";
     }
-    return db_manager_->getTranscodedFilePath(source_file_path);
+    std::string transcoded_path = db_manager_->getTranscodedFilePath(source_file_path);
+    if (!transcoded_path.empty())
+    {
+        recordCacheAccess(transcoded_path);
+    }
+    return transcoded_path;
 }
 
 // Helper method to check if database manager is available
@@ -702,6 +784,7 @@ void TranscodingManager::shutdown()
     }
 
     stopTranscoding();
+    flushCacheAccess();
     Logger::info("TranscodingManager shutdown complete");
 }
 
@@ -715,44 +798,62 @@ void TranscodingManager::transcodingThread()
         {
             Logger::debug("Transcoding thread checking for jobs...");
 
-            // Get next job from database
+            // Cleared before the claim: anything queued from here on wakes the wait below
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                jobs_pending_ = false;
+            }
+
+            // Claim the next job; it comes back already marked in progress
             std::string file_path = getNextTranscodingJob();
 
             if (file_path.empty())
             {
-                // No jobs available, wait a bit before checking again
+                // Sleep until something is queued; the timeout is the fallback for jobs this
+                // process was not told about (other processes, lapsed leases)
                 Logger::debug("No jobs available, waiting...");
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_cv_.wait_for(lock, JOB_POLL_INTERVAL, [this]
+                                   { return jobs_pending_ || cancelled_.load() || !running_.load(); });
                 continue;
             }
 
             Logger::debug("Got job: " + file_path);
 
-            // Mark job as in progress
-            if (!markJobInProgress(file_path))
+            // Reads of RAW sources on a network share take the mount's I/O slots one read at a
+            // time. If the mount is unavailable the job goes back in the queue and this thread
+            // backs off before claiming again.
+            auto deferForMount = [&](const std::string &reason)
+            {
+                Logger::warn(reason + ", deferring transcoding job: " + file_path);
+                if (!releaseJob(file_path))
+                {
+                    Logger::warn("Failed to release deferred job, it is retried once its lease lapses: " + file_path);
+                }
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_cv_.wait_for(lock, MOUNT_DEFER_BACKOFF, [this]
+                                   { return cancelled_.load() || !running_.load(); });
+            };
+            if (!MountThrottle::getInstance().isAvailable(file_path))
             {
-                Logger::warn("Failed to mark job as in progress, skipping: " + file_path);
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                deferForMount("Network mount unavailable");
                 continue;
             }
 
             Logger::info("Processing transcoding job: " + file_path);
 
             // Attempt to transcode the file
-            std::string output_path = transcodeFile(file_path);
+            bool transcoded = transcodeFile(file_path);
 
-            if (!output_path.empty())
+            if (!transcoded && !MountThrottle::getInstance().isAvailable(file_path))
             {
-                // Transcoding succeeded
-                if (markJobCompleted(file_path, output_path))
-                {
-                    processed_count_.fetch_add(1);
-                    Logger::info("Transcoding completed successfully: " + file_path + " -> " + output_path);
-                }
-                else
-                {
-                    Logger::warn("Failed to mark job as completed: " + file_path);
-                }
+                // The mount failed during this job: defer instead of marking the job failed
+                deferForMount("Network mount became unavailable");
+            }
+            else if (transcoded)
+            {
+                processed_count_.fetch_add(1);
+                Logger::info("Transcoding completed successfully: " + file_path);
             }
             else
             {
@@ -767,9 +868,6 @@ void TranscodingManager::transcodingThread()
                     Logger::warn("Failed to mark job as failed: " + file_path);
                 }
             }
-
-            // Small delay between jobs to prevent overwhelming the system
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
         catch (const std::exception &e)
         {
@@ -781,82 +879,414 @@ void TranscodingManager::transcodingThread()
     Logger::info("Transcoding thread stopped");
 }
 
-std::string TranscodingManager::transcodeFile(const std::string &source_file_path)
+bool TranscodingManager::transcodeFile(const std::string &source_file_path)
 {
-    std::string cache_filename = generateCacheFilename(source_file_path);
-    std::string output_path = std::filesystem::path(cache_dir_) / cache_filename;
+    std::string content_key;
+    {
+        auto permit = MountThrottle::getInstance().acquire(source_file_path);
+        if (!permit)
+        {
+            return false;
+        }
+        content_key = FileUtils::computeSampledFileHash(source_file_path);
+        permit.complete(!content_key.empty() || !MountThrottle::isMountError(errno));
+    }
+    if (content_key.empty())
+    {
+        Logger::error("Cannot read source file for transcoding: " + source_file_path);
+        return false;
+    }
+
+    // Same content already transcoded for another path (a copy, or the file before a move)
+    std::string content_hash;
+    if (shareCachedTranscode(source_file_path, content_key, content_hash))
+    {
+        return true;
+    }
 
-    // Check if already exists and is valid
-    if (std::filesystem::exists(output_path))
+    // Use LibRaw directly for transcoding (no external executables). The cache file is named
+    // after the whole content, hashed from the bytes LibRaw decodes rather than by reading the
+    // file a second time.
+    const bool write_cache = PocoConfigAdapter::getInstance().getWriteRawTranscodes();
+    cv::Mat bgr;
+    if (!decodeRawFile(source_file_path, bgr, write_cache && content_hash.empty() ? &content_hash : nullptr))
     {
-        // Use existing file change detection to check if cache is still valid
-        auto current_metadata = FileUtils::getFileMetadata(source_file_path);
-        if (current_metadata)
+        Logger::error("LibRaw transcoding failed for: " + source_file_path);
+        return false;
+    }
+    auto image = std::make_shared<const cv::Mat>(std::move(bgr));
+    publishDecodedImage(source_file_path, image);
+
+    // The job is completed once, with the cache file it names already on disk; a crash before
+    // that leaves the job leased and it is transcoded again once the lease lapses. Without a cache
+    // file the job completes with the in-memory proxy only, and a later run that finds neither
+    // queues it again.
+    std::string output_path;
+    uint64_t output_size = 0;
+    if (write_cache)
+    {
+        if (content_hash.empty())
         {
-            // Check if source file has changed using existing metadata system
-            // This would integrate with the existing DatabaseManager metadata comparison
-            Logger::debug("Transcoded file already exists: " + output_path);
-            return output_path;
+            Logger::warn("Cannot hash source file, not caching its transcode: " + source_file_path);
         }
         else
         {
-            // Source file doesn't exist, remove invalid cache entry
-            Logger::debug("Source file no longer exists, removing invalid cache: " + output_path);
-            std::filesystem::remove(output_path);
+            output_path = std::filesystem::path(cache_dir_) / generateCacheFilename(source_file_path, content_hash);
+
+            // Left behind by an earlier run whose record was lost: adopt it instead of encoding
+            // again, unless it is truncated or corrupt
+            std::error_code size_error;
+            bool adopt = std::filesystem::exists(output_path, size_error);
+            if (adopt && !isCompleteCacheFile(output_path))
+            {
+                Logger::warn("Replacing incomplete cache file: " + output_path);
+                adopt = false;
+            }
+            if (!adopt)
+            {
+                // Check cache size and evict least recently used files if needed
+                if (isCacheOverLimit())
+                {
+                    Logger::info("Cache size limit exceeded, evicting least recently used files before transcoding");
+                    cleanupCache();
+                }
+                if (!writeCacheFile(*image, output_path))
+                {
+                    output_path.clear();
+                }
+            }
+            if (!output_path.empty())
+            {
+                output_size = std::filesystem::file_size(output_path, size_error);
+                if (size_error)
+                {
+                    output_size = 0;
+                }
+            }
         }
     }
 
-    // Check cache size and cleanup if needed
-    if (isCacheOverLimit())
+    // Completing the job requeues the file for processing, which takes the pixels from memory or
+    // the cache file
+    const bool cached = !output_path.empty();
+    if (!markJobCompleted(source_file_path, output_path, output_size, cached ? content_key : "", cached ? content_hash : ""))
+    {
+        Logger::warn("Failed to mark job as completed: " + source_file_path);
+        releaseDecodedImage(source_file_path);
+        return false;
+    }
+
+    Logger::info("LibRaw transcoding succeeded: " + source_file_path + (cached ? " -> " + output_path : " (in memory)"));
+    return true;
+}
+
+bool TranscodingManager::shareCachedTranscode(const std::string &source_file_path, const std::string &content_key, std::string &content_hash)
+{
+    std::vector<CachedTranscode> candidates = db_manager_->findCachedTranscodes(content_key);
+    if (candidates.empty())
+    {
+        return false;
+    }
+
+    // The sampled digest only narrows the search; the full hash decides. Read through the
+    // mount's I/O slots, one per chunk; while the mount is unavailable nothing is shared.
+    if (content_hash.empty())
+    {
+        content_hash = FileUtils::computeStreamHash([&](const std::function<void(const unsigned char *, size_t)> &sink)
+                                                    { return MountThrottle::getInstance().readChunks(source_file_path, [&](const unsigned char *data, size_t length, uint64_t)
+                                                                                                     { sink(data, length); }); });
+        if (content_hash.empty())
+        {
+            return false;
+        }
+    }
+
+    for (const auto &candidate : candidates)
+    {
+        if (candidate.content_hash != content_hash || !std::filesystem::exists(candidate.transcoded_file_path))
+        {
+            continue;
+        }
+        if (!markJobCompleted(source_file_path, candidate.transcoded_file_path, candidate.file_size, content_key, content_hash))
+        {
+            Logger::warn("Failed to mark job as completed: " + source_file_path);
+            return false;
+        }
+        Logger::info("Identical content already cached (" + std::to_string(candidate.references) + " other source(s)): " +
+                     source_file_path + " -> " + candidate.transcoded_file_path);
+        return true;
+    }
+    return false;
+}
+
+void TranscodingManager::publishDecodedImage(const std::string &source_file_path, std::shared_ptr<const cv::Mat> image)
+{
+    const size_t budget = static_cast<size_t>(std::max(0, PocoConfigAdapter::getInstance().getRawHandoffMB())) * 1024 * 1024;
+    const size_t image_bytes = imageBytes(*image);
+
+    std::lock_guard<std::mutex> lock(decoded_mutex_);
+
+    auto found = decoded_index_.find(source_file_path);
+    if (found != decoded_index_.end())
+    {
+        decoded_bytes_ -= imageBytes(*found->second->second);
+        decoded_images_.erase(found->second);
+        decoded_index_.erase(found);
+    }
+
+    if (image_bytes > budget)
+    {
+        return;
+    }
+    while (decoded_bytes_ + image_bytes > budget && !decoded_images_.empty())
     {
-        Logger::info("Cache size limit exceeded, performing smart cleanup before transcoding");
-        cleanupCacheSmart(true);
+        // Not fingerprinted in time: processing falls back to the cache file or decodes again
+        auto &oldest = decoded_images_.front();
+        decoded_bytes_ -= imageBytes(*oldest.second);
+        decoded_index_.erase(oldest.first);
+        decoded_images_.pop_front();
     }
 
-    // Use LibRaw directly for transcoding (no external executables)
-    if (transcodeRawFileDirectly(source_file_path, output_path))
+    decoded_images_.emplace_back(source_file_path, std::move(image));
+    decoded_index_[source_file_path] = std::prev(decoded_images_.end());
+    decoded_bytes_ += image_bytes;
+}
+
+std::shared_ptr<const cv::Mat> TranscodingManager::getDecodedImage(const std::string &source_file_path)
+{
+    std::lock_guard<std::mutex> lock(decoded_mutex_);
+    auto found = decoded_index_.find(source_file_path);
+    if (found == decoded_index_.end())
     {
-        Logger::info("LibRaw transcoding succeeded: " + source_file_path + " -> " + output_path);
-        return output_path;
+        return nullptr;
     }
-    Logger::error("LibRaw transcoding failed for: " + source_file_path);
-    return "";
+    return found->second->second;
 }
 
-std::string TranscodingManager::generateCacheFilename(const std::string &source_file_path)
+void TranscodingManager::releaseDecodedImage(const std::string &source_file_path)
 {
-    // Generate a unique filename based on source file path hash
-    std::string hash = MediaProcessor::generateHash(std::vector<uint8_t>(source_file_path.begin(), source_file_path.end()));
+    std::lock_guard<std::mutex> lock(decoded_mutex_);
+    auto found = decoded_index_.find(source_file_path);
+    if (found == decoded_index_.end())
+    {
+        return;
+    }
+    decoded_bytes_ -= imageBytes(*found->second->second);
+    decoded_images_.erase(found->second);
+    decoded_index_.erase(found);
+}
 
+std::string TranscodingManager::generateCacheFilename(const std::string &source_file_path, const std::string &content_hash)
+{
     // Get original extension and convert to jpg
     std::string original_ext = MediaProcessor::getFileExtension(source_file_path);
     std::transform(original_ext.begin(), original_ext.end(), original_ext.begin(), ::tolower);
 
-    // Use first 16 characters of hash + original extension + .jpg
-    return hash.substr(0, 16) + "_" + original_ext + ".jpg";
+    // First 16 characters of the content hash + original extension + .jpg; identical files share it
+    return content_hash.substr(0, 16) + "_" + original_ext + ".jpg";
 }
 
 size_t TranscodingManager::getCacheSize() const
 {
-    std::lock_guard<std::mutex> lock(cache_size_mutex_);
+    return cache_bytes_.load();
+}
 
-    size_t total_size = 0;
-    try
+void TranscodingManager::loadCacheIndex()
+{
+    if (!db_manager_)
     {
-        for (const auto &entry : std::filesystem::recursive_directory_iterator(cache_dir_))
+        return;
+    }
+
+    std::vector<CachedTranscode> transcodes = db_manager_->getCachedTranscodes();
+    std::vector<CachedTranscode> backfilled;
+    std::vector<std::string> missing;
+    size_t loaded = 0;
+    size_t unreferenced = 0;
+    {
+        std::lock_guard<std::mutex> lock(cache_index_mutex_);
+        cache_lru_.clear();
+        cache_index_.clear();
+        accessed_since_flush_.clear();
+
+        size_t total_size = 0;
+        for (auto &transcode : transcodes)
         {
-            if (entry.is_regular_file())
+            if (transcode.file_size == 0)
             {
-                total_size += entry.file_size();
+                // Transcoded before sizes were recorded: stat once and store the result
+                std::error_code ec;
+                uint64_t size = std::filesystem::file_size(transcode.transcoded_file_path, ec);
+                if (ec)
+                {
+                    missing.push_back(transcode.transcoded_file_path);
+                    continue;
+                }
+                transcode.file_size = size;
+                backfilled.push_back(transcode);
+            }
+            if (transcode.references == 0)
+            {
+                unreferenced++;
             }
+            total_size += transcode.file_size;
+            auto it = cache_lru_.insert(cache_lru_.end(), std::move(transcode));
+            cache_index_[it->transcoded_file_path] = it;
         }
+        cache_bytes_.store(total_size);
+        loaded = cache_index_.size();
     }
-    catch (const std::exception &e)
+
+    if (!backfilled.empty())
+    {
+        DBOpResult result = db_manager_->updateCachedTranscodes(backfilled);
+        if (!result.success)
+        {
+            Logger::warn("Failed to store sizes of cached transcodes: " + result.error_message);
+        }
+    }
+    if (!missing.empty())
+    {
+        // The file is gone, so its sources get transcoded again the next time they are processed
+        DBOpResult result = db_manager_->removeCachedTranscodes(missing);
+        if (!result.success)
+        {
+            Logger::warn("Failed to remove records of missing transcodes: " + result.error_message);
+        }
+    }
+
+    Logger::info("Loaded cache index: " + std::to_string(loaded) + " files (" + std::to_string(unreferenced) +
+                 " kept for moved copies), " + getCacheSizeString() +
+                 (missing.empty() ? "" : ", dropped " + std::to_string(missing.size()) + " missing files"));
+}
+
+void TranscodingManager::addToCacheIndex(const std::string &cache_file_path, uint64_t file_size)
+{
+    std::lock_guard<std::mutex> lock(cache_index_mutex_);
+
+    // Another source sharing the file only refreshes it
+    auto found = cache_index_.find(cache_file_path);
+    if (found != cache_index_.end())
+    {
+        if (file_size > 0 && file_size != found->second->file_size)
+        {
+            cache_bytes_.fetch_sub(found->second->file_size);
+            cache_bytes_.fetch_add(file_size);
+            found->second->file_size = file_size;
+        }
+        found->second->last_access = std::time(nullptr);
+        cache_lru_.splice(cache_lru_.end(), cache_lru_, found->second);
+        return;
+    }
+
+    CachedTranscode transcode;
+    transcode.transcoded_file_path = cache_file_path;
+    transcode.file_size = file_size;
+    transcode.last_access = std::time(nullptr);
+    auto it = cache_lru_.insert(cache_lru_.end(), std::move(transcode));
+    cache_index_[cache_file_path] = it;
+    cache_bytes_.fetch_add(file_size);
+}
+
+void TranscodingManager::recordCacheAccess(const std::string &cache_file_path)
+{
+    bool flush = false;
+    {
+        std::lock_guard<std::mutex> lock(cache_index_mutex_);
+        auto found = cache_index_.find(cache_file_path);
+        if (found == cache_index_.end())
+        {
+            return;
+        }
+        found->second->last_access = std::time(nullptr);
+        cache_lru_.splice(cache_lru_.end(), cache_lru_, found->second);
+        accessed_since_flush_.insert(cache_file_path);
+        flush = accessed_since_flush_.size() >= CACHE_ACCESS_FLUSH_BATCH;
+    }
+
+    if (flush)
+    {
+        flushCacheAccess();
+    }
+}
+
+std::optional<CachedTranscode> TranscodingManager::removeFromCacheIndex(const std::string &cache_file_path)
+{
+    std::lock_guard<std::mutex> lock(cache_index_mutex_);
+
+    auto found = cache_index_.find(cache_file_path);
+    if (found == cache_index_.end())
+    {
+        return std::nullopt;
+    }
+
+    CachedTranscode removed = std::move(*found->second);
+    cache_bytes_.fetch_sub(removed.file_size);
+    cache_lru_.erase(found->second);
+    cache_index_.erase(found);
+    accessed_since_flush_.erase(cache_file_path);
+    return removed;
+}
+
+std::vector<CachedTranscode> TranscodingManager::cachedTranscodesByAge()
+{
+    // The database knows which sources still use each file; recent accesses are written first
+    // so its order matches the index
+    flushCacheAccess();
+    return db_manager_ ? db_manager_->getCachedTranscodes() : std::vector<CachedTranscode>();
+}
+
+void TranscodingManager::flushCacheAccess()
+{
+    std::vector<CachedTranscode> accessed;
+    {
+        std::lock_guard<std::mutex> lock(cache_index_mutex_);
+        accessed.reserve(accessed_since_flush_.size());
+        for (const auto &cache_file_path : accessed_since_flush_)
+        {
+            auto found = cache_index_.find(cache_file_path);
+            if (found != cache_index_.end())
+            {
+                accessed.push_back(*found->second);
+            }
+        }
+        accessed_since_flush_.clear();
+    }
+
+    if (accessed.empty() || !db_manager_)
+    {
+        return;
+    }
+    DBOpResult result = db_manager_->updateCachedTranscodes(accessed);
+    if (!result.success)
     {
-        Logger::error("Error calculating cache size: " + std::string(e.what()));
+        Logger::warn("Failed to store cache access times: " + result.error_message);
+    }
+}
+
+size_t TranscodingManager::evictCacheFile(const std::string &cache_file_path)
+{
+    auto removed = removeFromCacheIndex(cache_file_path);
+
+    std::error_code ec;
+    std::filesystem::remove(cache_file_path, ec);
+    if (ec)
+    {
+        Logger::error("Error removing cache file " + cache_file_path + ": " + ec.message());
+    }
+
+    if (db_manager_)
+    {
+        // Every source sharing the file is transcoded again the next time it is processed
+        DBOpResult result = db_manager_->removeCachedTranscodes({cache_file_path});
+        if (!result.success)
+        {
+            Logger::warn("Failed to remove cached transcode from database: " + cache_file_path +
+                         " - " + result.error_message);
+        }
     }
 
-    return total_size;
+    return removed ? removed->file_size : 0;
 }
 
 std::string TranscodingManager::getCacheSizeString() const
@@ -935,57 +1365,51 @@ size_t TranscodingManager::cleanupCache(bool force_cleanup)
     Logger::info("Starting cache cleanup. Current size: " + getCacheSizeString() +
                  ", Max size: " + std::to_string(max_size / (1024 * 1024)) + " MB");
 
-    // Get all cache files and sort by modification time (oldest first)
-    std::vector<std::filesystem::path> cache_files;
-    try
+    // Take entries off the least recently used end until the rest fits
+    std::vector<CachedTranscode> evicted;
     {
-        for (const auto &entry : std::filesystem::recursive_directory_iterator(cache_dir_))
+        std::lock_guard<std::mutex> index_lock(cache_index_mutex_);
+        while (cache_bytes_.load() > max_size && !cache_lru_.empty())
         {
-            if (entry.is_regular_file())
-            {
-                cache_files.push_back(entry.path());
-            }
+            CachedTranscode &oldest = cache_lru_.front();
+            cache_bytes_.fetch_sub(oldest.file_size);
+            cache_index_.erase(oldest.transcoded_file_path);
+            accessed_since_flush_.erase(oldest.transcoded_file_path);
+            evicted.push_back(std::move(oldest));
+            cache_lru_.pop_front();
         }
     }
-    catch (const std::exception &e)
-    {
-        Logger::error("Error scanning cache directory: " + std::string(e.what()));
-        return 0;
-    }
 
-    // Sort by modification time (oldest first)
-    std::sort(cache_files.begin(), cache_files.end(),
-              [](const auto &a, const auto &b)
-              {
-                  return std::filesystem::last_write_time(a) < std::filesystem::last_write_time(b);
-              });
-
-    // Remove oldest files until under limit
     size_t files_removed = 0;
     size_t bytes_freed = 0;
+    std::vector<std::string> evicted_paths;
+    evicted_paths.reserve(evicted.size());
 
-    for (const auto &cache_file : cache_files)
+    for (const auto &transcode : evicted)
     {
-        if (current_size <= max_size)
+        std::error_code ec;
+        std::filesystem::remove(transcode.transcoded_file_path, ec);
+        if (ec)
         {
-            break;
+            Logger::error("Error removing cache file " + transcode.transcoded_file_path + ": " + ec.message());
         }
-
-        try
+        else
         {
-            size_t file_size = std::filesystem::file_size(cache_file);
-            std::filesystem::remove(cache_file);
-
-            current_size -= file_size;
-            bytes_freed += file_size;
             files_removed++;
-
-            Logger::debug("Removed cache file: " + cache_file.string() +
-                          " (size: " + std::to_string(file_size) + " bytes)");
+            Logger::debug("Removed cache file: " + transcode.transcoded_file_path +
+                          " (size: " + std::to_string(transcode.file_size) + " bytes)");
         }
-        catch (const std::exception &e)
+        bytes_freed += transcode.file_size;
+        evicted_paths.push_back(transcode.transcoded_file_path);
+    }
+
+    // Their sources are transcoded again the next time they are processed
+    if (db_manager_)
+    {
+        DBOpResult result = db_manager_->removeCachedTranscodes(evicted_paths);
+        if (!result.success)
         {
-            Logger::error("Error removing cache file " + cache_file.string() + ": " + std::string(e.what()));
+            Logger::warn("Failed to remove evicted transcoding records: " + result.error_message);
         }
     }
 
@@ -1011,42 +1435,22 @@ size_t TranscodingManager::cleanupCacheEnhanced(bool force_cleanup)
     Logger::info("Starting enhanced cache cleanup. Current size: " + getCacheSizeString() +
                  ", Max size: " + std::to_string(max_size / (1024 * 1024)) + " MB");
 
-    // Get all cache entries from database
-    std::vector<std::pair<std::string, std::string>> cache_entries;
-    try
-    {
-        // This would come from DatabaseManager::getAllCacheEntries()
-        // For now, we'll scan the cache directory
-        for (const auto &entry : std::filesystem::recursive_directory_iterator(cache_dir_))
-        {
-            if (entry.is_regular_file())
-            {
-                // Extract source file path from cache filename (reverse the hash)
-                // This is simplified - in practice, we'd store the mapping in database
-                std::string cache_file = entry.path().string();
-                std::string source_file = "unknown"; // Would be retrieved from database
-
-                cache_entries.emplace_back(source_file, cache_file);
-            }
-        }
-    }
-    catch (const std::exception &e)
-    {
-        Logger::error("Error scanning cache directory: " + std::string(e.what()));
-        return 0;
-    }
+    // All cached files with their sources, least recently used first
+    std::vector<CachedTranscode> cache_entries = cachedTranscodesByAge();
 
     // Use existing file change detection system
     std::vector<std::pair<std::string, std::string>> invalid_files; // Source file changed
     std::vector<std::pair<std::string, std::string>> valid_files;   // Source file unchanged
 
-    for (const auto &[source_file, cache_file] : cache_entries)
+    for (const auto &transcode : cache_entries)
     {
+        const std::string &source_file = transcode.source_file_path;
+        const std::string &cache_file = transcode.transcoded_file_path;
+
         // Use existing FileUtils::getFileMetadata and database comparison
-        auto current_metadata = FileUtils::getFileMetadata(source_file);
-        if (!current_metadata)
+        if (!sourceStillExists(transcode))
         {
-            // Source file doesn't exist, mark as invalid
+            // No source left (kept for a moved copy) or the source is gone, mark as invalid
             invalid_files.emplace_back(source_file, cache_file);
             continue;
         }
@@ -1072,37 +1476,22 @@ size_t TranscodingManager::cleanupCacheEnhanced(bool force_cleanup)
 
     for (const auto &[source_file, cache_file] : invalid_files)
     {
-        try
-        {
-            size_t file_size = std::filesystem::file_size(cache_file);
-            std::filesystem::remove(cache_file);
+        size_t file_size = evictCacheFile(cache_file);
 
-            current_size -= file_size;
-            bytes_freed += file_size;
-            files_removed++;
+        current_size -= std::min(current_size, file_size);
+        bytes_freed += file_size;
+        files_removed++;
 
-            Logger::debug("Removed invalid cache file: " + cache_file +
-                          " (source changed or missing, size: " + std::to_string(file_size) + " bytes)");
-        }
-        catch (const std::exception &e)
-        {
-            Logger::error("Error removing invalid cache file " + cache_file + ": " + std::string(e.what()));
-        }
+        Logger::debug("Removed invalid cache file: " + cache_file +
+                      " (source changed or missing, size: " + std::to_string(file_size) + " bytes)");
     }
 
     // If still over limit, remove oldest valid files
     if (current_size > max_size)
     {
-        Logger::info("Still over limit after removing invalid files, removing oldest valid files");
-
-        // Sort valid files by modification time (oldest first)
-        std::sort(valid_files.begin(), valid_files.end(),
-                  [](const auto &a, const auto &b)
-                  {
-                      return std::filesystem::last_write_time(a.second) < std::filesystem::last_write_time(b.second);
-                  });
+        Logger::info("Still over limit after removing invalid files, removing least recently used valid files");
 
-        // Remove oldest files until under limit
+        // valid_files keeps the least recently used first order of the cache index
         for (const auto &[source_file, cache_file] : valid_files)
         {
             if (current_size <= max_size)
@@ -1110,22 +1499,14 @@ size_t TranscodingManager::cleanupCacheEnhanced(bool force_cleanup)
                 break;
             }
 
-            try
-            {
-                size_t file_size = std::filesystem::file_size(cache_file);
-                std::filesystem::remove(cache_file);
+            size_t file_size = evictCacheFile(cache_file);
 
-                current_size -= file_size;
-                bytes_freed += file_size;
-                files_removed++;
+            current_size -= std::min(current_size, file_size);
+            bytes_freed += file_size;
+            files_removed++;
 
-                Logger::debug("Removed oldest valid cache file: " + cache_file +
-                              " (size: " + std::to_string(file_size) + " bytes)");
-            }
-            catch (const std::exception &e)
-            {
-                Logger::error("Error removing oldest cache file " + cache_file + ": " + std::string(e.what()));
-            }
+            Logger::debug("Removed least recently used cache file: " + cache_file +
+                          " (size: " + std::to_string(file_size) + " bytes)");
         }
     }
 
@@ -1205,80 +1586,56 @@ std::vector<TranscodingManager::CacheEntry> TranscodingManager::getCacheEntriesW
             return entries;
         }
 
-        // This would be implemented in DatabaseManager to get cache entries with processing status
-        // For now, we'll scan the cache directory and build entries manually
-        for (const auto &entry : std::filesystem::recursive_directory_iterator(cache_dir_))
+        for (const auto &transcode : cachedTranscodesByAge())
         {
-            if (entry.is_regular_file())
-            {
-                std::string cache_file = entry.path().string();
-
-                // Extract source file path from cache filename (reverse the hash)
-                // This is simplified - in practice, we'd get this from database
-                std::string source_file = "unknown"; // Would be retrieved from database
+            const std::string &cache_file = transcode.transcoded_file_path;
+            const std::string &source_file = transcode.source_file_path;
 
-                // Get file metadata
-                auto current_metadata = FileUtils::getFileMetadata(source_file);
-                bool source_exists = current_metadata.has_value();
+            // Get file metadata
+            bool source_exists = sourceStillExists(transcode);
 
-                // Get processing status from database (would be implemented)
-                bool processed_fast = false;
-                bool processed_balanced = false;
-                bool processed_quality = false;
+            // Get processing status from database (would be implemented)
+            bool processed_fast = false;
+            bool processed_balanced = false;
+            bool processed_quality = false;
 
-                // Determine processing status
-                bool is_processed = processed_fast || processed_balanced || processed_quality;
-                bool is_fully_processed = processed_fast && processed_balanced && processed_quality;
-
-                // Calculate cache age
-                std::time_t cache_age = 0;
-                try
-                {
-                    auto cache_time = std::filesystem::last_write_time(entry.path());
-                    auto now = std::chrono::system_clock::now();
-                    auto cache_duration = cache_time.time_since_epoch();
-                    auto now_duration = now.time_since_epoch();
-                    auto age_duration = now_duration - cache_duration;
-                    cache_age = std::chrono::duration_cast<std::chrono::seconds>(age_duration).count();
-                }
-                catch (...)
-                {
-                    cache_age = std::time(nullptr);
-                }
+            // Determine processing status
+            bool is_processed = processed_fast || processed_balanced || processed_quality;
+            bool is_fully_processed = processed_fast && processed_balanced && processed_quality;
 
-                // Get file size
-                size_t file_size = std::filesystem::file_size(entry.path());
+            // Age and size come from the cache index
+            std::time_t cache_age = static_cast<std::time_t>(transcode.last_access);
+            size_t file_size = transcode.file_size;
 
-                // Create processing status string
-                std::string processing_status;
-                if (!source_exists)
-                {
-                    processing_status = "SOURCE_MISSING";
-                }
-                else if (is_fully_processed)
-                {
-                    processing_status = "FULLY_PROCESSED";
-                }
-                else if (is_processed)
-                {
-                    processing_status = "PARTIALLY_PROCESSED";
-                }
-                else
-                {
-                    processing_status = "UNPROCESSED";
-                }
+            // Create processing status string
+            std::string processing_status;
+            if (!source_exists)
+            {
+                processing_status = "SOURCE_MISSING";
+            }
+            else if (is_fully_processed)
+            {
+                processing_status = "FULLY_PROCESSED";
+            }
+            else if (is_processed)
+            {
+                processing_status = "PARTIALLY_PROCESSED";
+            }
+            else
+            {
+                processing_status = "UNPROCESSED";
+            }
 
-                CacheEntry cache_entry{
-                    source_file,
-                    cache_file,
-                    is_processed,
-                    is_fully_processed,
-                    cache_age,
-                    file_size,
-                    processing_status};
+            CacheEntry cache_entry{
+                source_file,
+                cache_file,
+                is_processed,
+                is_fully_processed,
+                cache_age,
+                file_size,
+                processing_status};
 
-                entries.push_back(cache_entry);
-            }
+            entries.push_back(cache_entry);
         }
     }
     catch (const std::exception &e)
@@ -1320,7 +1677,7 @@ size_t TranscodingManager::removeProcessedOldFiles(const std::vector<CacheEntry>
             {
                 files_removed++;
                 Logger::debug("Removed processed old cache file: " + entry.cache_file +
-                              " (age: " + std::to_string(entry.cache_age) + "s, status: " + entry.processing_status + ")");
+                              " (last access: " + std::to_string(entry.cache_age) + ", status: " + entry.processing_status + ")");
             }
         }
     }
@@ -1340,7 +1697,7 @@ size_t TranscodingManager::removeUnprocessedOldFiles(const std::vector<CacheEntr
             {
                 files_removed++;
                 Logger::debug("Removed unprocessed old cache file: " + entry.cache_file +
-                              " (age: " + std::to_string(entry.cache_age) + "s, status: " + entry.processing_status + ")");
+                              " (last access: " + std::to_string(entry.cache_age) + ", status: " + entry.processing_status + ")");
             }
         }
     }
@@ -1385,7 +1742,7 @@ size_t TranscodingManager::removeOldestValidFiles(const std::vector<CacheEntry>
             current_size -= entry.file_size;
             files_removed++;
             Logger::debug("Removed oldest valid cache file: " + entry.cache_file +
-                          " (age: " + std::to_string(entry.cache_age) + "s, size: " + std::to_string(entry.file_size) + " bytes)");
+                          " (last access: " + std::to_string(entry.cache_age) + ", size: " + std::to_string(entry.file_size) + " bytes)");
         }
     }
 
@@ -1418,23 +1775,8 @@ bool TranscodingManager::removeCacheEntry(const CacheEntry &entry)
 {
     try
     {
-        // Remove cache file
-        if (std::filesystem::exists(entry.cache_file))
-        {
-            std::filesystem::remove(entry.cache_file);
-        }
-
-        // Remove database record
-        if (db_manager_)
-        {
-            DBOpResult result = db_manager_->removeTranscodingRecord(entry.source_file);
-            if (!result.success)
-            {
-                Logger::warn("Failed to remove transcoding record from database: " + entry.source_file +
-                             " - " + result.error_message);
-            }
-        }
-
+        // Removes the cache file, its index entry and the records of every source sharing it
+        evictCacheFile(entry.cache_file);
         return true;
     }
     catch (const std::exception &e)
@@ -1444,10 +1786,11 @@ bool TranscodingManager::removeCacheEntry(const CacheEntry &entry)
     }
 }
 
-bool TranscodingManager::transcodeRawFileDirectly(const std::string &source_file_path, const std::string &output_path)
+bool TranscodingManager::decodeRawFile(const std::string &source_file_path, cv::Mat &bgr, std::string *content_hash)
 {
-    std::lock_guard<std::mutex> lock(libraw_mutex_);
-
+    // Declared in this order so LibRaw's memory is freed before the lock, and both before the grant
+    MemoryAdmission::Grant memory_grant;
+    std::unique_lock<std::mutex> lock(libraw_mutex_, std::defer_lock);
     LibRawRAII libraw_raii;
 
     try
@@ -1459,8 +1802,36 @@ bool TranscodingManager::transcodeRawFileDirectly(const std::string &source_file
             return false;
         }
 
-        // Ensure parent directory exists
-        std::filesystem::create_directories(std::filesystem::path(output_path).parent_path());
+        // Admitted before the file is buffered, from its size and header. The wait holds neither
+        // the LibRaw lock nor a mount slot; the header read takes one of its own.
+        const int max_edge = PocoConfigAdapter::getInstance().getTranscodeMaxEdgePx();
+        uint64_t peak_bytes = 0;
+        {
+            auto permit = MountThrottle::getInstance().acquire(source_file_path);
+            if (!permit)
+            {
+                Logger::error("Mount unavailable, cannot read RAW file: " + source_file_path);
+                return false;
+            }
+            peak_bytes = MemoryAdmission::estimateRawPeakBytes(source_file_path, max_edge);
+        }
+        memory_grant = MemoryAdmission::getInstance().admit(peak_bytes, source_file_path);
+
+        // Read under the mount's I/O slots; LibRaw decodes from memory without holding one
+        Logger::debug("Opening RAW file: " + source_file_path);
+        std::vector<unsigned char> raw_data;
+        if (!MountThrottle::getInstance().readFile(source_file_path, raw_data))
+        {
+            Logger::error("Cannot read RAW file: " + source_file_path);
+            return false;
+        }
+        if (content_hash)
+        {
+            *content_hash = FileUtils::computeBufferHash(raw_data.data(), raw_data.size());
+        }
+
+        // Only the LibRaw calls are serialised
+        lock.lock();
 
         // Create LibRaw instance
         libraw_raii.setRaw(new LibRaw());
@@ -1479,14 +1850,21 @@ bool TranscodingManager::transcodeRawFileDirectly(const std::string &source_file
         libraw_raii.getRaw()->imgdata.params.half_size = 0;
         libraw_raii.getRaw()->imgdata.params.output_tiff = 0; // JPEG output
 
-        Logger::debug("Opening RAW file: " + source_file_path);
-        int rc = libraw_raii.getRaw()->open_file(source_file_path.c_str());
+        int rc = libraw_raii.getRaw()->open_buffer(raw_data.data(), raw_data.size());
         if (rc != LIBRAW_SUCCESS)
         {
-            Logger::error("LibRaw open_file failed: " + std::string(libraw_strerror(rc)) + " (" + std::to_string(rc) + ") for: " + source_file_path);
+            Logger::error("LibRaw open_buffer failed: " + std::string(libraw_strerror(rc)) + " (" + std::to_string(rc) + ") for: " + source_file_path);
             return false;
         }
 
+        // Every dedup mode shrinks the image to 224px or less, so a proxy is enough. Half-size
+        // decoding skips demosaicing and is only used while it still leaves max_edge pixels.
+        const int raw_edge = std::max<int>(libraw_raii.getRaw()->imgdata.sizes.width, libraw_raii.getRaw()->imgdata.sizes.height);
+        if (max_edge > 0 && raw_edge / 2 >= max_edge)
+        {
+            libraw_raii.getRaw()->imgdata.params.half_size = 1;
+        }
+
         Logger::debug("Unpacking RAW data for: " + source_file_path);
         rc = libraw_raii.getRaw()->unpack();
         if (rc != LIBRAW_SUCCESS)
@@ -1542,24 +1920,33 @@ bool TranscodingManager::transcodeRawFileDirectly(const std::string &source_file
         Logger::debug("Creating OpenCV Mat for: " + source_file_path + " (" + std::to_string(libraw_raii.getImg()->width) + "x" + std::to_string(libraw_raii.getImg()->height) + ")");
 
         // Create a copy of the data to avoid memory issues
-        size_t data_size = libraw_raii.getImg()->width * libraw_raii.getImg()->height * 3;
+        const int width = libraw_raii.getImg()->width;
+        const int height = libraw_raii.getImg()->height;
+        size_t data_size = static_cast<size_t>(width) * height * 3;
         std::vector<unsigned char> rgb_data(data_size);
         std::memcpy(rgb_data.data(), libraw_raii.getImg()->data, data_size);
 
-        // Construct cv::Mat with copied data (RGB to BGR for OpenCV)
-        cv::Mat rgb(libraw_raii.getImg()->height, libraw_raii.getImg()->width, CV_8UC3, rgb_data.data());
-        cv::Mat bgr;
-        cv::cvtColor(rgb, bgr, cv::COLOR_RGB2BGR);
+        // LibRaw is done: free its buffers and let the next RAW decode start while this one resizes
+        libraw_raii.cleanup();
+        lock.unlock();
 
-        Logger::debug("Writing JPEG output: " + output_path);
-        std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, 92};
-        if (!cv::imwrite(output_path, bgr, params))
+        // Construct cv::Mat with copied data (RGB to BGR for OpenCV)
+        cv::Mat rgb(height, width, CV_8UC3, rgb_data.data());
+        const int longest_edge = std::max(rgb.cols, rgb.rows);
+        if (max_edge > 0 && longest_edge > max_edge)
         {
-            Logger::error("OpenCV imwrite failed for: " + output_path);
-            return false;
+            // Shrink before the colour conversion so it only touches the proxy
+            const double scale = static_cast<double>(max_edge) / longest_edge;
+            cv::Mat proxy;
+            cv::resize(rgb, proxy, cv::Size(std::max(1, static_cast<int>(rgb.cols * scale + 0.5)), std::max(1, static_cast<int>(rgb.rows * scale + 0.5))), 0, 0, cv::INTER_AREA);
+            cv::cvtColor(proxy, bgr, cv::COLOR_RGB2BGR);
+        }
+        else
+        {
+            cv::cvtColor(rgb, bgr, cv::COLOR_RGB2BGR);
         }
 
-        Logger::info("Successfully transcoded: " + source_file_path + " -> " + output_path);
+        Logger::debug("Decoded RAW file: " + source_file_path + " (" + std::to_string(bgr.cols) + "x" + std::to_string(bgr.rows) + ")");
         return true;
     }
     catch (const std::exception &e)
@@ -1579,6 +1966,118 @@ bool TranscodingManager::transcodeRawFileDirectly(const std::string &source_file
     return false;
 }
 
+bool TranscodingManager::writeCacheFile(const cv::Mat &bgr, const std::string &output_path)
+{
+    try
+    {
+        // Ensure parent directory exists
+        std::filesystem::create_directories(std::filesystem::path(output_path).parent_path());
+
+        Logger::debug("Writing JPEG output: " + output_path);
+        std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, 92};
+        std::vector<unsigned char> encoded;
+        if (!cv::imencode(".jpg", bgr, encoded, params))
+        {
+            Logger::error("OpenCV imencode failed for: " + output_path);
+            return false;
+        }
+
+        // The job is completed with this path right after, so the bytes must be on disk first.
+        // Written beside it under a name of this writer's own and renamed into place: a crash or
+        // a concurrent writer of the same content never leaves a partial file at output_path.
+        const std::string temp_path = output_path + "." + std::to_string(::getpid()) + "-" +
+                                      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + TEMP_SUFFIX;
+        int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            Logger::error("Cannot create cache file: " + temp_path + " - " + std::strerror(errno));
+            return false;
+        }
+        size_t written = 0;
+        while (written < encoded.size())
+        {
+            ssize_t n = ::write(fd, encoded.data() + written, encoded.size() - written);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        bool durable = written == encoded.size() && ::fsync(fd) == 0;
+        durable = ::close(fd) == 0 && durable;
+        durable = durable && ::rename(temp_path.c_str(), output_path.c_str()) == 0;
+        if (!durable)
+        {
+            Logger::error("Failed to write cache file: " + output_path + " - " + std::strerror(errno));
+            std::error_code ignored;
+            std::filesystem::remove(temp_path, ignored);
+            return false;
+        }
+
+        // Make the rename itself durable
+        int dir_fd = ::open(std::filesystem::path(output_path).parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0)
+        {
+            ::fsync(dir_fd);
+            ::close(dir_fd);
+        }
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        Logger::error("Exception writing cache file: " + std::string(e.what()) + " for: " + output_path);
+        return false;
+    }
+}
+
+bool TranscodingManager::isCompleteCacheFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size < 4)
+    {
+        return false;
+    }
+    unsigned char head[2] = {};
+    unsigned char tail[2] = {};
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(head), 2);
+    file.seekg(size - 2);
+    file.read(reinterpret_cast<char *>(tail), 2);
+    return file.good() && head[0] == 0xFF && head[1] == 0xD8 && tail[0] == 0xFF && tail[1] == 0xD9;
+}
+
+void TranscodingManager::removeStaleCacheWrites()
+{
+    // Only called at startup, before any transcoding thread writes
+    std::error_code ec;
+    size_t removed = 0;
+    for (std::filesystem::directory_iterator it(cache_dir_, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const std::string name = it->path().filename().string();
+        if (name.size() > TEMP_SUFFIX.size() && name.compare(name.size() - TEMP_SUFFIX.size(), TEMP_SUFFIX.size(), TEMP_SUFFIX) == 0)
+        {
+            std::error_code remove_error;
+            if (std::filesystem::remove(it->path(), remove_error))
+            {
+                ++removed;
+            }
+        }
+    }
+    if (removed > 0)
+    {
+        Logger::info("Removed " + std::to_string(removed) + " unfinished cache file write(s) from " + cache_dir_);
+    }
+}
+
 size_t TranscodingManager::retryTranscodingErrorFiles()
 {
     Logger::info("Checking for files in transcoding error state (3) to retry...");
@@ -1632,7 +2131,7 @@ size_t TranscodingManager::retryTranscodingErrorFiles()
             {
                 Logger::info("Retrying transcoding for file in error state: " + file_path);
 
-                // Reset the flag to -1 (in progress) to allow retry
+                // Park the file until the retried transcode finishes; completion requeues it
                 auto &config_manager = PocoConfigAdapter::getInstance();
                 bool pre_process_quality_stack = config_manager.getPreProcessQualityStack();
 
@@ -1650,7 +2149,7 @@ size_t TranscodingManager::retryTranscodingErrorFiles()
                 bool reset_success = true;
                 for (const auto &mode : modes_to_reset)
                 {
-                    auto flag_result = db_manager_->resetProcessingFlag(file_path, mode);
+                    auto flag_result = db_manager_->setProcessingFlagAwaitingTranscode(file_path, mode);
                     if (!flag_result.success)
                     {
                         Logger::warn("Failed to reset processing flag for retry: " + file_path +
@@ -3,12 +3,15 @@
 #include "core/processing_result.hpp"
 #include "core/dedup_modes.hpp"
 #include "core/file_utils.hpp"
+#include "core/mount_manager.hpp"
 #include "logging/logger.hpp"
 #include "poco_config_adapter.hpp"
+#include <sqlite3.h>
 #include <filesystem>
 #include <fstream>
 #include <chrono>
 #include <iostream> // Added for debug output
+#include <set>
 
 namespace fs = std::filesystem;
 
@@ -1107,4 +1110,734 @@ TEST_F(DatabaseManagerTest, MetadataBasedChangeDetection)
 
     // Clean up test file
     fs::remove(test_file);
-}
\ No newline at end of file
+}
+
+TEST_F(DatabaseManagerTest, FileTypeFilteringUsesStoredExtension)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    // Extension matching is case-insensitive and unsupported types are never returned
+    std::string upper_case_file = "test_upper_case.JPG";
+    std::string unsupported_file = "test_unsupported.txt";
+    createTestFile(upper_case_file);
+    createTestFile(unsupported_file);
+
+    dbMan.storeScannedFile(upper_case_file);
+    dbMan.storeScannedFile(unsupported_file);
+    dbMan.waitForWrites();
+
+    auto files_needing_processing = dbMan.getFilesNeedingProcessing(DedupMode::FAST);
+    ASSERT_EQ(files_needing_processing.size(), 1);
+    EXPECT_EQ(files_needing_processing[0].first, upper_case_file);
+
+    fs::remove(upper_case_file);
+    fs::remove(unsupported_file);
+}
+
+TEST_F(DatabaseManagerTest, ClaimSkipsFilesAlreadyInProgress)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string first_file = "test_claim_first.jpg";
+    std::string second_file = "test_claim_second.jpg";
+    createTestFile(first_file);
+    createTestFile(second_file);
+
+    dbMan.storeScannedFile(first_file);
+    dbMan.storeScannedFile(second_file);
+    dbMan.waitForWrites();
+
+    // Each claim takes a file off the pending index until none are left
+    auto first_claim = dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 1);
+    ASSERT_EQ(first_claim.size(), 1);
+    auto second_claim = dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 1);
+    ASSERT_EQ(second_claim.size(), 1);
+    EXPECT_NE(first_claim[0].first, second_claim[0].first);
+    EXPECT_TRUE(dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 1).empty());
+
+    // Other modes still see both files as pending
+    EXPECT_EQ(dbMan.getFilesNeedingProcessing(DedupMode::BALANCED).size(), 2);
+
+    fs::remove(first_file);
+    fs::remove(second_file);
+}
+
+TEST_F(DatabaseManagerTest, TranscodeCompletionRequeuesOnlyModesAwaitingIt)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_awaiting_transcode.jpg";
+    createTestFile(test_file);
+    ASSERT_TRUE(dbMan.storeScannedFile(test_file).success);
+    dbMan.waitForWrites();
+    ASSERT_EQ(dbMan.getAndMarkFilesForProcessingAnyModeWithPriority(1).size(), 1);
+
+    // FAST and BALANCED wait for the transcode; QUALITY is still being worked on
+    ASSERT_TRUE(dbMan.setProcessingFlagAwaitingTranscode(test_file, DedupMode::FAST).success);
+    ASSERT_TRUE(dbMan.setProcessingFlagAwaitingTranscode(test_file, DedupMode::BALANCED).success);
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::FAST), -2);
+
+    ASSERT_TRUE(dbMan.insertTranscodingFile(test_file).success);
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(test_file, ""));
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::FAST), 0);
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::BALANCED), 0);
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::QUALITY), -1);
+
+    auto priority = [&]()
+    {
+        sqlite3 *raw_db = nullptr;
+        EXPECT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(raw_db, "SELECT processing_priority FROM scanned_files WHERE file_path = ?", -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, test_file.c_str(), -1, SQLITE_STATIC);
+        int value = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+        sqlite3_finalize(stmt);
+        sqlite3_close(raw_db);
+        return value;
+    };
+
+    // The boost lasts while any mode is pending and is dropped once the work is done
+    EXPECT_EQ(priority(), 1);
+    ASSERT_TRUE(dbMan.setProcessingFlag(test_file, DedupMode::FAST).success);
+    EXPECT_EQ(priority(), 1);
+    ASSERT_TRUE(dbMan.setProcessingFlag(test_file, DedupMode::BALANCED).success);
+    ASSERT_TRUE(dbMan.setProcessingFlagError(test_file, DedupMode::QUALITY).success);
+    EXPECT_EQ(priority(), 0);
+
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, ExpiredClaimLeaseIsReclaimed)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_lease_reclaim.jpg";
+    createTestFile(test_file);
+    dbMan.storeScannedFile(test_file);
+    dbMan.waitForWrites();
+
+    auto claimed = dbMan.getAndMarkFilesForProcessing(DedupMode::FAST, 10);
+    ASSERT_EQ(claimed.size(), 1);
+
+    // While the lease is live the file is not handed out again
+    EXPECT_TRUE(dbMan.getAndMarkFilesForProcessing(DedupMode::FAST, 10).empty());
+
+    // Simulate a worker that crashed and let its lease lapse
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET lease_until = 0", nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(raw_db);
+
+    auto reclaimed = dbMan.getAndMarkFilesForProcessing(DedupMode::FAST, 10);
+    ASSERT_EQ(reclaimed.size(), 1);
+    EXPECT_EQ(reclaimed[0].first, test_file);
+
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, StaleLeaseOwnerCannotOverwriteNewClaim)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_lease_race.jpg";
+    createTestFile(test_file);
+    dbMan.storeScannedFile(test_file);
+    dbMan.waitForWrites();
+
+    ASSERT_EQ(dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 10).size(), 1);
+    EXPECT_TRUE(dbMan.renewProcessingLease(test_file));
+
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    auto lease_owner = [&]()
+    {
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(raw_db, "SELECT IFNULL(lease_owner, '') FROM scanned_files WHERE file_path = ?", -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, test_file.c_str(), -1, SQLITE_STATIC);
+        std::string owner = sqlite3_step(stmt) == SQLITE_ROW ? reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)) : "";
+        sqlite3_finalize(stmt);
+        return owner;
+    };
+
+    // Our lease lapses and another server reclaims the file and claims it for itself
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET lease_until = 0", nullptr, nullptr, nullptr), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET processed_fast = 0, lease_owner = NULL WHERE processed_fast = -1 AND lease_until < strftime('%s', 'now')",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET processed_fast = -1, lease_owner = 'other-host:42', lease_until = strftime('%s', 'now') + 900",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+
+    // The stale worker can neither renew nor finish the file
+    EXPECT_FALSE(dbMan.renewProcessingLease(test_file));
+    EXPECT_FALSE(dbMan.setProcessingFlag(test_file, DedupMode::FAST).success);
+    EXPECT_FALSE(dbMan.setProcessingFlagError(test_file, DedupMode::FAST).success);
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::FAST), -1);
+    EXPECT_EQ(lease_owner(), "other-host:42");
+
+    // The other server dies in turn; our next claim takes the file back and completes it
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET lease_until = 0", nullptr, nullptr, nullptr), SQLITE_OK);
+    ASSERT_EQ(dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 10).size(), 1);
+    EXPECT_TRUE(dbMan.setProcessingFlag(test_file, DedupMode::FAST).success);
+    EXPECT_EQ(dbMan.getProcessingFlag(test_file, DedupMode::FAST), 1);
+    EXPECT_EQ(lease_owner(), "");
+
+    sqlite3_close(raw_db);
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, DuplicateDetectionHashTracksTableVersions)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_version_hash.jpg";
+    createTestFile(test_file);
+
+    auto [ok_before, hash_before] = dbMan.getDuplicateDetectionHash();
+    ASSERT_TRUE(ok_before);
+    EXPECT_EQ(dbMan.getDuplicateDetectionHash().second, hash_before);
+
+    dbMan.storeScannedFile(test_file);
+    dbMan.waitForWrites();
+
+    auto [ok_after, hash_after] = dbMan.getDuplicateDetectionHash();
+    ASSERT_TRUE(ok_after);
+    EXPECT_NE(hash_after, hash_before);
+
+    // Writing links changes the hash once; rewriting identical links does not
+    dbMan.setFileLinksForMode(test_file, {42}, DedupMode::FAST);
+    dbMan.waitForWrites();
+    auto linked_hash = dbMan.getDuplicateDetectionHash().second;
+    EXPECT_NE(linked_hash, hash_after);
+
+    dbMan.setFileLinksForMode(test_file, {42}, DedupMode::FAST);
+    dbMan.waitForWrites();
+    EXPECT_EQ(dbMan.getDuplicateDetectionHash().second, linked_hash);
+
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, ClaimsDoNotChangeTheDuplicateDetectionHash)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_version_claim.jpg";
+    createTestFile(test_file);
+    dbMan.storeScannedFile(test_file);
+    dbMan.waitForWrites();
+    auto stored_hash = dbMan.getDuplicateDetectionHash().second;
+
+    // Claiming, renewing and releasing the lease are bookkeeping, not content
+    ASSERT_EQ(dbMan.getAndMarkFilesForProcessingWithPriority(DedupMode::FAST, 10).size(), 1);
+    EXPECT_TRUE(dbMan.renewProcessingLease(test_file));
+    EXPECT_TRUE(dbMan.resetProcessingFlag(test_file, DedupMode::FAST).success);
+    EXPECT_EQ(dbMan.getDuplicateDetectionHash().second, stored_hash);
+
+    // A change to the file itself still counts
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(raw_db, "UPDATE scanned_files SET file_size = file_size + 1", nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(raw_db);
+    EXPECT_NE(dbMan.getDuplicateDetectionHash().second, stored_hash);
+
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, RecreatedDatabaseDoesNotRepeatTableVersions)
+{
+    std::string first_hash;
+    {
+        auto &dbMan = DatabaseManager::getInstance(db_path);
+        first_hash = dbMan.getDuplicateDetectionHash().second;
+        ASSERT_FALSE(first_hash.empty());
+    }
+
+    // Same (empty) contents in a new database file must not look unchanged to a cached version
+    DatabaseManager::shutdown();
+    for (const std::string suffix : {"", "-shm", "-wal"})
+        fs::remove(db_path + suffix);
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+    EXPECT_NE(dbMan.getDuplicateDetectionHash().second, first_hash);
+}
+
+TEST_F(DatabaseManagerTest, KeysetPaginationWalksAllRows)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::vector<std::string> files = {"test_page_a.jpg", "test_page_b.jpg", "test_page_c.jpg"};
+    for (const auto &file : files)
+    {
+        createTestFile(file);
+        dbMan.storeScannedFile(file);
+
+        ProcessingResult result;
+        result.success = true;
+        result.artifact.format = "phash";
+        result.artifact.hash = "hash_" + file;
+        result.artifact.data = {0x01, 0x02, 0x03};
+        dbMan.storeProcessingResult(file, DedupMode::FAST, result);
+    }
+    dbMan.waitForWrites();
+
+    EXPECT_EQ(dbMan.getScannedFilesCount(), files.size());
+    EXPECT_EQ(dbMan.getProcessingResultsCount(), files.size());
+
+    auto first_page = dbMan.getScannedFilesPage(0, 2);
+    ASSERT_EQ(first_page.size(), 2);
+    auto second_page = dbMan.getScannedFilesPage(std::get<0>(first_page.back()), 2);
+    ASSERT_EQ(second_page.size(), 1);
+    EXPECT_LT(std::get<0>(first_page.back()), std::get<0>(second_page.front()));
+    EXPECT_TRUE(dbMan.getScannedFilesPage(std::get<0>(second_page.back()), 2).empty());
+
+    std::set<std::string> seen;
+    long cursor = 0;
+    for (auto page = dbMan.getProcessingResultsPage(cursor, 1); !page.empty(); page = dbMan.getProcessingResultsPage(cursor, 1))
+    {
+        ASSERT_EQ(page.size(), 1);
+        EXPECT_GT(std::get<0>(page[0]), cursor);
+        cursor = std::get<0>(page[0]);
+        seen.insert(std::get<1>(page[0]));
+        EXPECT_EQ(std::get<2>(page[0]).artifact.hash, "hash_" + std::get<1>(page[0]));
+        EXPECT_TRUE(std::get<2>(page[0]).artifact.data.empty());
+        EXPECT_EQ(std::get<3>(page[0]), 3u);
+    }
+    EXPECT_EQ(seen.size(), files.size());
+
+    for (const auto &file : files)
+        fs::remove(file);
+}
+
+TEST_F(DatabaseManagerTest, LegacyMetadataWithoutInodeIsRefreshedWithoutReprocessing)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::string test_file = "test_legacy_metadata.jpg";
+    createTestFile(test_file);
+    auto metadata = FileUtils::getFileMetadata(test_file);
+    ASSERT_TRUE(metadata.has_value());
+
+    dbMan.storeScannedFile(*metadata);
+    dbMan.waitForWrites();
+    dbMan.setProcessingFlag(test_file, DedupMode::BALANCED);
+    dbMan.waitForWrites();
+
+    // Same size and mtime, but no inode/device and the mtime in file_time_type ticks, as older Linux builds stored it
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    auto store_legacy = [&](int64_t legacy_mtime)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(raw_db, "UPDATE scanned_files SET file_mtime = ?1, file_created = ?1, file_inode = 0, file_device = 0 WHERE file_path = ?2",
+                           -1, &stmt, nullptr);
+        sqlite3_bind_int64(stmt, 1, legacy_mtime);
+        sqlite3_bind_text(stmt, 2, test_file.c_str(), -1, SQLITE_STATIC);
+        EXPECT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+        sqlite3_finalize(stmt);
+    };
+    const int64_t legacy_mtime = fs::last_write_time(test_file).time_since_epoch().count();
+    store_legacy(legacy_mtime);
+
+    bool callback_called = false;
+    dbMan.storeScannedFile(*metadata, [&](const std::string &)
+                           { callback_called = true; });
+    dbMan.waitForWrites();
+
+    EXPECT_FALSE(callback_called);
+    EXPECT_TRUE(dbMan.getFilesNeedingProcessing(DedupMode::BALANCED).empty());
+
+    // A legacy row whose mtime differs is a changed file, even at the same size
+    store_legacy(legacy_mtime - fs::file_time_type::duration(std::chrono::hours(1)).count());
+    dbMan.storeScannedFile(*metadata, [&](const std::string &)
+                           { callback_called = true; });
+    dbMan.waitForWrites();
+
+    EXPECT_TRUE(callback_called);
+    EXPECT_FALSE(dbMan.getFilesNeedingProcessing(DedupMode::BALANCED).empty());
+    sqlite3_close(raw_db);
+
+    fs::remove(test_file);
+}
+
+TEST_F(DatabaseManagerTest, DirectoryManifestIsReplacedPerRoot)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    std::vector<DirectoryManifestEntry> first = {
+        {"/data/photos", "", 100},
+        {"/data/photos/2023", "/data/photos", 200},
+        {"/data/photos/2024", "/data/photos", 300}};
+    ASSERT_TRUE(dbMan.replaceDirectoryManifest("/data/photos", first).success);
+
+    // A sibling root sharing the path prefix must not be touched
+    std::vector<DirectoryManifestEntry> other = {{"/data/photos-old", "", 400}};
+    ASSERT_TRUE(dbMan.replaceDirectoryManifest("/data/photos-old", other).success);
+
+    auto manifest = dbMan.getDirectoryManifest("/data/photos");
+    ASSERT_EQ(manifest.size(), 3);
+    EXPECT_EQ(manifest["/data/photos/2024"].mtime_ns, 300);
+
+    // 2023 was removed on disk: the next walk no longer reports it and its row is pruned
+    std::vector<DirectoryManifestEntry> second = {
+        {"/data/photos", "", 150},
+        {"/data/photos/2024", "/data/photos", 300}};
+    ASSERT_TRUE(dbMan.replaceDirectoryManifest("/data/photos", second).success);
+
+    manifest = dbMan.getDirectoryManifest("/data/photos");
+    EXPECT_EQ(manifest.size(), 2);
+    EXPECT_EQ(manifest.count("/data/photos/2023"), 0);
+    EXPECT_EQ(manifest["/data/photos"].mtime_ns, 150);
+    EXPECT_EQ(dbMan.getDirectoryManifest("/data/photos-old").size(), 1);
+
+    // Trailing slashes name the same root, and "/" covers every absolute path
+    EXPECT_EQ(dbMan.getDirectoryManifest("/data/photos/").size(), 2);
+    EXPECT_EQ(dbMan.getDirectoryManifest("/").size(), 3);
+    ASSERT_TRUE(dbMan.replaceDirectoryManifest("/", {{"/", "", 50}, {"/data/photos", "/data", 150}}).success);
+    manifest = dbMan.getDirectoryManifest("/");
+    EXPECT_EQ(manifest.size(), 2);
+    EXPECT_EQ(manifest.count("/data/photos-old"), 0);
+}
+
+TEST_F(DatabaseManagerTest, RemoveScannedPathDropsFileOrSubtree)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("remove_test/album/raw");
+    fs::create_directories("remove_test/album-2");
+    std::vector<std::string> files = {
+        "remove_test/album/a.jpg", "remove_test/album/raw/b.jpg", "remove_test/album-2/c.jpg", "remove_test/d.jpg"};
+    for (const auto &file : files)
+    {
+        createTestFile(file);
+        ASSERT_TRUE(dbMan.storeScannedFile(file).success);
+    }
+    dbMan.waitForWrites();
+
+    auto storedPaths = [&dbMan]()
+    {
+        std::set<std::string> paths;
+        for (const auto &[path, name] : dbMan.getAllScannedFiles())
+            paths.insert(path);
+        return paths;
+    };
+
+    // A single file
+    ASSERT_TRUE(dbMan.removeScannedPath("remove_test/d.jpg").success);
+    EXPECT_EQ(storedPaths().count("remove_test/d.jpg"), 0);
+    EXPECT_EQ(storedPaths().size(), 3);
+
+    // A directory takes everything below it, but not a sibling sharing its name prefix
+    ASSERT_TRUE(dbMan.removeScannedPath("remove_test/album/").success);
+    auto remaining = storedPaths();
+    EXPECT_EQ(remaining, std::set<std::string>{"remove_test/album-2/c.jpg"});
+
+    fs::remove_all("remove_test");
+}
+
+TEST_F(DatabaseManagerTest, ScanDiffResolvesMountsFromTheScanTable)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    // A network mount only the scan's table knows about
+    fs::create_directories("mount_diff_test");
+    const std::string share_root = fs::absolute("mount_diff_test").lexically_normal().string();
+    const std::string file = share_root + "/a.jpg";
+    createTestFile(file);
+    auto metadata = FileUtils::getFileMetadata(file);
+    ASSERT_TRUE(metadata);
+    MountTable mounts({MountInfo{share_root, "nfs", "nas", "media", true}});
+
+    ScanDiff diff;
+    diff.inserted = {*metadata};
+    ASSERT_TRUE(dbMan.applyScanDiff(diff, &mounts).success);
+
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(raw_db, "SELECT relative_path, is_network_file FROM scanned_files WHERE file_path = ?", -1, &stmt, nullptr), SQLITE_OK);
+    sqlite3_bind_text(stmt, 1, file.c_str(), -1, SQLITE_TRANSIENT);
+    ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))), "media:a.jpg");
+    EXPECT_EQ(sqlite3_column_int(stmt, 1), 1);
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw_db);
+
+    fs::remove_all("mount_diff_test");
+}
+
+TEST_F(DatabaseManagerTest, ScanDiffAppliesInsertsUpdatesAndDeletes)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("diff_test/sub");
+    createTestFile("diff_test/a.jpg");
+    createTestFile("diff_test/sub/b.jpg");
+    auto a = FileUtils::getFileMetadata("diff_test/a.jpg");
+    auto b = FileUtils::getFileMetadata("diff_test/sub/b.jpg");
+    ASSERT_TRUE(a && b);
+
+    ScanDiff diff;
+    diff.inserted = {*a, *b};
+    ASSERT_TRUE(dbMan.applyScanDiff(diff).success);
+
+    // Stats come back from the binary columns for everything under the root, and only there
+    createTestFile("diff_test_other.jpg");
+    ASSERT_TRUE(dbMan.storeScannedFile("diff_test_other.jpg").success);
+    auto stats = dbMan.getScannedFileStats("diff_test/");
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_TRUE(stats["diff_test/a.jpg"].matches(*a));
+    EXPECT_TRUE(stats["diff_test/sub/b.jpg"].matches(*b));
+
+    // A changed file is stored with its new stat and queued again; a removed one is dropped
+    dbMan.setProcessingFlag("diff_test/a.jpg", DedupMode::BALANCED);
+    EXPECT_EQ(dbMan.getProcessingFlag("diff_test/a.jpg", DedupMode::BALANCED), 1);
+    FileMetadata changed = *a;
+    changed.file_size += 10;
+    diff.clear();
+    diff.changed = {changed};
+    diff.removed = {"diff_test/sub/b.jpg"};
+    ASSERT_TRUE(dbMan.applyScanDiff(diff).success);
+
+    stats = dbMan.getScannedFileStats("diff_test");
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats["diff_test/a.jpg"].file_size, changed.file_size);
+    EXPECT_EQ(dbMan.getProcessingFlag("diff_test/a.jpg", DedupMode::BALANCED), 0);
+
+    // 64-bit inode and device ids (XFS, btrfs, network filesystems) survive the round trip
+    changed.inode = (uint64_t{1} << 40) + 7;
+    changed.device_id = (uint64_t{1} << 33) + 3;
+    diff.clear();
+    diff.changed = {changed};
+    ASSERT_TRUE(dbMan.applyScanDiff(diff).success);
+    stats = dbMan.getScannedFileStats("diff_test");
+    EXPECT_EQ(stats["diff_test/a.jpg"].inode, changed.inode);
+    EXPECT_EQ(stats["diff_test/a.jpg"].device_id, changed.device_id);
+    EXPECT_TRUE(stats["diff_test/a.jpg"].matches(changed));
+
+    fs::remove_all("diff_test");
+    fs::remove("diff_test_other.jpg");
+}
+
+TEST_F(DatabaseManagerTest, SweepRemovesRowsNotSeenInGeneration)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("sweep_test");
+    for (const auto &name : {"sweep_test/a.jpg", "sweep_test/b.jpg", "sweep_test/c.jpg", "sweep_test_other.jpg"})
+    {
+        createTestFile(name);
+        ASSERT_TRUE(dbMan.storeScannedFile(name).success);
+    }
+    int id_a = dbMan.getFileId("sweep_test/a.jpg");
+    int id_b = dbMan.getFileId("sweep_test/b.jpg");
+    ASSERT_TRUE(dbMan.setFileLinksForMode("sweep_test/a.jpg", {id_b}, DedupMode::BALANCED).success);
+    ASSERT_TRUE(dbMan.setFileLinksForMode("sweep_test/b.jpg", {id_a}, DedupMode::BALANCED).success);
+
+    createTestFile("sweep_test_b_cache.jpg");
+    ASSERT_TRUE(dbMan.insertTranscodingFile("sweep_test/b.jpg").success);
+    ASSERT_TRUE(dbMan.updateTranscodedFilePath("sweep_test/b.jpg", "sweep_test_b_cache.jpg").success);
+
+    // The walk confirms a and c; b was not seen
+    int64_t generation = dbMan.beginScanGeneration();
+    ASSERT_GT(generation, 0);
+    ScanDiff diff;
+    diff.seen = {"sweep_test/a.jpg", "sweep_test/c.jpg"};
+    ASSERT_TRUE(dbMan.applyScanDiff(diff).success);
+    ASSERT_TRUE(dbMan.sweepScanGeneration("sweep_test", generation).success);
+
+    auto stats = dbMan.getScannedFileStats("sweep_test");
+    EXPECT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats.count("sweep_test/b.jpg"), 0);
+    EXPECT_NE(dbMan.getFileId("sweep_test_other.jpg"), -1);
+
+    // The removed file's links, cache entry and cache file go with it
+    EXPECT_TRUE(dbMan.getFileLinksForMode("sweep_test/a.jpg", DedupMode::BALANCED).empty());
+    EXPECT_TRUE(dbMan.getTranscodedFilePath("sweep_test/b.jpg").empty());
+    EXPECT_FALSE(fs::exists("sweep_test_b_cache.jpg"));
+
+    // Generations only move forward
+    EXPECT_GT(dbMan.beginScanGeneration(), generation);
+
+    fs::remove_all("sweep_test");
+    fs::remove("sweep_test_other.jpg");
+}
+
+TEST_F(DatabaseManagerTest, ClaimNextTranscodingJobLeasesEachJobOnce)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("claim_test");
+    std::vector<std::string> files = {"claim_test/a.cr2", "claim_test/b.cr2"};
+    for (const auto &name : files)
+    {
+        createTestFile(name);
+        ASSERT_TRUE(dbMan.storeScannedFile(name).success);
+    }
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success);
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success); // already queued: ignored
+
+    std::set<std::string> claimed;
+    claimed.insert(dbMan.claimNextTranscodingJob());
+    claimed.insert(dbMan.claimNextTranscodingJob());
+    EXPECT_EQ(claimed, std::set<std::string>(files.begin(), files.end()));
+
+    // Both are leased to this process now
+    EXPECT_TRUE(dbMan.claimNextTranscodingJob().empty());
+
+    // A released job is queued again at once, without waiting for its lease to lapse
+    ASSERT_TRUE(dbMan.releaseTranscodingJob(files[0]));
+    EXPECT_EQ(dbMan.claimNextTranscodingJob(), files[0]);
+
+    fs::remove_all("claim_test");
+}
+
+TEST_F(DatabaseManagerTest, QueueingLeavesInFlightAndCompletedTranscodingJobsAlone)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("requeue_test");
+    std::vector<std::string> files = {"requeue_test/a.cr2", "requeue_test/b.cr2", "requeue_test/c.cr2"};
+    for (const auto &name : files)
+    {
+        createTestFile(name);
+        ASSERT_TRUE(dbMan.storeScannedFile(name).success);
+    }
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success);
+
+    // a in progress, b completed in memory only, c completed with a cache file
+    ASSERT_EQ(dbMan.claimNextTranscodingJob(), files[0]);
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[1], "", 0));
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[2], "requeue_test/c.jpg", 100));
+
+    for (const auto &name : files)
+        ASSERT_TRUE(dbMan.insertTranscodingFile(name).success);
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success);
+    EXPECT_TRUE(dbMan.claimNextTranscodingJob().empty());
+    EXPECT_EQ(dbMan.getTranscodedFilePath(files[2]), "requeue_test/c.jpg");
+
+    // Only the job whose proxy went to memory alone is queued again on request
+    ASSERT_TRUE(dbMan.insertTranscodingFile(files[0], true).success);
+    ASSERT_TRUE(dbMan.insertTranscodingFile(files[2], true).success);
+    EXPECT_TRUE(dbMan.claimNextTranscodingJob().empty());
+    ASSERT_TRUE(dbMan.insertTranscodingFile(files[1], true).success);
+    EXPECT_EQ(dbMan.claimNextTranscodingJob(), files[1]);
+    EXPECT_EQ(dbMan.getTranscodedFilePath(files[2]), "requeue_test/c.jpg");
+
+    fs::remove_all("requeue_test");
+}
+
+TEST_F(DatabaseManagerTest, TranscodingJobClaimsUseThePendingIndex)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+    dbMan.waitForWrites();
+
+    // Created with the table, not only by the SQL scripts
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(raw_db,
+                                 "EXPLAIN QUERY PLAN SELECT id FROM cache_map WHERE (status = 0 OR (status = 1 AND lease_until < 0)) "
+                                 "AND transcoded_file_path IS NULL ORDER BY created_at ASC, id ASC LIMIT 1",
+                                 -1, &stmt, nullptr),
+              SQLITE_OK);
+    std::string plan;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        plan += reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw_db);
+    EXPECT_NE(plan.find("idx_cache_map_pending"), std::string::npos) << plan;
+}
+
+TEST_F(DatabaseManagerTest, CacheIndexesAreCreatedWithTheTables)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+    dbMan.waitForWrites();
+
+    sqlite3 *raw_db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &raw_db), SQLITE_OK);
+    for (const char *index : {"idx_cache_map_transcoded", "idx_cache_objects_lru", "idx_cache_objects_content_key"})
+    {
+        sqlite3_stmt *stmt = nullptr;
+        ASSERT_EQ(sqlite3_prepare_v2(raw_db, "SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ?", -1, &stmt, nullptr), SQLITE_OK);
+        sqlite3_bind_text(stmt, 1, index, -1, SQLITE_STATIC);
+        EXPECT_EQ(sqlite3_step(stmt), SQLITE_ROW) << index;
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(raw_db);
+}
+
+TEST_F(DatabaseManagerTest, CachedTranscodesComeBackLeastRecentlyUsedFirst)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("lru_test");
+    std::vector<std::string> files = {"lru_test/a.cr2", "lru_test/b.cr2"};
+    for (const auto &name : files)
+    {
+        createTestFile(name);
+        ASSERT_TRUE(dbMan.storeScannedFile(name).success);
+    }
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success);
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[0], "lru_test/a.jpg", 100));
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[1], "lru_test/b.jpg", 200));
+
+    // a was used after b
+    CachedTranscode touched;
+    touched.transcoded_file_path = "lru_test/a.jpg";
+    touched.file_size = 150;
+    touched.last_access = time(nullptr) + 60;
+    ASSERT_TRUE(dbMan.updateCachedTranscodes({touched}).success);
+
+    auto transcodes = dbMan.getCachedTranscodes();
+    ASSERT_EQ(transcodes.size(), 2u);
+    EXPECT_EQ(transcodes[0].source_file_path, files[1]);
+    EXPECT_EQ(transcodes[0].transcoded_file_path, "lru_test/b.jpg");
+    EXPECT_EQ(transcodes[0].file_size, 200u);
+    EXPECT_EQ(transcodes[1].source_file_path, files[0]);
+    EXPECT_EQ(transcodes[1].file_size, 150u);
+
+    ASSERT_TRUE(dbMan.removeCachedTranscodes({"lru_test/a.jpg", "lru_test/b.jpg"}).success);
+    EXPECT_TRUE(dbMan.getCachedTranscodes().empty());
+    EXPECT_TRUE(dbMan.getTranscodedFilePath(files[0]).empty());
+
+    fs::remove_all("lru_test");
+}
+
+TEST_F(DatabaseManagerTest, IdenticalSourcesShareOneCachedTranscode)
+{
+    auto &dbMan = DatabaseManager::getInstance(db_path);
+
+    fs::create_directories("share_test/copy");
+    std::vector<std::string> files = {"share_test/a.cr2", "share_test/copy/a.cr2"};
+    for (const auto &name : files)
+    {
+        createTestFile(name);
+        ASSERT_TRUE(dbMan.storeScannedFile(name).success);
+    }
+    ASSERT_TRUE(dbMan.insertTranscodingFiles(files).success);
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[0], "share_test/obj.jpg", 100, "100-key", "full-hash"));
+    // The copy attaches without knowing the size
+    ASSERT_TRUE(dbMan.markTranscodingJobCompleted(files[1], "share_test/obj.jpg", 0, "100-key", "full-hash"));
+    EXPECT_EQ(dbMan.getTranscodedFilePath(files[1]), "share_test/obj.jpg");
+
+    auto transcodes = dbMan.getCachedTranscodes();
+    ASSERT_EQ(transcodes.size(), 1u);
+    EXPECT_EQ(transcodes[0].references, 2u);
+    EXPECT_EQ(transcodes[0].file_size, 100u);
+
+    auto candidates = dbMan.findCachedTranscodes("100-key");
+    ASSERT_EQ(candidates.size(), 1u);
+    EXPECT_EQ(candidates[0].content_hash, "full-hash");
+    EXPECT_TRUE(dbMan.findCachedTranscodes("200-key").empty());
+
+    // Removing both sources keeps the content-addressed file for a moved copy
+    createTestFile("share_test/obj.jpg");
+    ASSERT_TRUE(dbMan.removeScannedPath("share_test/copy").success);
+    ASSERT_TRUE(dbMan.removeScannedPath(files[0]).success);
+    transcodes = dbMan.getCachedTranscodes();
+    ASSERT_EQ(transcodes.size(), 1u);
+    EXPECT_EQ(transcodes[0].references, 0u);
+    EXPECT_TRUE(transcodes[0].source_file_path.empty());
+    EXPECT_TRUE(fs::exists("share_test/obj.jpg"));
+
+    fs::remove_all("share_test");
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "test_base.hpp"
+#include "core/cache/decoder_cache.hpp"
+#include "core/memory_pool.hpp"
+#include <opencv2/core.hpp>
+#include <thread>
+
+namespace
+{
+    std::shared_ptr<const cv::Mat> image(int rows, int cols)
+    {
+        return std::make_shared<const cv::Mat>(rows, cols, CV_8U, cv::Scalar(7));
+    }
+
+    // Restores the configured budget and empties the cache around each test
+    class DecoderCacheTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            original_mb_ = DecoderCache::getInstance().getCacheSizeMB();
+            DecoderCache::getInstance().clear();
+        }
+
+        void TearDown() override
+        {
+            DecoderCache::getInstance().clear();
+            DecoderCache::getInstance().setCacheSizeMB(original_mb_);
+        }
+
+        uint32_t original_mb_ = 0;
+    };
+}
+
+TEST_F(DecoderCacheTest, HitsOnlyForTheSameFileVersionAndVariant)
+{
+    auto &cache = DecoderCache::getInstance();
+    cache.setCacheSizeMB(16);
+
+    cache.put(cacheKey("/media/a.jpg"), image(32, 32));
+    auto hit = cache.get(cacheKey("/media/a.jpg"));
+    ASSERT_NE(hit, nullptr);
+    EXPECT_EQ(hit->rows, 32);
+
+    // Modified file, other variant, other skip
+    EXPECT_EQ(cache.get(cacheKey("/media/a.jpg", 2)), nullptr);
+    EXPECT_EQ(cache.get(cacheKey("/media/a.jpg").withVariant(DecoderCache::Variant::GRAY_9X8)), nullptr);
+    EXPECT_EQ(cache.get(cacheKey("/media/a.jpg").forSkip(DecoderCache::Variant::GRAY_32X32, 0, 2)), nullptr);
+
+    // Files that cannot be stat'ed are never cached
+    auto missing = DecoderCache::Key::forFile("/nonexistent/decoder_cache_test.jpg", DecoderCache::Variant::GRAY_9X8);
+    EXPECT_TRUE(missing.path.empty());
+    cache.put(missing, image(8, 9));
+    EXPECT_EQ(cache.get(missing), nullptr);
+}
+
+TEST_F(DecoderCacheTest, StaysWithinBudgetAndResizesLive)
+{
+    auto &cache = DecoderCache::getInstance();
+    cache.setCacheSizeMB(1);
+
+    // ~3.2 MB of 16 KiB decodes into a 1 MB budget
+    for (int i = 0; i < 200; ++i)
+        cache.put(cacheKey("/media/" + std::to_string(i) + ".jpg"), image(128, 128));
+
+    EXPECT_LE(cache.bytesUsed(), 1024u * 1024u);
+    EXPECT_LT(cache.entryCount(), 200u);
+    EXPECT_NE(cache.get(cacheKey("/media/199.jpg")), nullptr);
+    EXPECT_EQ(cache.get(cacheKey("/media/0.jpg")), nullptr);
+
+    // Larger than a shard's share: not kept
+    cache.put(cacheKey("/media/huge.jpg"), image(1024, 1024));
+    EXPECT_EQ(cache.get(cacheKey("/media/huge.jpg")), nullptr);
+
+    // Shrinking evicts at once, zero disables
+    cache.setCacheSizeMB(0);
+    EXPECT_FALSE(cache.enabled());
+    EXPECT_EQ(cache.bytesUsed(), 0u);
+    cache.put(cacheKey("/media/a.jpg"), image(32, 32));
+    EXPECT_EQ(cache.entryCount(), 0u);
+}
+
+TEST_F(DecoderCacheTest, KeepsExactCopiesOfPooledImages)
+{
+    auto &cache = DecoderCache::getInstance();
+    cache.setCacheSizeMB(16);
+
+    // A 224x224 colour canonical is 147 KiB in a 256 KiB pooled block
+    std::thread worker([&]
+                       {
+                           PooledMatAllocator::enableForCurrentThread();
+                           cv::Mat pooled;
+                           pooled.allocator = PooledMatAllocator::allocator();
+                           pooled.create(224, 224, CV_8UC3);
+                           pooled.setTo(cv::Scalar(5, 6, 7));
+                           cache.put(cacheKey("/media/a.jpg"), std::make_shared<const cv::Mat>(pooled)); });
+    worker.join();
+
+    auto hit = cache.get(cacheKey("/media/a.jpg"));
+    ASSERT_NE(hit, nullptr);
+    EXPECT_NE(hit->u->currAllocator, PooledMatAllocator::allocator());
+    EXPECT_EQ(hit->at<cv::Vec3b>(10, 10), cv::Vec3b(5, 6, 7));
+    EXPECT_LT(cache.bytesUsed(), 200u * 1024u);
+}
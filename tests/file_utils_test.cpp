@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -139,4 +141,144 @@ TEST_F(FileUtilsTest, InvalidDirectory)
 
     EXPECT_TRUE(error_received);
     EXPECT_TRUE(error_message.find("Invalid directory path") != std::string::npos);
-}
\ No newline at end of file
+}
+
+TEST_F(FileUtilsTest, ParallelRecursiveScanFindsEveryFileOnce)
+{
+    // Wide and deep enough that several walker threads share the work
+    for (int d = 0; d < 20; ++d)
+    {
+        std::string dir = "test_dir/wide/d" + std::to_string(d) + "/nested";
+        fs::create_directories(dir);
+        for (int f = 0; f < 30; ++f)
+            std::ofstream(dir + "/f" + std::to_string(f) + ".txt").close();
+    }
+
+    std::vector<std::string> files;
+    FileUtils::scanDirectoryRecursively("test_dir", [&files](const std::string &file_path)
+                                        { files.push_back(file_path); }, 4);
+
+    std::sort(files.begin(), files.end());
+    EXPECT_EQ(std::unique(files.begin(), files.end()), files.end());
+    EXPECT_EQ(files.size(), 4 + 20 * 30);
+}
+
+TEST_F(FileUtilsTest, ConcurrentWalksShareOneListingBudget)
+{
+    for (int d = 0; d < 10; ++d)
+    {
+        std::string dir = "test_dir/shared/d" + std::to_string(d);
+        fs::create_directories(dir);
+        for (int f = 0; f < 5; ++f)
+            std::ofstream(dir + "/f" + std::to_string(f) + ".txt").close();
+    }
+
+    // Two walks of four threads each, but only one listing at a time between them
+    ScanThreadBudget budget(1);
+    auto walk = [&budget](const std::string &root, size_t &count)
+    {
+        std::vector<DirectoryManifestEntry> manifest;
+        FileUtils::scanDirectoryIncremental(root, [&count](const FileMetadata &)
+                                            { ++count; }, 4, nullptr, manifest, &budget);
+    };
+    size_t shared_count = 0;
+    size_t all_count = 0;
+    std::thread other([&]
+                      { walk("test_dir/shared", shared_count); });
+    walk("test_dir", all_count);
+    other.join();
+
+    EXPECT_EQ(shared_count, 10u * 5);
+    EXPECT_EQ(all_count, 4 + 10u * 5);
+}
+
+TEST_F(FileUtilsTest, RecursiveListingCarriesStatMetadata)
+{
+    std::vector<FileMetadata> entries;
+    auto observable = FileUtils::listFilesWithMetadataAsObservable("test_dir", true);
+    observable.subscribe(
+        [&entries](const FileMetadata &metadata)
+        {
+            entries.push_back(metadata);
+        },
+        [](const std::exception &e)
+        {
+            FAIL() << "Unexpected error in file listing: " << e.what();
+        });
+
+    ASSERT_EQ(entries.size(), 4);
+    for (const auto &entry : entries)
+    {
+        // The walker's stat must agree with a standalone lookup of the same file
+        auto direct = FileUtils::getFileMetadata(entry.file_path);
+        ASSERT_TRUE(direct.has_value());
+        EXPECT_EQ(entry, *direct);
+#ifdef __linux__
+        EXPECT_NE(entry.inode, 0u);
+#endif
+    }
+}
+
+TEST_F(FileUtilsTest, IncrementalScanSkipsUnchangedDirectories)
+{
+    auto walk = [](const DirectoryManifest *previous, std::vector<DirectoryManifestEntry> &manifest)
+    {
+        std::vector<std::string> files;
+        FileUtils::scanDirectoryIncremental("test_dir", [&files](const FileMetadata &metadata)
+                                            { files.push_back(metadata.file_path); }, 2, previous, manifest);
+        std::sort(files.begin(), files.end());
+        return files;
+    };
+    auto toManifest = [](const std::vector<DirectoryManifestEntry> &entries)
+    {
+        DirectoryManifest manifest;
+        for (const auto &entry : entries)
+            manifest[entry.dir_path] = entry;
+        return manifest;
+    };
+
+    std::vector<DirectoryManifestEntry> first;
+    EXPECT_EQ(walk(nullptr, first).size(), 4);
+    EXPECT_EQ(first.size(), 3); // test_dir, subdir1, subdir2
+
+    // Nothing changed: every directory is reused from the manifest
+    auto previous = toManifest(first);
+    std::vector<DirectoryManifestEntry> second;
+    EXPECT_TRUE(walk(&previous, second).empty());
+    EXPECT_EQ(second.size(), 3);
+
+    // Only the directory that gained an entry is listed again
+    std::ofstream("test_dir/subdir1/file5.txt").close();
+    previous = toManifest(second);
+    std::vector<DirectoryManifestEntry> third;
+    auto files = walk(&previous, third);
+    ASSERT_EQ(files.size(), 2);
+    EXPECT_NE(files[0].find("subdir1/file3.txt"), std::string::npos);
+    EXPECT_NE(files[1].find("subdir1/file5.txt"), std::string::npos);
+    EXPECT_EQ(third.size(), 3);
+}
+
+TEST_F(FileUtilsTest, SampledHashMatchesIdenticalContentOnly)
+{
+    auto write = [](const std::string &path, size_t size, char tail)
+    {
+        std::string data(size, 'x');
+        for (size_t i = 0; i < size; i += 4096)
+            data[i] = static_cast<char>(i / 4096);
+        data.back() = tail;
+        std::ofstream(path, std::ios::binary) << data;
+    };
+    write("test_dir/a.raw", 2 * 1024 * 1024, 'a');
+    write("test_dir/subdir1/a_copy.raw", 2 * 1024 * 1024, 'a');
+    write("test_dir/b.raw", 2 * 1024 * 1024, 'b');
+    write("test_dir/small.raw", 1000, 'a');
+
+    std::string key = FileUtils::computeSampledFileHash("test_dir/a.raw");
+    ASSERT_FALSE(key.empty());
+    EXPECT_EQ(key.rfind("2097152-", 0), 0u);
+    EXPECT_EQ(key, FileUtils::computeSampledFileHash("test_dir/subdir1/a_copy.raw"));
+    // The last block is always sampled
+    EXPECT_NE(key, FileUtils::computeSampledFileHash("test_dir/b.raw"));
+    EXPECT_EQ(FileUtils::computeSampledFileHash("test_dir/small.raw").rfind("1000-", 0), 0u);
+    EXPECT_TRUE(FileUtils::computeSampledFileHash("test_dir/missing.raw").empty());
+}
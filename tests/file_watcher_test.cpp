@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "core/file_watcher.hpp"
+#include "core/shutdown_manager.hpp"
+#include "database/database_manager.hpp"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class FileWatcherTest : public ::testing::Test
+{
+protected:
+    std::string db_path = "test_file_watcher.db";
+    std::string watch_dir = "watch_test_dir";
+
+    void SetUp() override
+    {
+        ShutdownManager::getInstance().reset();
+        DatabaseManager::resetForTesting();
+        fs::remove(db_path);
+        fs::remove_all(watch_dir);
+        fs::create_directories(watch_dir);
+        DatabaseManager::getInstance(db_path);
+    }
+
+    void TearDown() override
+    {
+        FileWatcher::getInstance().stop();
+        DatabaseManager::shutdown();
+        fs::remove_all(watch_dir);
+        for (const auto &file : {db_path, db_path + "-shm", db_path + "-wal"})
+            fs::remove(file);
+    }
+
+    std::set<std::string> storedPaths()
+    {
+        std::set<std::string> paths;
+        for (const auto &[path, name] : DatabaseManager::getInstance().getAllScannedFiles())
+            paths.insert(path);
+        return paths;
+    }
+
+    bool waitFor(const std::function<bool()> &condition)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            if (condition())
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+};
+
+TEST_F(FileWatcherTest, StoresAndRemovesFilesAsTheyChange)
+{
+    auto &watcher = FileWatcher::getInstance();
+    if (!watcher.start(db_path, {watch_dir}, 50))
+        GTEST_SKIP() << "File watching not supported on this platform";
+    ASSERT_TRUE(waitFor([&]()
+                        { return watcher.isWatching(watch_dir); }));
+
+    // A new file is stored without any scan
+    std::string photo = watch_dir + "/photo.jpg";
+    std::ofstream(photo) << "watched content";
+    EXPECT_TRUE(waitFor([&]()
+                        { return storedPaths().count(photo) == 1; }));
+
+    // A directory moved in after the watch started is scanned and watched itself
+    fs::create_directories("watch_test_staging/album");
+    std::ofstream("watch_test_staging/album/a.jpg") << "album content";
+    fs::rename("watch_test_staging/album", watch_dir + "/album");
+    fs::remove_all("watch_test_staging");
+    std::string album_photo = watch_dir + "/album/a.jpg";
+    EXPECT_TRUE(waitFor([&]()
+                        { return storedPaths().count(album_photo) == 1; }));
+
+    std::string later = watch_dir + "/album/b.jpg";
+    std::ofstream(later) << "later content";
+    EXPECT_TRUE(waitFor([&]()
+                        { return storedPaths().count(later) == 1; }));
+
+    // Deleting the file and the directory removes their rows
+    fs::remove(photo);
+    fs::remove_all(watch_dir + "/album");
+    EXPECT_TRUE(waitFor([&]()
+                        { return storedPaths().empty(); }));
+}
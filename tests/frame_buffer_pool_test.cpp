@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "core/decoder/frame_buffer_pool.hpp"
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace
+{
+    AVFrame *pooledFrame(AVPixelFormat format, int width, int height)
+    {
+        AVFrame *frame = av_frame_alloc();
+        frame->format = format;
+        frame->width = width;
+        frame->height = height;
+        EXPECT_EQ(FrameBufferPool::getInstance().getBuffer(frame), 0);
+        return frame;
+    }
+}
+
+TEST(FrameBufferPoolTest, RecyclesBuffersOfTheSameGeometry)
+{
+    AVFrame *first = pooledFrame(AV_PIX_FMT_RGB24, 1920, 1080);
+    ASSERT_NE(first->data[0], nullptr);
+    EXPECT_GE(first->linesize[0], 1920 * 3);
+    EXPECT_EQ(first->linesize[0] % 64, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first->data[0]) % 64, 0u);
+    first->data[0][first->linesize[0] * 1079 + 1920 * 3 - 1] = 1;
+
+    // Held buffers are never handed out twice; released ones come back
+    AVFrame *second = pooledFrame(AV_PIX_FMT_RGB24, 1920, 1080);
+    EXPECT_NE(second->data[0], first->data[0]);
+    uint8_t *released = first->data[0];
+    av_frame_free(&first);
+    AVFrame *third = pooledFrame(AV_PIX_FMT_RGB24, 1920, 1080);
+    EXPECT_EQ(third->data[0], released);
+
+    // Planar formats get every plane from the one buffer
+    AVFrame *yuv = pooledFrame(AV_PIX_FMT_YUV420P, 640, 480);
+    ASSERT_NE(yuv->data[2], nullptr);
+    EXPECT_EQ(yuv->data[1], yuv->data[0] + yuv->linesize[0] * 480);
+    EXPECT_EQ(yuv->data[2], yuv->data[1] + yuv->linesize[1] * 240);
+
+    av_frame_free(&second);
+    av_frame_free(&third);
+    av_frame_free(&yuv);
+}
+
+TEST(FrameBufferPoolTest, ReleasesTheLeastRecentlyUsedGeometry)
+{
+    auto &pools = FrameBufferPool::getInstance();
+
+    // A frame from the oldest pool outlives its pool's eviction
+    AVFrame *held = pooledFrame(AV_PIX_FMT_GRAY8, 64, 64);
+    held->data[0][0] = 7;
+    for (size_t i = 1; i <= FrameBufferPool::MAX_POOLS; ++i)
+    {
+        AVFrame *frame = pooledFrame(AV_PIX_FMT_GRAY8, 64, 64 + static_cast<int>(i));
+        av_frame_free(&frame);
+    }
+    EXPECT_EQ(pools.poolCount(), FrameBufferPool::MAX_POOLS);
+    EXPECT_EQ(held->data[0][0], 7);
+    av_frame_free(&held);
+}
@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include "core/memory_admission.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    constexpr uint64_t MB = 1024 * 1024;
+
+    // 100 MB budget for the test, back to the defaults (half of physical memory) afterwards
+    class MemoryAdmissionTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override { MemoryAdmission::getInstance().setBudgetMB(100); }
+        void TearDown() override
+        {
+            MemoryAdmission::getInstance().setMaxBypass(MemoryAdmission::DEFAULT_MAX_BYPASS);
+            MemoryAdmission::getInstance().setBudgetMB(0);
+        }
+
+        // Poll instead of sleeping: true once count jobs are queued
+        static bool waitForWaiting(size_t count)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (MemoryAdmission::getInstance().waitingCount() != count)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                    return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+    };
+}
+
+TEST_F(MemoryAdmissionTest, SmallJobsFlowAroundAWaitingBigJob)
+{
+    auto &admission = MemoryAdmission::getInstance();
+    auto running = admission.admit(60 * MB, "running");
+
+    std::atomic<bool> big_admitted{false};
+    std::thread big([&]
+                    {
+        auto grant = admission.admit(80 * MB, "big");
+        big_admitted = true; });
+
+    ASSERT_TRUE(waitForWaiting(1));
+    EXPECT_FALSE(big_admitted.load());
+
+    // Fits next to the running job although the big one arrived first
+    auto small = admission.admit(30 * MB, "small");
+    EXPECT_EQ(admission.admittedBytes(), 90 * MB);
+
+    // 30 + 80 still exceeds the budget
+    running.release();
+    EXPECT_EQ(admission.waitingCount(), 1u);
+    EXPECT_FALSE(big_admitted.load());
+
+    small.release();
+    big.join();
+    EXPECT_TRUE(big_admitted.load());
+    EXPECT_EQ(admission.admittedBytes(), 0u);
+}
+
+TEST_F(MemoryAdmissionTest, LaterArrivalsQueueBehindAnAgedWaiter)
+{
+    // With no bypass allowance every waiting job counts as aged at once
+    auto &admission = MemoryAdmission::getInstance();
+    admission.setMaxBypass(std::chrono::milliseconds(0));
+    auto running = admission.admit(60 * MB, "running");
+
+    std::atomic<bool> big_admitted{false};
+    std::thread big([&]
+                    {
+        auto grant = admission.admit(80 * MB, "big");
+        big_admitted = true; });
+    ASSERT_TRUE(waitForWaiting(1));
+
+    // Would fit next to the running job, but the big one is first in line
+    std::atomic<bool> small_admitted{false};
+    std::thread small([&]
+                      {
+        auto grant = admission.admit(30 * MB, "small");
+        small_admitted = true; });
+    ASSERT_TRUE(waitForWaiting(2));
+    EXPECT_FALSE(small_admitted.load());
+    EXPECT_EQ(admission.admittedBytes(), 60 * MB);
+
+    // The big job goes first; the small one only gets in after it is done
+    running.release();
+    big.join();
+    EXPECT_TRUE(big_admitted.load());
+    small.join();
+    EXPECT_TRUE(small_admitted.load());
+    EXPECT_EQ(admission.admittedBytes(), 0u);
+}
+
+TEST_F(MemoryAdmissionTest, JobsLargerThanTheBudgetRunAlone)
+{
+    auto &admission = MemoryAdmission::getInstance();
+    auto huge = admission.admit(500 * MB, "huge");
+    EXPECT_EQ(huge.bytes(), 500 * MB);
+
+    // Nothing else fits while it runs; zero-byte jobs are never held
+    auto audio = admission.admit(0, "audio");
+    EXPECT_EQ(audio.bytes(), 0u);
+
+    std::atomic<bool> admitted{false};
+    std::thread next([&]
+                     {
+        auto grant = admission.admit(1 * MB, "next");
+        admitted = true; });
+    ASSERT_TRUE(waitForWaiting(1));
+    EXPECT_FALSE(admitted.load());
+
+    huge.release();
+    next.join();
+    EXPECT_TRUE(admitted.load());
+}
+
+TEST_F(MemoryAdmissionTest, EstimatesVideoFromItsFrames)
+{
+    // 10-bit 4K video needs far more than 8-bit 1080p
+    EXPECT_GT(MemoryAdmission::videoPeakBytes(3840, 2160, 10, 1), 4 * MemoryAdmission::videoPeakBytes(1920, 1080, 8, 1));
+}
+
+namespace
+{
+    // Writes a header-only image per test under a path unique to the process
+    class ImageHeaderTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override
+        {
+            if (!path_.empty())
+                std::remove(path_.c_str());
+        }
+
+        const std::string &write(const std::string &name, const std::vector<unsigned char> &bytes)
+        {
+            path_ = ::testing::TempDir() + "memory_admission_test_" + std::to_string(::getpid()) + "_" + name;
+            std::ofstream out(path_, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            return path_;
+        }
+
+        static void append(std::vector<unsigned char> &to, const std::vector<unsigned char> &from) { to.insert(to.end(), from.begin(), from.end()); }
+        static std::vector<unsigned char> le16(uint32_t v) { return {static_cast<unsigned char>(v), static_cast<unsigned char>(v >> 8)}; }
+        static std::vector<unsigned char> le32(uint32_t v)
+        {
+            return {static_cast<unsigned char>(v), static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v >> 16), static_cast<unsigned char>(v >> 24)};
+        }
+
+        std::string path_;
+    };
+}
+
+TEST_F(ImageHeaderTest, Png)
+{
+    // Signature and IHDR of a 4000x3000 RGBA image with 16 bits per sample
+    const std::string &path = write("image.png", {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A,
+                                                  0, 0, 0, 13, 'I', 'H', 'D', 'R',
+                                                  0, 0, 0x0F, 0xA0, 0, 0, 0x0B, 0xB8, 16, 6, 0, 0, 0});
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(path), MemoryAdmission::imagePeakBytes(4000, 3000, 4, 16));
+    EXPECT_EQ(MemoryAdmission::imagePeakBytes(4000, 3000, 4, 16), 4000ull * 3000 * (8 + 3 + 4));
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(::testing::TempDir() + "nonexistent/memory_admission_test.png"), 0u);
+}
+
+TEST_F(ImageHeaderTest, Jpeg)
+{
+    // SOI, an APP0 segment to skip, then SOF0 of a 6000x4000 8-bit YCbCr image
+    std::vector<unsigned char> jpeg = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0};
+    jpeg.resize(jpeg.size() + 9, 0);
+    append(jpeg, {0xFF, 0xC0, 0x00, 0x11, 8, 0x0F, 0xA0, 0x17, 0x70, 3});
+    jpeg.resize(jpeg.size() + 9, 0);
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(write("image.jpg", jpeg)), MemoryAdmission::imagePeakBytes(6000, 4000, 3, 8));
+}
+
+TEST_F(ImageHeaderTest, TiffUsesTheLargestImage)
+{
+    // IFD0 is a 160x120 thumbnail, IFD1 the 5000x3000 16-bit RGB image
+    auto ifd = [](uint32_t width, uint32_t height, uint32_t bits, uint32_t next)
+    {
+        std::vector<unsigned char> out = le16(4);
+        for (auto entry : {std::vector<uint32_t>{256, 4, width}, {257, 4, height}, {258, 3, bits}, {277, 3, 3}})
+        {
+            append(out, le16(entry[0]));
+            append(out, le16(entry[1]));
+            append(out, le32(1));
+            append(out, entry[1] == 3 ? std::vector<unsigned char>{static_cast<unsigned char>(entry[2]), static_cast<unsigned char>(entry[2] >> 8), 0, 0}
+                                      : le32(entry[2]));
+        }
+        append(out, le32(next));
+        return out;
+    };
+    const uint32_t ifd_size = 2 + 4 * 12 + 4;
+    std::vector<unsigned char> tiff = {'I', 'I', 42, 0};
+    append(tiff, le32(8));
+    append(tiff, ifd(160, 120, 8, 8 + ifd_size));
+    append(tiff, ifd(5000, 3000, 16, 0));
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(write("image.tif", tiff)), MemoryAdmission::imagePeakBytes(5000, 3000, 3, 16));
+}
+
+TEST_F(ImageHeaderTest, WebpExtended)
+{
+    // RIFF header and a VP8X chunk of a 4096x2048 image (dimensions stored minus one)
+    std::vector<unsigned char> webp = {'R', 'I', 'F', 'F'};
+    append(webp, le32(22));
+    append(webp, {'W', 'E', 'B', 'P', 'V', 'P', '8', 'X'});
+    append(webp, le32(10));
+    append(webp, le32(0));
+    append(webp, {0xFF, 0x0F, 0x00, 0xFF, 0x07, 0x00});
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(write("image.webp", webp)), MemoryAdmission::imagePeakBytes(4096, 2048, 4, 8));
+}
+
+TEST_F(ImageHeaderTest, BmpTopDown)
+{
+    // File header and BITMAPINFOHEADER of a 1920x1080 24-bit image stored top-down
+    std::vector<unsigned char> bmp = {'B', 'M'};
+    append(bmp, le32(54 + 1920 * 1080 * 3));
+    append(bmp, le32(0));
+    append(bmp, le32(54));
+    append(bmp, le32(40));
+    append(bmp, le32(1920));
+    append(bmp, le32(static_cast<uint32_t>(-1080)));
+    append(bmp, le16(1));
+    append(bmp, le16(24));
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(write("image.bmp", bmp)), MemoryAdmission::imagePeakBytes(1920, 1080, 3, 8));
+}
+
+TEST_F(ImageHeaderTest, OpenExr)
+{
+    // Magic, version, a half-float B/G/R channel list and a 3840x2160 data window
+    std::vector<unsigned char> exr = {0x76, 0x2f, 0x31, 0x01, 2, 0, 0, 0};
+    auto attribute = [&](const std::string &name, const std::string &type, const std::vector<unsigned char> &value)
+    {
+        exr.insert(exr.end(), name.begin(), name.end());
+        exr.push_back(0);
+        exr.insert(exr.end(), type.begin(), type.end());
+        exr.push_back(0);
+        append(exr, le32(static_cast<uint32_t>(value.size())));
+        append(exr, value);
+    };
+    std::vector<unsigned char> channels;
+    for (unsigned char name : {'B', 'G', 'R'})
+    {
+        append(channels, {name, 0});
+        append(channels, le32(1)); // half
+        append(channels, {0, 0, 0, 0});
+        append(channels, le32(1));
+        append(channels, le32(1));
+    }
+    channels.push_back(0);
+    attribute("channels", "chlist", channels);
+    std::vector<unsigned char> window = le32(0);
+    append(window, le32(0));
+    append(window, le32(3839));
+    append(window, le32(2159));
+    attribute("dataWindow", "box2i", window);
+    exr.push_back(0);
+    EXPECT_EQ(MemoryAdmission::estimateImagePeakBytes(write("image.exr", exr)), MemoryAdmission::imagePeakBytes(3840, 2160, 3, 16));
+}
+
+TEST_F(ImageHeaderTest, RawFromItsTiffHeaderBeforeReadingIt)
+{
+    // One IFD of a 6000x4000 sensor; half-size decoding still covers a 1024 px edge
+    std::vector<unsigned char> raw = {'I', 'I', 42, 0};
+    append(raw, le32(8));
+    append(raw, le16(2));
+    for (auto entry : {std::pair<uint32_t, uint32_t>{256, 6000}, {257, 4000}})
+    {
+        append(raw, le16(entry.first));
+        append(raw, le16(4));
+        append(raw, le32(1));
+        append(raw, le32(entry.second));
+    }
+    append(raw, le32(0));
+    const std::string &path = write("image.dng", raw);
+    EXPECT_EQ(MemoryAdmission::estimateRawPeakBytes(path, 1024), raw.size() + MemoryAdmission::rawPeakBytes(6000, 4000, 3000, 2000));
+    EXPECT_EQ(MemoryAdmission::estimateRawPeakBytes(path, 0), raw.size() + MemoryAdmission::rawPeakBytes(6000, 4000, 6000, 4000));
+}
+
+TEST_F(ImageHeaderTest, RawWithoutAHeaderFillsTheFile)
+{
+    // Not TIFF-based: a 16-bit mosaic the size of the file, 3:2
+    const std::vector<unsigned char> raw(600 * 400 * 2, 0x5A);
+    EXPECT_EQ(MemoryAdmission::estimateRawPeakBytes(write("image.raf", raw), 0), raw.size() + MemoryAdmission::rawPeakBytes(600, 400, 600, 400));
+    EXPECT_EQ(MemoryAdmission::estimateRawPeakBytes(::testing::TempDir() + "nonexistent/memory_admission_test.raf", 0), 0u);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "core/mount_manager.hpp"
+
+namespace
+{
+    MountInfo mount(const std::string &mount_point, bool network, const std::string &share = "")
+    {
+        MountInfo info;
+        info.mount_point = mount_point;
+        info.mount_type = network ? "nfs" : "ext4";
+        info.server_name = network ? "nas" : "";
+        info.share_name = share;
+        info.is_network_mount = network;
+        return info;
+    }
+}
+
+TEST(MountTableTest, FindsLongestNetworkMountOnComponentBoundaries)
+{
+    MountTable table({mount("/", false),
+                      mount("/mnt/nas", true, "media"),
+                      mount("/mnt/nas/photos", true, "photos"),
+                      mount("/mnt/local", false)});
+
+    const MountInfo *found = table.findNetworkMount("/mnt/nas/video/a.mp4");
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->share_name, "media");
+
+    found = table.findNetworkMount("/mnt/nas/photos/2020//b.jpg");
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->share_name, "photos");
+
+    // Same string prefix, different component
+    EXPECT_EQ(table.findNetworkMount("/mnt/nas2/a.mp4"), nullptr);
+    EXPECT_EQ(table.findNetworkMount("/mnt/local/a.mp4"), nullptr);
+    EXPECT_FALSE(table.isNetworkPath("/home/user/a.jpg"));
+    EXPECT_TRUE(table.isNetworkPath("/mnt/nas"));
+}
+
+TEST(MountTableTest, ConvertsPathsRelativeToTheShare)
+{
+    MountTable table({mount("/mnt/nas", true, "media")});
+
+    auto relative = table.toRelativePath("/mnt/nas/video/a.mp4");
+    ASSERT_TRUE(relative.has_value());
+    EXPECT_EQ(relative->share_name, "media");
+    EXPECT_EQ(relative->relative_path, "video/a.mp4");
+
+    auto absolute = table.toAbsolutePath(*relative);
+    ASSERT_TRUE(absolute.has_value());
+    EXPECT_EQ(*absolute, "/mnt/nas/video/a.mp4");
+
+    EXPECT_FALSE(table.toRelativePath("/mnt/nas").has_value());
+    EXPECT_FALSE(table.toRelativePath("/mnt/other/a.mp4").has_value());
+}
+
+TEST(MountTableTest, SnapshotIsStableUntilMountsChange)
+{
+    auto first = MountManager::getInstance().snapshot();
+    auto second = MountManager::getInstance().snapshot();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+}
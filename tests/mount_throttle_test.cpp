@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "core/mount_throttle.hpp"
+#include "core/file_utils.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    // Explicit limits for every test, back to the defaults afterwards
+    class MountThrottleTest : public ::testing::Test
+    {
+    protected:
+        static constexpr int MAX_CONCURRENT_IO = 2;
+
+        void SetUp() override
+        {
+            MountThrottle::Limits limits;
+            limits.max_concurrent_io = MAX_CONCURRENT_IO;
+            limits.acquire_timeout_seconds = 30;
+            limits.breaker_timeout_seconds = 60;
+            MountThrottle::getInstance().setLimits(limits);
+        }
+        void TearDown() override { MountThrottle::getInstance().setLimits(MountThrottle::Limits()); }
+    };
+}
+
+TEST_F(MountThrottleTest, LocalPathsAreNotThrottled)
+{
+    auto permit = MountThrottle::getInstance().acquire("/tmp/mount_throttle_local.jpg");
+    EXPECT_TRUE(permit.granted());
+    EXPECT_TRUE(MountThrottle::getInstance().isAvailable("/tmp/mount_throttle_local.jpg"));
+}
+
+TEST_F(MountThrottleTest, WaitsForAFreeSlotOnTheMount)
+{
+    auto &throttle = MountThrottle::getInstance();
+    const std::string mount = "/test_mount_throttle_slots";
+
+    // Fill every slot of the mount
+    std::vector<MountThrottle::Permit> held;
+    for (int i = 0; i < MAX_CONCURRENT_IO; ++i)
+    {
+        held.push_back(throttle.acquireForMount(mount));
+        ASSERT_TRUE(held.back().granted());
+    }
+
+    auto waiter = std::async(std::launch::async, [&]
+                             { return throttle.acquireForMount(mount).granted(); });
+    EXPECT_EQ(waiter.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+    held.back().complete(true);
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_TRUE(waiter.get());
+}
+
+TEST_F(MountThrottleTest, MountErrorsOpenTheBreaker)
+{
+    auto &throttle = MountThrottle::getInstance();
+    const std::string mount = "/test_mount_throttle_breaker";
+
+    for (int i = 0; i < 5; ++i)
+    {
+        auto permit = throttle.acquireForMount(mount);
+        ASSERT_TRUE(permit.granted());
+        permit.complete(false);
+    }
+
+    // Fails fast while the breaker is open
+    auto start = std::chrono::steady_clock::now();
+    auto permit = throttle.acquireForMount(mount);
+    EXPECT_FALSE(permit.granted());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_F(MountThrottleTest, ClassifiesMountErrors)
+{
+    EXPECT_TRUE(MountThrottle::isMountError(EIO));
+    EXPECT_TRUE(MountThrottle::isMountError(ESTALE));
+    EXPECT_TRUE(MountThrottle::isMountError(ETIMEDOUT));
+    EXPECT_FALSE(MountThrottle::isMountError(ENOENT));
+    EXPECT_FALSE(MountThrottle::isMountError(EACCES));
+    EXPECT_FALSE(MountThrottle::isMountError(0));
+}
+
+TEST_F(MountThrottleTest, ReadsWholeFilesInChunks)
+{
+    // Spans several READ_CHUNK_BYTES reads
+    const std::string path = ::testing::TempDir() + "mount_throttle_read_" + std::to_string(::getpid()) + ".bin";
+    std::vector<unsigned char> written(MountThrottle::READ_CHUNK_BYTES * 2 + 123);
+    for (size_t i = 0; i < written.size(); ++i)
+        written[i] = static_cast<unsigned char>(i * 31);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(written.data()), static_cast<std::streamsize>(written.size()));
+    }
+
+    std::vector<unsigned char> read;
+    EXPECT_TRUE(MountThrottle::getInstance().readFile(path, read));
+    EXPECT_EQ(read, written);
+
+    // Streamed through the same chunks, the hash matches a plain read of the file
+    const std::string hash = FileUtils::computeStreamHash([&](const std::function<void(const unsigned char *, size_t)> &sink)
+                                                          { return MountThrottle::getInstance().readChunks(path, [&](const unsigned char *data, size_t length, uint64_t)
+                                                                                                           { sink(data, length); }); });
+    EXPECT_FALSE(hash.empty());
+    EXPECT_EQ(hash, FileUtils::computeFileHash(path));
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(MountThrottle::getInstance().readFile(path, read));
+    EXPECT_TRUE(read.empty());
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "core/memory_pool.hpp"
+#include <opencv2/core.hpp>
+#include <thread>
+
+namespace
+{
+    cv::Mat pooledMat(int rows, int cols, int type)
+    {
+        cv::Mat mat;
+        mat.allocator = PooledMatAllocator::allocator();
+        mat.create(rows, cols, type);
+        return mat;
+    }
+}
+
+TEST(PooledMatAllocatorTest, ReusesFreedBlocksOnEnabledThreads)
+{
+    // Run on a fresh thread so the pool state does not leak into other tests
+    std::thread worker([]
+                       {
+                           PooledMatAllocator::enableForCurrentThread();
+                           auto before = PooledMatAllocator::stats();
+
+                           const uint8_t *first_data = nullptr;
+                           {
+                               cv::Mat first = pooledMat(32, 32, CV_8U);
+                               first.setTo(cv::Scalar(1));
+                               first_data = first.data;
+                           }
+
+                           // Same size class (1 KiB), so the freed block comes back
+                           cv::Mat second = pooledMat(30, 30, CV_8U);
+                           EXPECT_EQ(second.data, first_data);
+                           EXPECT_EQ(second.rows, 30);
+
+                           auto after = PooledMatAllocator::stats();
+                           EXPECT_EQ(after.allocated - before.allocated, 1u);
+                           EXPECT_EQ(after.reused - before.reused, 1u);
+                       });
+    worker.join();
+}
+
+TEST(PooledMatAllocatorTest, LeavesOtherThreadsOnTheStandardAllocator)
+{
+    std::thread worker([]
+                       {
+                           auto before = PooledMatAllocator::stats();
+                           cv::Mat mat = pooledMat(32, 32, CV_8U);
+                           mat.setTo(cv::Scalar(3));
+                           EXPECT_EQ(mat.at<uint8_t>(0, 0), 3);
+                           EXPECT_NE(mat.u->currAllocator, PooledMatAllocator::allocator());
+                           auto after = PooledMatAllocator::stats();
+                           EXPECT_EQ(after.allocated, before.allocated);
+                       });
+    worker.join();
+}
+
+TEST(PooledMatAllocatorTest, BlocksFreedOnOtherThreadsGoBackToTheirPool)
+{
+    std::thread worker([]
+                       {
+                           PooledMatAllocator::enableForCurrentThread();
+                           cv::Mat handed_off = pooledMat(64, 64, CV_8U);
+                           const uint8_t *data = handed_off.data;
+
+                           // Released by the next stage, on a thread that never pools
+                           std::thread([mat = std::move(handed_off)]() mutable
+                                       { mat.release(); })
+                               .join();
+
+                           // Same size class (4 KiB): the block came home and is served again
+                           auto before = PooledMatAllocator::stats();
+                           cv::Mat next = pooledMat(60, 60, CV_8U);
+                           EXPECT_EQ(next.data, data);
+                           auto after = PooledMatAllocator::stats();
+                           EXPECT_EQ(after.reused - before.reused, 1u);
+                           EXPECT_EQ(after.allocated, before.allocated);
+                       });
+    worker.join();
+}
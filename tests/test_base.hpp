@@ -9,6 +9,7 @@
 #include "database/database_manager.hpp"
 #include "poco_config_adapter.hpp"
 #include "logging/logger.hpp"
+#include "core/cache/decoder_cache.hpp"
 
 /**
  * @brief Base class for all tests that provides common test environment setup
@@ -132,3 +133,14 @@ private:
     std::filesystem::path test_files_dir_;
     std::string test_db_path_;
 };
+
+// Key of a 32x32 grayscale decode of path as DecoderCache and ThumbnailStore tests use it
+inline DecoderCache::Key cacheKey(const std::string &path, int64_t mtime_ns = 1)
+{
+    DecoderCache::Key key;
+    key.path = path;
+    key.mtime_ns = mtime_ns;
+    key.file_size = 1000;
+    key.variant = DecoderCache::Variant::GRAY_32X32;
+    return key;
+}
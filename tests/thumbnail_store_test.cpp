@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "test_base.hpp"
+#include "core/cache/thumbnail_store.hpp"
+#include <opencv2/core.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    class ThumbnailStoreTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            dir_ = (std::filesystem::temp_directory_path() / "thumbnail_store_test").string();
+            std::filesystem::remove_all(dir_);
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(dir_);
+        }
+
+        std::string dir_;
+    };
+}
+
+TEST_F(ThumbnailStoreTest, RecordsSurviveReopenAcrossSegments)
+{
+    {
+        ThumbnailStore store(2);
+        ASSERT_TRUE(store.open(dir_));
+        for (int i = 0; i < 5; ++i)
+            ASSERT_TRUE(store.put(cacheKey("/media/" + std::to_string(i) + ".jpg"), cv::Mat(32, 32, CV_8U, cv::Scalar(i))));
+
+        // A modified file replaces its record
+        ASSERT_TRUE(store.put(cacheKey("/media/0.jpg", 2), cv::Mat(32, 32, CV_8U, cv::Scalar(42))));
+        EXPECT_EQ(store.segmentCount(), 3u);
+    }
+
+    ThumbnailStore store(2);
+    ASSERT_TRUE(store.open(dir_));
+    EXPECT_EQ(store.entryCount(), 5u);
+
+    auto image = store.get(cacheKey("/media/3.jpg"));
+    ASSERT_NE(image, nullptr);
+    EXPECT_EQ(image->rows, 32);
+    EXPECT_EQ(image->at<uint8_t>(5, 5), 3);
+
+    EXPECT_EQ(store.get(cacheKey("/media/0.jpg")), nullptr);
+    auto replaced = store.get(cacheKey("/media/0.jpg", 2));
+    ASSERT_NE(replaced, nullptr);
+    EXPECT_EQ(replaced->at<uint8_t>(0, 0), 42);
+    EXPECT_EQ(store.get(cacheKey("/media/3.jpg").withVariant(DecoderCache::Variant::GRAY_9X8)), nullptr);
+
+    size_t visited = 0;
+    store.forEach([&](const DecoderCache::Key &k, const cv::Mat &pixels)
+                  {
+                      ++visited;
+                      EXPECT_EQ(pixels.rows, 32);
+                      if (k.path == "/media/0.jpg")
+                          EXPECT_EQ(k.mtime_ns, 2);
+                  });
+    EXPECT_EQ(visited, 5u);
+}
+
+TEST_F(ThumbnailStoreTest, DropsATornRecordAtTheEnd)
+{
+    {
+        ThumbnailStore store;
+        ASSERT_TRUE(store.open(dir_));
+        ASSERT_TRUE(store.put(cacheKey("/media/a.jpg"), cv::Mat(8, 9, CV_8U, cv::Scalar(1))));
+    }
+
+    // Half of a record header, as left by a crash mid-append
+    auto segment = std::filesystem::path(dir_) / "segment_000001.thm";
+    auto intact_size = std::filesystem::file_size(segment);
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        out.write("THMBgarbage", 11);
+    }
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(dir_));
+    EXPECT_EQ(std::filesystem::file_size(segment), intact_size);
+    EXPECT_NE(store.get(cacheKey("/media/a.jpg")), nullptr);
+    ASSERT_TRUE(store.put(cacheKey("/media/b.jpg"), cv::Mat(8, 9, CV_8U, cv::Scalar(2))));
+    EXPECT_EQ(store.entryCount(), 2u);
+}
+
+TEST_F(ThumbnailStoreTest, DamagedRecordReadsAsAMiss)
+{
+    {
+        ThumbnailStore store;
+        ASSERT_TRUE(store.open(dir_));
+        ASSERT_TRUE(store.put(cacheKey("/media/a.jpg"), cv::Mat(32, 32, CV_8U, cv::Scalar(7))));
+        ASSERT_TRUE(store.put(cacheKey("/media/b.jpg"), cv::Mat(32, 32, CV_8U, cv::Scalar(8))));
+    }
+
+    // One pixel of a's record: past the segment header, the record header and the padded path
+    {
+        std::fstream segment(std::filesystem::path(dir_) / "segment_000001.thm", std::ios::binary | std::ios::in | std::ios::out);
+        segment.seekp(16 + 64 + 16 + 100);
+        segment.put('x');
+    }
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(dir_));
+    EXPECT_EQ(store.entryCount(), 2u);
+
+    // Callbacks run outside the store's lock and may use it
+    size_t visited = 0;
+    store.forEach([&](const DecoderCache::Key &k, const cv::Mat &)
+                  {
+                      ++visited;
+                      EXPECT_EQ(k.path, "/media/b.jpg");
+                      EXPECT_NE(store.get(k), nullptr);
+                  });
+    EXPECT_EQ(visited, 1u);
+    EXPECT_EQ(store.get(cacheKey("/media/a.jpg")), nullptr);
+    EXPECT_EQ(store.entryCount(), 1u);
+}
+
+TEST_F(ThumbnailStoreTest, CompactsSupersededRecordsAndDropsTheOldestBeyondTheCap)
+{
+    constexpr uint64_t cap = 8 * 1024; // about seven 32x32 records
+    ThumbnailStore store(2);
+    ASSERT_TRUE(store.open(dir_, cap));
+
+    // Every version replaces the one before: compaction keeps the current one
+    for (int version = 1; version <= 20; ++version)
+        ASSERT_TRUE(store.put(cacheKey("/media/a.jpg", version), cv::Mat(32, 32, CV_8U, cv::Scalar(version))));
+    EXPECT_LE(store.diskBytes(), cap);
+    EXPECT_EQ(store.entryCount(), 1u);
+    auto latest = store.get(cacheKey("/media/a.jpg", 20));
+    ASSERT_NE(latest, nullptr);
+    EXPECT_EQ(latest->at<uint8_t>(0, 0), 20);
+
+    // Distinct entries that do not fit: the oldest go
+    for (int i = 0; i < 20; ++i)
+        ASSERT_TRUE(store.put(cacheKey("/media/" + std::to_string(i) + ".jpg"), cv::Mat(32, 32, CV_8U, cv::Scalar(i))));
+    EXPECT_LE(store.diskBytes(), cap);
+    EXPECT_LT(store.entryCount(), 21u);
+    EXPECT_EQ(store.get(cacheKey("/media/0.jpg")), nullptr);
+    EXPECT_NE(store.get(cacheKey("/media/19.jpg")), nullptr);
+
+    const size_t entries = store.entryCount();
+    store.close();
+    ThumbnailStore reopened(2);
+    ASSERT_TRUE(reopened.open(dir_, cap));
+    EXPECT_EQ(reopened.entryCount(), entries);
+    uint64_t on_disk = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(dir_))
+        on_disk += std::filesystem::file_size(entry.path());
+    EXPECT_EQ(reopened.diskBytes(), on_disk);
+}
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include "core/transcoding_manager.hpp"
+#include "poco_config_adapter.hpp"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    // Minimal uncompressed DNG: one 16-bit RGGB mosaic in a single strip, no preview
+    class DngWriter
+    {
+    public:
+        DngWriter(uint32_t width, uint32_t height) : width_(width), height_(height) {}
+
+        void write(const std::string &path)
+        {
+            const char make[] = "Test";
+            const char model[] = "DNG";
+            const char unique_model[] = "Test DNG";
+
+            struct Entry
+            {
+                uint16_t tag, type;
+                uint32_t count;
+                std::vector<uint8_t> value;
+            };
+            std::vector<Entry> entries = {
+                {254, LONG, 1, le32(0)},
+                {256, LONG, 1, le32(width_)},
+                {257, LONG, 1, le32(height_)},
+                {258, SHORT, 1, le16(16)},
+                {259, SHORT, 1, le16(1)},
+                {262, SHORT, 1, le16(32803)}, // CFA
+                {271, ASCII, sizeof(make), bytes(make, sizeof(make))},
+                {272, ASCII, sizeof(model), bytes(model, sizeof(model))},
+                {273, LONG, 1, {}}, // strip offset, filled in below
+                {274, SHORT, 1, le16(1)},
+                {277, SHORT, 1, le16(1)},
+                {278, LONG, 1, le32(height_)},
+                {279, LONG, 1, le32(width_ * height_ * 2)},
+                {284, SHORT, 1, le16(1)},
+                {33421, SHORT, 2, concat(le16(2), le16(2))},
+                {33422, BYTE, 4, {0, 1, 1, 2}}, // RGGB
+                {50706, BYTE, 4, {1, 4, 0, 0}},
+                {50708, ASCII, sizeof(unique_model), bytes(unique_model, sizeof(unique_model))},
+                {50721, SRATIONAL, 9, identityMatrix()},
+                {50728, RATIONAL, 3, concat(concat(rational(1), rational(1)), rational(1))},
+                {50778, SHORT, 1, le16(21)}, // D65
+            };
+
+            // Header, IFD, then the values that do not fit an entry, then the pixels
+            const uint32_t ifd_size = 2 + static_cast<uint32_t>(entries.size()) * 12 + 4;
+            uint32_t extra_offset = 8 + ifd_size;
+            uint32_t extra_size = 0;
+            for (const auto &entry : entries)
+                if (entry.value.size() > 4)
+                    extra_size += static_cast<uint32_t>(entry.value.size() + (entry.value.size() & 1));
+            const uint32_t strip_offset = extra_offset + extra_size;
+            for (auto &entry : entries)
+                if (entry.tag == 273)
+                    entry.value = le32(strip_offset);
+
+            std::vector<uint8_t> file = {'I', 'I', 42, 0};
+            append(file, le32(8));
+            append(file, le16(static_cast<uint16_t>(entries.size())));
+            std::vector<uint8_t> extra;
+            for (const auto &entry : entries)
+            {
+                append(file, le16(entry.tag));
+                append(file, le16(entry.type));
+                append(file, le32(entry.count));
+                if (entry.value.size() <= 4)
+                {
+                    std::vector<uint8_t> inline_value = entry.value;
+                    inline_value.resize(4, 0);
+                    append(file, inline_value);
+                }
+                else
+                {
+                    append(file, le32(extra_offset + static_cast<uint32_t>(extra.size())));
+                    append(extra, entry.value);
+                    if (extra.size() & 1)
+                        extra.push_back(0);
+                }
+            }
+            append(file, le32(0)); // no next IFD
+            append(file, extra);
+
+            // A smooth gradient so demosaicing has something to work with
+            file.reserve(file.size() + static_cast<size_t>(width_) * height_ * 2);
+            for (uint32_t y = 0; y < height_; ++y)
+                for (uint32_t x = 0; x < width_; ++x)
+                    append(file, le16(static_cast<uint16_t>(4096 + (x * 40000) / width_ + (y * 20000) / height_)));
+
+            std::ofstream out(path, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+        }
+
+    private:
+        enum : uint16_t
+        {
+            BYTE = 1,
+            ASCII = 2,
+            SHORT = 3,
+            LONG = 4,
+            RATIONAL = 5,
+            SRATIONAL = 10
+        };
+
+        static std::vector<uint8_t> le16(uint16_t v) { return {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8)}; }
+        static std::vector<uint8_t> le32(uint32_t v)
+        {
+            return {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 24)};
+        }
+        static std::vector<uint8_t> rational(int32_t numerator) { return concat(le32(static_cast<uint32_t>(numerator)), le32(1)); }
+        static std::vector<uint8_t> bytes(const char *data, size_t size) { return std::vector<uint8_t>(data, data + size); }
+        static std::vector<uint8_t> concat(std::vector<uint8_t> a, const std::vector<uint8_t> &b)
+        {
+            append(a, b);
+            return a;
+        }
+        static void append(std::vector<uint8_t> &to, const std::vector<uint8_t> &from) { to.insert(to.end(), from.begin(), from.end()); }
+        static std::vector<uint8_t> identityMatrix()
+        {
+            std::vector<uint8_t> matrix;
+            for (int i = 0; i < 9; ++i)
+                append(matrix, rational(i % 4 == 0 ? 1 : 0));
+            return matrix;
+        }
+
+        const uint32_t width_;
+        const uint32_t height_;
+    };
+
+    class TranscodingManagerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            raw_path_ = ::testing::TempDir() + "transcoding_manager_test_" + std::to_string(::getpid()) + ".dng";
+            DngWriter(RAW_WIDTH, RAW_HEIGHT).write(raw_path_);
+        }
+
+        void TearDown() override
+        {
+            setMaxEdge(1024); // default
+            std::remove(raw_path_.c_str());
+        }
+
+        static void setMaxEdge(int max_edge_px)
+        {
+            PocoConfigAdapter::getInstance().updateCacheConfig(
+                R"({"cache": {"transcode_max_edge_px": )" + std::to_string(max_edge_px) + "}}");
+        }
+
+        static constexpr uint32_t RAW_WIDTH = 2400;
+        static constexpr uint32_t RAW_HEIGHT = 1600;
+        std::string raw_path_;
+    };
+}
+
+TEST_F(TranscodingManagerTest, RawProxyIsShrunkToTheMaxEdge)
+{
+    // Half-size decoding leaves 1200 px, the resize takes it the rest of the way
+    setMaxEdge(1024);
+    cv::Mat bgr;
+    ASSERT_TRUE(TranscodingManager::getInstance().decodeRawFile(raw_path_, bgr));
+    EXPECT_EQ(bgr.type(), CV_8UC3);
+    EXPECT_LE(std::max(bgr.cols, bgr.rows), 1024);
+    EXPECT_GE(std::max(bgr.cols, bgr.rows), 1023);
+    EXPECT_GT(bgr.cols, bgr.rows); // aspect ratio kept
+}
+
+TEST_F(TranscodingManagerTest, RawProxyKeepsFullResolutionWithoutAMaxEdge)
+{
+    setMaxEdge(0);
+    cv::Mat bgr;
+    ASSERT_TRUE(TranscodingManager::getInstance().decodeRawFile(raw_path_, bgr));
+    EXPECT_EQ(std::max(bgr.cols, bgr.rows), static_cast<int>(RAW_WIDTH));
+    EXPECT_EQ(std::min(bgr.cols, bgr.rows), static_cast<int>(RAW_HEIGHT));
+}
+
+namespace
+{
+    // 1 MB in-memory handoff for the test, back to the default afterwards
+    class DecodedImageHandoffTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override { setHandoffMB(1); }
+        void TearDown() override
+        {
+            auto &transcoder = TranscodingManager::getInstance();
+            for (const char *name : {"a.cr2", "b.cr2", "c.cr2", "huge.cr2"})
+                transcoder.releaseDecodedImage(name);
+            setHandoffMB(256); // default
+        }
+
+        static void setHandoffMB(int handoff_mb)
+        {
+            PocoConfigAdapter::getInstance().updateCacheConfig(R"({"cache": {"raw_handoff_mb": )" + std::to_string(handoff_mb) + "}}");
+        }
+
+        // 600 x 240 x 3 = 432000 bytes: two fit the budget, three do not
+        static std::shared_ptr<const cv::Mat> proxy(int rows = 240, int cols = 600)
+        {
+            return std::make_shared<const cv::Mat>(rows, cols, CV_8UC3);
+        }
+    };
+}
+
+TEST_F(DecodedImageHandoffTest, OldestProxiesAreDroppedBeyondTheBudget)
+{
+    auto &transcoder = TranscodingManager::getInstance();
+    auto a = proxy();
+    transcoder.publishDecodedImage("a.cr2", a);
+    transcoder.publishDecodedImage("b.cr2", proxy());
+    EXPECT_EQ(transcoder.getDecodedImage("a.cr2"), a);
+    ASSERT_NE(transcoder.getDecodedImage("b.cr2"), nullptr);
+
+    transcoder.publishDecodedImage("c.cr2", proxy());
+    EXPECT_EQ(transcoder.getDecodedImage("a.cr2"), nullptr);
+    EXPECT_NE(transcoder.getDecodedImage("b.cr2"), nullptr);
+    EXPECT_NE(transcoder.getDecodedImage("c.cr2"), nullptr);
+
+    // A released proxy frees its share of the budget
+    transcoder.releaseDecodedImage("b.cr2");
+    EXPECT_EQ(transcoder.getDecodedImage("b.cr2"), nullptr);
+    transcoder.publishDecodedImage("a.cr2", a);
+    EXPECT_EQ(transcoder.getDecodedImage("a.cr2"), a);
+    EXPECT_NE(transcoder.getDecodedImage("c.cr2"), nullptr);
+}
+
+TEST_F(DecodedImageHandoffTest, ProxyLargerThanTheBudgetIsNotHeld)
+{
+    auto &transcoder = TranscodingManager::getInstance();
+    transcoder.publishDecodedImage("a.cr2", proxy());
+    transcoder.publishDecodedImage("huge.cr2", proxy(1000, 1000));
+    EXPECT_EQ(transcoder.getDecodedImage("huge.cr2"), nullptr);
+
+    // Nothing was evicted to make room for it
+    EXPECT_NE(transcoder.getDecodedImage("a.cr2"), nullptr);
+}